@@ -246,6 +246,9 @@ static const char *get_sigtype(int nid)
      case NID_id_GostR3410_2012_512:
         return "gost2012_512";
 
+     case EVP_PKEY_SM2:
+        return "SM2";
+
     default:
         return NULL;
     }
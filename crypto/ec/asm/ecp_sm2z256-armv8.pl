@@ -18,6 +18,10 @@ open OUT,"| \"$^X\" $xlate $flavour \"$output\""
     or die "can't call $xlate: $!";
 *STDOUT=*OUT;
 
+# With another comb geometry configured, the generator table is compiled
+# from the generated ecp_sm2z256_comb.h instead
+$comb_table = grep { $_ eq "-DSM2Z256_COMB_TABLE" } @ARGV;
+
 {
 my ($rp,$ap,$bp,$bi,$a0,$a1,$a2,$a3,$t0,$t1,$t2,$t3,$poly1,$poly3,
     $acc0,$acc1,$acc2,$acc3,$acc4,$acc5) =
@@ -34,64 +38,69 @@ ___
 # Convert ecp_sm2z256_table.c to layout expected by ecp_nistz_gather_w7
 #
 $0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
-open TABLE,"<ecp_sm2z256_table.c"		or
-open TABLE,"<${dir}../ecp_sm2z256_table.c"	or
-die "failed to open ecp_sm2z256_table.c:",$!;
-
 use integer;
 
-foreach(<TABLE>) {
-	s/TOBN\(\s*(0x[0-9a-f]+),\s*(0x[0-9a-f]+)\s*\)/push @arr,hex($2),hex($1)/geo;
-}
-close TABLE;
+if (!$comb_table) {
+	open TABLE,"<ecp_sm2z256_table.c"		or
+	open TABLE,"<${dir}../ecp_sm2z256_table.c"	or
+	die "failed to open ecp_sm2z256_table.c:",$!;
 
-# See ecp_sm2z256_table.c for explanation for why it's 64*16*37.
-# 64*16*37-1 is because $#arr returns last valid index or @arr, not
-# amount of elements.
-die "insane number of elements" if ($#arr != 64*16*37-1);
+	foreach(<TABLE>) {
+		s/TOBN\(\s*(0x[0-9a-f]+),\s*(0x[0-9a-f]+)\s*\)/push @arr,hex($2),hex($1)/geo;
+	}
+	close TABLE;
 
-$code.=<<___;
+	# See ecp_sm2z256_table.c for explanation for why it's 64*16*37.
+	# 64*16*37-1 is because $#arr returns last valid index or @arr, not
+	# amount of elements.
+	die "insane number of elements" if ($#arr != 64*16*37-1);
+
+	$code.=<<___;
 .globl	ecp_sm2z256_precomputed
 .type	ecp_sm2z256_precomputed,%object
 .align	12
 ecp_sm2z256_precomputed:
 ___
 
-$gather_scatter_use_neon = 0;
-
-########################################################################
-# this conversion smashes P256_POINT_AFFINE by individual bytes with
-# 64 byte interval, similar to
-#	1111222233334444
-#	1234123412341234
-if($gather_scatter_use_neon == 0) {
-	# there are 37 sub-tables, where each sub-table has 64 points
-	# and each point is 64B (32B for X, 32B for Y)
-	# each item of @arr is 4B, so a sub-table includes 64*64/4=64*16 items
-	for(1..37) {
-		@tbl = splice(@arr,0,64*16);
-		for($i=0;$i<64;$i++) {
-			undef @line;
-			for($j=0;$j<64;$j++) {
-				push @line,(@tbl[$j*16+$i/4]>>(($i%4)*8))&0xff;
+	$gather_scatter_use_neon = 0;
+
+	########################################################################
+	# this conversion smashes P256_POINT_AFFINE by individual bytes with
+	# 64 byte interval, similar to
+	#	1111222233334444
+	#	1234123412341234
+	if($gather_scatter_use_neon == 0) {
+		# there are 37 sub-tables, where each sub-table has 64 points
+		# and each point is 64B (32B for X, 32B for Y)
+		# each item of @arr is 4B, so a sub-table includes 64*64/4=64*16 items
+		for(1..37) {
+			@tbl = splice(@arr,0,64*16);
+			for($i=0;$i<64;$i++) {
+				undef @line;
+				for($j=0;$j<64;$j++) {
+					push @line,(@tbl[$j*16+$i/4]>>(($i%4)*8))&0xff;
+				}
+				$code.=".byte\t";
+				$code.=join(',',map { sprintf "0x%02x",$_} @line);
+				$code.="\n";
 			}
-			$code.=".byte\t";
-			$code.=join(',',map { sprintf "0x%02x",$_} @line);
-			$code.="\n";
+		}
+	} else {
+		# each item of @arr is 4B, 16*4B=64B = 1 point
+		while (@line=splice(@arr,0,16)) {
+			$code.=".word\t";
+			$code.=join(',',map { sprintf "0x%08x",$_} @line);
+			$code.="\n"
+			# print ".word\t",join(',',map { sprintf "0x%08x",$_} @line),"\n";
 		}
 	}
-} else {
-	# each item of @arr is 4B, 16*4B=64B = 1 point
-	while (@line=splice(@arr,0,16)) {
-		$code.=".word\t";
-		$code.=join(',',map { sprintf "0x%08x",$_} @line);
-		$code.="\n"
-		# print ".word\t",join(',',map { sprintf "0x%08x",$_} @line),"\n";
-	}
+
+	$code.=<<___;
+.size	ecp_sm2z256_precomputed,.-ecp_sm2z256_precomputed
+___
 }
 
 $code.=<<___;
-.size	ecp_sm2z256_precomputed,.-ecp_sm2z256_precomputed
 
 .align	5
 .Lpoly: // modulus for SM2
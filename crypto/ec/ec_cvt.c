@@ -21,6 +21,7 @@
 EC_GROUP *EC_GROUP_new_curve_sm2_GFp(const BIGNUM *p, const BIGNUM *a,
                                  const BIGNUM *b, BN_CTX *ctx)
 {
+#ifdef ECP_SM2Z256_ASM
     const EC_METHOD *meth;
     EC_GROUP *ret;
 
@@ -36,6 +37,9 @@ EC_GROUP *EC_GROUP_new_curve_sm2_GFp(const BIGNUM *p, const BIGNUM *a,
     }
 
     return ret;
+#else
+    return EC_GROUP_new_curve_GFp(p, a, b, ctx);
+#endif
 }
 
 EC_GROUP *EC_GROUP_new_curve_GFp(const BIGNUM *p, const BIGNUM *a,
@@ -25,6 +25,8 @@
 #include <openssl/self_test.h>
 #include "prov/providercommon.h"
 #include "crypto/bn.h"
+#include "crypto/sm2.h"
+#include "crypto/sm2err.h"
 
 static int ecdsa_keygen_pairwise_test(EC_KEY *eckey, OSSL_CALLBACK *cb,
                                       void *cbarg);
@@ -94,6 +96,13 @@ void EC_KEY_free(EC_KEY *r)
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_EC_KEY, r, &r->ex_data);
 #endif
     CRYPTO_THREAD_lock_free(r->lock);
+#ifdef ECP_SM2Z256_ASM
+    ecp_sm2z256_point_table_free(r->sm2_pub_table);
+#endif
+#if !defined(OPENSSL_NO_SM2) && !defined(FIPS_MODULE)
+    EVP_MD_CTX_free(r->sm2_z_mdctx);
+    OPENSSL_free(r->sm2_z_id);
+#endif
     EC_GROUP_free(r->group);
     EC_POINT_free(r->pub_key);
     BN_clear_free(r->priv_key);
@@ -669,6 +678,170 @@ void ossl_ec_key_set0_libctx(EC_KEY *key, OSSL_LIB_CTX *libctx)
     /* Do we need to propagate this to the group? */
 }
 
+#ifdef ECP_SM2Z256_ASM
+# ifndef SM2Z256_POINT_TABLE_THRESHOLD
+#  define SM2Z256_POINT_TABLE_THRESHOLD 16
+# endif
+
+/*
+ * Returns in |inv| the SM2 signing context of |key|, (1+dA)^-1 mod n in
+ * Montgomery form. It is computed on first use and kept until the key
+ * material changes. Returns 0 if |key| has no usable private key.
+ */
+int ossl_ec_key_sm2z256_sign_inverse(const EC_KEY *key, BN_ULONG inv[4])
+{
+    EC_KEY *eckey = (EC_KEY *)key;
+    BN_ULONG dA[4];
+    int ret = 0;
+
+    if (!CRYPTO_THREAD_read_lock(eckey->lock))
+        return 0;
+    if (eckey->sm2_sign_dirty_cnt == eckey->dirty_cnt + 1) {
+        memcpy(inv, eckey->sm2_sign_inv, sizeof(eckey->sm2_sign_inv));
+        ret = 1;
+    }
+    CRYPTO_THREAD_unlock(eckey->lock);
+    if (ret)
+        return 1;
+
+    if (eckey->priv_key == NULL || BN_is_negative(eckey->priv_key)
+            || !bn_copy_words(dA, eckey->priv_key, 4))
+        return 0;
+    ret = ecp_sm2z256_sign_inverse(inv, dA);
+    OPENSSL_cleanse(dA, sizeof(dA));
+    if (!ret)
+        return 0;
+
+    if (CRYPTO_THREAD_write_lock(eckey->lock)) {
+        memcpy(eckey->sm2_sign_inv, inv, sizeof(eckey->sm2_sign_inv));
+        eckey->sm2_sign_dirty_cnt = eckey->dirty_cnt + 1;
+        CRYPTO_THREAD_unlock(eckey->lock);
+    }
+    return 1;
+}
+
+/*
+ * Returns the comb table of the public key of |key| for SM2 verification
+ * and encryption, or NULL if there is none (yet). Each call counts as one
+ * use of the key: the table is built on the SM2Z256_POINT_TABLE_THRESHOLD-th
+ * one and kept until the key material changes, unless the global cap on
+ * tables is reached.
+ */
+const SM2Z256_POINT_TABLE *ossl_ec_key_sm2z256_pub_table(const EC_KEY *key)
+{
+    EC_KEY *eckey = (EC_KEY *)key;
+    SM2Z256_POINT_TABLE *tbl = NULL, *old = NULL;
+    int build = 0;
+
+    if (eckey->pub_key == NULL || eckey->group == NULL
+            || !ecp_sm2z256_group_is_builtin(eckey->group))
+        return NULL;
+
+    if (!CRYPTO_THREAD_read_lock(eckey->lock))
+        return NULL;
+    if (eckey->sm2_pub_dirty_cnt == eckey->dirty_cnt + 1)
+        tbl = eckey->sm2_pub_table;
+    CRYPTO_THREAD_unlock(eckey->lock);
+    if (tbl != NULL)
+        return tbl;
+
+    if (!CRYPTO_THREAD_write_lock(eckey->lock))
+        return NULL;
+    if (eckey->sm2_pub_dirty_cnt != eckey->dirty_cnt + 1) {
+        old = eckey->sm2_pub_table;
+        eckey->sm2_pub_table = NULL;
+        eckey->sm2_pub_uses = 0;
+        eckey->sm2_pub_dirty_cnt = eckey->dirty_cnt + 1;
+    }
+    tbl = eckey->sm2_pub_table;
+    if (tbl == NULL)
+        build = ++eckey->sm2_pub_uses == SM2Z256_POINT_TABLE_THRESHOLD;
+    CRYPTO_THREAD_unlock(eckey->lock);
+    ecp_sm2z256_point_table_free(old);
+    if (!build)
+        return tbl;
+
+    if ((tbl = ecp_sm2z256_point_table_new(eckey->pub_key)) == NULL)
+        return NULL;
+    if (!CRYPTO_THREAD_write_lock(eckey->lock)) {
+        ecp_sm2z256_point_table_free(tbl);
+        return NULL;
+    }
+    if (eckey->sm2_pub_dirty_cnt == eckey->dirty_cnt + 1
+            && eckey->sm2_pub_table == NULL) {
+        eckey->sm2_pub_table = tbl;
+        CRYPTO_THREAD_unlock(eckey->lock);
+        return tbl;
+    }
+    CRYPTO_THREAD_unlock(eckey->lock);
+    /* Lost a race against a key change, use the generic path this time */
+    ecp_sm2z256_point_table_free(tbl);
+    return NULL;
+}
+#endif
+
+#if !defined(OPENSSL_NO_SM2) && !defined(FIPS_MODULE)
+/*
+ * Sets |mdctx| to the |md| digest state that has absorbed the SM2 Z value
+ * of |key| for |id|, ready for the message. The state is computed once per
+ * (ID, digest) and kept in the key until the key material changes.
+ */
+int ossl_ec_key_sm2_z_digest_init(const EC_KEY *key, EVP_MD_CTX *mdctx,
+                                  const EVP_MD *md, const uint8_t *id,
+                                  size_t id_len)
+{
+    EC_KEY *eckey = (EC_KEY *)key;
+    EVP_MD_CTX *zctx = NULL, *old_zctx;
+    unsigned char *zid = NULL, *old_zid;
+    uint8_t z[EVP_MAX_MD_SIZE];
+    int md_size = EVP_MD_get_size(md), hit = 0;
+
+    if (md_size <= 0 || md_size > EVP_MAX_MD_SIZE) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_DIGEST);
+        return 0;
+    }
+
+    if (!CRYPTO_THREAD_read_lock(eckey->lock))
+        return 0;
+    if (eckey->sm2_z_dirty_cnt == eckey->dirty_cnt + 1
+            && EVP_MD_CTX_get0_md(eckey->sm2_z_mdctx) == md
+            && eckey->sm2_z_id_len == id_len
+            && (id_len == 0 || memcmp(eckey->sm2_z_id, id, id_len) == 0))
+        hit = EVP_MD_CTX_copy_ex(mdctx, eckey->sm2_z_mdctx);
+    CRYPTO_THREAD_unlock(eckey->lock);
+    if (hit)
+        return 1;
+
+    if (!ossl_sm2_compute_z_digest(z, md, id, id_len, key))
+        return 0;
+    if (!EVP_DigestInit_ex(mdctx, md, NULL)
+            || !EVP_DigestUpdate(mdctx, z, md_size)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        return 0;
+    }
+
+    /* Failing to cache the state only costs time on the next message */
+    if ((zctx = EVP_MD_CTX_new()) == NULL
+            || !EVP_MD_CTX_copy_ex(zctx, mdctx)
+            || (id_len > 0 && (zid = OPENSSL_memdup(id, id_len)) == NULL)
+            || !CRYPTO_THREAD_write_lock(eckey->lock)) {
+        EVP_MD_CTX_free(zctx);
+        OPENSSL_free(zid);
+        return 1;
+    }
+    old_zctx = eckey->sm2_z_mdctx;
+    old_zid = eckey->sm2_z_id;
+    eckey->sm2_z_mdctx = zctx;
+    eckey->sm2_z_id = zid;
+    eckey->sm2_z_id_len = id_len;
+    eckey->sm2_z_dirty_cnt = eckey->dirty_cnt + 1;
+    CRYPTO_THREAD_unlock(eckey->lock);
+    EVP_MD_CTX_free(old_zctx);
+    OPENSSL_free(old_zid);
+    return 1;
+}
+#endif
+
 const EC_GROUP *EC_KEY_get0_group(const EC_KEY *key)
 {
     return key->group;
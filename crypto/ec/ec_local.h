@@ -307,6 +307,33 @@ struct ec_key_st {
 
     /* Provider data */
     size_t dirty_cnt; /* If any key material changes, increment this */
+#ifdef ECP_SM2Z256_ASM
+    /*
+     * SM2 signing context: (1+dA)^-1 mod n in Montgomery form, valid while
+     * sm2_sign_dirty_cnt == dirty_cnt + 1
+     */
+    BN_ULONG sm2_sign_inv[256 / BN_BITS2];
+    size_t sm2_sign_dirty_cnt;
+    /*
+     * SM2 verification and encryption context: comb table of pub_key, built
+     * once the key has been used SM2Z256_POINT_TABLE_THRESHOLD times and
+     * valid while sm2_pub_dirty_cnt == dirty_cnt + 1
+     */
+    SM2Z256_POINT_TABLE *sm2_pub_table;
+    unsigned int sm2_pub_uses;
+    size_t sm2_pub_dirty_cnt;
+#endif
+#if !defined(OPENSSL_NO_SM2) && !defined(FIPS_MODULE)
+    /*
+     * SM2 Z digest context: digest state that has absorbed ZA for
+     * (sm2_z_id, digest of sm2_z_mdctx), valid while
+     * sm2_z_dirty_cnt == dirty_cnt + 1
+     */
+    EVP_MD_CTX *sm2_z_mdctx;
+    unsigned char *sm2_z_id;
+    size_t sm2_z_id_len;
+    size_t sm2_z_dirty_cnt;
+#endif
 };
 
 struct ec_point_st {
@@ -623,6 +650,11 @@ const EC_METHOD *EC_GFp_nistz256_method(void);
 
 #ifdef ECP_SM2Z256_ASM
 const EC_METHOD *EC_GFp_sm2z256_method(void);
+int ecp_sm2z256_sign_inverse(BN_ULONG inv[4], const BN_ULONG dA[4]);
+void ecp_sm2z256_mod_inverse_sqr(BN_ULONG r[4], const BN_ULONG in[4]);
+SM2Z256_POINT_TABLE *ecp_sm2z256_point_table_new(const EC_POINT *point);
+void ecp_sm2z256_point_table_free(SM2Z256_POINT_TABLE *tbl);
+const char *ecp_sm2z256_comb_geometry(size_t *table_size);
 #endif
 
 #ifdef S390X_EC_ASM
@@ -6,6 +6,9 @@
 #include "crypto/bn.h"
 #include "ec_local.h"
 #include "internal/refcount.h"
+#include "internal/tsan_assist.h"
+#include "internal/constant_time.h"
+#include "ecp_sm2z256_local.h"
 
 #if BN_BITS2 != 64
 # define TOBN(hi,lo)    lo,hi
@@ -22,21 +25,8 @@
 #endif
 
 #define ALIGNPTR(p,N)   ((unsigned char *)p+N-(size_t)p%N)
-#define P256_LIMBS      (256/BN_BITS2)
-
 typedef unsigned short u16;
 
-typedef struct {
-    BN_ULONG X[P256_LIMBS];
-    BN_ULONG Y[P256_LIMBS];
-    BN_ULONG Z[P256_LIMBS];
-} P256_POINT;
-
-typedef struct {
-    BN_ULONG X[P256_LIMBS];
-    BN_ULONG Y[P256_LIMBS];
-} P256_POINT_AFFINE;
-
 typedef P256_POINT_AFFINE PRECOMP256_ROW[64];
 
 /* structure for precomputed multiples of the generator */
@@ -54,69 +44,6 @@ struct sm2z256_pre_comp_st {
     CRYPTO_RWLOCK *lock;
 };
 
-/* Functions implemented in assembly */
-/*
- * Most of below mentioned functions *preserve* the property of inputs
- * being fully reduced, i.e. being in [0, modulus) range. Simply put if
- * inputs are fully reduced, then output is too. Note that reverse is
- * not true, in sense that given partially reduced inputs output can be
- * either, not unlikely reduced. And "most" in first sentence refers to
- * the fact that given the calculations flow one can tolerate that
- * addition, 1st function below, produces partially reduced result *if*
- * multiplications by 2 and 3, which customarily use addition, fully
- * reduce it. This effectively gives two options: a) addition produces
- * fully reduced result [as long as inputs are, just like remaining
- * functions]; b) addition is allowed to produce partially reduced
- * result, but multiplications by 2 and 3 perform additional reduction
- * step. Choice between the two can be platform-specific, but it was a)
- * in all cases so far...
- */
-/* Modular add: res = a+b mod P   */
-void ecp_sm2z256_add(BN_ULONG res[P256_LIMBS],
-                      const BN_ULONG a[P256_LIMBS],
-                      const BN_ULONG b[P256_LIMBS]);
-/* Modular mul by 2: res = 2*a mod P */
-void ecp_sm2z256_mul_by_2(BN_ULONG res[P256_LIMBS],
-                           const BN_ULONG a[P256_LIMBS]);
-/* Modular mul by 3: res = 3*a mod P */
-void ecp_sm2z256_mul_by_3(BN_ULONG res[P256_LIMBS],
-                           const BN_ULONG a[P256_LIMBS]);
-
-/* Modular div by 2: res = a/2 mod P */
-void ecp_sm2z256_div_by_2(BN_ULONG res[P256_LIMBS],
-                           const BN_ULONG a[P256_LIMBS]);
-/* Modular sub: res = a-b mod P   */
-void ecp_sm2z256_sub(BN_ULONG res[P256_LIMBS],
-                      const BN_ULONG a[P256_LIMBS],
-                      const BN_ULONG b[P256_LIMBS]);
-/* Modular neg: res = -a mod P    */
-void ecp_sm2z256_neg(BN_ULONG res[P256_LIMBS], const BN_ULONG a[P256_LIMBS]);
-/* Montgomery mul: res = a*b*2^-256 mod P */
-void ecp_sm2z256_mul_mont(BN_ULONG res[P256_LIMBS],
-                           const BN_ULONG a[P256_LIMBS],
-                           const BN_ULONG b[P256_LIMBS]);
-/* Montgomery sqr: res = a*a*2^-256 mod P */
-void ecp_sm2z256_sqr_mont(BN_ULONG res[P256_LIMBS],
-                           const BN_ULONG a[P256_LIMBS]);
-/* Convert a number from Montgomery domain, by multiplying with 1 */
-void ecp_sm2z256_from_mont(BN_ULONG res[P256_LIMBS],
-                            const BN_ULONG in[P256_LIMBS]);
-/* Convert a number to Montgomery domain, by multiplying with 2^512 mod P*/
-void ecp_sm2z256_to_mont(BN_ULONG res[P256_LIMBS],
-                          const BN_ULONG in[P256_LIMBS]);
-/* Functions that perform constant time access to the precomputed tables */
-void ecp_sm2z256_scatter_w5(P256_POINT *val,
-                             const P256_POINT *in_t, int idx);
-void ecp_sm2z256_gather_w5(P256_POINT *val,
-                            const P256_POINT *in_t, int idx);
-void ecp_sm2z256_scatter_w7(P256_POINT_AFFINE *val,
-                             const P256_POINT_AFFINE *in_t, int idx);
-void ecp_sm2z256_gather_w7(P256_POINT_AFFINE *val,
-                            const P256_POINT_AFFINE *in_t, int idx);
-void ecp_sm2z256_scatter_w7_unfixed_point(void *x0,
-                            const P256_POINT_AFFINE *x1, int x2);
-void ecp_sm2z256_gather_w7_unfixed_point(P256_POINT_AFFINE *val,
-                            const P256_POINT_AFFINE *in_t, int idx);
 // void ecp_sm2z256_scatter_w5_neon(P256_POINT *val,
 //                              const P256_POINT *in_t, int idx);
 // void ecp_sm2z256_gather_w5_neon(P256_POINT *val,
@@ -138,22 +65,22 @@ static const BN_ULONG ONE[P256_LIMBS] = {
 
 static SM2Z256_PRE_COMP *ecp_sm2z256_pre_comp_new(const EC_GROUP *group);
 
+#ifdef SM2Z256_COMB_TABLE
+/*
+ * Another comb geometry than the default w7 one was configured, the table
+ * of the default generator is generated by ecp_sm2z256_comb.pl
+ */
+# include "ecp_sm2z256_comb.h"
+# define SM2Z256_COMB_G_ROW_PLAIN 1
+#else
 /* Precomputed tables for the default generator */
 extern const PRECOMP256_ROW ecp_sm2z256_precomputed[37];
+# define SM2Z256_COMB_G_ROW     ecp_sm2z256_precomputed[0]
+# define SM2Z256_COMB_G_ROW_PLAIN 0
+# define SM2Z256_COMB_G_ROW_WNAF MULTI_WNAF_G
+#endif
 
 /* Recode window to a signed digit, see ecp_nistputil.c for details */
-static unsigned int _booth_recode_w4(unsigned int in)
-{
-    unsigned int s, d;
-
-    s = ~((in >> 4) - 1);
-    d = (1 << 5) - in - 1;
-    d = (d & s) | (in & ~s);
-    d = (d >> 1) + (d & 1);
-
-    return (d << 1) + (s & 1);
-}
-
 static unsigned int _booth_recode_w5(unsigned int in)
 {
     unsigned int s, d;
@@ -166,18 +93,6 @@ static unsigned int _booth_recode_w5(unsigned int in)
     return (d << 1) + (s & 1);
 }
 
-static unsigned int _booth_recode_w6(unsigned int in)
-{
-    unsigned int s, d;
-
-    s = ~((in >> 6) - 1);
-    d = (1 << 7) - in - 1;
-    d = (d & s) | (in & ~s);
-    d = (d >> 1) + (d & 1);
-
-    return (d << 1) + (s & 1);
-}
-
 /* 
  * the LSB of the returned value is sign bit, remaining is absoluate value
  * give two examples for understanding this function
@@ -215,6 +130,21 @@ static unsigned int _booth_recode_w7(unsigned int in)
     return (d << 1) + (s & 1);
 }
 
+#ifdef SM2Z256_COMB_BOOTH_W
+/* _booth_recode_w7 for the window of the configured comb geometry */
+static unsigned int _booth_recode_comb(unsigned int in)
+{
+    unsigned int s, d;
+
+    s = ~((in >> SM2Z256_COMB_BOOTH_W) - 1);
+    d = (1 << (SM2Z256_COMB_BOOTH_W + 1)) - in - 1;
+    d = (d & s) | (in & ~s);
+    d = (d >> 1) + (d & 1);
+
+    return (d << 1) + (s & 1);
+}
+#endif
+
 static void copy_conditional(BN_ULONG dst[P256_LIMBS],
                              const BN_ULONG src[P256_LIMBS], BN_ULONG move)
 {
@@ -294,8 +224,11 @@ static BN_ULONG is_one(const BIGNUM *z)
  * operations. Then remove ECP_SM2Z256_REFERENCE_IMPLEMENTATION
  * and never define it again. (The correct macro denoting presence of
  * ecp_sm2z256 module is ECP_SM2Z256_ASM.)
+ *
+ * The portable C module, ecp_sm2z256_c64.c, implements the vector
+ * arithmetic only and relies on the point operations below.
  */
-#ifndef ECP_SM2Z256_REFERENCE_IMPLEMENTATION
+#if !defined(ECP_SM2Z256_REFERENCE_IMPLEMENTATION) && !defined(ECP_SM2Z256_C64)
 void ecp_sm2z256_point_double(P256_POINT *r, const P256_POINT *a);
 void ecp_sm2z256_point_add(P256_POINT *r,
                             const P256_POINT *a, const P256_POINT *b);
@@ -1080,13 +1013,125 @@ __owur static int ecp_sm2z256_windowed_mul(const EC_GROUP *group,
 # undef _booth_recode_w5
 # endif
 
+/* p_str = |k| as 33 little-endian bytes, the input of the w7 comb */
+static void ecp_sm2z256_scalar_str(unsigned char p_str[33],
+                                   const BN_ULONG k[P256_LIMBS])
+{
+    int i;
+
+    for (i = 0; i < P256_LIMBS * BN_BYTES; i++)
+        p_str[i] = (unsigned char)(k[i / BN_BYTES] >> (8 * (i % BN_BYTES)));
+    p_str[i] = 0;
+}
+
+/* Booth window j of the w5 ladder: scalar bits 5j-1 .. 5j+4, bit -1 is 0 */
+static unsigned int ecp_sm2z256_window_w5(const unsigned char p_str[33],
+                                          int j)
+{
+    unsigned int wvalue, off;
+
+    if (j == 0)
+        return (p_str[0] << 1) & 0x3f;
+
+    off = (5 * j - 1) / 8;
+    wvalue = p_str[off] | p_str[off + 1] << 8;
+    return (wvalue >> ((5 * j - 1) % 8)) & 0x3f;
+}
+
+/*
+ * r = scalar*point for a secret |scalar|, the shape of SM2 decryption and
+ * of ECDH. Unlike ecp_sm2z256_windowed_mul this handles a single point only,
+ * so everything lives on the stack: a w5 table of 16 multiples and a regular
+ * Booth recoding of 52 windows, each one 5 doublings (none for the top one),
+ * a gather, a conditional negation and an addition. Constant-time in
+ * |scalar| unless it has to be reduced first.
+ */
+__owur static int ecp_sm2z256_point_mul_ct(const EC_GROUP *group,
+                                            P256_POINT *r,
+                                            const BIGNUM *scalar,
+                                            const EC_POINT *point,
+                                            BN_CTX *ctx)
+{
+    int i, j, ret = 0;
+    unsigned int wvalue;
+    unsigned char p_str[33];
+    BN_ULONG k[P256_LIMBS];
+    BIGNUM *mod;
+    ALIGN32 P256_POINT table[16];
+    ALIGN32 P256_POINT mult[16];
+    ALIGN32 P256_POINT t;
+
+    /* This is an unusual input, we don't guarantee constant-timeness. */
+    if ((BN_num_bits(scalar) > 256) || BN_is_negative(scalar)) {
+        if ((mod = BN_CTX_get(ctx)) == NULL)
+            return 0;
+        if (!BN_nnmod(mod, scalar, group->order, ctx)) {
+            ERR_raise(ERR_LIB_EC, ERR_R_BN_LIB);
+            return 0;
+        }
+        scalar = mod;
+    }
+
+    if (!bn_copy_words(k, scalar, P256_LIMBS)) {
+        ERR_raise(ERR_LIB_EC, EC_R_BIGNUM_OUT_OF_RANGE);
+        return 0;
+    }
+
+    if (!ecp_sm2z256_bignum_to_field_elem(mult[0].X, point->X)
+        || !ecp_sm2z256_bignum_to_field_elem(mult[0].Y, point->Y)
+        || !ecp_sm2z256_bignum_to_field_elem(mult[0].Z, point->Z)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        goto err;
+    }
+
+    /* mult[i] = (i+1)*P, the even ones by doubling */
+    ecp_sm2z256_scatter_w5(table, &mult[0], 1);
+    for (i = 1; i < 16; i++) {
+        if (i & 1)
+            ecp_sm2z256_point_double(&mult[i], &mult[i >> 1]);
+        else
+            ecp_sm2z256_point_add(&mult[i], &mult[i - 1], &mult[0]);
+        ecp_sm2z256_scatter_w5(table, &mult[i], i + 1);
+    }
+
+    ecp_sm2z256_scalar_str(p_str, k);
+
+    for (j = 51; j >= 0; j--) {
+        wvalue = _booth_recode_w5(ecp_sm2z256_window_w5(p_str, j));
+
+        ecp_sm2z256_gather_w5(&t, table, wvalue >> 1);
+        ecp_sm2z256_neg(mult[0].Y, t.Y);
+        copy_conditional(t.Y, mult[0].Y, wvalue & 1);
+
+        if (j == 51) {
+            memcpy(r, &t, sizeof(t));
+            continue;
+        }
+
+        ecp_sm2z256_point_double(r, r);
+        ecp_sm2z256_point_double(r, r);
+        ecp_sm2z256_point_double(r, r);
+        ecp_sm2z256_point_double(r, r);
+        ecp_sm2z256_point_double(r, r);
+        ecp_sm2z256_point_add(r, r, &t);
+    }
+
+    ret = 1;
+
+err:
+    OPENSSL_cleanse(p_str, sizeof(p_str));
+    OPENSSL_cleanse(k, sizeof(k));
+    OPENSSL_cleanse(&t, sizeof(t));
+    return ret;
+}
+
 /* Coordinates of G, for which we have precomputed tables */
-const static BN_ULONG def_xG[P256_LIMBS] = {
+static const BN_ULONG def_xG[P256_LIMBS] = {
      TOBN(0x61328990, 0xf418029e), TOBN(0x3e7981ed, 0xdca6c050),
      TOBN(0xd6a1ed99, 0xac24c3c3), TOBN(0x91167a5e, 0xe1c13b05)
 };
 
-const static BN_ULONG def_yG[P256_LIMBS] = {
+static const BN_ULONG def_yG[P256_LIMBS] = {
      TOBN(0xc1354e59, 0x3c2d0ddd), TOBN(0xc1f5e578, 0x8d3295fa),
      TOBN(0x8d4cfb06, 0x6e2a48f8), TOBN(0x63cd65d4, 0x81d735bd)
 };
@@ -1104,6 +1149,84 @@ static int ecp_sm2z256_is_affine_G(const EC_POINT *generator)
         is_one(generator->Z);
 }
 
+/*
+ * Fills |rows| in the layout of ecp_sm2z256_precomputed, rows[j][k - 1] =
+ * k*2^(7j)*P in affine Montgomery form, from the Jacobian point |base|. The
+ * entries are made with the native point operations and all 37*64 of them
+ * share one field inversion.
+ */
+static int ecp_sm2z256_comb_table_fill(PRECOMP256_ROW *rows,
+                                       const P256_POINT *base)
+{
+    P256_POINT *jac = NULL;
+    BN_ULONG (*prod)[P256_LIMBS] = NULL;
+    P256_POINT_AFFINE aff;
+    BN_ULONG inv[P256_LIMBS], z_inv[P256_LIMBS], z_inv2[P256_LIMBS];
+    const int n = 37 * 64;
+    int i, j, ret = 0;
+
+    if ((jac = OPENSSL_malloc(n * sizeof(*jac))) == NULL
+        || (prod = OPENSSL_malloc(n * sizeof(*prod))) == NULL) {
+        ERR_raise(ERR_LIB_EC, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    /*
+     * jac[64*j + k - 1] = k*2^(7j)*P, row j + 1 starts from twice the last
+     * entry of row j.
+     */
+    for (j = 0; j < 37; j++) {
+        P256_POINT *row = jac + 64 * j;
+
+        if (j == 0)
+            memcpy(&row[0], base, sizeof(*base));
+        else
+            ecp_sm2z256_point_double(&row[0], &row[-1]);
+        ecp_sm2z256_point_double(&row[1], &row[0]);
+        for (i = 2; i < 64; i++)
+            ecp_sm2z256_point_add(&row[i], &row[i - 1], &row[0]);
+    }
+
+    /* Convert all of them to affine with one inversion */
+    memcpy(prod[0], jac[0].Z, sizeof(prod[0]));
+    for (i = 1; i < n; i++)
+        ecp_sm2z256_mul_mont(prod[i], prod[i - 1], jac[i].Z);
+
+    /*
+     * A zero product means some entry is at infinity, which only happens
+     * for a point at infinity or of tiny order
+     */
+    if (is_zero(prod[n - 1][0] | prod[n - 1][1] | prod[n - 1][2]
+                | prod[n - 1][3])) {
+        ERR_raise(ERR_LIB_EC, EC_R_POINT_AT_INFINITY);
+        goto err;
+    }
+
+    ecp_sm2z256_mod_inverse_sqr(inv, prod[n - 1]);
+    ecp_sm2z256_mul_mont(inv, inv, prod[n - 1]);
+
+    for (i = n; i-- > 0;) {
+        if (i > 0) {
+            ecp_sm2z256_mul_mont(z_inv, inv, prod[i - 1]);
+            ecp_sm2z256_mul_mont(inv, inv, jac[i].Z);
+        } else {
+            memcpy(z_inv, inv, sizeof(z_inv));
+        }
+        ecp_sm2z256_sqr_mont(z_inv2, z_inv);
+        ecp_sm2z256_mul_mont(aff.X, jac[i].X, z_inv2);
+        ecp_sm2z256_mul_mont(z_inv2, z_inv2, z_inv);
+        ecp_sm2z256_mul_mont(aff.Y, jac[i].Y, z_inv2);
+        ecp_sm2z256_scatter_w7(rows[i / 64], &aff, i % 64);
+    }
+
+    ret = 1;
+
+err:
+    OPENSSL_free(jac);
+    OPENSSL_free(prod);
+    return ret;
+}
+
 __owur static int ecp_sm2z256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
 {
     /*
@@ -1113,11 +1236,10 @@ __owur static int ecp_sm2z256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
      * therefore require ceil(256/7) = 37 tables.
      */
     const BIGNUM *order;
-    EC_POINT *P = NULL, *T = NULL;
     const EC_POINT *generator;
     SM2Z256_PRE_COMP *pre_comp;
-    BN_CTX *new_ctx = NULL;
-    int i, j, k, ret = 0;
+    ALIGN32 P256_POINT base;
+    int ret = 0;
     size_t w;
 
     PRECOMP256_ROW *preComputedTable = NULL;
@@ -1142,14 +1264,6 @@ __owur static int ecp_sm2z256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
     if ((pre_comp = ecp_sm2z256_pre_comp_new(group)) == NULL)
         return 0;
 
-    if (ctx == NULL) {
-        ctx = new_ctx = BN_CTX_new_ex(group->libctx);
-        if (ctx == NULL)
-            goto err;
-    }
-
-    BN_CTX_start(ctx);
-
     order = EC_GROUP_get0_order(group);
     if (order == NULL)
         goto err;
@@ -1161,6 +1275,13 @@ __owur static int ecp_sm2z256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
 
     w = 7;
 
+    if (!ecp_sm2z256_bignum_to_field_elem(base.X, generator->X) ||
+        !ecp_sm2z256_bignum_to_field_elem(base.Y, generator->Y) ||
+        !ecp_sm2z256_bignum_to_field_elem(base.Z, generator->Z)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        goto err;
+    }
+
     if ((precomp_storage =
          OPENSSL_malloc(37 * 64 * sizeof(P256_POINT_AFFINE) + 64)) == NULL) {
         ERR_raise(ERR_LIB_EC, ERR_R_MALLOC_FAILURE);
@@ -1169,51 +1290,9 @@ __owur static int ecp_sm2z256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
 
     preComputedTable = (void *)ALIGNPTR(precomp_storage, 64);
 
-    P = EC_POINT_new(group);
-    T = EC_POINT_new(group);
-    if (P == NULL || T == NULL)
-        goto err;
-
-    /*
-     * The zero entry is implicitly infinity, and we skip it, storing other
-     * values with -1 offset.
-     */
-    if (!EC_POINT_copy(T, generator))
+    if (!ecp_sm2z256_comb_table_fill(preComputedTable, &base))
         goto err;
 
-    // each sub-table has 64 points
-    // if we smashes precompute-table (preComputedTable[j]+k) is the address
-    // where k-th point's first byte of the sub-table will be stored
-    // if we don't smashes precompute-table (preComputedTable[j]+k*64) is the address
-    // where k-th point of the sub-table will be stored
-    for (k = 0; k < 64; k++) {
-        if (!EC_POINT_copy(P, T))
-            goto err;
-        // there are 37 sub-tables
-        for (j = 0; j < 37; j++) {
-            P256_POINT_AFFINE temp;
-            /*
-             * It would be faster to use EC_POINTs_make_affine and
-             * make multiple points affine at the same time.
-             */
-            if (group->meth->make_affine == NULL
-                || !group->meth->make_affine(group, P, ctx))
-                goto err;
-            if (!ecp_sm2z256_bignum_to_field_elem(temp.X, P->X) ||
-                !ecp_sm2z256_bignum_to_field_elem(temp.Y, P->Y)) {
-                ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
-                goto err;
-            }
-            ecp_sm2z256_scatter_w7(preComputedTable[j], &temp, k);
-            for (i = 0; i < 7; i++) {
-                if (!EC_POINT_dbl(group, P, P, ctx))
-                    goto err;
-            }
-        }
-        if (!EC_POINT_add(group, T, T, generator, ctx))
-            goto err;
-    }
-
     pre_comp->group = group;
     pre_comp->w = w;
     pre_comp->precomp = preComputedTable;
@@ -1224,13 +1303,8 @@ __owur static int ecp_sm2z256_mult_precompute(EC_GROUP *group, BN_CTX *ctx)
     ret = 1;
 
  err:
-    BN_CTX_end(ctx);
-    BN_CTX_free(new_ctx);
-
     EC_sm2z256_pre_comp_free(pre_comp);
     OPENSSL_free(precomp_storage);
-    EC_POINT_free(P);
-    EC_POINT_free(T);
     return ret;
 }
 
@@ -1248,94 +1322,344 @@ __owur static int ecp_sm2z256_set_from_affine(EC_POINT *out, const EC_GROUP *gro
     return ret;
 }
 
+/*
+ * Window sizes of the interleaved kernel, in the bn_compute_wNAF sense: the
+ * digits are odd and bounded by 2^w in absolute value. The generator side
+ * reads the first row of the w7 table, which holds 1*G..64*G, so it can use
+ * digits up to 63. The point side uses the odd multiples P, 3P, ..., 15P.
+ */
+# define MULTI_WNAF_G   6
+# define MULTI_WNAF_P   4
+# define MULTI_TABLE_P  (1 << (MULTI_WNAF_P - 1))
+
+static int ecp_sm2z256_is_infinity(const P256_POINT *a)
+{
+    BN_ULONG z = 0;
+    int i;
+
+    for (i = 0; i < P256_LIMBS; i++)
+        z |= a->Z[i];
+
+    return z == 0;
+}
+
 /**
- * @brief computing scalar1*G + scalar2*P，w=4
- * 
+ * @brief computing r = scalar1*G + scalar2*P with one shared doubling chain
+ *
+ * Both scalars are recoded into wNAF and the two sums are interleaved
+ * (Straus), so the 256 doublings are paid once instead of once per scalar.
+ * The G digits are fetched from |row|, the first row of the precomputed
+ * table, and added in affine form; the P digits come from a small Jacobian
+ * table of odd multiples built on the stack. |row| is in the w7 layout of
+ * ecp_sm2z256_gather_w7, or a plain array of k*G starting at k = 1 if
+ * |plain| is set, as SM2Z256_COMB_G_ROW is for a generated comb table; the
+ * wNAF window of G then comes with it.
+ *
+ * Separate sparse windows are used rather than a joint jG+kP table: with
+ * signed digits the joint table needs every (j, +-k) combination, and
+ * building it costs more additions than interleaving two wNAFs saves.
+ *
+ * This is NOT constant-time. Like ossl_ec_wNAF_mul, it is only used when
+ * both a generator scalar and one point/scalar pair are given, which is the
+ * shape of a signature verification where all inputs are public.
+ *
  * @param group including computing function and parameters of SM2
- * @param r result point
+ * @param r result point, Jacobian and in the Montgomery domain
+ * @param row first row of the precomputed table for the generator
+ * @param plain whether |row| is a plain array rather than a w7 table row
  * @param scalar1 the scalar of base point G
  * @param point2 another point namely P
  * @param scalar2 the scalar of unfixed point P
  * @param ctx context of big number computing
  */
 __owur static int ecp_sm2z256_multi_points_mul(const EC_GROUP *group,
-                                                EC_POINT *r,
+                                                P256_POINT *r,
+                                                const P256_POINT_AFFINE *row,
+                                                int plain,
                                                 const BIGNUM *scalar1,
                                                 const EC_POINT *point2,
                                                 const BIGNUM *scalar2,
                                                 BN_CTX *ctx)
 {
-    int i = 0, ret = 0;
-    // char version of the scalar1 and scalar2
-    unsigned char s1_str[33] = {0};
-    unsigned char s2_str[33] = {0};
-    // we used our hardcoded table
-    const PRECOMP256_ROW *preComputedTable = ecp_sm2z256_precomputed;
-    const EC_POINT *generator = NULL;
-    unsigned int idx = 0;
-    const unsigned int windows_size = 4;
-    const unsigned int mask = (1 << (windows_size + 1)) - 1;
-    unsigned int wvalue;
-    BN_ULONG infty;
+    int i, d, ret = 0;
+    signed char *wNAF1 = NULL, *wNAF2 = NULL;
+    size_t len1 = 0, len2 = 0, len;
+    BIGNUM *mod;
     ALIGN32 union {
         P256_POINT p;           // including X Y Z
         P256_POINT_AFFINE a;    // including X Y
-    } t, p;
-    // for pre-computed table
-    P256_POINT table[16];
-    P256_POINT temp[3];
-
-    generator = EC_GROUP_get0_generator(group);
+    } t;
+    ALIGN32 P256_POINT acc, sum;
+    ALIGN32 P256_POINT table[MULTI_TABLE_P];
 
-    for (i = 0; i < bn_get_top(scalar1) * BN_BYTES; i += BN_BYTES) {
-        // i-th word of scalar1 and scalar2
-        BN_ULONG d1 = bn_get_words(scalar1)[i / BN_BYTES];
-        BN_ULONG d2 = bn_get_words(scalar2)[i / BN_BYTES];
-        // for scalar1
-        s1_str[i + 0] = (unsigned char)d1;
-        s1_str[i + 1] = (unsigned char)(d1 >> 8);
-        s1_str[i + 2] = (unsigned char)(d1 >> 16);
-        s1_str[i + 3] = (unsigned char)(d1 >>= 24);
-        // for scalar2
-        s2_str[i + 0] = (unsigned char)d2;
-        s2_str[i + 1] = (unsigned char)(d2 >> 8);
-        s2_str[i + 2] = (unsigned char)(d2 >> 16);
-        s2_str[i + 3] = (unsigned char)(d2 >>= 24);
-        if (BN_BYTES == 8) {
-            d1 >>= 8;
-            d2 >>= 8;
-            s1_str[i + 4] = (unsigned char)d1;
-            s1_str[i + 5] = (unsigned char)(d1 >> 8);
-            s1_str[i + 6] = (unsigned char)(d1 >> 16);
-            s1_str[i + 7] = (unsigned char)(d1 >> 24);
-            s2_str[i + 4] = (unsigned char)d2;
-            s2_str[i + 5] = (unsigned char)(d2 >> 8);
-            s2_str[i + 6] = (unsigned char)(d2 >> 16);
-            s2_str[i + 7] = (unsigned char)(d2 >> 24);
+    /* This is an unusual input, reduce it like ecp_sm2z256_windowed_mul. */
+    if ((BN_num_bits(scalar2) > 256) || BN_is_negative(scalar2)) {
+        if ((mod = BN_CTX_get(ctx)) == NULL)
+            goto err;
+        if (!BN_nnmod(mod, scalar2, group->order, ctx)) {
+            ERR_raise(ERR_LIB_EC, ERR_R_BN_LIB);
+            goto err;
         }
-    }
-    for (; i < 33; i++) {
-        s1_str[i] = 0;
-        s2_str[i] = 0;
+        scalar2 = mod;
     }
 
-    if (!ecp_sm2z256_bignum_to_field_elem(temp[0].X, point2->X)
-        || !ecp_sm2z256_bignum_to_field_elem(temp[0].Y, point2->Y)
-        || !ecp_sm2z256_bignum_to_field_elem(temp[0].Z, point2->Z)) {
+    if (!ecp_sm2z256_bignum_to_field_elem(table[0].X, point2->X)
+        || !ecp_sm2z256_bignum_to_field_elem(table[0].Y, point2->Y)
+        || !ecp_sm2z256_bignum_to_field_elem(table[0].Z, point2->Z)) {
         ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
         goto err;
     }
 
-    /**
-     * Now, we want to pre-compute jG+kQ for j, k in [1, 8]
-     * jG+kQ is stored into table[i*8]
-     * 
-     */
+    if ((wNAF1 = bn_compute_wNAF(scalar1,
+                                 plain ? SM2Z256_COMB_G_ROW_WNAF
+                                       : MULTI_WNAF_G,
+                                 &len1)) == NULL
+        || (wNAF2 = bn_compute_wNAF(scalar2, MULTI_WNAF_P, &len2)) == NULL)
+        goto err;
+
+    /* table[i] = (2*i+1)*P */
+    ecp_sm2z256_point_double(&sum, &table[0]);
+    for (i = 1; i < MULTI_TABLE_P; i++)
+        ecp_sm2z256_point_add(&table[i], &table[i - 1], &sum);
+
+    memset(&acc, 0, sizeof(acc));
+    len = len1 > len2 ? len1 : len2;
+
+    for (i = (int)len - 1; i >= 0; i--) {
+        if (!ecp_sm2z256_is_infinity(&acc))
+            ecp_sm2z256_point_double(&acc, &acc);
+
+        if ((size_t)i < len2 && (d = wNAF2[i]) != 0) {
+            if (d > 0) {
+                ecp_sm2z256_point_add(&acc, &acc, &table[d >> 1]);
+            } else {
+                memcpy(&t.p, &table[(-d) >> 1], sizeof(t.p));
+                ecp_sm2z256_neg(t.p.Y, t.p.Y);
+                ecp_sm2z256_point_add(&acc, &acc, &t.p);
+            }
+        }
+
+        if ((size_t)i < len1 && (d = wNAF1[i]) != 0) {
+            if (plain)
+                memcpy(&t.a, &row[(d > 0 ? d : -d) - 1], sizeof(t.a));
+            else
+                ecp_sm2z256_gather_w7(&t.a, row, d > 0 ? d : -d);
+            if (d < 0)
+                ecp_sm2z256_neg(t.a.Y, t.a.Y);
+
+            ecp_sm2z256_point_add_affine(&sum, &acc, &t.a);
+            /*
+             * The affine formulae do not handle acc == t, and yield
+             * infinity for it. Public inputs can be chosen to hit that, so
+             * redo the addition with the general formulae, which double.
+             */
+            if (ecp_sm2z256_is_infinity(&sum)
+                && !ecp_sm2z256_is_infinity(&acc)) {
+                memcpy(t.p.Z, ONE, sizeof(t.p.Z));
+                ecp_sm2z256_point_add(&sum, &acc, &t.p);
+            }
+            memcpy(&acc, &sum, sizeof(acc));
+        }
+    }
+
+    memcpy(r, &acc, sizeof(acc));
+    ret = 1;
 
 err:
+    OPENSSL_free(wNAF1);
+    OPENSSL_free(wNAF2);
     return ret;
 }
 
+/*
+ * r = scalar*G using the w7 comb over |table|, |p_str| holds the scalar
+ * as 33 little-endian bytes (the top one is zero). Constant-time.
+ */
+static void ecp_sm2z256_mul_g_comb(P256_POINT *r, const unsigned char p_str[33],
+                                    const PRECOMP256_ROW *table)
+{
+    int i;
+    unsigned int idx = 0;
+    const unsigned int window_size = 7;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue;
+    BN_ULONG infty;
+    ALIGN32 union {
+        P256_POINT p;
+        P256_POINT_AFFINE a;
+    } t, p;
+
+    /* First 7-bit window */
+    // 这里左移了一位，是为了booth编码
+    wvalue = (p_str[0] << 1) & mask;
+    idx += window_size;
+    // 对前7bit进行booth编码，wvalue的最低位为符号位、其余位为绝对值
+    wvalue = _booth_recode_w7(wvalue);
+    // 取预计算点，保存到p中
+    ecp_sm2z256_gather_w7(&p.a, table[0], wvalue >> 1);
+    // 根据wvalue的符号位决定是否对点的Y值取负
+    ecp_sm2z256_neg(p.p.Z, p.p.Y);
+    copy_conditional(p.p.Y, p.p.Z, wvalue & 1);
+
+    /*
+     * Since affine infinity is encoded as (0,0) and
+     * Jacobian is (,,0), we need to harmonize them
+     * by assigning "one" or zero to Z.
+     */
+    infty = (p.p.X[0] | p.p.X[1] | p.p.X[2] | p.p.X[3] |
+             p.p.Y[0] | p.p.Y[1] | p.p.Y[2] | p.p.Y[3]);
+    if (P256_LIMBS == 8)
+        infty |= (p.p.X[4] | p.p.X[5] | p.p.X[6] | p.p.X[7] |
+                  p.p.Y[4] | p.p.Y[5] | p.p.Y[6] | p.p.Y[7]);
+
+    infty = 0 - is_zero(infty);
+    infty = ~infty;
+
+    p.p.Z[0] = ONE[0] & infty;
+    p.p.Z[1] = ONE[1] & infty;
+    p.p.Z[2] = ONE[2] & infty;
+    p.p.Z[3] = ONE[3] & infty;
+    if (P256_LIMBS == 8) {
+        p.p.Z[4] = ONE[4] & infty;
+        p.p.Z[5] = ONE[5] & infty;
+        p.p.Z[6] = ONE[6] & infty;
+        p.p.Z[7] = ONE[7] & infty;
+    }
+
+    for (i = 1; i < 37; i++) {
+        // 再次构造booth编码的输入
+        unsigned int off = (idx - 1) / 8;
+        wvalue = p_str[off] | p_str[off + 1] << 8;
+        wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+        idx += window_size;
+        // 计算booth编码，并根据值取预计算表项
+        wvalue = _booth_recode_w7(wvalue);
+        ecp_sm2z256_gather_w7(&t.a, table[i], wvalue >> 1);
+        ecp_sm2z256_neg(t.p.Z, t.a.Y);
+        copy_conditional(t.a.Y, t.p.Z, wvalue & 1);
+        // 预计算表中包含了G^(2^window_size)，无需在此处计算p.p^(2^window_size)
+        ecp_sm2z256_point_add_affine(&p.p, &p.p, &t.a);
+    }
+
+    memcpy(r, &p.p, sizeof(p.p));
+}
+
+#ifndef SM2Z256_COMB_TABLE
+/*
+ * r = scalar*G for the default generator, |p_str| as for
+ * ecp_sm2z256_mul_g_comb. Constant-time.
+ */
+static void ecp_sm2z256_mul_g(P256_POINT *r, const unsigned char p_str[33])
+{
+    ecp_sm2z256_mul_g_comb(r, p_str, ecp_sm2z256_precomputed);
+}
+#else
+/* *val = row[idx - 1], or (0,0) if idx == 0, in constant time */
+static void ecp_sm2z256_comb_gather(P256_POINT_AFFINE *val,
+                                    const BN_ULONG *row, unsigned int idx)
+{
+    BN_ULONG *out = (BN_ULONG *)val, mask;
+    size_t i, j;
+
+    memset(val, 0, sizeof(*val));
+    for (i = 0; i < SM2Z256_COMB_ENTRIES; i++) {
+        mask = (BN_ULONG)constant_time_eq_s(i + 1, (size_t)idx);
+        for (j = 0; j < 2 * P256_LIMBS; j++)
+            out[j] |= row[j] & mask;
+        row += 2 * P256_LIMBS;
+    }
+}
+
+# ifdef SM2Z256_COMB_BOOTH_W
+/*
+ * r = scalar*G for the default generator with the generated Booth comb,
+ * one affine addition per row and no doubling, like ecp_sm2z256_mul_g_comb
+ * with another window. Constant-time.
+ */
+static void ecp_sm2z256_mul_g(P256_POINT *r, const unsigned char p_str[33])
+{
+    const unsigned int mask = (1 << (SM2Z256_COMB_BOOTH_W + 1)) - 1;
+    unsigned int wvalue, off, idx = 0;
+    int i;
+    ALIGN32 union {
+        P256_POINT p;
+        P256_POINT_AFFINE a;
+    } t;
+    ALIGN32 P256_POINT p;
+
+    memset(&p, 0, sizeof(p));
+    for (i = 0; i < SM2Z256_COMB_ROWS; i++) {
+        if (i == 0) {
+            wvalue = (p_str[0] << 1) & mask;
+        } else {
+            off = (idx - 1) / 8;
+            wvalue = p_str[off] | p_str[off + 1] << 8;
+            wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+        }
+        idx += SM2Z256_COMB_BOOTH_W;
+
+        wvalue = _booth_recode_comb(wvalue);
+        ecp_sm2z256_comb_gather(&t.a, ecp_sm2z256_comb_table[i], wvalue >> 1);
+        ecp_sm2z256_neg(t.p.Z, t.a.Y);
+        copy_conditional(t.a.Y, t.p.Z, wvalue & 1);
+        ecp_sm2z256_point_add_affine(&p, &p, &t.a);
+    }
+
+    memcpy(r, &p, sizeof(p));
+}
+# else
+/*
+ * r = scalar*G for the default generator with the generated Lim-Lee comb:
+ * the scalar is cut into T pieces of A bits, each of them into V blocks of
+ * B bits, and one column of bits across the pieces selects an entry of the
+ * row of its block. This takes B - 1 doublings and B*V affine additions
+ * from a table of V*(2^T - 1) points. Constant-time.
+ */
+static void ecp_sm2z256_mul_g(P256_POINT *r, const unsigned char p_str[33])
+{
+    unsigned int u, pos;
+    int i, k, v;
+    ALIGN32 P256_POINT_AFFINE t;
+    ALIGN32 P256_POINT p;
+
+    memset(&p, 0, sizeof(p));
+    for (k = SM2Z256_COMB_LIMLEE_B - 1; k >= 0; k--) {
+        if (k != SM2Z256_COMB_LIMLEE_B - 1)
+            ecp_sm2z256_point_double(&p, &p);
+
+        for (v = 0; v < SM2Z256_COMB_LIMLEE_V; v++) {
+            u = 0;
+            for (i = 0; i < SM2Z256_COMB_LIMLEE_T; i++) {
+                pos = i * SM2Z256_COMB_LIMLEE_A + v * SM2Z256_COMB_LIMLEE_B + k;
+                if (pos < 256)
+                    u |= ((p_str[pos / 8] >> (pos % 8)) & 1) << i;
+            }
+            ecp_sm2z256_comb_gather(&t, ecp_sm2z256_comb_table[v], u);
+            ecp_sm2z256_point_add_affine(&p, &p, &t);
+        }
+    }
+
+    memcpy(r, &p, sizeof(p));
+}
+# endif
+#endif
+
+/*
+ * Returns the name of the configured comb geometry for the default
+ * generator, see ecp_sm2z256_comb.pl, and sets |*table_size| to the size of
+ * its table in bytes
+ */
+const char *ecp_sm2z256_comb_geometry(size_t *table_size)
+{
+#ifdef SM2Z256_COMB_TABLE
+    *table_size = sizeof(ecp_sm2z256_comb_table);
+    return SM2Z256_COMB_NAME;
+#else
+    *table_size = sizeof(ecp_sm2z256_precomputed);
+    return "w7";
+#endif
+}
+
 /* num=0, points=NULL, scalars=NULL when computing scalar*G */
 /**
  * @brief r = scalar*G + sum(scalars[i]*points[i])
@@ -1356,6 +1680,7 @@ __owur static int ecp_sm2z256_points_mul(const EC_GROUP *group,
                                           const BIGNUM *scalars[], BN_CTX *ctx)
 {
     int i = 0, ret = 0, no_precomp_for_generator = 0, p_is_infinity = 0;
+    int builtin_g = 0;
     // p_str[i]指向标量的第i个byte
     unsigned char p_str[33] = { 0 };
     // one row includes 64 points
@@ -1364,12 +1689,6 @@ __owur static int ecp_sm2z256_points_mul(const EC_GROUP *group,
     const EC_POINT *generator = NULL;
     const BIGNUM **new_scalars = NULL;
     const EC_POINT **new_points = NULL;
-    unsigned int idx = 0;
-    // 滑动窗口，窗口的大小
-    const unsigned int window_size = 7;
-    // 2^8 - 1 = 0xff
-    const unsigned int mask = (1 << (window_size + 1)) - 1;
-    unsigned int wvalue;
     ALIGN32 union {
         P256_POINT p;           // including X Y Z
         P256_POINT_AFFINE a;    // including X Y
@@ -1423,11 +1742,26 @@ __owur static int ecp_sm2z256_points_mul(const EC_GROUP *group,
              * is because applications, such as Apache, do not use
              * EC_KEY_precompute_mult.
              */
-            preComputedTable = ecp_sm2z256_precomputed;
+            builtin_g = 1;
         }
         // 使用的是我们硬编码的预计算表
-        if (preComputedTable) {
-            BN_ULONG infty;
+        if ((preComputedTable != NULL || builtin_g) && num == 1) {
+            /*
+             * scalar*G + scalars[0]*points[0] is the verification shape:
+             * share one doubling chain. This is NOT constant-time in either
+             * scalar, see ecp_sm2z256_multi_points_mul; callers with a
+             * secret scalar use the single-scalar forms, which are.
+             */
+            if (!ecp_sm2z256_multi_points_mul(group, &p.p,
+                                               builtin_g ? SM2Z256_COMB_G_ROW
+                                                         : preComputedTable[0],
+                                               builtin_g
+                                               && SM2Z256_COMB_G_ROW_PLAIN,
+                                               scalar, points[0], scalars[0],
+                                               ctx))
+                goto err;
+            num = 0;
+        } else if (preComputedTable != NULL || builtin_g) {
             // 如果标量过长 或 为负数，进行模运算处理
             if ((BN_num_bits(scalar) > 256)
                 || BN_is_negative(scalar)) {
@@ -1440,15 +1774,6 @@ __owur static int ecp_sm2z256_points_mul(const EC_GROUP *group,
                 }
                 scalar = tmp_scalar;
             }
-            /**
-             * Here, if num == 1, we call our multi-point scalar mul function,
-             * set ret, and goto err label
-             */
-
-            // if (!ecp_sm2z256_multi_points_mul(group, r, scalar, points[0], scalars[0], ctx)){
-            //     goto err;
-            // }
-
             // for sm2, bn_get_top(scalar) returns 4, BN_BYTES = 8 on 64-bit machine
             // 256-bit scalar == 4 * 8 Bytes == 4 * BN_BYTES Bytes == 32 Bytes
             // i = 0, 8, 16, 24
@@ -1474,59 +1799,10 @@ __owur static int ecp_sm2z256_points_mul(const EC_GROUP *group,
             for (; i < 33; i++)
                 p_str[i] = 0;
 
-            /* First 7-bit window */
-            // 这里左移了一位，是为了booth编码
-            wvalue = (p_str[0] << 1) & mask;
-            idx += window_size;
-            // 对前7bit进行booth编码，wvalue的最低位为符号位、其余位为绝对值
-            wvalue = _booth_recode_w7(wvalue);
-            // 取预计算点，保存到p中
-            ecp_sm2z256_gather_w7(&p.a, preComputedTable[0],
-                                   wvalue >> 1);
-            // 根据wvalue的符号位决定是否对点的Y值取负
-            ecp_sm2z256_neg(p.p.Z, p.p.Y);
-            copy_conditional(p.p.Y, p.p.Z, wvalue & 1);
-
-            /*
-             * Since affine infinity is encoded as (0,0) and
-             * Jacobian is (,,0), we need to harmonize them
-             * by assigning "one" or zero to Z.
-             */
-            infty = (p.p.X[0] | p.p.X[1] | p.p.X[2] | p.p.X[3] |
-                     p.p.Y[0] | p.p.Y[1] | p.p.Y[2] | p.p.Y[3]);
-            if (P256_LIMBS == 8)
-                infty |= (p.p.X[4] | p.p.X[5] | p.p.X[6] | p.p.X[7] |
-                          p.p.Y[4] | p.p.Y[5] | p.p.Y[6] | p.p.Y[7]);
-
-            infty = 0 - is_zero(infty);
-            infty = ~infty;
-
-            p.p.Z[0] = ONE[0] & infty;
-            p.p.Z[1] = ONE[1] & infty;
-            p.p.Z[2] = ONE[2] & infty;
-            p.p.Z[3] = ONE[3] & infty;
-            if (P256_LIMBS == 8) {
-                p.p.Z[4] = ONE[4] & infty;
-                p.p.Z[5] = ONE[5] & infty;
-                p.p.Z[6] = ONE[6] & infty;
-                p.p.Z[7] = ONE[7] & infty;
-            }
-
-            for (i = 1; i < 37; i++) {
-                // 再次构造booth编码的输入
-                unsigned int off = (idx - 1) / 8;
-                wvalue = p_str[off] | p_str[off + 1] << 8;
-                wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
-                idx += window_size;
-                // 计算booth编码，并根据值取预计算表项
-                wvalue = _booth_recode_w7(wvalue);
-                ecp_sm2z256_gather_w7(&t.a,
-                                       preComputedTable[i], wvalue >> 1);
-                ecp_sm2z256_neg(t.p.Z, t.a.Y);
-                copy_conditional(t.a.Y, t.p.Z, wvalue & 1);
-                // 预计算表中包含了G^(2^window_size)，无需在此处计算p.p^(2^window_size)
-                ecp_sm2z256_point_add_affine(&p.p, &p.p, &t.a);
-            }
+            if (builtin_g)
+                ecp_sm2z256_mul_g(&p.p, p_str);
+            else
+                ecp_sm2z256_mul_g_comb(&p.p, p_str, preComputedTable);
         } else {
             p_is_infinity = 1;
             no_precomp_for_generator = 1;
@@ -1568,8 +1844,14 @@ __owur static int ecp_sm2z256_points_mul(const EC_GROUP *group,
         if (p_is_infinity)
             out = &p.p;
 
-        if (!ecp_sm2z256_windowed_mul(group, out, scalars, points, num, ctx))
+        if (num == 1) {
+            if (!ecp_sm2z256_point_mul_ct(group, out, scalars[0], points[0],
+                                           ctx))
+                goto err;
+        } else if (!ecp_sm2z256_windowed_mul(group, out, scalars, points, num,
+                                             ctx)) {
             goto err;
+        }
 
         if (!p_is_infinity)
             ecp_sm2z256_point_add(&p.p, &p.p, out);
@@ -1712,69 +1994,37 @@ static int ecp_sm2z256_window_have_precompute_mult(const EC_GROUP *group)
 #if defined(__x86_64) || defined(__x86_64__) || \
     defined(_M_AMD64) || defined(_M_X64) || \
     defined(__powerpc64__) || defined(_ARCH_PP64) || \
-    defined(__aarch64__)
+    defined(__aarch64__) || defined(ECP_SM2Z256_C64)
+/* RR = 2^512 mod ord(sm2) */
+static const BN_ULONG ord_RR[P256_LIMBS] = {
+    TOBN(0x901192af,0x7c114f20), TOBN(0x3464504a,0xde6fa2fa),
+    TOBN(0x620fc84c,0x3affe0d4), TOBN(0x1eb5e412,0xa22b3d3b)
+};
+
 /*
- * Montgomery mul modulo Order(P): res = a*b*2^-256 mod Order(P)
+ * out = in^-1 mod Order(P), both in Montgomery representation. Uses a fixed
+ * addition chain for ord(sm2) - 2, so it is constant-time in |in|.
  */
-void ecp_sm2z256_ord_mul_mont(BN_ULONG res[P256_LIMBS],
-                               const BN_ULONG a[P256_LIMBS],
-                               const BN_ULONG b[P256_LIMBS]);
-void ecp_sm2z256_ord_sqr_mont(BN_ULONG res[P256_LIMBS],
-                               const BN_ULONG a[P256_LIMBS],
-                               BN_ULONG rep);
-
-static int ecp_sm2z256_inv_mod_ord(const EC_GROUP *group, BIGNUM *r,
-                                    const BIGNUM *x, BN_CTX *ctx)
+static void ecp_sm2z256_ord_inverse_mont(BN_ULONG out[P256_LIMBS],
+                                         const BN_ULONG in[P256_LIMBS])
 {
-    /* RR = 2^512 mod ord(sm2) */
-    static const BN_ULONG RR[P256_LIMBS]  = {
-        TOBN(0x901192af,0x7c114f20), TOBN(0x3464504a,0xde6fa2fa),
-        TOBN(0x620fc84c,0x3affe0d4), TOBN(0x1eb5e412,0xa22b3d3b)
-    };
-    /* The constant 1 (unlike ONE that is one in Montgomery representation) */
-    static const BN_ULONG one[P256_LIMBS] = {
-        TOBN(0,1), TOBN(0,0), TOBN(0,0), TOBN(0,0)
-    };
-    /*
-     * We don't use entry 0 in the table, so we omit it and address
-     * with -1 offset.
-     */
-    BN_ULONG out[P256_LIMBS], t[P256_LIMBS];
-    int i, ret = 0;
-
-    /*
-     * Catch allocation failure early.
-     */
-    if (bn_wexpand(r, P256_LIMBS) == NULL) {
-        ERR_raise(ERR_LIB_EC, ERR_R_BN_LIB);
-        goto err;
-    }
-
-    if ((BN_num_bits(x) > 256) || BN_is_negative(x)) {
-        BIGNUM *tmp;
-
-        if ((tmp = BN_CTX_get(ctx)) == NULL
-            || !BN_nnmod(tmp, x, group->order, ctx)) {
-            ERR_raise(ERR_LIB_EC, ERR_R_BN_LIB);
-            goto err;
-        }
-        x = tmp;
-    }
+    BN_ULONG t[P256_LIMBS];
+    int i;
 
-    if (!ecp_sm2z256_bignum_to_field_elem(t, x)) {
-        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
-        goto err;
-    }
 #if 0
     /**
      * overhead:
      * mul: 1+8+10+32-3+1=49
      * dbl: 8+124+128=260
      */
+    /*
+     * We don't use entry 0 in the table, so we omit it and address
+     * with -1 offset.
+     */
     BN_ULONG table[15][P256_LIMBS];
     BN_ULONG t2[P256_LIMBS];
-    // trans to mont field
-    ecp_sm2z256_ord_mul_mont(table[0], t, RR);
+
+    memcpy(table[0], in, sizeof(table[0]));
     /*
      * Original sparse-then-fixed-window algorithm, retained for reference.
      * table[1]=_10, table[2]=_11, ...
@@ -1835,8 +2085,8 @@ static int ecp_sm2z256_inv_mod_ord(const EC_GROUP *group, BIGNUM *r,
         i_1 = 0, i_11,     i_101, i_111, i_1001, i_1011, i_1111,
         i_10101, i_11111,  i_x31, i_x32
     };
-    // trans to mont field
-    ecp_sm2z256_ord_mul_mont(table[0], t, RR);
+
+    memcpy(table[0], in, sizeof(table[0]));
     /*
      * https://briansmith.org/ecc-inversion-addition-chains-01#p256_scalar_inversion
      *
@@ -1912,6 +2162,44 @@ static int ecp_sm2z256_inv_mod_ord(const EC_GROUP *group, BIGNUM *r,
         ecp_sm2z256_ord_mul_mont(out, out, table[chain[i].i]);
     }
 #endif
+}
+
+static int ecp_sm2z256_inv_mod_ord(const EC_GROUP *group, BIGNUM *r,
+                                    const BIGNUM *x, BN_CTX *ctx)
+{
+    /* The constant 1 (unlike ONE that is one in Montgomery representation) */
+    static const BN_ULONG one[P256_LIMBS] = {
+        TOBN(0,1), TOBN(0,0), TOBN(0,0), TOBN(0,0)
+    };
+    BN_ULONG out[P256_LIMBS], t[P256_LIMBS];
+    int ret = 0;
+
+    /*
+     * Catch allocation failure early.
+     */
+    if (bn_wexpand(r, P256_LIMBS) == NULL) {
+        ERR_raise(ERR_LIB_EC, ERR_R_BN_LIB);
+        goto err;
+    }
+
+    if ((BN_num_bits(x) > 256) || BN_is_negative(x)) {
+        BIGNUM *tmp;
+
+        if ((tmp = BN_CTX_get(ctx)) == NULL
+            || !BN_nnmod(tmp, x, group->order, ctx)) {
+            ERR_raise(ERR_LIB_EC, ERR_R_BN_LIB);
+            goto err;
+        }
+        x = tmp;
+    }
+
+    if (!ecp_sm2z256_bignum_to_field_elem(t, x)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        goto err;
+    }
+    // trans to mont field
+    ecp_sm2z256_ord_mul_mont(t, t, ord_RR);
+    ecp_sm2z256_ord_inverse_mont(out, t);
     // trans to normal field
     ecp_sm2z256_ord_mul_mont(out, out, one);
 
@@ -1925,14 +2213,809 @@ static int ecp_sm2z256_inv_mod_ord(const EC_GROUP *group, BIGNUM *r,
 err:
     return ret;
 }
+
+/*
+ * ecp_sm2z256_group_is_builtin returns one if |group| is the built-in SM2
+ * curve on this method, so the hard-coded comb table and the order
+ * arithmetic above apply to it as they are.
+ */
+int ecp_sm2z256_group_is_builtin(const EC_GROUP *group)
+{
+    static const BN_ULONG def_n[P256_LIMBS] = {
+        TOBN(0x53bbf409,0x39d54123), TOBN(0x7203df6b,0x21c6052b),
+        TOBN(0xffffffff,0xffffffff), TOBN(0xfffffffe,0xffffffff)
+    };
+    const EC_POINT *generator = EC_GROUP_get0_generator(group);
+
+    return group->meth == EC_GFp_sm2z256_method()
+        && generator != NULL
+        && ecp_sm2z256_is_affine_G(generator)
+        && bn_get_top(group->order) == P256_LIMBS
+        && is_equal(bn_get_words(group->order), def_n);
+}
+
+/*
+ * inv = (1+dA)^-1 mod ord(sm2) in Montgomery representation, the per-key
+ * part of an SM2 signature. Returns 0 if 1+dA is not invertible.
+ */
+int ecp_sm2z256_sign_inverse(BN_ULONG inv[P256_LIMBS],
+                             const BN_ULONG dA[P256_LIMBS])
+{
+    static const BN_ULONG one[P256_LIMBS] = {
+        TOBN(0,1), TOBN(0,0), TOBN(0,0), TOBN(0,0)
+    };
+    BN_ULONG t[P256_LIMBS];
+    int ret;
+
+    ecp_sm2z256_ord_sub_reduce(t, dA);
+    ecp_sm2z256_ord_add(t, t, one);
+    ret = !is_zero(t[0] | t[1] | t[2] | t[3]);
+    ecp_sm2z256_ord_mul_mont(t, t, ord_RR);
+    ecp_sm2z256_ord_inverse_mont(inv, t);
+    OPENSSL_cleanse(t, sizeof(t));
+    return ret;
+}
+
+/*
+ * x = affine x-coordinate of k*G in normal representation, with |k| a
+ * non-zero scalar below ord(sm2). Constant-time in |k|, no allocation.
+ */
+void ecp_sm2z256_mul_g_affine_x(BN_ULONG x[P256_LIMBS],
+                                const BN_ULONG k[P256_LIMBS])
+{
+    unsigned char p_str[33];
+    ALIGN32 P256_POINT p;
+    BN_ULONG z_inv2[P256_LIMBS], x_aff[P256_LIMBS];
+
+    ecp_sm2z256_scalar_str(p_str, k);
+    ecp_sm2z256_mul_g(&p, p_str);
+
+    ecp_sm2z256_mod_inverse_sqr(z_inv2, p.Z);
+    ecp_sm2z256_mul_mont(x_aff, z_inv2, p.X);
+    ecp_sm2z256_from_mont(x, x_aff);
+
+    OPENSSL_cleanse(p_str, sizeof(p_str));
+    OPENSSL_cleanse(&p, sizeof(p));
+}
+
+/*
+ * Comb tables for points other than the generator, in the layout of
+ * ecp_sm2z256_precomputed: rows[j][k - 1] = k*2^(7j)*P in affine Montgomery
+ * form. Each one takes 37*64*64 bytes and at most SM2Z256_POINT_TABLE_MAX of
+ * them are alive at a time, so ecp_sm2z256_point_table_new returning NULL is
+ * not an error for the caller.
+ */
+# ifndef SM2Z256_POINT_TABLE_MAX
+#  define SM2Z256_POINT_TABLE_MAX 64
+# endif
+
+struct sm2z256_point_table_st {
+    const PRECOMP256_ROW *rows;
+    void *storage;
+};
+
+static TSAN_QUALIFIER int sm2z256_point_tables;
+
+SM2Z256_POINT_TABLE *ecp_sm2z256_point_table_new(const EC_POINT *point)
+{
+    SM2Z256_POINT_TABLE *tbl = NULL;
+    PRECOMP256_ROW *rows;
+    ALIGN32 P256_POINT base;
+
+    if (tsan_counter(&sm2z256_point_tables) >= SM2Z256_POINT_TABLE_MAX) {
+        tsan_decr(&sm2z256_point_tables);
+        return NULL;
+    }
+
+    if ((tbl = OPENSSL_zalloc(sizeof(*tbl))) == NULL
+        || (tbl->storage = OPENSSL_malloc(37 * sizeof(PRECOMP256_ROW) + 64))
+           == NULL) {
+        ERR_raise(ERR_LIB_EC, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    rows = (void *)ALIGNPTR(tbl->storage, 64);
+
+    if (!ecp_sm2z256_bignum_to_field_elem(base.X, point->X) ||
+        !ecp_sm2z256_bignum_to_field_elem(base.Y, point->Y) ||
+        !ecp_sm2z256_bignum_to_field_elem(base.Z, point->Z)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        goto err;
+    }
+
+    if (!ecp_sm2z256_comb_table_fill(rows, &base))
+        goto err;
+    tbl->rows = (const PRECOMP256_ROW *)rows;
+
+    return tbl;
+
+err:
+    if (tbl != NULL)
+        OPENSSL_free(tbl->storage);
+    OPENSSL_free(tbl);
+    tsan_decr(&sm2z256_point_tables);
+    return NULL;
+}
+
+void ecp_sm2z256_point_table_free(SM2Z256_POINT_TABLE *tbl)
+{
+    if (tbl == NULL)
+        return;
+    OPENSSL_free(tbl->storage);
+    OPENSSL_free(tbl);
+    tsan_decr(&sm2z256_point_tables);
+}
+
+/* out = |in| in normal representation as 32 big-endian bytes */
+static void ecp_sm2z256_mont2bin(unsigned char out[32],
+                                 const BN_ULONG in[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS];
+    int i;
+
+    ecp_sm2z256_from_mont(t, in);
+    for (i = 0; i < 32; i++)
+        out[31 - i] = (unsigned char)(t[i / BN_BYTES] >> (8 * (i % BN_BYTES)));
+    OPENSSL_cleanse(t, sizeof(t));
+}
+
+/*
+ * SM2 encryption shape on the built-in group: c1 = k*G and kp = k*P as
+ * affine x || y, 32 big-endian bytes each. k*G runs through the comb, k*P
+ * through the comb as well if |tbl| holds the table of P and through
+ * ecp_sm2z256_point_mul_ct otherwise, all constant-time in |k|. The two
+ * points share one field inversion. Returns 0 on error or if either one is at infinity.
+ */
+int ecp_sm2z256_encrypt_points(const EC_GROUP *group, unsigned char c1[64],
+                               unsigned char kp[64], const BIGNUM *k,
+                               const EC_POINT *point,
+                               const SM2Z256_POINT_TABLE *tbl, BN_CTX *ctx)
+{
+    unsigned char p_str[33];
+    ALIGN32 P256_POINT a, b;
+    BN_ULONG kw[P256_LIMBS], inv[P256_LIMBS], z_inv[P256_LIMBS];
+    BN_ULONG z_inv2[P256_LIMBS], t[P256_LIMBS];
+    int ret = 0;
+
+    if (BN_is_negative(k) || !bn_copy_words(kw, k, P256_LIMBS)) {
+        ERR_raise(ERR_LIB_EC, EC_R_BIGNUM_OUT_OF_RANGE);
+        return 0;
+    }
+
+    ecp_sm2z256_scalar_str(p_str, kw);
+    ecp_sm2z256_mul_g(&a, p_str);
+    if (tbl != NULL)
+        ecp_sm2z256_mul_g_comb(&b, p_str, tbl->rows);
+    else if (!ecp_sm2z256_point_mul_ct(group, &b, k, point, ctx))
+        goto err;
+
+    /* inv = (Za*Zb)^-1, zero if either one is at infinity */
+    ecp_sm2z256_mul_mont(t, a.Z, b.Z);
+    if (is_zero(t[0] | t[1] | t[2] | t[3])) {
+        ERR_raise(ERR_LIB_EC, EC_R_POINT_AT_INFINITY);
+        goto err;
+    }
+    ecp_sm2z256_mod_inverse_sqr(inv, t);
+    ecp_sm2z256_mul_mont(inv, inv, t);
+
+    ecp_sm2z256_mul_mont(z_inv, inv, b.Z);
+    ecp_sm2z256_sqr_mont(z_inv2, z_inv);
+    ecp_sm2z256_mul_mont(t, a.X, z_inv2);
+    ecp_sm2z256_mont2bin(c1, t);
+    ecp_sm2z256_mul_mont(z_inv2, z_inv2, z_inv);
+    ecp_sm2z256_mul_mont(t, a.Y, z_inv2);
+    ecp_sm2z256_mont2bin(c1 + 32, t);
+
+    ecp_sm2z256_mul_mont(z_inv, inv, a.Z);
+    ecp_sm2z256_sqr_mont(z_inv2, z_inv);
+    ecp_sm2z256_mul_mont(t, b.X, z_inv2);
+    ecp_sm2z256_mont2bin(kp, t);
+    ecp_sm2z256_mul_mont(z_inv2, z_inv2, z_inv);
+    ecp_sm2z256_mul_mont(t, b.Y, z_inv2);
+    ecp_sm2z256_mont2bin(kp + 32, t);
+
+    ret = 1;
+
+err:
+    OPENSSL_cleanse(p_str, sizeof(p_str));
+    OPENSSL_cleanse(kw, sizeof(kw));
+    OPENSSL_cleanse(&a, sizeof(a));
+    OPENSSL_cleanse(&b, sizeof(b));
+    OPENSSL_cleanse(t, sizeof(t));
+    return ret;
+}
+
+/*
+ * Batch form of the verification shape: for each i < num, x[i] is the affine
+ * x-coordinate, in normal representation, of
+ * g_scalars[i]*G + p_scalars[i]*points[i] on the built-in group. The
+ * Jacobian sums share a single field inversion (Montgomery's trick).
+ * infinity[i] is set where the sum is the point at infinity, x[i] is zero
+ * then. Where |tables| is not NULL and tables[i] is set, it is the comb
+ * table of points[i] and both products use the comb. Not constant-time, all
+ * inputs are public.
+ */
+int ecp_sm2z256_mul_batch_x(const EC_GROUP *group, size_t num,
+                            const BIGNUM *g_scalars[],
+                            const EC_POINT *points[],
+                            const BIGNUM *p_scalars[],
+                            const SM2Z256_POINT_TABLE *const tables[],
+                            BN_ULONG (*x)[P256_LIMBS],
+                            unsigned char *infinity, BN_CTX *ctx)
+{
+    P256_POINT *acc = NULL;
+    BN_ULONG (*prod)[P256_LIMBS] = NULL;
+    BN_ULONG inv[P256_LIMBS], z_inv2[P256_LIMBS], x_aff[P256_LIMBS];
+    BN_ULONG gk[P256_LIMBS], pk[P256_LIMBS];
+    unsigned char p_str[33];
+    ALIGN32 P256_POINT t;
+    size_t i;
+    int ret = 0;
+
+    if (num == 0)
+        return 1;
+
+    acc = OPENSSL_malloc(num * sizeof(*acc));
+    prod = OPENSSL_malloc(num * sizeof(*prod));
+    if (acc == NULL || prod == NULL) {
+        ERR_raise(ERR_LIB_EC, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    /*
+     * acc[i].Z is replaced by Z^2 (or one at infinity, so it does not
+     * cancel the product) and prod[i] is the product of the first i+1.
+     */
+    for (i = 0; i < num; i++) {
+        if (tables != NULL && tables[i] != NULL
+            && !BN_is_negative(g_scalars[i]) && !BN_is_negative(p_scalars[i])
+            && bn_copy_words(gk, g_scalars[i], P256_LIMBS)
+            && bn_copy_words(pk, p_scalars[i], P256_LIMBS)) {
+            ecp_sm2z256_scalar_str(p_str, gk);
+            ecp_sm2z256_mul_g(&acc[i], p_str);
+            ecp_sm2z256_scalar_str(p_str, pk);
+            ecp_sm2z256_mul_g_comb(&t, p_str, tables[i]->rows);
+            ecp_sm2z256_point_add(&acc[i], &acc[i], &t);
+        } else if (!ecp_sm2z256_multi_points_mul(group, &acc[i],
+                                                 SM2Z256_COMB_G_ROW,
+                                                 SM2Z256_COMB_G_ROW_PLAIN,
+                                                 g_scalars[i], points[i],
+                                                 p_scalars[i], ctx)) {
+            goto err;
+        }
+
+        infinity[i] = (unsigned char)is_zero(acc[i].Z[0] | acc[i].Z[1] |
+                                             acc[i].Z[2] | acc[i].Z[3]);
+        if (infinity[i])
+            memcpy(acc[i].Z, ONE, sizeof(ONE));
+        else
+            ecp_sm2z256_sqr_mont(acc[i].Z, acc[i].Z);
+
+        if (i == 0)
+            memcpy(prod[0], acc[0].Z, sizeof(prod[0]));
+        else
+            ecp_sm2z256_mul_mont(prod[i], prod[i - 1], acc[i].Z);
+    }
+
+    /* inv = prod^-1 = prod * prod^-2 */
+    ecp_sm2z256_mod_inverse_sqr(inv, prod[num - 1]);
+    ecp_sm2z256_mul_mont(inv, inv, prod[num - 1]);
+
+    for (i = num; i-- > 0;) {
+        if (i > 0) {
+            ecp_sm2z256_mul_mont(z_inv2, inv, prod[i - 1]);
+            ecp_sm2z256_mul_mont(inv, inv, acc[i].Z);
+        } else {
+            memcpy(z_inv2, inv, sizeof(z_inv2));
+        }
+
+        if (infinity[i]) {
+            memset(x[i], 0, sizeof(x[i]));
+            continue;
+        }
+        ecp_sm2z256_mul_mont(x_aff, z_inv2, acc[i].X);
+        ecp_sm2z256_from_mont(x[i], x_aff);
+    }
+
+    ret = 1;
+
+err:
+    OPENSSL_free(acc);
+    OPENSSL_free(prod);
+    return ret;
+}
 #else
 # define ecp_sm2z256_inv_mod_ord NULL
 #endif
 
+/* The field prime, to range-check encoded coordinates */
+static const BN_ULONG P[P256_LIMBS] = {
+    TOBN(0xffffffff, 0xffffffff), TOBN(0xffffffff, 0x00000000),
+    TOBN(0xffffffff, 0xffffffff), TOBN(0xfffffffe, 0xffffffff)
+};
+
+/*
+ * r = in^((p+1)/4) mod p. As p = 3 mod 4 this is a square root of |in|
+ * whenever |in| is a square, the caller checks that by squaring r. The
+ * exponent is 31 ones, a zero, 128 ones, 31 zeros, a one and 62 zeros,
+ * built from xk = in^(2^k - 1): 254 squarings and 13 multiplications.
+ */
+static void ecp_sm2z256_mod_sqrt(BN_ULONG r[P256_LIMBS],
+                                 const BN_ULONG in[P256_LIMBS])
+{
+    BN_ULONG x2[P256_LIMBS], x6[P256_LIMBS], x32[P256_LIMBS];
+    BN_ULONG t[P256_LIMBS];
+    int i;
+
+    /* x2 = x1<<1 + x1 */
+    ecp_sm2z256_sqr_mont(x2, in);
+    ecp_sm2z256_mul_mont(x2, x2, in);
+    /* x4 = x2<<2 + x2 */
+    ecp_sm2z256_sqr_mont(t, x2);
+    ecp_sm2z256_sqr_mont(t, t);
+    ecp_sm2z256_mul_mont(t, t, x2);
+    /* x6 = x4<<2 + x2 */
+    ecp_sm2z256_sqr_mont(x6, t);
+    ecp_sm2z256_sqr_mont(x6, x6);
+    ecp_sm2z256_mul_mont(x6, x6, x2);
+    /* x12 = x6<<6 + x6 */
+    ecp_sm2z256_sqr_mont(t, x6);
+    for (i = 0; i < 5; i++)
+        ecp_sm2z256_sqr_mont(t, t);
+    ecp_sm2z256_mul_mont(t, t, x6);
+    /* x24 = x12<<12 + x12 */
+    memcpy(x32, t, sizeof(x32));
+    for (i = 0; i < 12; i++)
+        ecp_sm2z256_sqr_mont(t, t);
+    ecp_sm2z256_mul_mont(t, t, x32);
+    /* x30 = x24<<6 + x6 */
+    for (i = 0; i < 6; i++)
+        ecp_sm2z256_sqr_mont(t, t);
+    ecp_sm2z256_mul_mont(t, t, x6);
+    /* x31 = x30<<1 + x1 */
+    ecp_sm2z256_sqr_mont(t, t);
+    ecp_sm2z256_mul_mont(t, t, in);
+    /* x32 = x31<<1 + x1 */
+    ecp_sm2z256_sqr_mont(x32, t);
+    ecp_sm2z256_mul_mont(x32, x32, in);
+
+    /* x31<<33 + x32, then three times <<32 + x32: 31 ones, 0, 128 ones */
+    for (i = 0; i < 33; i++)
+        ecp_sm2z256_sqr_mont(t, t);
+    ecp_sm2z256_mul_mont(t, t, x32);
+    for (i = 0; i < 3 * 32; i++) {
+        ecp_sm2z256_sqr_mont(t, t);
+        if (i % 32 == 31)
+            ecp_sm2z256_mul_mont(t, t, x32);
+    }
+    /* <<32 + x1, <<62 */
+    for (i = 0; i < 32; i++)
+        ecp_sm2z256_sqr_mont(t, t);
+    ecp_sm2z256_mul_mont(t, t, in);
+    for (i = 0; i < 62; i++)
+        ecp_sm2z256_sqr_mont(t, t);
+
+    memcpy(r, t, sizeof(t));
+}
+
+/* r = x^3 - 3*x + b, all in Montgomery form */
+static void ecp_sm2z256_curve_rhs(BN_ULONG r[P256_LIMBS],
+                                  const BN_ULONG x[P256_LIMBS],
+                                  const BN_ULONG b[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS];
+
+    ecp_sm2z256_sqr_mont(r, x);
+    ecp_sm2z256_mul_mont(r, r, x);
+    ecp_sm2z256_mul_by_3(t, x);
+    ecp_sm2z256_sub(r, r, t);
+    ecp_sm2z256_add(r, r, b);
+}
+
+/*
+ * out = |in|, 32 big-endian bytes, in Montgomery form. Returns zero if |in|
+ * is not below p.
+ */
+static int ecp_sm2z256_bin2mont(BN_ULONG out[P256_LIMBS],
+                                const unsigned char in[32])
+{
+    BN_ULONG t[P256_LIMBS] = { 0 };
+    int i;
+
+    for (i = 0; i < 32; i++)
+        t[i / BN_BYTES] |= (BN_ULONG)in[31 - i] << (8 * (i % BN_BYTES));
+
+    for (i = P256_LIMBS - 1; i >= 0 && t[i] == P[i]; i--)
+        continue;
+    if (i < 0 || t[i] > P[i])
+        return 0;
+
+    ecp_sm2z256_to_mont(out, t);
+    return 1;
+}
+
+/*
+ * y = the square root of x^3 - 3*x + b whose normal representation has
+ * parity |y_bit|, all in Montgomery form. Returns zero with an error raised
+ * if x is not the abscissa of a point or no root has that parity.
+ */
+static int ecp_sm2z256_decompress(BN_ULONG y[P256_LIMBS],
+                                  const BN_ULONG x[P256_LIMBS],
+                                  const BN_ULONG b[P256_LIMBS], int y_bit)
+{
+    BN_ULONG rhs[P256_LIMBS], t[P256_LIMBS], y_zero;
+
+    ecp_sm2z256_curve_rhs(rhs, x, b);
+    ecp_sm2z256_mod_sqrt(y, rhs);
+    ecp_sm2z256_sqr_mont(t, y);
+    if (!is_equal(t, rhs)) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_COMPRESSED_POINT);
+        return 0;
+    }
+
+    y_zero = y[0] | y[1] | y[2] | y[3];
+    if (P256_LIMBS == 8)
+        y_zero |= y[4] | y[5] | y[6] | y[7];
+
+    ecp_sm2z256_from_mont(t, y);
+    if ((int)(t[0] & 1) != (y_bit != 0)) {
+        if (is_zero(y_zero)) {
+            ERR_raise(ERR_LIB_EC, EC_R_INVALID_COMPRESSION_BIT);
+            return 0;
+        }
+        ecp_sm2z256_neg(y, y);
+    }
+    return 1;
+}
+
+/* Sets |point| to the affine (x, y), both already in Montgomery form */
+static int ecp_sm2z256_set_affine_mont(EC_POINT *point,
+                                       const BN_ULONG x[P256_LIMBS],
+                                       const BN_ULONG y[P256_LIMBS])
+{
+    if (!bn_set_words(point->X, x, P256_LIMBS)
+        || !bn_set_words(point->Y, y, P256_LIMBS)
+        || !bn_set_words(point->Z, ONE, P256_LIMBS))
+        return 0;
+    point->Z_is_one = 1;
+    return 1;
+}
+
+/*
+ * The encoding, decoding and validation hooks below work on Montgomery limbs
+ * and take square roots through ecp_sm2z256_mod_sqrt. The limb formulae
+ * assume a = -3, which holds on every curve the method is used for, and
+ * defer to the generic code otherwise.
+ */
+static int ecp_sm2z256_is_on_curve(const EC_GROUP *group,
+                                   const EC_POINT *point, BN_CTX *ctx)
+{
+    BN_ULONG x[P256_LIMBS], y[P256_LIMBS], z[P256_LIMBS], b[P256_LIMBS];
+    BN_ULONG z4[P256_LIMBS], z6[P256_LIMBS], lhs[P256_LIMBS];
+    BN_ULONG rhs[P256_LIMBS];
+
+    if (!group->a_is_minus3)
+        return ossl_ec_GFp_simple_is_on_curve(group, point, ctx);
+
+    if (EC_POINT_is_at_infinity(group, point))
+        return 1;
+
+    if (!ecp_sm2z256_bignum_to_field_elem(x, point->X)
+        || !ecp_sm2z256_bignum_to_field_elem(y, point->Y)
+        || !ecp_sm2z256_bignum_to_field_elem(z, point->Z)
+        || !ecp_sm2z256_bignum_to_field_elem(b, group->b)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        return -1;
+    }
+
+    if (point->Z_is_one) {
+        ecp_sm2z256_curve_rhs(rhs, x, b);
+    } else {
+        /* Y^2 = X^3 - 3*X*Z^4 + b*Z^6 */
+        ecp_sm2z256_sqr_mont(z6, z);
+        ecp_sm2z256_sqr_mont(z4, z6);
+        ecp_sm2z256_mul_mont(z6, z6, z4);
+
+        ecp_sm2z256_sqr_mont(rhs, x);
+        ecp_sm2z256_mul_by_3(z4, z4);
+        ecp_sm2z256_sub(rhs, rhs, z4);
+        ecp_sm2z256_mul_mont(rhs, rhs, x);
+        ecp_sm2z256_mul_mont(z6, z6, b);
+        ecp_sm2z256_add(rhs, rhs, z6);
+    }
+    ecp_sm2z256_sqr_mont(lhs, y);
+
+    return (int)is_equal(lhs, rhs);
+}
+
+static int ecp_sm2z256_point_set_affine_coordinates(const EC_GROUP *group,
+                                                    EC_POINT *point,
+                                                    const BIGNUM *x,
+                                                    const BIGNUM *y,
+                                                    BN_CTX *ctx)
+{
+    BN_ULONG xw[P256_LIMBS], yw[P256_LIMBS];
+
+    if (x == NULL || y == NULL) {
+        ERR_raise(ERR_LIB_EC, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+
+    /* This is an unusual input, reduce it the generic way. */
+    if (BN_is_negative(x) || BN_is_negative(y)
+        || BN_ucmp(x, group->field) >= 0 || BN_ucmp(y, group->field) >= 0)
+        return ossl_ec_GFp_simple_point_set_affine_coordinates(group, point,
+                                                               x, y, ctx);
+
+    if (!bn_copy_words(xw, x, P256_LIMBS) || !bn_copy_words(yw, y, P256_LIMBS))
+        return 0;
+    ecp_sm2z256_to_mont(xw, xw);
+    ecp_sm2z256_to_mont(yw, yw);
+
+    return ecp_sm2z256_set_affine_mont(point, xw, yw);
+}
+
+static int ecp_sm2z256_set_compressed_coordinates(const EC_GROUP *group,
+                                                  EC_POINT *point,
+                                                  const BIGNUM *x, int y_bit,
+                                                  BN_CTX *ctx)
+{
+    BN_ULONG xw[P256_LIMBS], yw[P256_LIMBS], b[P256_LIMBS];
+
+    /* This is an unusual input, reduce it the generic way. */
+    if (!group->a_is_minus3 || BN_is_negative(x)
+        || BN_ucmp(x, group->field) >= 0)
+        return ossl_ec_GFp_simple_set_compressed_coordinates(group, point, x,
+                                                             y_bit, ctx);
+
+    if (!bn_copy_words(xw, x, P256_LIMBS)
+        || !ecp_sm2z256_bignum_to_field_elem(b, group->b)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        return 0;
+    }
+    ecp_sm2z256_to_mont(xw, xw);
+
+    return ecp_sm2z256_decompress(yw, xw, b, y_bit)
+        && ecp_sm2z256_set_affine_mont(point, xw, yw);
+}
+
+static size_t ecp_sm2z256_point2oct(const EC_GROUP *group,
+                                    const EC_POINT *point,
+                                    point_conversion_form_t form,
+                                    unsigned char *buf, size_t len,
+                                    BN_CTX *ctx)
+{
+    BN_ULONG x[P256_LIMBS], y[P256_LIMBS], z[P256_LIMBS];
+    BN_ULONG z_inv2[P256_LIMBS], z_inv3[P256_LIMBS];
+    unsigned char y_bin[32];
+    size_t ret;
+
+    if (form != POINT_CONVERSION_COMPRESSED
+        && form != POINT_CONVERSION_UNCOMPRESSED
+        && form != POINT_CONVERSION_HYBRID) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_FORM);
+        return 0;
+    }
+
+    if (EC_POINT_is_at_infinity(group, point)) {
+        /* encodes to a single 0 octet */
+        if (buf != NULL) {
+            if (len < 1) {
+                ERR_raise(ERR_LIB_EC, EC_R_BUFFER_TOO_SMALL);
+                return 0;
+            }
+            buf[0] = 0;
+        }
+        return 1;
+    }
+
+    ret = form == POINT_CONVERSION_COMPRESSED ? 1 + 32 : 1 + 2 * 32;
+    if (buf == NULL)
+        return ret;
+    if (len < ret) {
+        ERR_raise(ERR_LIB_EC, EC_R_BUFFER_TOO_SMALL);
+        return 0;
+    }
+
+    if (!ecp_sm2z256_bignum_to_field_elem(x, point->X)
+        || !ecp_sm2z256_bignum_to_field_elem(y, point->Y)
+        || !ecp_sm2z256_bignum_to_field_elem(z, point->Z)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        return 0;
+    }
+
+    if (!point->Z_is_one) {
+        ecp_sm2z256_mod_inverse_sqr(z_inv2, z);
+        ecp_sm2z256_sqr_mont(z_inv3, z_inv2);
+        ecp_sm2z256_mul_mont(z_inv3, z_inv3, z);
+        ecp_sm2z256_mul_mont(x, x, z_inv2);
+        ecp_sm2z256_mul_mont(y, y, z_inv3);
+    }
+
+    ecp_sm2z256_mont2bin(buf + 1, x);
+    ecp_sm2z256_mont2bin(y_bin, y);
+
+    buf[0] = form;
+    if (form != POINT_CONVERSION_UNCOMPRESSED)
+        buf[0] |= y_bin[31] & 1;
+    if (form != POINT_CONVERSION_COMPRESSED)
+        memcpy(buf + 1 + 32, y_bin, 32);
+
+    return ret;
+}
+
+static int ecp_sm2z256_oct2point(const EC_GROUP *group, EC_POINT *point,
+                                 const unsigned char *buf, size_t len,
+                                 BN_CTX *ctx)
+{
+    point_conversion_form_t form;
+    int y_bit;
+    BN_ULONG x[P256_LIMBS], y[P256_LIMBS], b[P256_LIMBS];
+    BN_ULONG lhs[P256_LIMBS], rhs[P256_LIMBS];
+
+    if (!group->a_is_minus3)
+        return ossl_ec_GFp_simple_oct2point(group, point, buf, len, ctx);
+
+    if (len == 0) {
+        ERR_raise(ERR_LIB_EC, EC_R_BUFFER_TOO_SMALL);
+        return 0;
+    }
+    form = buf[0];
+    y_bit = form & 1;
+    form = form & ~1U;
+    if ((form != 0) && (form != POINT_CONVERSION_COMPRESSED)
+        && (form != POINT_CONVERSION_UNCOMPRESSED)
+        && (form != POINT_CONVERSION_HYBRID)) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_ENCODING);
+        return 0;
+    }
+    if ((form == 0 || form == POINT_CONVERSION_UNCOMPRESSED) && y_bit) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_ENCODING);
+        return 0;
+    }
+
+    if (form == 0) {
+        if (len != 1) {
+            ERR_raise(ERR_LIB_EC, EC_R_INVALID_ENCODING);
+            return 0;
+        }
+
+        return EC_POINT_set_to_infinity(group, point);
+    }
+
+    if (len != (form == POINT_CONVERSION_COMPRESSED ? 1 + 32 : 1 + 2 * 32)
+        || !ecp_sm2z256_bin2mont(x, buf + 1)) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_ENCODING);
+        return 0;
+    }
+    if (!ecp_sm2z256_bignum_to_field_elem(b, group->b)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        return 0;
+    }
+
+    if (form == POINT_CONVERSION_COMPRESSED) {
+        if (!ecp_sm2z256_decompress(y, x, b, y_bit))
+            return 0;
+    } else {
+        if (!ecp_sm2z256_bin2mont(y, buf + 1 + 32)
+            || (form == POINT_CONVERSION_HYBRID
+                && y_bit != (buf[2 * 32] & 1))) {
+            ERR_raise(ERR_LIB_EC, EC_R_INVALID_ENCODING);
+            return 0;
+        }
+
+        ecp_sm2z256_curve_rhs(rhs, x, b);
+        ecp_sm2z256_sqr_mont(lhs, y);
+        if (!is_equal(lhs, rhs)) {
+            ERR_raise(ERR_LIB_EC, EC_R_POINT_IS_NOT_ON_CURVE);
+            return 0;
+        }
+    }
+
+    return ecp_sm2z256_set_affine_mont(point, x, y);
+}
+
+/*
+ * The checks of ossl_ec_key_simple_check_key on native limbs: [n]Q = O
+ * through ecp_sm2z256_point_mul_ct, the curve equation through
+ * ecp_sm2z256_is_on_curve, and on the built-in group dQ = [d]G through the
+ * generator comb, compared in Jacobian form without an inversion. The
+ * coordinates of Q are reduced mod p by construction, so the range check
+ * comes down to their limbs fitting. Error codes are the generic ones.
+ */
+static int ecp_sm2z256_check_key(const EC_KEY *eckey)
+{
+    const EC_GROUP *group;
+    const EC_POINT *pub_key;
+    BN_CTX *ctx = NULL;
+    unsigned char p_str[33];
+    BN_ULONG d[P256_LIMBS];
+    BN_ULONG z1sqr[P256_LIMBS], z2sqr[P256_LIMBS];
+    BN_ULONG u1[P256_LIMBS], u2[P256_LIMBS];
+    ALIGN32 P256_POINT q, r;
+    int ok = 0;
+
+    if (eckey == NULL || eckey->group == NULL || eckey->pub_key == NULL) {
+        ERR_raise(ERR_LIB_EC, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    group = eckey->group;
+    pub_key = eckey->pub_key;
+
+    if (EC_POINT_is_at_infinity(group, pub_key)) {
+        ERR_raise(ERR_LIB_EC, EC_R_POINT_AT_INFINITY);
+        return 0;
+    }
+    if (!ecp_sm2z256_bignum_to_field_elem(q.X, pub_key->X)
+        || !ecp_sm2z256_bignum_to_field_elem(q.Y, pub_key->Y)
+        || !ecp_sm2z256_bignum_to_field_elem(q.Z, pub_key->Z)) {
+        ERR_raise(ERR_LIB_EC, EC_R_COORDINATES_OUT_OF_RANGE);
+        return 0;
+    }
+    if (ecp_sm2z256_is_on_curve(group, pub_key, NULL) <= 0) {
+        ERR_raise(ERR_LIB_EC, EC_R_POINT_IS_NOT_ON_CURVE);
+        return 0;
+    }
+
+    if (BN_is_zero(group->order)) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_GROUP_ORDER);
+        return 0;
+    }
+    if ((ctx = BN_CTX_new_ex(eckey->libctx)) == NULL)
+        return 0;
+    if (!ecp_sm2z256_point_mul_ct(group, &r, group->order, pub_key, ctx)) {
+        ERR_raise(ERR_LIB_EC, ERR_R_EC_LIB);
+        goto err;
+    }
+    if (!ecp_sm2z256_is_infinity(&r)) {
+        ERR_raise(ERR_LIB_EC, EC_R_WRONG_ORDER);
+        goto err;
+    }
+
+    if (eckey->priv_key == NULL) {
+        ok = 1;
+        goto err;
+    }
+    if (!ossl_ec_key_private_check(eckey))
+        goto err;
+    if (!ecp_sm2z256_group_is_builtin(group)) {
+        ok = ossl_ec_key_pairwise_check(eckey, ctx);
+        goto err;
+    }
+
+    /* The private check above leaves d in [1, n-1] */
+    if (!bn_copy_words(d, eckey->priv_key, P256_LIMBS)) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_PRIVATE_KEY);
+        goto err;
+    }
+    ecp_sm2z256_scalar_str(p_str, d);
+    ecp_sm2z256_mul_g(&r, p_str);
+
+    /* r == q iff X1*Z2^2 == X2*Z1^2 and Y1*Z2^3 == Y2*Z1^3 */
+    ecp_sm2z256_sqr_mont(z1sqr, r.Z);
+    ecp_sm2z256_sqr_mont(z2sqr, q.Z);
+    ecp_sm2z256_mul_mont(u1, r.X, z2sqr);
+    ecp_sm2z256_mul_mont(u2, q.X, z1sqr);
+    ok = (int)is_equal(u1, u2);
+    ecp_sm2z256_mul_mont(z2sqr, z2sqr, q.Z);
+    ecp_sm2z256_mul_mont(z1sqr, z1sqr, r.Z);
+    ecp_sm2z256_mul_mont(u1, r.Y, z2sqr);
+    ecp_sm2z256_mul_mont(u2, q.Y, z1sqr);
+    ok &= (int)is_equal(u1, u2);
+    if (!ok)
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_PRIVATE_KEY);
+
+err:
+    OPENSSL_cleanse(p_str, sizeof(p_str));
+    OPENSSL_cleanse(d, sizeof(d));
+    OPENSSL_cleanse(&r, sizeof(r));
+    BN_CTX_free(ctx);
+    return ok;
+}
+
 const EC_METHOD *EC_GFp_sm2z256_method(void)
 {
     static const EC_METHOD ret = {
-        EC_FLAGS_DEFAULT_OCT,
+        0,
         NID_X9_62_prime_field,
         ossl_ec_GFp_mont_group_init,
         ossl_ec_GFp_mont_group_finish,
@@ -1948,14 +3031,16 @@ const EC_METHOD *EC_GFp_sm2z256_method(void)
         ossl_ec_GFp_simple_point_clear_finish,
         ossl_ec_GFp_simple_point_copy,
         ossl_ec_GFp_simple_point_set_to_infinity,
-        ossl_ec_GFp_simple_point_set_affine_coordinates,
+        ecp_sm2z256_point_set_affine_coordinates,
         ecp_sm2z256_get_affine,
-        0, 0, 0,
+        ecp_sm2z256_set_compressed_coordinates,
+        ecp_sm2z256_point2oct,
+        ecp_sm2z256_oct2point,
         ossl_ec_GFp_simple_add,
         ossl_ec_GFp_simple_dbl,
         ossl_ec_GFp_simple_invert,
         ossl_ec_GFp_simple_is_at_infinity,
-        ossl_ec_GFp_simple_is_on_curve,
+        ecp_sm2z256_is_on_curve,
         ossl_ec_GFp_simple_cmp,
         ossl_ec_GFp_simple_make_affine,
         ossl_ec_GFp_simple_points_make_affine,
@@ -1973,7 +3058,7 @@ const EC_METHOD *EC_GFp_sm2z256_method(void)
         ossl_ec_key_simple_oct2priv,
         0, /* set private */
         ossl_ec_key_simple_generate_key,
-        ossl_ec_key_simple_check_key,
+        ecp_sm2z256_check_key,
         ossl_ec_key_simple_generate_public_key,
         0, /* keycopy */
         0, /* keyfinish */
@@ -0,0 +1,530 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Portable 64-bit C implementation of the ecp_sm2z256 primitives, i.e. of
+ * the subroutines that crypto/ec/asm/ecp_sm2z256-*.pl provide. It is used on
+ * targets that have no assembly module, see the ec_sm2z256_64_gcc_128
+ * configuration option, and serves as reference for the assembly modules.
+ *
+ * Field elements are four little-endian 64-bit limbs in the Montgomery
+ * domain, R = 2^256. Reduction modulo
+ *
+ *     p = 2^256 - 2^224 - 2^96 + 2^64 - 1
+ *
+ * takes advantage of p = -1 mod 2^64, so that the Montgomery factor of each
+ * reduction step is the lowest limb itself, and of the sparse form of
+ * (p + 1) / 2^64 = 2^192 - 2^160 - 2^32 + 1, so that adding the multiple of
+ * p is done with shifts, additions and subtractions only. Arithmetic modulo
+ * the group order uses generic word-by-word Montgomery multiplication.
+ *
+ * Everything is constant-time, with the exception of the |rep| count in
+ * ecp_sm2z256_ord_sqr_mont which is public.
+ */
+
+#include <string.h>
+#include <openssl/opensslconf.h>
+#include "internal/numbers.h"
+#include "internal/constant_time.h"
+#include "crypto/bn.h"
+#include "crypto/ec.h"
+#include "ecp_sm2z256_local.h"
+
+#if BN_BITS2 != 64
+# error "ecp_sm2z256_c64.c requires 64-bit BN_ULONG"
+#endif
+#ifndef INT128_MAX
+# error "Your compiler doesn't appear to support 128-bit integer types"
+#endif
+
+typedef uint64_t u64;
+
+#define TOBN(hi,lo)     ((BN_ULONG)hi<<32|lo)
+
+/*
+ * The table of multiples of the generator, see ecp_sm2z256_table.c. With
+ * another comb geometry configured it comes from ecp_sm2z256_comb.h.
+ */
+#ifndef SM2Z256_COMB_TABLE
+# include "ecp_sm2z256_table.c"
+#endif
+
+/* modulus for SM2 */
+static const BN_ULONG poly[P256_LIMBS] = {
+    0xffffffffffffffffULL, 0xffffffff00000000ULL,
+    0xffffffffffffffffULL, 0xfffffffeffffffffULL
+};
+
+/* 2^512 mod P precomputed for SM2 polynomial */
+static const BN_ULONG RR[P256_LIMBS] = {
+    0x0000000200000003ULL, 0x00000002ffffffffULL,
+    0x0000000100000001ULL, 0x0000000400000002ULL
+};
+
+static const BN_ULONG one[P256_LIMBS] = { 1, 0, 0, 0 };
+
+/* order n of sm2 */
+static const BN_ULONG ord[P256_LIMBS] = {
+    0x53bbf40939d54123ULL, 0x7203df6b21c6052bULL,
+    0xffffffffffffffffULL, 0xfffffffeffffffffULL
+};
+
+/* ordK = low 64 bits of -1/ord mod 2^256 */
+static const BN_ULONG ordK = 0x327f9e8872350975ULL;
+
+/*
+ * res = (a - m) if (a_hi:a) >= m, otherwise res = a. |a_hi| is the carry
+ * word of a 257-bit input.
+ */
+static void sub_cond(BN_ULONG res[P256_LIMBS], const BN_ULONG a[P256_LIMBS],
+                     BN_ULONG a_hi, const BN_ULONG m[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS], mask;
+    uint128_t d;
+    u64 borrow = 0;
+    int i;
+
+    for (i = 0; i < P256_LIMBS; i++) {
+        d = (uint128_t)a[i] - m[i] - borrow;
+        t[i] = (u64)d;
+        borrow = (u64)(d >> 64) & 1;
+    }
+    /* borrow out of the carry word means a < m, keep a */
+    borrow = (u64)(((uint128_t)a_hi - borrow) >> 64) & 1;
+    mask = 0 - borrow;
+
+    for (i = 0; i < P256_LIMBS; i++)
+        res[i] = (a[i] & mask) | (t[i] & ~mask);
+}
+
+/* res = a + b mod m, inputs fully reduced */
+static void add_mod(BN_ULONG res[P256_LIMBS], const BN_ULONG a[P256_LIMBS],
+                    const BN_ULONG b[P256_LIMBS], const BN_ULONG m[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS];
+    uint128_t acc = 0;
+    int i;
+
+    for (i = 0; i < P256_LIMBS; i++) {
+        acc += (uint128_t)a[i] + b[i];
+        t[i] = (u64)acc;
+        acc >>= 64;
+    }
+    sub_cond(res, t, (BN_ULONG)acc, m);
+}
+
+/* res = a - b mod m, inputs fully reduced */
+static void sub_mod(BN_ULONG res[P256_LIMBS], const BN_ULONG a[P256_LIMBS],
+                    const BN_ULONG b[P256_LIMBS], const BN_ULONG m[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS], mask;
+    uint128_t d, acc = 0;
+    u64 borrow = 0;
+    int i;
+
+    for (i = 0; i < P256_LIMBS; i++) {
+        d = (uint128_t)a[i] - b[i] - borrow;
+        t[i] = (u64)d;
+        borrow = (u64)(d >> 64) & 1;
+    }
+    /* add the modulus back if subtraction borrowed */
+    mask = 0 - (BN_ULONG)borrow;
+    for (i = 0; i < P256_LIMBS; i++) {
+        acc += (uint128_t)t[i] + (m[i] & mask);
+        res[i] = (u64)acc;
+        acc >>= 64;
+    }
+}
+
+/*
+ * One step of Montgomery reduction modulo p on the six-word accumulator
+ * |acc|: acc = (acc + acc[0] * p) / 2^64.
+ */
+static ossl_inline void sm2z256_reduce_step(u64 acc[6])
+{
+    u64 m = acc[0], lo = m << 32, hi = m >> 32, borrow;
+    uint128_t t;
+
+    /* add m * (2^192 + 1) */
+    t = (uint128_t)acc[1] + m;
+    acc[0] = (u64)t;
+    t = (uint128_t)acc[2] + (u64)(t >> 64);
+    acc[1] = (u64)t;
+    t = (uint128_t)acc[3] + (u64)(t >> 64);
+    acc[2] = (u64)t;
+    t = (uint128_t)acc[4] + m + (u64)(t >> 64);
+    acc[3] = (u64)t;
+    acc[4] = acc[5] + (u64)(t >> 64);
+
+    /* subtract m * (2^160 + 2^32) */
+    t = (uint128_t)acc[0] - lo;
+    acc[0] = (u64)t;
+    borrow = (u64)(t >> 64) & 1;
+    t = (uint128_t)acc[1] - hi - borrow;
+    acc[1] = (u64)t;
+    borrow = (u64)(t >> 64) & 1;
+    t = (uint128_t)acc[2] - lo - borrow;
+    acc[2] = (u64)t;
+    borrow = (u64)(t >> 64) & 1;
+    t = (uint128_t)acc[3] - hi - borrow;
+    acc[3] = (u64)t;
+    borrow = (u64)(t >> 64) & 1;
+    acc[4] -= borrow;
+    acc[5] = 0;
+}
+
+/*
+ * res = t * 2^-256 mod p for a 512-bit |t| < p * 2^256. The low half is
+ * reduced in four steps, giving a value not exceeding p, and the high half,
+ * being smaller than p, is added to it.
+ */
+static void sm2z256_mont_reduce(BN_ULONG res[P256_LIMBS], const u64 t[8])
+{
+    u64 acc[6], r[P256_LIMBS];
+    uint128_t c = 0;
+    int i;
+
+    acc[0] = t[0];
+    acc[1] = t[1];
+    acc[2] = t[2];
+    acc[3] = t[3];
+    acc[4] = 0;
+    acc[5] = 0;
+
+    for (i = 0; i < 4; i++)
+        sm2z256_reduce_step(acc);
+
+    for (i = 0; i < P256_LIMBS; i++) {
+        c += (uint128_t)acc[i] + t[4 + i];
+        r[i] = (u64)c;
+        c >>= 64;
+    }
+    sub_cond(res, r, (BN_ULONG)c, poly);
+}
+
+/* t = a * b, full 512-bit product */
+static void mul_512(u64 t[8], const BN_ULONG a[P256_LIMBS],
+                    const BN_ULONG b[P256_LIMBS])
+{
+    uint128_t acc;
+    u64 carry;
+    int i, j;
+
+    memset(t, 0, 8 * sizeof(u64));
+    for (i = 0; i < P256_LIMBS; i++) {
+        carry = 0;
+        for (j = 0; j < P256_LIMBS; j++) {
+            acc = (uint128_t)a[j] * b[i] + t[i + j] + carry;
+            t[i + j] = (u64)acc;
+            carry = (u64)(acc >> 64);
+        }
+        t[i + P256_LIMBS] = carry;
+    }
+}
+
+/* t = a * a, full 512-bit square */
+static void sqr_512(u64 t[8], const BN_ULONG a[P256_LIMBS])
+{
+    uint128_t acc;
+    u64 carry;
+    int i, j;
+
+    memset(t, 0, 8 * sizeof(u64));
+    /* cross products a[i] * a[j], i < j */
+    for (i = 0; i < P256_LIMBS - 1; i++) {
+        carry = 0;
+        for (j = i + 1; j < P256_LIMBS; j++) {
+            acc = (uint128_t)a[i] * a[j] + t[i + j] + carry;
+            t[i + j] = (u64)acc;
+            carry = (u64)(acc >> 64);
+        }
+        t[i + P256_LIMBS] = carry;
+    }
+    /* double them */
+    carry = 0;
+    for (i = 1; i < 2 * P256_LIMBS; i++) {
+        u64 w = t[i];
+
+        t[i] = (w << 1) | carry;
+        carry = w >> 63;
+    }
+    /* and add the squares a[i] * a[i] */
+    carry = 0;
+    for (i = 0; i < P256_LIMBS; i++) {
+        acc = (uint128_t)a[i] * a[i] + t[2 * i] + carry;
+        t[2 * i] = (u64)acc;
+        acc = (uint128_t)t[2 * i + 1] + (u64)(acc >> 64);
+        t[2 * i + 1] = (u64)acc;
+        carry = (u64)(acc >> 64);
+    }
+}
+
+/* Modular add: res = a+b mod P   */
+void ecp_sm2z256_add(BN_ULONG res[P256_LIMBS],
+                     const BN_ULONG a[P256_LIMBS],
+                     const BN_ULONG b[P256_LIMBS])
+{
+    add_mod(res, a, b, poly);
+}
+
+/* Modular mul by 2: res = 2*a mod P */
+void ecp_sm2z256_mul_by_2(BN_ULONG res[P256_LIMBS],
+                          const BN_ULONG a[P256_LIMBS])
+{
+    add_mod(res, a, a, poly);
+}
+
+/* Modular mul by 3: res = 3*a mod P */
+void ecp_sm2z256_mul_by_3(BN_ULONG res[P256_LIMBS],
+                          const BN_ULONG a[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS];
+
+    add_mod(t, a, a, poly);
+    add_mod(res, t, a, poly);
+}
+
+/* Modular div by 2: res = a/2 mod P */
+void ecp_sm2z256_div_by_2(BN_ULONG res[P256_LIMBS],
+                          const BN_ULONG a[P256_LIMBS])
+{
+    BN_ULONG t[P256_LIMBS], mask = 0 - (a[0] & 1);
+    uint128_t acc = 0;
+    int i;
+
+    /* make it even by adding p if it's odd */
+    for (i = 0; i < P256_LIMBS; i++) {
+        acc += (uint128_t)a[i] + (poly[i] & mask);
+        t[i] = (u64)acc;
+        acc >>= 64;
+    }
+    for (i = 0; i < P256_LIMBS - 1; i++)
+        res[i] = (t[i] >> 1) | (t[i + 1] << 63);
+    res[P256_LIMBS - 1] = (t[P256_LIMBS - 1] >> 1) | ((u64)acc << 63);
+}
+
+/* Modular sub: res = a-b mod P   */
+void ecp_sm2z256_sub(BN_ULONG res[P256_LIMBS],
+                     const BN_ULONG a[P256_LIMBS],
+                     const BN_ULONG b[P256_LIMBS])
+{
+    sub_mod(res, a, b, poly);
+}
+
+/* Modular neg: res = -a mod P    */
+void ecp_sm2z256_neg(BN_ULONG res[P256_LIMBS], const BN_ULONG a[P256_LIMBS])
+{
+    static const BN_ULONG zero[P256_LIMBS] = { 0 };
+
+    sub_mod(res, zero, a, poly);
+}
+
+/* Montgomery mul: res = a*b*2^-256 mod P */
+void ecp_sm2z256_mul_mont(BN_ULONG res[P256_LIMBS],
+                          const BN_ULONG a[P256_LIMBS],
+                          const BN_ULONG b[P256_LIMBS])
+{
+    u64 t[8];
+
+    mul_512(t, a, b);
+    sm2z256_mont_reduce(res, t);
+}
+
+/* Montgomery sqr: res = a*a*2^-256 mod P */
+void ecp_sm2z256_sqr_mont(BN_ULONG res[P256_LIMBS],
+                          const BN_ULONG a[P256_LIMBS])
+{
+    u64 t[8];
+
+    sqr_512(t, a);
+    sm2z256_mont_reduce(res, t);
+}
+
+/* Convert a number from Montgomery domain, by multiplying with 1 */
+void ecp_sm2z256_from_mont(BN_ULONG res[P256_LIMBS],
+                           const BN_ULONG in[P256_LIMBS])
+{
+    ecp_sm2z256_mul_mont(res, in, one);
+}
+
+/* Convert a number to Montgomery domain, by multiplying with 2^512 mod P*/
+void ecp_sm2z256_to_mont(BN_ULONG res[P256_LIMBS],
+                         const BN_ULONG in[P256_LIMBS])
+{
+    ecp_sm2z256_mul_mont(res, in, RR);
+}
+
+/*
+ * Montgomery mul modulo Order(P): res = a*b*2^-256 mod Order(P)
+ */
+void ecp_sm2z256_ord_mul_mont(BN_ULONG res[P256_LIMBS],
+                              const BN_ULONG a[P256_LIMBS],
+                              const BN_ULONG b[P256_LIMBS])
+{
+    u64 acc[P256_LIMBS + 2], m, carry;
+    uint128_t t;
+    int i, j;
+
+    memset(acc, 0, sizeof(acc));
+    for (i = 0; i < P256_LIMBS; i++) {
+        /* acc += a * b[i] */
+        carry = 0;
+        for (j = 0; j < P256_LIMBS; j++) {
+            t = (uint128_t)a[j] * b[i] + acc[j] + carry;
+            acc[j] = (u64)t;
+            carry = (u64)(t >> 64);
+        }
+        t = (uint128_t)acc[P256_LIMBS] + carry;
+        acc[P256_LIMBS] = (u64)t;
+        acc[P256_LIMBS + 1] = (u64)(t >> 64);
+
+        /* acc = (acc + m * ord) / 2^64 */
+        m = acc[0] * ordK;
+        t = (uint128_t)m * ord[0] + acc[0];
+        carry = (u64)(t >> 64);
+        for (j = 1; j < P256_LIMBS; j++) {
+            t = (uint128_t)m * ord[j] + acc[j] + carry;
+            acc[j - 1] = (u64)t;
+            carry = (u64)(t >> 64);
+        }
+        t = (uint128_t)acc[P256_LIMBS] + carry;
+        acc[P256_LIMBS - 1] = (u64)t;
+        acc[P256_LIMBS] = acc[P256_LIMBS + 1] + (u64)(t >> 64);
+    }
+    sub_cond(res, acc, acc[P256_LIMBS], ord);
+}
+
+/* res = a^(2^rep) * 2^-(256*(2^rep-1)) mod Order(P), i.e. |rep| squarings */
+void ecp_sm2z256_ord_sqr_mont(BN_ULONG res[P256_LIMBS],
+                              const BN_ULONG a[P256_LIMBS],
+                              BN_ULONG rep)
+{
+    BN_ULONG t[P256_LIMBS];
+
+    memcpy(t, a, sizeof(t));
+    while (rep-- > 0)
+        ecp_sm2z256_ord_mul_mont(t, t, t);
+    memcpy(res, t, sizeof(t));
+}
+
+/* if a>ord then res=a-ord. else res=a */
+void ecp_sm2z256_ord_sub_reduce(BN_ULONG res[P256_LIMBS],
+                                const BN_ULONG a[P256_LIMBS])
+{
+    sub_cond(res, a, 0, ord);
+}
+
+/* res=order-a suppose a<order */
+void ecp_sm2z256_ord_negative(BN_ULONG res[P256_LIMBS],
+                              const BN_ULONG a[P256_LIMBS])
+{
+    uint128_t d;
+    u64 borrow = 0;
+    int i;
+
+    for (i = 0; i < P256_LIMBS; i++) {
+        d = (uint128_t)ord[i] - a[i] - borrow;
+        res[i] = (u64)d;
+        borrow = (u64)(d >> 64) & 1;
+    }
+}
+
+/* a+=b => if a>ord then res=a-ord. else res=a */
+void ecp_sm2z256_ord_add(BN_ULONG res[P256_LIMBS],
+                         const BN_ULONG a[P256_LIMBS],
+                         const BN_ULONG b[P256_LIMBS])
+{
+    add_mod(res, a, b, ord);
+}
+
+/* res=a-b mod ord */
+void ecp_sm2z256_ord_sub(BN_ULONG res[P256_LIMBS],
+                         const BN_ULONG a[P256_LIMBS],
+                         const BN_ULONG b[P256_LIMBS])
+{
+    sub_mod(res, a, b, ord);
+}
+
+/*
+ * Constant time access to the tables. Unlike the ARMv8 module, which
+ * interleaves table entries byte by byte, the tables are kept as plain
+ * arrays of points and every entry is read on each gather.
+ */
+
+/* table[idx - 1] = *in, idx in [1, 16] */
+void ecp_sm2z256_scatter_w5(P256_POINT *val,
+                            const P256_POINT *in_t, int idx)
+{
+    memcpy(&val[idx - 1], in_t, sizeof(*in_t));
+}
+
+/* *val = table[idx - 1], or the point at infinity if idx == 0 */
+void ecp_sm2z256_gather_w5(P256_POINT *val,
+                           const P256_POINT *in_t, int idx)
+{
+    BN_ULONG *out = (BN_ULONG *)val, mask;
+    const BN_ULONG *in = (const BN_ULONG *)in_t;
+    size_t i, j;
+
+    memset(val, 0, sizeof(*val));
+    for (i = 0; i < 16; i++) {
+        mask = (BN_ULONG)constant_time_eq_s(i + 1, (size_t)idx);
+        for (j = 0; j < 3 * P256_LIMBS; j++)
+            out[j] |= in[j] & mask;
+        in += 3 * P256_LIMBS;
+    }
+}
+
+/* table[idx - 1] = *in, idx in [1, 32] */
+void ecp_sm2z256_scatter_w6(P256_POINT *val,
+                            const P256_POINT *in_t, int idx)
+{
+    memcpy(&val[idx - 1], in_t, sizeof(*in_t));
+}
+
+/* *val = table[idx - 1], or the point at infinity if idx == 0 */
+void ecp_sm2z256_gather_w6(P256_POINT *val,
+                           const P256_POINT *in_t, int idx)
+{
+    BN_ULONG *out = (BN_ULONG *)val, mask;
+    const BN_ULONG *in = (const BN_ULONG *)in_t;
+    size_t i, j;
+
+    memset(val, 0, sizeof(*val));
+    for (i = 0; i < 32; i++) {
+        mask = (BN_ULONG)constant_time_eq_s(i + 1, (size_t)idx);
+        for (j = 0; j < 3 * P256_LIMBS; j++)
+            out[j] |= in[j] & mask;
+        in += 3 * P256_LIMBS;
+    }
+}
+
+/* table[idx] = *in, idx in [0, 63] */
+void ecp_sm2z256_scatter_w7(P256_POINT_AFFINE *val,
+                            const P256_POINT_AFFINE *in_t, int idx)
+{
+    memcpy(&val[idx], in_t, sizeof(*in_t));
+}
+
+/* *val = table[idx - 1], or (0,0) if idx == 0 */
+void ecp_sm2z256_gather_w7(P256_POINT_AFFINE *val,
+                           const P256_POINT_AFFINE *in_t, int idx)
+{
+    BN_ULONG *out = (BN_ULONG *)val, mask;
+    const BN_ULONG *in = (const BN_ULONG *)in_t;
+    size_t i, j;
+
+    memset(val, 0, sizeof(*val));
+    for (i = 0; i < 64; i++) {
+        mask = (BN_ULONG)constant_time_eq_s(i + 1, (size_t)idx);
+        for (j = 0; j < 2 * P256_LIMBS; j++)
+            out[j] |= in[j] & mask;
+        in += 2 * P256_LIMBS;
+    }
+}
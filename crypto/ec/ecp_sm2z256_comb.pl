@@ -0,0 +1,245 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+# Generates the fixed-base comb table of the SM2 generator for the sm2z256
+# method, for the geometry given as the only argument:
+#
+#   w5, w6      Booth-recoded comb with a w-bit window, ceil(257/w) rows of
+#               2^(w-1) points, rows[j][k - 1] = k*2^(w*j)*G.
+#   limlee      Lim-Lee comb with 6 teeth and 4 blocks, 4 rows of 63 points,
+#               rows[s][u - 1] = sum of 2^(44*i + 11*s)*G over the bits i
+#               set in u.
+#
+# w7, the default, is ecp_sm2z256_table.c and is not generated.
+# The generated tables are read with a portable constant-time scan rather
+# than the assembler gather of the default, so they are meant to save
+# memory, not time: a larger window would not be faster than w7. Points are
+# affine, in the Montgomery domain, as four little-endian 64-bit limbs for
+# x followed by four for y.
+
+use strict;
+use warnings;
+
+use FindBin;
+use lib "$FindBin::Bin/../../util/perl";
+use OpenSSL::copyright;
+use Math::BigInt;
+
+my $YEAR = OpenSSL::copyright::year_of($0);
+
+my $geometry = shift @ARGV // '';
+
+my $p = Math::BigInt->from_hex("FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF00000000FFFFFFFFFFFFFFFF");
+my $gx = Math::BigInt->from_hex("32C4AE2C1F1981195F9904466A39C9948FE30BBFF2660BE1715A4589334C74C7");
+my $gy = Math::BigInt->from_hex("BC3736A2F4F6779C59BDCEE36B692153D0A9877CC62A474002DF32E52139F0A0");
+my $mont = Math::BigInt->new(2)->bpow(256)->bmod($p);
+
+sub fmul { return ($_[0] * $_[1]) % $p; }
+sub fsub { return ($_[0] - $_[1]) % $p; }
+
+# Jacobian doubling, a = -3
+sub point_double {
+    my ($x, $y, $z) = @{$_[0]};
+    my $delta = fmul($z, $z);
+    my $gamma = fmul($y, $y);
+    my $beta = fmul($x, $gamma);
+    my $alpha = fmul(3 * fsub($x, $delta), ($x + $delta) % $p);
+    my $x3 = fsub(fmul($alpha, $alpha), 8 * $beta);
+    my $z3 = fsub(fsub(fmul($y + $z, $y + $z), $gamma), $delta);
+    my $y3 = fsub(fmul($alpha, fsub(4 * $beta, $x3)), 8 * fmul($gamma, $gamma));
+
+    return [ $x3, $y3, $z3 ];
+}
+
+# Jacobian addition of two points that are neither equal nor opposite
+sub point_add {
+    my ($x1, $y1, $z1) = @{$_[0]};
+    my ($x2, $y2, $z2) = @{$_[1]};
+    my $z1z1 = fmul($z1, $z1);
+    my $z2z2 = fmul($z2, $z2);
+    my $u1 = fmul($x1, $z2z2);
+    my $u2 = fmul($x2, $z1z1);
+    my $s1 = fmul($y1, fmul($z2, $z2z2));
+    my $s2 = fmul($y2, fmul($z1, $z1z1));
+    my $h = fsub($u2, $u1);
+    my $r = fsub($s2, $s1);
+
+    die "unexpected doubling or infinity in the comb table\n" if $h->is_zero();
+
+    my $hh = fmul($h, $h);
+    my $hhh = fmul($h, $hh);
+    my $v = fmul($u1, $hh);
+    my $x3 = fsub(fsub(fmul($r, $r), $hhh), 2 * $v);
+    my $y3 = fsub(fmul($r, fsub($v, $x3)), fmul($s1, $hhh));
+    my $z3 = fmul($h, fmul($z1, $z2));
+
+    return [ $x3, $y3, $z3 ];
+}
+
+sub point_double_n {
+    my ($pt, $n) = @_;
+
+    $pt = point_double($pt) for 1 .. $n;
+    return $pt;
+}
+
+# Converts all points to affine, sharing one inversion
+sub to_affine {
+    my @pts = @_;
+    my @prod = ($pts[0]->[2]);
+
+    push @prod, fmul($prod[-1], $pts[$_]->[2]) for 1 .. $#pts;
+
+    my $inv = $prod[-1]->copy()->bmodinv($p);
+    my @out;
+
+    for (my $i = $#pts; $i >= 0; $i--) {
+        my $zinv = $i > 0 ? fmul($inv, $prod[$i - 1]) : $inv;
+        my $zinv2 = fmul($zinv, $zinv);
+
+        $inv = fmul($inv, $pts[$i]->[2]) if $i > 0;
+        $out[$i] = [ fmul($pts[$i]->[0], $zinv2),
+                     fmul($pts[$i]->[1], fmul($zinv2, $zinv)) ];
+    }
+    return @out;
+}
+
+# The limbs of |x| in the Montgomery domain as TOBN() words
+sub limbs {
+    my $m = fmul($_[0], $mont);
+    my $hex = substr(("0" x 64) . substr($m->as_hex(), 2), -64);
+    my @out;
+
+    for (my $i = 3; $i >= 0; $i--) {
+        my $limb = substr($hex, 16 * $i, 16);
+
+        push @out, sprintf("TOBN(0x%s, 0x%s)",
+                           substr($limb, 0, 8), substr($limb, 8, 8));
+    }
+    return @out;
+}
+
+sub emit_rows {
+    my ($name, $rows, $entries, @pts) = @_;
+    my $out = "static const BN_ULONG ${name}[$rows][$entries *\n"
+        . " " x (length($name) + 24) . "sizeof(P256_POINT_AFFINE) /\n"
+        . " " x (length($name) + 24) . "sizeof(BN_ULONG)] = {\n";
+
+    for my $j (0 .. $rows - 1) {
+        my @words = map { (limbs($_->[0]), limbs($_->[1])) }
+                    @pts[$j * $entries .. ($j + 1) * $entries - 1];
+
+        $out .= "    {\n";
+        while (my @pair = splice(@words, 0, 2)) {
+            $out .= "     " . join(", ", @pair) . ",\n";
+        }
+        $out .= "    },\n";
+    }
+    return $out . "};\n";
+}
+
+my $g = [ $gx, $gy, Math::BigInt->bone() ];
+my ($defines, @table, @multiples);
+my ($rows, $entries);
+
+if ($geometry =~ /^w([56])$/) {
+    my $w = $1;
+
+    $rows = int(257 / $w) + (257 % $w ? 1 : 0);
+    $entries = 1 << ($w - 1);
+
+    my $base = $g;
+    for my $j (0 .. $rows - 1) {
+        my @row = ($base, point_double($base));
+
+        push @row, point_add($row[-1], $base) for 3 .. $entries;
+        push @table, @row;
+        $base = point_double($row[-1]) if $j < $rows - 1;
+    }
+    $defines = <<"EOF";
+# define SM2Z256_COMB_BOOTH_W   $w
+# define SM2Z256_COMB_ROWS      $rows
+# define SM2Z256_COMB_ENTRIES   $entries
+# define SM2Z256_COMB_G_ROW \\
+    ((const P256_POINT_AFFINE *)ecp_sm2z256_comb_table[0])
+# define SM2Z256_COMB_G_ROW_WNAF ${\($w - 1)}
+EOF
+} elsif ($geometry eq 'limlee') {
+    my ($t, $v) = (6, 4);
+    my $a = int(256 / $t) + (256 % $t ? 1 : 0);
+    my $b = int($a / $v) + ($a % $v ? 1 : 0);
+
+    # Pieces are padded to whole blocks, so that the bit positions
+    # a*i + b*s + k with k < b are all distinct
+    $a = $v * $b;
+
+    $rows = $v;
+    $entries = (1 << $t) - 1;
+    for my $s (0 .. $v - 1) {
+        my @teeth = map { point_double_n($g, $_ * $a + $s * $b) } 0 .. $t - 1;
+        my @row;
+
+        for my $u (1 .. $entries) {
+            my $top = 0;
+
+            $top++ while (2 << $top) <= $u;
+            my $rest = $u - (1 << $top);
+            push @row, $rest ? point_add($row[$rest - 1], $teeth[$top])
+                             : $teeth[$top];
+        }
+        push @table, @row;
+    }
+
+    # The verification kernel wants k*G for k = 1..32, which the Lim-Lee
+    # rows do not hold
+    @multiples = ($g, point_double($g));
+    push @multiples, point_add($multiples[-1], $g) for 3 .. 32;
+
+    $defines = <<"EOF";
+# define SM2Z256_COMB_LIMLEE_T  $t
+# define SM2Z256_COMB_LIMLEE_V  $v
+# define SM2Z256_COMB_LIMLEE_A  $a
+# define SM2Z256_COMB_LIMLEE_B  $b
+# define SM2Z256_COMB_ROWS      $rows
+# define SM2Z256_COMB_ENTRIES   $entries
+# define SM2Z256_COMB_G_ROW \\
+    ((const P256_POINT_AFFINE *)ecp_sm2z256_comb_multiples[0])
+# define SM2Z256_COMB_G_ROW_WNAF 5
+EOF
+} else {
+    die "Usage: $0 w5|w6|limlee\n";
+}
+
+my @affine = to_affine(@table, @multiples);
+my @multiples_affine = splice(@affine, scalar @table);
+
+print <<"EOF";
+/*
+ * WARNING: do not edit!
+ * Generated by crypto/ec/ecp_sm2z256_comb.pl $geometry
+ *
+ * Copyright 2021-$YEAR The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+# define SM2Z256_COMB_NAME      "$geometry"
+$defines
+EOF
+
+print "#if defined(__GNUC__)\n__attribute((aligned(64)))\n#endif\n";
+print emit_rows("ecp_sm2z256_comb_table", $rows, $entries, @affine);
+
+if (@multiples_affine) {
+    print "\n/* k*G for k = 1..32, for the verification kernel */\n";
+    print "#if defined(__GNUC__)\n__attribute((aligned(64)))\n#endif\n";
+    print emit_rows("ecp_sm2z256_comb_multiples", 1, 32, @multiples_affine);
+}
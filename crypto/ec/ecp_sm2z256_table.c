@@ -76,9 +76,9 @@ __declspec(align(4096))
 #elif defined(__SUNPRO_C)
 # pragma align 4096(ecp_sm2z256_precomputed)
 #endif
-static const BN_ULONG ecp_sm2z256_precomputed[37][64 *
-                                                  sizeof(P256_POINT_AFFINE) /
-                                                  sizeof(BN_ULONG)] = {
+const BN_ULONG ecp_sm2z256_precomputed[37][64 *
+                                           sizeof(P256_POINT_AFFINE) /
+                                           sizeof(BN_ULONG)] = {
     {
      TOBN(0x61328990, 0xf418029e), TOBN(0x3e7981ed, 0xdca6c050),
      TOBN(0xd6a1ed99, 0xac24c3c3), TOBN(0x91167a5e, 0xe1c13b05),
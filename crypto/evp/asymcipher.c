@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <openssl/objects.h>
 #include <openssl/evp.h>
+#include <openssl/core_names.h>
 #include "internal/cryptlib.h"
 #include "internal/provider.h"
 #include "internal/core.h"
@@ -276,7 +277,7 @@ static void *evp_asym_cipher_from_algorithm(int name_id,
     const OSSL_DISPATCH *fns = algodef->implementation;
     EVP_ASYM_CIPHER *cipher = NULL;
     int ctxfncnt = 0, encfncnt = 0, decfncnt = 0;
-    int gparamfncnt = 0, sparamfncnt = 0;
+    int gparamfncnt = 0, sparamfncnt = 0, strmfncnt = 0;
 
     if ((cipher = evp_asym_cipher_new(prov)) == NULL) {
         ERR_raise(ERR_LIB_EVP, ERR_R_MALLOC_FAILURE);
@@ -359,6 +360,18 @@ static void *evp_asym_cipher_from_algorithm(int name_id,
                 = OSSL_FUNC_asym_cipher_settable_ctx_params(fns);
             sparamfncnt++;
             break;
+        case OSSL_FUNC_ASYM_CIPHER_STREAM_UPDATE:
+            if (cipher->stream_update != NULL)
+                break;
+            cipher->stream_update = OSSL_FUNC_asym_cipher_stream_update(fns);
+            strmfncnt++;
+            break;
+        case OSSL_FUNC_ASYM_CIPHER_STREAM_FINAL:
+            if (cipher->stream_final != NULL)
+                break;
+            cipher->stream_final = OSSL_FUNC_asym_cipher_stream_final(fns);
+            strmfncnt++;
+            break;
         }
     }
     if (ctxfncnt != 2
@@ -366,7 +379,8 @@ static void *evp_asym_cipher_from_algorithm(int name_id,
         || (decfncnt != 0 && decfncnt != 2)
         || (encfncnt != 2 && decfncnt != 2)
         || (gparamfncnt != 0 && gparamfncnt != 2)
-        || (sparamfncnt != 0 && sparamfncnt != 2)) {
+        || (sparamfncnt != 0 && sparamfncnt != 2)
+        || (strmfncnt != 0 && strmfncnt != 2)) {
         /*
          * In order to be a consistent set of functions we must have at least
          * a set of context functions (newctx and freectx) as well as a pair of
@@ -374,7 +388,8 @@ static void *evp_asym_cipher_from_algorithm(int name_id,
          * (decrypt_init decrypt). set_ctx_params and settable_ctx_params are
          * optional, but if one of them is present then the other one must also
          * be present. The same applies to get_ctx_params and
-         * gettable_ctx_params. The dupctx function is optional.
+         * gettable_ctx_params, and to stream_update and stream_final. The
+         * dupctx function is optional.
          */
         ERR_raise(ERR_LIB_EVP, EVP_R_INVALID_PROVIDER_FUNCTIONS);
         goto err;
@@ -487,3 +502,167 @@ const OSSL_PARAM *EVP_ASYM_CIPHER_settable_ctx_params(const EVP_ASYM_CIPHER *cip
     provctx = ossl_provider_ctx(EVP_ASYM_CIPHER_get0_provider(cip));
     return cip->settable_ctx_params(NULL, provctx);
 }
+
+#if !defined(FIPS_MODULE) && !defined(OPENSSL_NO_SM2)
+/*
+ * Streaming SM2 encryption. The C1 || C3 || C2 message is produced and
+ * consumed through the stream functions of the SM2 asym cipher, with C1 and
+ * C3 passed as operation parameters.
+ */
+struct evp_sm2_stream_ctx_st {
+    EVP_PKEY_CTX *pctx;
+};
+
+EVP_SM2_STREAM_CTX *EVP_SM2_STREAM_CTX_new(void)
+{
+    EVP_SM2_STREAM_CTX *ctx = OPENSSL_zalloc(sizeof(*ctx));
+
+    if (ctx == NULL)
+        ERR_raise(ERR_LIB_EVP, ERR_R_MALLOC_FAILURE);
+    return ctx;
+}
+
+static void sm2_stream_reset(EVP_SM2_STREAM_CTX *ctx)
+{
+    EVP_PKEY_CTX_free(ctx->pctx);
+    ctx->pctx = NULL;
+}
+
+void EVP_SM2_STREAM_CTX_free(EVP_SM2_STREAM_CTX *ctx)
+{
+    if (ctx == NULL)
+        return;
+    sm2_stream_reset(ctx);
+    OPENSSL_free(ctx);
+}
+
+/*
+ * Sets up an encryption or decryption with |pkey|, fetching the cipher from
+ * |libctx| with |propq|. |params| has room for the digest name ahead of the
+ * |nparams| operation parameters it holds.
+ */
+static int sm2_stream_init(EVP_SM2_STREAM_CTX *ctx, OSSL_LIB_CTX *libctx,
+                           EVP_PKEY *pkey, const char *propq,
+                           const EVP_MD *md, int operation,
+                           OSSL_PARAM *params, size_t nparams)
+{
+    int ret;
+
+    sm2_stream_reset(ctx);
+    if (pkey == NULL || !EVP_PKEY_is_a(pkey, "SM2")) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+        return 0;
+    }
+    if (md != NULL)
+        params[nparams++] =
+            OSSL_PARAM_construct_utf8_string(OSSL_ASYM_CIPHER_PARAM_DIGEST,
+                                             (char *)EVP_MD_get0_name(md), 0);
+    params[nparams] = OSSL_PARAM_construct_end();
+
+    if ((ctx->pctx = EVP_PKEY_CTX_new_from_pkey(libctx, pkey, propq)) == NULL)
+        return 0;
+    ret = operation == EVP_PKEY_OP_ENCRYPT
+          ? EVP_PKEY_encrypt_init_ex(ctx->pctx, params)
+          : EVP_PKEY_decrypt_init_ex(ctx->pctx, params);
+    if (ret <= 0)
+        goto err;
+    if (ctx->pctx->op.ciph.algctx == NULL
+            || ctx->pctx->op.ciph.cipher->stream_update == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+        goto err;
+    }
+    return 1;
+
+ err:
+    sm2_stream_reset(ctx);
+    return 0;
+}
+
+int EVP_SM2_STREAM_encrypt_init(EVP_SM2_STREAM_CTX *ctx, OSSL_LIB_CTX *libctx,
+                                EVP_PKEY *pkey, const char *propq,
+                                const EVP_MD *md,
+                                unsigned char *c1, size_t *c1len)
+{
+    OSSL_PARAM params[2];
+
+    if (!sm2_stream_init(ctx, libctx, pkey, propq, md, EVP_PKEY_OP_ENCRYPT,
+                         params, 0))
+        return 0;
+
+    /* Fetching C1 starts the encryption, a NULL |c1| only gets its size */
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_ASYM_CIPHER_PARAM_SM2_C1,
+                                                  c1, c1 == NULL ? 0 : *c1len);
+    params[1] = OSSL_PARAM_construct_end();
+    if (!EVP_PKEY_CTX_get_params(ctx->pctx, params)) {
+        sm2_stream_reset(ctx);
+        return 0;
+    }
+    *c1len = params[0].return_size;
+    if (c1 == NULL)
+        sm2_stream_reset(ctx);
+    return 1;
+}
+
+int EVP_SM2_STREAM_decrypt_init(EVP_SM2_STREAM_CTX *ctx, OSSL_LIB_CTX *libctx,
+                                EVP_PKEY *pkey, const char *propq,
+                                const EVP_MD *md,
+                                const unsigned char *c1, size_t c1len,
+                                const unsigned char *c3, size_t c3len)
+{
+    OSSL_PARAM params[4];
+
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_ASYM_CIPHER_PARAM_SM2_C1,
+                                                  (void *)c1, c1len);
+    params[1] = OSSL_PARAM_construct_octet_string(OSSL_ASYM_CIPHER_PARAM_SM2_C3,
+                                                  (void *)c3, c3len);
+    return sm2_stream_init(ctx, libctx, pkey, propq, md, EVP_PKEY_OP_DECRYPT,
+                           params, 2);
+}
+
+int EVP_SM2_STREAM_update(EVP_SM2_STREAM_CTX *ctx, unsigned char *out,
+                          const unsigned char *in, size_t inlen)
+{
+    if (ctx->pctx == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_OPERATION_NOT_INITIALIZED);
+        return 0;
+    }
+    if (!ctx->pctx->op.ciph.cipher->stream_update(ctx->pctx->op.ciph.algctx,
+                                                  out, in, inlen)) {
+        sm2_stream_reset(ctx);
+        return 0;
+    }
+    return 1;
+}
+
+int EVP_SM2_STREAM_encrypt_final(EVP_SM2_STREAM_CTX *ctx,
+                                 unsigned char *c3, size_t *c3len)
+{
+    int ret;
+
+    if (ctx->pctx == NULL || ctx->pctx->operation != EVP_PKEY_OP_ENCRYPT) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_OPERATION_NOT_INITIALIZED);
+        return 0;
+    }
+    ret = ctx->pctx->op.ciph.cipher->stream_final(ctx->pctx->op.ciph.algctx,
+                                                  c3, c3len,
+                                                  c3 == NULL ? 0 : *c3len);
+    if (c3 != NULL || !ret)
+        sm2_stream_reset(ctx);
+    return ret;
+}
+
+int EVP_SM2_STREAM_decrypt_final(EVP_SM2_STREAM_CTX *ctx)
+{
+    size_t len = 0;
+    int ret;
+
+    if (ctx->pctx == NULL || ctx->pctx->operation != EVP_PKEY_OP_DECRYPT) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_OPERATION_NOT_INITIALIZED);
+        return 0;
+    }
+    ret = ctx->pctx->op.ciph.cipher->stream_final(ctx->pctx->op.ciph.algctx,
+                                                  NULL, &len, 0);
+    sm2_stream_reset(ctx);
+    return ret;
+}
+#endif
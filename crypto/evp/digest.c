@@ -22,6 +22,9 @@
 #include "internal/cryptlib.h"
 #include "internal/provider.h"
 #include "internal/core.h"
+#if !defined(FIPS_MODULE) && !defined(OPENSSL_NO_SM3)
+# include "internal/sm3.h"
+#endif
 #include "crypto/evp.h"
 #include "evp_local.h"
 
@@ -631,6 +634,50 @@ int EVP_Digest(const void *data, size_t count,
     return ret;
 }
 
+#ifndef FIPS_MODULE
+int evp_md_is_default_sm3(const EVP_MD *md)
+{
+    const OSSL_PROVIDER *prov = EVP_MD_get0_provider(md);
+
+    /* Legacy methods and other providers keep their own implementation */
+    return prov != NULL
+        && ossl_provider_dso(prov) == NULL
+        && strcmp(ossl_provider_name(prov), "default") == 0
+        && EVP_MD_is_a(md, "SM3");
+}
+
+int EVP_Digest_batch(size_t num, const void *const data[],
+                     const size_t counts[], unsigned char *const mds[],
+                     const EVP_MD *type)
+{
+    size_t i;
+
+    if (num == 0)
+        return 1;
+    if (data == NULL || counts == NULL || mds == NULL || type == NULL) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+
+# ifndef OPENSSL_NO_SM3
+    /*
+     * SM3 messages are hashed side by side, see ossl_sm3_digest_batch().
+     * That is the default provider's code, so anything else is dispatched.
+     */
+    if (evp_md_is_default_sm3(type)) {
+        ossl_sm3_digest_batch(num, (const unsigned char *const *)data, counts,
+                              mds);
+        return 1;
+    }
+# endif
+
+    for (i = 0; i < num; i++)
+        if (!EVP_Digest(data[i], counts[i], mds[i], NULL, type, NULL))
+            return 0;
+    return 1;
+}
+#endif
+
 int EVP_Q_digest(OSSL_LIB_CTX *libctx, const char *name, const char *propq,
                  const void *data, size_t datalen,
                  unsigned char *md, size_t *mdlen)
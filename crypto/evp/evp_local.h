@@ -185,6 +185,7 @@ struct evp_signature_st {
     OSSL_FUNC_signature_gettable_ctx_md_params_fn *gettable_ctx_md_params;
     OSSL_FUNC_signature_set_ctx_md_params_fn *set_ctx_md_params;
     OSSL_FUNC_signature_settable_ctx_md_params_fn *settable_ctx_md_params;
+    OSSL_FUNC_signature_verify_batch_fn *verify_batch;
 } /* EVP_SIGNATURE */;
 
 struct evp_asym_cipher_st {
@@ -206,6 +207,8 @@ struct evp_asym_cipher_st {
     OSSL_FUNC_asym_cipher_gettable_ctx_params_fn *gettable_ctx_params;
     OSSL_FUNC_asym_cipher_set_ctx_params_fn *set_ctx_params;
     OSSL_FUNC_asym_cipher_settable_ctx_params_fn *settable_ctx_params;
+    OSSL_FUNC_asym_cipher_stream_update_fn *stream_update;
+    OSSL_FUNC_asym_cipher_stream_final_fn *stream_final;
 } /* EVP_ASYM_CIPHER */;
 
 struct evp_kem_st {
@@ -225,6 +225,11 @@ static void *evp_signature_from_algorithm(int name_id,
                 = OSSL_FUNC_signature_settable_ctx_md_params(fns);
             smdparamfncnt++;
             break;
+        case OSSL_FUNC_SIGNATURE_VERIFY_BATCH:
+            if (signature->verify_batch != NULL)
+                break;
+            signature->verify_batch = OSSL_FUNC_signature_verify_batch(fns);
+            break;
         }
     }
     if (ctxfncnt != 2
@@ -246,6 +251,7 @@ static void *evp_signature_from_algorithm(int name_id,
             && signature->digest_sign_init == NULL)
         || (signature->digest_verify != NULL
             && signature->digest_verify_init == NULL)
+        || (signature->verify_batch != NULL && verifyfncnt != 2)
         || (gparamfncnt != 0 && gparamfncnt != 2)
         || (sparamfncnt != 0 && sparamfncnt != 2)
         || (gmdparamfncnt != 0 && gmdparamfncnt != 2)
@@ -638,6 +644,93 @@ int EVP_PKEY_verify(EVP_PKEY_CTX *ctx,
     return ctx->pmeth->verify(ctx, sig, siglen, tbs, tbslen);
 }
 
+#ifndef FIPS_MODULE
+int EVP_PKEY_verify_batch(size_t num, EVP_PKEY *const pkeys[],
+                          const unsigned char *const sigs[],
+                          const size_t siglens[],
+                          const unsigned char *const tbs[],
+                          const size_t tbslens[], unsigned char *results)
+{
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_KEYMGMT *keymgmt;
+    void **keydata = NULL;
+    size_t i;
+    int ok, ret = 0;
+
+    if (num == 0)
+        return 1;
+    if (pkeys == NULL || sigs == NULL || siglens == NULL || tbs == NULL
+            || tbslens == NULL || results == NULL) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    if (num > OPENSSL_MALLOC_MAX_NELEMS(void *)) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    memset(results, 0, (num + 7) / 8);
+
+    /*
+     * If the signature implementation for the first key can verify a batch,
+     * it gets every key of the same type that exports to its key manager.
+     */
+    for (i = 0; i < num && pkeys[i] == NULL; i++)
+        continue;
+    ERR_set_mark();
+    if (i < num)
+        ctx = EVP_PKEY_CTX_new_from_pkey(NULL, pkeys[i], NULL);
+    if (ctx != NULL
+            && EVP_PKEY_verify_init(ctx) > 0
+            && ctx->op.sig.algctx != NULL
+            && ctx->op.sig.signature->verify_batch != NULL) {
+        if ((keydata = OPENSSL_zalloc(num * sizeof(*keydata))) == NULL) {
+            ERR_clear_last_mark();
+            ERR_raise(ERR_LIB_EVP, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
+        for (; i < num; i++) {
+            keymgmt = ctx->keymgmt;
+            if (pkeys[i] != NULL && EVP_PKEY_is_a(pkeys[i], ctx->keytype))
+                keydata[i] = evp_pkey_export_to_provider(pkeys[i],
+                                                         ctx->libctx,
+                                                         &keymgmt,
+                                                         ctx->propquery);
+        }
+        if (!ctx->op.sig.signature->verify_batch(ctx->op.sig.algctx, num,
+                                                 keydata, sigs, siglens,
+                                                 tbs, tbslens, results)) {
+            ERR_clear_last_mark();
+            goto err;
+        }
+    }
+    ERR_pop_to_mark();
+    EVP_PKEY_CTX_free(ctx);
+
+    for (i = 0; i < num; i++) {
+        if (pkeys[i] == NULL || (keydata != NULL && keydata[i] != NULL))
+            continue;
+
+        ERR_set_mark();
+        ctx = EVP_PKEY_CTX_new_from_pkey(NULL, pkeys[i], NULL);
+        ok = ctx != NULL
+            && EVP_PKEY_verify_init(ctx) > 0
+            && EVP_PKEY_verify(ctx, sigs[i], siglens[i], tbs[i],
+                               tbslens[i]) == 1;
+        EVP_PKEY_CTX_free(ctx);
+        ERR_pop_to_mark();
+        if (ok)
+            results[i / 8] |= 1 << (i % 8);
+    }
+    ctx = NULL;
+    ret = 1;
+
+ err:
+    EVP_PKEY_CTX_free(ctx);
+    OPENSSL_free(keydata);
+    return ret;
+}
+#endif
+
 int EVP_PKEY_verify_recover_init(EVP_PKEY_CTX *ctx)
 {
     return evp_pkey_signature_init(ctx, EVP_PKEY_OP_VERIFYRECOVER, NULL);
@@ -159,3 +159,210 @@ int CRYPTO_xts128_encrypt(const XTS128_CONTEXT *ctx,
 
     return 0;
 }
+
+/*
+ * Tweaks are carried as a 128-bit integer in whichever byte order the
+ * standard multiplies by the primitive element in.  IEEE Std 1619 reads
+ * the tweak little-endian and multiplies by x modulo x^128+x^7+x^2+x+1,
+ * GB/T 17964 uses the bit-reflected convention of GHASH, where the same
+ * multiplication is a right shift of the big-endian value.
+ */
+typedef struct {
+    u64 hi, lo;
+} XTS128_TWEAK;
+
+#define XTS128_BATCH_BLOCKS 32
+
+static void xts128_load_tweak(XTS128_TWEAK *t, const u8 *p, int standard)
+{
+    int i;
+
+    t->hi = t->lo = 0;
+    if (standard == XTS128_STANDARD_GB) {
+        for (i = 0; i < 8; i++) {
+            t->hi = (t->hi << 8) | p[i];
+            t->lo = (t->lo << 8) | p[8 + i];
+        }
+    } else {
+        for (i = 7; i >= 0; i--) {
+            t->lo = (t->lo << 8) | p[i];
+            t->hi = (t->hi << 8) | p[8 + i];
+        }
+    }
+}
+
+static void xts128_store_tweak_bytes(u8 *p, const XTS128_TWEAK *t,
+                                     int standard)
+{
+    int i;
+
+    if (standard == XTS128_STANDARD_GB) {
+        for (i = 0; i < 8; i++) {
+            p[i] = (u8)(t->hi >> (56 - 8 * i));
+            p[8 + i] = (u8)(t->lo >> (56 - 8 * i));
+        }
+    } else {
+        for (i = 0; i < 8; i++) {
+            p[i] = (u8)(t->lo >> (8 * i));
+            p[8 + i] = (u8)(t->hi >> (8 * i));
+        }
+    }
+}
+
+static ossl_inline void xts128_store_tweak(u64 *p, const XTS128_TWEAK *t,
+                                           int standard)
+{
+    DECLARE_IS_ENDIAN;
+
+    if (standard == XTS128_STANDARD_GB) {
+        if (IS_LITTLE_ENDIAN) {
+#ifdef BSWAP8
+            p[0] = BSWAP8(t->hi);
+            p[1] = BSWAP8(t->lo);
+            return;
+#endif
+        } else {
+            p[0] = t->hi;
+            p[1] = t->lo;
+            return;
+        }
+    } else if (IS_LITTLE_ENDIAN) {
+        p[0] = t->lo;
+        p[1] = t->hi;
+        return;
+    }
+    xts128_store_tweak_bytes((u8 *)p, t, standard);
+}
+
+static ossl_inline void xts128_next_tweak(XTS128_TWEAK *t, int standard)
+{
+    u64 mask;
+
+    if (standard == XTS128_STANDARD_GB) {
+        mask = 0 - (t->lo & 1);
+        t->lo = (t->lo >> 1) | (t->hi << 63);
+        t->hi = (t->hi >> 1) ^ (mask & ((u64)0xe1 << 56));
+    } else {
+        mask = 0 - (t->hi >> 63);
+        t->hi = (t->hi << 1) | (t->lo >> 63);
+        t->lo = (t->lo << 1) ^ (mask & 0x87);
+    }
+}
+
+/* out = inp ^ tweaks for |n| blocks, |out| may be equal to |inp| */
+static void xts128_xor(unsigned char *out, const unsigned char *inp,
+                       const u64 *tweaks, size_t n)
+{
+    size_t i;
+#if defined(STRICT_ALIGNMENT)
+    u64 a, b;
+
+    for (i = 0; i < n; i++, inp += 16, out += 16, tweaks += 2) {
+        memcpy(&a, inp, 8);
+        memcpy(&b, inp + 8, 8);
+        a ^= tweaks[0];
+        b ^= tweaks[1];
+        memcpy(out, &a, 8);
+        memcpy(out + 8, &b, 8);
+    }
+#else
+    for (i = 0; i < n; i++, inp += 16, out += 16, tweaks += 2) {
+        ((u64_a1 *)out)[0] = ((const u64_a1 *)inp)[0] ^ tweaks[0];
+        ((u64_a1 *)out)[1] = ((const u64_a1 *)inp)[1] ^ tweaks[1];
+    }
+#endif
+}
+
+/*
+ * Same as CRYPTO_xts128_encrypt(), but the whole blocks are handed to
+ * |ecb| up to XTS128_BATCH_BLOCKS at a time: the tweaks for a batch are
+ * generated up front, the data is whitened with them in |out| and then
+ * encrypted in place, so a multi-block cipher kernel runs at full width.
+ * ctx->block1 is only used for the ciphertext stealing tail.
+ */
+int ossl_crypto_xts128_encrypt_blocks(const XTS128_CONTEXT *ctx,
+                                      const unsigned char iv[16],
+                                      const unsigned char *inp,
+                                      unsigned char *out, size_t len,
+                                      int enc, int standard, ecb128_f ecb)
+{
+    union {
+        u64 u[2 * XTS128_BATCH_BLOCKS];
+        u8 c[16 * XTS128_BATCH_BLOCKS];
+    } tweaks;
+    union {
+        u64 u[2];
+        u8 c[16];
+    } tweak, tweak1, scratch;
+    XTS128_TWEAK t;
+    size_t blocks, n, i, tail = len % 16;
+
+    if (len < 16)
+        return -1;
+
+    memcpy(scratch.c, iv, 16);
+    (*ctx->block2) (scratch.c, scratch.c, ctx->key2);
+    xts128_load_tweak(&t, scratch.c, standard);
+
+    blocks = len / 16;
+    if (!enc && tail != 0)
+        blocks--;
+
+    while (blocks > 0) {
+        n = blocks < XTS128_BATCH_BLOCKS ? blocks : XTS128_BATCH_BLOCKS;
+        for (i = 0; i < n; i++) {
+            xts128_store_tweak(tweaks.u + 2 * i, &t, standard);
+            xts128_next_tweak(&t, standard);
+        }
+        xts128_xor(out, inp, tweaks.u, n);
+        (*ecb) (out, out, 16 * n, ctx->key1, enc);
+        xts128_xor(out, out, tweaks.u, n);
+        inp += 16 * n;
+        out += 16 * n;
+        blocks -= n;
+    }
+
+    if (tail == 0)
+        return 0;
+
+    /* |t| is now the tweak of the block that follows the whole ones */
+    xts128_store_tweak(tweak.u, &t, standard);
+    if (enc) {
+        memcpy(scratch.c, out - 16, 16);
+        for (i = 0; i < tail; ++i) {
+            u8 c = inp[i];
+            out[i] = scratch.c[i];
+            scratch.c[i] = c;
+        }
+        scratch.u[0] ^= tweak.u[0];
+        scratch.u[1] ^= tweak.u[1];
+        (*ctx->block1) (scratch.c, scratch.c, ctx->key1);
+        scratch.u[0] ^= tweak.u[0];
+        scratch.u[1] ^= tweak.u[1];
+        memcpy(out - 16, scratch.c, 16);
+    } else {
+        xts128_next_tweak(&t, standard);
+        xts128_store_tweak(tweak1.u, &t, standard);
+
+        memcpy(scratch.c, inp, 16);
+        scratch.u[0] ^= tweak1.u[0];
+        scratch.u[1] ^= tweak1.u[1];
+        (*ctx->block1) (scratch.c, scratch.c, ctx->key1);
+        scratch.u[0] ^= tweak1.u[0];
+        scratch.u[1] ^= tweak1.u[1];
+
+        for (i = 0; i < tail; ++i) {
+            u8 c = inp[16 + i];
+            out[16 + i] = scratch.c[i];
+            scratch.c[i] = c;
+        }
+        scratch.u[0] ^= tweak.u[0];
+        scratch.u[1] ^= tweak.u[1];
+        (*ctx->block1) (scratch.c, scratch.c, ctx->key1);
+        scratch.u[0] ^= tweak.u[0];
+        scratch.u[1] ^= tweak.u[1];
+        memcpy(out, scratch.c, 16);
+    }
+
+    return 0;
+}
@@ -18,6 +18,9 @@
 #include "crypto/sm2.h"
 #include "crypto/sm2err.h"
 #include "crypto/ec.h" /* ossl_ecdh_kdf_X9_63() */
+#include "crypto/evp.h" /* evp_md_is_default_sm3() */
+#include "internal/numbers.h"
+#include "internal/sm3.h"
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/bn.h>
@@ -67,6 +70,67 @@ static size_t ec_field_size(const EC_GROUP *group)
     return field_size;
 }
 
+/*
+ * Counter blocks per ossl_sm3_digest_batch() call, and the largest Z: x2 || y2
+ * for encryption, xU || yU || ZA || ZB for the key exchange
+ */
+#define SM2_KDF_BATCH   16
+#define SM2_KDF_MAX_Z   (2 * 66)
+
+/*
+ * The SM2 KDF, X9.63 with no shared info, shared with sm2_exch.c. The blocks
+ * H(Z || ct) are independent messages, so with the default provider's SM3
+ * they are hashed side by side.
+ */
+int ossl_sm2_kdf(unsigned char *out, size_t outlen,
+                 const unsigned char *z, size_t zlen, const EVP_MD *digest,
+                 OSSL_LIB_CTX *libctx, const char *propq)
+{
+    unsigned char buf[SM2_KDF_BATCH][SM2_KDF_MAX_Z + 4];
+    unsigned char last[SM3_DIGEST_LENGTH];
+    const unsigned char *in[SM2_KDF_BATCH];
+    size_t inlen[SM2_KDF_BATCH];
+    unsigned char *md[SM2_KDF_BATCH];
+    uint32_t ctr = 1;
+    size_t i, n, len;
+
+    if (!evp_md_is_default_sm3(digest) || zlen > SM2_KDF_MAX_Z)
+        return ossl_ecdh_kdf_X9_63(out, outlen, z, zlen, NULL, 0, digest,
+                                   libctx, propq);
+
+    for (i = 0; i < SM2_KDF_BATCH; i++) {
+        memcpy(buf[i], z, zlen);
+        in[i] = buf[i];
+        inlen[i] = zlen + 4;
+    }
+    while (outlen > 0) {
+        n = (outlen + SM3_DIGEST_LENGTH - 1) / SM3_DIGEST_LENGTH;
+        if (n > SM2_KDF_BATCH)
+            n = SM2_KDF_BATCH;
+        for (i = 0; i < n; i++, ctr++) {
+            buf[i][zlen] = (unsigned char)(ctr >> 24);
+            buf[i][zlen + 1] = (unsigned char)(ctr >> 16);
+            buf[i][zlen + 2] = (unsigned char)(ctr >> 8);
+            buf[i][zlen + 3] = (unsigned char)ctr;
+            md[i] = outlen >= (i + 1) * SM3_DIGEST_LENGTH
+                    ? out + i * SM3_DIGEST_LENGTH : last;
+        }
+        ossl_sm3_digest_batch(n, in, inlen, md);
+        len = n * SM3_DIGEST_LENGTH;
+        if (len > outlen) {
+            memcpy(out + len - SM3_DIGEST_LENGTH, last,
+                   outlen - (len - SM3_DIGEST_LENGTH));
+            len = outlen;
+        }
+        out += len;
+        outlen -= len;
+    }
+
+    OPENSSL_cleanse(buf, sizeof(buf));
+    OPENSSL_cleanse(last, sizeof(last));
+    return 1;
+}
+
 int ossl_sm2_plaintext_size(const EC_KEY *key, const EVP_MD *digest,
                             size_t msg_len, size_t *pt_size)
 {
@@ -113,6 +177,147 @@ int ossl_sm2_ciphertext_size(const EC_KEY *key, const EVP_MD *digest,
     return 1;
 }
 
+#ifdef ECP_SM2Z256_ASM
+/*
+ * Writes the DER INTEGER holding the 32-byte big-endian |in| to |*pp| if
+ * |pp| is not NULL and returns its content length.
+ */
+static int sm2z256_encode_integer(unsigned char **pp,
+                                  const unsigned char in[32])
+{
+    int skip = 0, pad, len;
+
+    while (skip < 31 && in[skip] == 0)
+        skip++;
+    pad = in[skip] >> 7;
+    len = pad + 32 - skip;
+    if (pp != NULL) {
+        ASN1_put_object(pp, 0, len, V_ASN1_INTEGER, V_ASN1_UNIVERSAL);
+        if (pad)
+            *(*pp)++ = 0;
+        memcpy(*pp, in + skip, 32 - skip);
+        *pp += 32 - skip;
+    }
+    return len;
+}
+
+/*
+ * Encryption on the built-in curve: C1 and (x2, y2) come out of one call
+ * sharing a single inversion, k*PB going through the comb table of the key
+ * once it has one, and the DER form of C1 || C3 || C2 is written
+ * straight into |ciphertext_buf|, C3 hashed and C2 masked in place. As with
+ * i2d_SM2_Ciphertext() below, the buffer is assumed to hold
+ * ossl_sm2_ciphertext_size() bytes.
+ */
+static int sm2z256_encrypt(const EC_KEY *key, const EVP_MD *digest,
+                           const uint8_t *msg, size_t msg_len,
+                           uint8_t *ciphertext_buf, size_t *ciphertext_len)
+{
+    int rc = 0, clen, total;
+    size_t i;
+    BN_CTX *ctx = NULL;
+    BIGNUM *k = NULL;
+    EVP_MD_CTX *hash = NULL;
+    EVP_MD *fetched_digest = NULL;
+    const EC_GROUP *group = EC_KEY_get0_group(key);
+    const int C3_size = EVP_MD_get_size(digest);
+    unsigned char c1[64], x2y2[64];
+    unsigned char *p = ciphertext_buf;
+    OSSL_LIB_CTX *libctx = ossl_ec_key_get_libctx(key);
+    const char *propq = ossl_ec_key_get0_propq(key);
+
+    if (C3_size <= 0 || msg_len > INT_MAX) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    hash = EVP_MD_CTX_new();
+    ctx = BN_CTX_new_ex(libctx);
+    if (hash == NULL || ctx == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        goto done;
+    }
+
+    BN_CTX_start(ctx);
+    if ((k = BN_CTX_get(ctx)) == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+        goto done;
+    }
+
+    memset(ciphertext_buf, 0, *ciphertext_len);
+
+    if (!BN_priv_rand_range_ex(k, EC_GROUP_get0_order(group), 0, ctx)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        goto done;
+    }
+
+    if (!ecp_sm2z256_encrypt_points(group, c1, x2y2, k,
+                                    EC_KEY_get0_public_key(key),
+                                    ossl_ec_key_sm2z256_pub_table(key),
+                                    ctx)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+        goto done;
+    }
+
+    clen = ASN1_object_size(0, sm2z256_encode_integer(NULL, c1),
+                            V_ASN1_INTEGER)
+           + ASN1_object_size(0, sm2z256_encode_integer(NULL, c1 + 32),
+                              V_ASN1_INTEGER)
+           + ASN1_object_size(0, C3_size, V_ASN1_OCTET_STRING);
+    total = ASN1_object_size(0, (int)msg_len, V_ASN1_OCTET_STRING);
+    if (total < 0 || clen > INT_MAX - total
+            || (total = ASN1_object_size(1, clen + total,
+                                         V_ASN1_SEQUENCE)) < 0) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        goto done;
+    }
+    ASN1_put_object(&p, 1, clen + ASN1_object_size(0, (int)msg_len,
+                                                  V_ASN1_OCTET_STRING),
+                    V_ASN1_SEQUENCE, V_ASN1_UNIVERSAL);
+    sm2z256_encode_integer(&p, c1);
+    sm2z256_encode_integer(&p, c1 + 32);
+
+    fetched_digest = EVP_MD_fetch(libctx, EVP_MD_get0_name(digest), propq);
+    if (fetched_digest == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        goto done;
+    }
+    ASN1_put_object(&p, 0, C3_size, V_ASN1_OCTET_STRING, V_ASN1_UNIVERSAL);
+    if (EVP_DigestInit(hash, fetched_digest) == 0
+            || EVP_DigestUpdate(hash, x2y2, 32) == 0
+            || EVP_DigestUpdate(hash, msg, msg_len) == 0
+            || EVP_DigestUpdate(hash, x2y2 + 32, 32) == 0
+            || EVP_DigestFinal(hash, p, NULL) == 0) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        goto done;
+    }
+    p += C3_size;
+
+    /* X9.63 with no salt happens to match the KDF used in SM2 */
+    ASN1_put_object(&p, 0, (int)msg_len, V_ASN1_OCTET_STRING,
+                    V_ASN1_UNIVERSAL);
+    if (!ossl_sm2_kdf(p, msg_len, x2y2, sizeof(x2y2), digest, libctx, propq)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        goto done;
+    }
+    for (i = 0; i != msg_len; ++i)
+        p[i] ^= msg[i];
+
+    *ciphertext_len = (size_t)total;
+    rc = 1;
+
+ done:
+    if (rc == 0)
+        OPENSSL_cleanse(ciphertext_buf, *ciphertext_len);
+    OPENSSL_cleanse(x2y2, sizeof(x2y2));
+    EVP_MD_free(fetched_digest);
+    EVP_MD_CTX_free(hash);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    return rc;
+}
+#endif
+
 int ossl_sm2_encrypt(const EC_KEY *key,
                      const EVP_MD *digest,
                      const uint8_t *msg, size_t msg_len,
@@ -126,7 +331,7 @@ int ossl_sm2_encrypt(const EC_KEY *key,
     BIGNUM *y1 = NULL;
     BIGNUM *x2 = NULL;
     BIGNUM *y2 = NULL;
-    EVP_MD_CTX *hash = EVP_MD_CTX_new();
+    EVP_MD_CTX *hash = NULL;
     struct SM2_Ciphertext_st ctext_struct;
     const EC_GROUP *group = EC_KEY_get0_group(key);
     const BIGNUM *order = EC_GROUP_get0_order(group);
@@ -142,10 +347,17 @@ int ossl_sm2_encrypt(const EC_KEY *key,
     OSSL_LIB_CTX *libctx = ossl_ec_key_get_libctx(key);
     const char *propq = ossl_ec_key_get0_propq(key);
 
+#ifdef ECP_SM2Z256_ASM
+    if (ecp_sm2z256_group_is_builtin(group) && P != NULL)
+        return sm2z256_encrypt(key, digest, msg, msg_len, ciphertext_buf,
+                               ciphertext_len);
+#endif
+
     /* NULL these before any "goto done" */
     ctext_struct.C2 = NULL;
     ctext_struct.C3 = NULL;
 
+    hash = EVP_MD_CTX_new();
     if (hash == NULL || C3_size <= 0) {
         ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
         goto done;
@@ -213,8 +425,8 @@ int ossl_sm2_encrypt(const EC_KEY *key,
    }
 
     /* X9.63 with no salt happens to match the KDF used in SM2 */
-    if (!ossl_ecdh_kdf_X9_63(msg_mask, msg_len, x2y2, 2 * field_size, NULL, 0,
-                             digest, libctx, propq)) {
+    if (!ossl_sm2_kdf(msg_mask, msg_len, x2y2, 2 * field_size, digest, libctx,
+                      propq)) {
         ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
         goto done;
     }
@@ -292,7 +504,6 @@ int ossl_sm2_decrypt(const EC_KEY *key,
     uint8_t *computed_C3 = NULL;
     const size_t field_size = ec_field_size(group);
     const int hash_size = EVP_MD_get_size(digest);
-    uint8_t *msg_mask = NULL;
     const uint8_t *C2 = NULL;
     const uint8_t *C3 = NULL;
     int msg_len = 0;
@@ -336,11 +547,10 @@ int ossl_sm2_decrypt(const EC_KEY *key,
         goto done;
     }
 
-    msg_mask = OPENSSL_zalloc(msg_len);
     x2y2 = OPENSSL_zalloc(2 * field_size);
     computed_C3 = OPENSSL_zalloc(hash_size);
 
-    if (msg_mask == NULL || x2y2 == NULL || computed_C3 == NULL) {
+    if (x2y2 == NULL || computed_C3 == NULL) {
         ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
         goto done;
     }
@@ -362,14 +572,15 @@ int ossl_sm2_decrypt(const EC_KEY *key,
 
     if (BN_bn2binpad(x2, x2y2, field_size) < 0
             || BN_bn2binpad(y2, x2y2 + field_size, field_size) < 0
-            || !ossl_ecdh_kdf_X9_63(msg_mask, msg_len, x2y2, 2 * field_size,
-                                    NULL, 0, digest, libctx, propq)) {
+            || !ossl_sm2_kdf(ptext_buf, msg_len, x2y2, 2 * field_size, digest,
+                             libctx, propq)) {
         ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
         goto done;
     }
 
+    /* the KDF output in ptext_buf is the mask, apply it in place */
     for (i = 0; i != msg_len; ++i)
-        ptext_buf[i] = C2[i] ^ msg_mask[i];
+        ptext_buf[i] ^= C2[i];
 
     hash = EVP_MD_CTX_new();
     if (hash == NULL) {
@@ -398,8 +609,7 @@ int ossl_sm2_decrypt(const EC_KEY *key,
     if (rc == 0)
         memset(ptext_buf, 0, *ptext_len);
 
-    OPENSSL_free(msg_mask);
-    OPENSSL_free(x2y2);
+    OPENSSL_clear_free(x2y2, 2 * field_size);
     OPENSSL_free(computed_C3);
     EC_POINT_free(C1);
     BN_CTX_free(ctx);
@@ -408,3 +618,389 @@ int ossl_sm2_decrypt(const EC_KEY *key,
 
     return rc;
 }
+
+/*
+ * Streaming SM2 encryption and decryption in the raw C1 || C3 || C2 layout
+ * of GM/T 0003-2012. C1 is the uncompressed point kG, C2 is as long as the
+ * message. The KDF keystream and C3 are computed as the data passes
+ * through, so the message never has to be in memory as a whole. The SM2
+ * asym cipher of the default provider drives this for EVP_SM2_STREAM_*().
+ */
+#define SM2_MAX_FIELD_SIZE ((SM2_STREAM_MAX_C1 - 1) / 2)
+
+struct sm2_stream_st {
+    int enc;
+    EVP_MD *md;
+    /* digest state after absorbing x2 || y2, the KDF blocks start here */
+    EVP_MD_CTX *kdf_z;
+    EVP_MD_CTX *kdf;
+    /* H(x2 || M || y2) up to the data seen so far */
+    EVP_MD_CTX *c3;
+    unsigned char y2[SM2_MAX_FIELD_SIZE];
+    size_t field_size;
+    /* current keystream block, block_used bytes of it consumed */
+    unsigned char block[EVP_MAX_MD_SIZE];
+    size_t block_len;
+    size_t block_used;
+    uint32_t counter;
+    unsigned char expected_c3[EVP_MAX_MD_SIZE];
+};
+
+SM2_STREAM *ossl_sm2_stream_new(void)
+{
+    SM2_STREAM *ctx = OPENSSL_zalloc(sizeof(*ctx));
+
+    if (ctx == NULL)
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+    return ctx;
+}
+
+static void sm2_stream_reset(SM2_STREAM *ctx)
+{
+    EVP_MD_free(ctx->md);
+    EVP_MD_CTX_free(ctx->kdf_z);
+    EVP_MD_CTX_free(ctx->kdf);
+    EVP_MD_CTX_free(ctx->c3);
+    OPENSSL_cleanse(ctx, sizeof(*ctx));
+}
+
+void ossl_sm2_stream_free(SM2_STREAM *ctx)
+{
+    if (ctx == NULL)
+        return;
+    sm2_stream_reset(ctx);
+    OPENSSL_free(ctx);
+}
+
+int ossl_sm2_stream_active(const SM2_STREAM *ctx)
+{
+    return ctx->c3 != NULL;
+}
+
+static int sm2_stream_field_size(const EC_KEY *key, size_t *field_size)
+{
+    if (EC_KEY_get0_group(key) == NULL) {
+        ERR_raise(ERR_LIB_EC, EC_R_MISSING_PARAMETERS);
+        return 0;
+    }
+    *field_size = ec_field_size(EC_KEY_get0_group(key));
+    if (*field_size == 0 || *field_size > SM2_MAX_FIELD_SIZE) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_FIELD);
+        return 0;
+    }
+    return 1;
+}
+
+/* Keys the KDF and the C3 digest with x2y2 = x2 || y2 */
+static int sm2_stream_start(SM2_STREAM *ctx, const EC_KEY *key,
+                            const EVP_MD *md, const unsigned char *x2y2,
+                            size_t field_size, int enc)
+{
+    int md_size;
+
+    ctx->md = EVP_MD_fetch(ossl_ec_key_get_libctx(key), EVP_MD_get0_name(md),
+                           ossl_ec_key_get0_propq(key));
+    if (ctx->md == NULL || (md_size = EVP_MD_get_size(ctx->md)) <= 0) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_DIGEST);
+        return 0;
+    }
+
+    ctx->kdf_z = EVP_MD_CTX_new();
+    ctx->kdf = EVP_MD_CTX_new();
+    ctx->c3 = EVP_MD_CTX_new();
+    if (ctx->kdf_z == NULL || ctx->kdf == NULL || ctx->c3 == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    if (!EVP_DigestInit_ex(ctx->kdf_z, ctx->md, NULL)
+            || !EVP_DigestUpdate(ctx->kdf_z, x2y2, 2 * field_size)
+            || !EVP_DigestInit_ex(ctx->c3, ctx->md, NULL)
+            || !EVP_DigestUpdate(ctx->c3, x2y2, field_size)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        return 0;
+    }
+
+    memcpy(ctx->y2, x2y2 + field_size, field_size);
+    ctx->field_size = field_size;
+    ctx->block_len = ctx->block_used = (size_t)md_size;
+    ctx->counter = 1;
+    ctx->enc = enc;
+    return 1;
+}
+
+int ossl_sm2_stream_encrypt_init(SM2_STREAM *ctx, const EC_KEY *key,
+                                 const EVP_MD *md,
+                                 unsigned char *c1, size_t *c1len)
+{
+    int rc = 0;
+    size_t field_size;
+    const EC_GROUP *group;
+    const EC_POINT *P;
+    BN_CTX *bnctx = NULL;
+    BIGNUM *k, *x2, *y2;
+    EC_POINT *kG = NULL;
+    EC_POINT *kP = NULL;
+    unsigned char x2y2[2 * SM2_MAX_FIELD_SIZE];
+
+    sm2_stream_reset(ctx);
+    if (!sm2_stream_field_size(key, &field_size))
+        return 0;
+    if (c1 == NULL) {
+        *c1len = 1 + 2 * field_size;
+        return 1;
+    }
+    if (*c1len < 1 + 2 * field_size) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_BUFFER_TOO_SMALL);
+        return 0;
+    }
+    group = EC_KEY_get0_group(key);
+    if ((P = EC_KEY_get0_public_key(key)) == NULL) {
+        ERR_raise(ERR_LIB_EC, EC_R_INVALID_KEY);
+        return 0;
+    }
+    if (md == NULL)
+        md = EVP_sm3();
+
+    bnctx = BN_CTX_new_ex(ossl_ec_key_get_libctx(key));
+    if (bnctx == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        goto done;
+    }
+    BN_CTX_start(bnctx);
+    k = BN_CTX_get(bnctx);
+    x2 = BN_CTX_get(bnctx);
+    y2 = BN_CTX_get(bnctx);
+    if (y2 == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+        goto done;
+    }
+
+    if (!BN_priv_rand_range_ex(k, EC_GROUP_get0_order(group), 0, bnctx)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        goto done;
+    }
+
+#ifdef ECP_SM2Z256_ASM
+    if (ecp_sm2z256_group_is_builtin(group)) {
+        c1[0] = POINT_CONVERSION_UNCOMPRESSED;
+        if (!ecp_sm2z256_encrypt_points(group, c1 + 1, x2y2, k, P,
+                                        ossl_ec_key_sm2z256_pub_table(key),
+                                        bnctx)) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+            goto done;
+        }
+    } else
+#endif
+    {
+        kG = EC_POINT_new(group);
+        kP = EC_POINT_new(group);
+        if (kG == NULL || kP == NULL) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+            goto done;
+        }
+        if (!EC_POINT_mul(group, kG, k, NULL, NULL, bnctx)
+                || EC_POINT_point2oct(group, kG, POINT_CONVERSION_UNCOMPRESSED,
+                                      c1, 1 + 2 * field_size, bnctx)
+                   != 1 + 2 * field_size
+                || !EC_POINT_mul(group, kP, NULL, P, k, bnctx)
+                || !EC_POINT_get_affine_coordinates(group, kP, x2, y2, bnctx)
+                || BN_bn2binpad(x2, x2y2, field_size) < 0
+                || BN_bn2binpad(y2, x2y2 + field_size, field_size) < 0) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+            goto done;
+        }
+    }
+
+    if (!sm2_stream_start(ctx, key, md, x2y2, field_size, 1))
+        goto done;
+    *c1len = 1 + 2 * field_size;
+    rc = 1;
+
+ done:
+    if (rc == 0)
+        sm2_stream_reset(ctx);
+    OPENSSL_cleanse(x2y2, sizeof(x2y2));
+    EC_POINT_free(kG);
+    EC_POINT_free(kP);
+    BN_CTX_end(bnctx);
+    BN_CTX_free(bnctx);
+    return rc;
+}
+
+int ossl_sm2_stream_decrypt_init(SM2_STREAM *ctx, const EC_KEY *key,
+                                 const EVP_MD *md,
+                                 const unsigned char *c1, size_t c1len,
+                                 const unsigned char *c3, size_t c3len)
+{
+    int rc = 0;
+    size_t field_size;
+    const EC_GROUP *group;
+    const BIGNUM *priv;
+    BN_CTX *bnctx = NULL;
+    BIGNUM *x2, *y2;
+    EC_POINT *C1 = NULL;
+    unsigned char x2y2[2 * SM2_MAX_FIELD_SIZE];
+
+    sm2_stream_reset(ctx);
+    if (!sm2_stream_field_size(key, &field_size))
+        return 0;
+    group = EC_KEY_get0_group(key);
+    if ((priv = EC_KEY_get0_private_key(key)) == NULL) {
+        ERR_raise(ERR_LIB_EC, EC_R_MISSING_PRIVATE_KEY);
+        return 0;
+    }
+    if (md == NULL)
+        md = EVP_sm3();
+    if (c3len != (size_t)EVP_MD_get_size(md)) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_ENCODING);
+        return 0;
+    }
+
+    bnctx = BN_CTX_new_ex(ossl_ec_key_get_libctx(key));
+    C1 = EC_POINT_new(group);
+    if (bnctx == NULL || C1 == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        goto done;
+    }
+    BN_CTX_start(bnctx);
+    x2 = BN_CTX_get(bnctx);
+    y2 = BN_CTX_get(bnctx);
+    if (y2 == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+        goto done;
+    }
+
+    if (!EC_POINT_oct2point(group, C1, c1, c1len, bnctx)
+            || !EC_POINT_mul(group, C1, NULL, C1, priv, bnctx)
+            || !EC_POINT_get_affine_coordinates(group, C1, x2, y2, bnctx)
+            || BN_bn2binpad(x2, x2y2, field_size) < 0
+            || BN_bn2binpad(y2, x2y2 + field_size, field_size) < 0) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+        goto done;
+    }
+
+    if (!sm2_stream_start(ctx, key, md, x2y2, field_size, 0))
+        goto done;
+    memcpy(ctx->expected_c3, c3, c3len);
+    rc = 1;
+
+ done:
+    if (rc == 0)
+        sm2_stream_reset(ctx);
+    OPENSSL_cleanse(x2y2, sizeof(x2y2));
+    EC_POINT_free(C1);
+    BN_CTX_end(bnctx);
+    BN_CTX_free(bnctx);
+    return rc;
+}
+
+int ossl_sm2_stream_update(SM2_STREAM *ctx, unsigned char *out,
+                           const unsigned char *in, size_t inlen)
+{
+    size_t i, j, n;
+    unsigned char ctr[4];
+
+    if (ctx->c3 == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+        return 0;
+    }
+
+    /* C3 covers the plaintext, which is |in| one way and |out| the other */
+    if (ctx->enc && !EVP_DigestUpdate(ctx->c3, in, inlen)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        goto err;
+    }
+
+    for (i = 0; i < inlen; i += n) {
+        if (ctx->block_used == ctx->block_len) {
+            /* X9.63 caps the output at (2^32 - 1) blocks */
+            if (ctx->counter == 0) {
+                ERR_raise(ERR_LIB_SM2, ERR_R_PASSED_INVALID_ARGUMENT);
+                goto err;
+            }
+            ctr[0] = (unsigned char)(ctx->counter >> 24);
+            ctr[1] = (unsigned char)(ctx->counter >> 16);
+            ctr[2] = (unsigned char)(ctx->counter >> 8);
+            ctr[3] = (unsigned char)ctx->counter;
+            if (!EVP_MD_CTX_copy_ex(ctx->kdf, ctx->kdf_z)
+                    || !EVP_DigestUpdate(ctx->kdf, ctr, sizeof(ctr))
+                    || !EVP_DigestFinal_ex(ctx->kdf, ctx->block, NULL)) {
+                ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+                goto err;
+            }
+            ctx->counter++;
+            ctx->block_used = 0;
+        }
+        n = ctx->block_len - ctx->block_used;
+        if (n > inlen - i)
+            n = inlen - i;
+        for (j = 0; j < n; j++)
+            out[i + j] = in[i + j] ^ ctx->block[ctx->block_used + j];
+        ctx->block_used += n;
+    }
+
+    if (!ctx->enc && !EVP_DigestUpdate(ctx->c3, out, inlen)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        goto err;
+    }
+    return 1;
+
+ err:
+    sm2_stream_reset(ctx);
+    return 0;
+}
+
+int ossl_sm2_stream_encrypt_final(SM2_STREAM *ctx,
+                                  unsigned char *c3, size_t *c3len)
+{
+    size_t md_size;
+    int rc = 0;
+
+    if (ctx->c3 == NULL || !ctx->enc) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+        return 0;
+    }
+    md_size = (size_t)EVP_MD_get_size(ctx->md);
+    if (c3 == NULL) {
+        *c3len = md_size;
+        return 1;
+    }
+    if (*c3len < md_size) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_BUFFER_TOO_SMALL);
+        return 0;
+    }
+
+    if (!EVP_DigestUpdate(ctx->c3, ctx->y2, ctx->field_size)
+            || !EVP_DigestFinal_ex(ctx->c3, c3, NULL)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+    } else {
+        *c3len = md_size;
+        rc = 1;
+    }
+    sm2_stream_reset(ctx);
+    return rc;
+}
+
+int ossl_sm2_stream_decrypt_final(SM2_STREAM *ctx)
+{
+    unsigned char computed_c3[EVP_MAX_MD_SIZE];
+    int rc = 0;
+
+    if (ctx->c3 == NULL || ctx->enc) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+        return 0;
+    }
+
+    if (!EVP_DigestUpdate(ctx->c3, ctx->y2, ctx->field_size)
+            || !EVP_DigestFinal_ex(ctx->c3, computed_c3, NULL)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+    } else if (CRYPTO_memcmp(computed_c3, ctx->expected_c3,
+                             (size_t)EVP_MD_get_size(ctx->md)) != 0) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_DIGEST);
+    } else {
+        rc = 1;
+    }
+    sm2_stream_reset(ctx);
+    return rc;
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * EC_POINTs_mul is deprecated for public use, but still ok for internal use.
+ */
+#include "internal/deprecated.h"
+
+#include "crypto/sm2.h"
+#include "crypto/sm2err.h"
+#include "crypto/ec.h" /* ossl_ec_key_get_libctx() */
+#include "crypto/bn.h"
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/bn.h>
+#include <string.h>
+
+/* The largest field element, as for sect571 and P-521 */
+#define SM2_MAX_FIELD_SIZE  66
+
+/*
+ * xbar = 2^w + (x & (2^w - 1)) with w = ceil(ceil(log2(n)) / 2) - 1, where x
+ * is the affine x coordinate of an ephemeral public key
+ */
+static int sm2_reduced_x(BIGNUM *xbar, const BIGNUM *x, int w)
+{
+    if (BN_copy(xbar, x) == NULL
+            || (BN_num_bits(xbar) > w && !BN_mask_bits(xbar, w))
+            || !BN_set_bit(xbar, w))
+        return 0;
+    return 1;
+}
+
+/*
+ * Computes U = [h * t](P + [xbar]R) for the peer's static key P and ephemeral
+ * key R, where t = (d + xbar' * r) mod n comes from our own static and
+ * ephemeral private keys. |t| is a fixed-width value below n, and the scalars
+ * derived from it are kept fixed-width too.
+ */
+static int sm2_shared_point(const EC_GROUP *group, EC_POINT *U,
+                            const BIGNUM *t, const BIGNUM *peer_xbar,
+                            const EC_POINT *peer_P, const EC_POINT *peer_R,
+                            BN_CTX *ctx)
+{
+    const BIGNUM *cofactor = EC_GROUP_get0_cofactor(group);
+    BIGNUM *ht, *htx;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    ht = BN_CTX_get(ctx);
+    htx = BN_CTX_get(ctx);
+    if (htx == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        goto done;
+    }
+    BN_set_flags(ht, BN_FLG_CONSTTIME);
+    BN_set_flags(htx, BN_FLG_CONSTTIME);
+
+#ifdef ECP_SM2Z256_ASM
+    /*
+     * The sm2z256 method multiplies both points in a single constant-time
+     * pass with one shared doubling chain, so compute
+     * [h * t]P + [h * t * xbar mod n]R instead of multiplying twice.  The
+     * cofactor of the built-in curve is one, so reducing mod n loses nothing.
+     */
+    if (ecp_sm2z256_group_is_builtin(group)) {
+        const EC_POINT *points[2];
+        const BIGNUM *scalars[2];
+        BN_MONT_CTX *mont = EC_GROUP_get_mont_data(group);
+
+        /* Only xbar is in the Montgomery domain, so htx comes out plain */
+        if (!bn_to_mont_fixed_top(htx, peer_xbar, mont, ctx)
+                || !bn_mul_mont_fixed_top(htx, htx, t, mont, ctx)) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+            goto done;
+        }
+        points[0] = peer_P;
+        points[1] = peer_R;
+        scalars[0] = t;
+        scalars[1] = htx;
+        if (!EC_POINTs_mul(group, U, NULL, 2, points, scalars, ctx)) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+            goto done;
+        }
+        ret = 1;
+        goto done;
+    }
+#endif
+
+    /*
+     * The generic multi-point multiplication is not constant time, so only
+     * the public part is combined that way and the secret scalar is applied
+     * through the ladder
+     */
+    if (!bn_mul_fixed_top(ht, t, cofactor, ctx)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+        goto done;
+    }
+    if (!EC_POINT_mul(group, U, NULL, peer_R, peer_xbar, ctx)
+            || !EC_POINT_add(group, U, U, peer_P, ctx)
+            || !EC_POINT_mul(group, U, NULL, U, ht, ctx)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+        goto done;
+    }
+    ret = 1;
+
+ done:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+int ossl_sm2_compute_key(unsigned char *out, size_t outlen, int initiator,
+                         const uint8_t *id, size_t id_len,
+                         const uint8_t *peer_id, size_t peer_id_len,
+                         const EC_KEY *key, const EC_KEY *eph,
+                         const EC_KEY *peer_key, const EC_KEY *peer_eph,
+                         const EVP_MD *digest, unsigned char *confirm,
+                         unsigned char *peer_confirm)
+{
+    int rc = 0;
+    const EC_GROUP *group = EC_KEY_get0_group(key);
+    const BIGNUM *order = EC_GROUP_get0_order(group);
+    BN_MONT_CTX *mont = EC_GROUP_get_mont_data(group);
+    const BIGNUM *d = EC_KEY_get0_private_key(key);
+    const BIGNUM *r = EC_KEY_get0_private_key(eph);
+    const EC_POINT *R = EC_KEY_get0_public_key(eph);
+    const EC_POINT *peer_P = EC_KEY_get0_public_key(peer_key);
+    const EC_POINT *peer_R = EC_KEY_get0_public_key(peer_eph);
+    OSSL_LIB_CTX *libctx = ossl_ec_key_get_libctx(key);
+    const char *propq = ossl_ec_key_get0_propq(key);
+    BN_CTX *ctx = NULL;
+    EVP_MD_CTX *hash = NULL;
+    EC_POINT *U = NULL;
+    BIGNUM *x, *y, *peer_x, *peer_y, *xbar, *peer_xbar, *t, *xU, *yU;
+    /* xU || yU || ZA || ZB, the input to the KDF */
+    unsigned char z[2 * SM2_MAX_FIELD_SIZE + 2 * EVP_MAX_MD_SIZE];
+    /* x1 || y1 || x2 || y2, the initiator's then the responder's R */
+    unsigned char xy[4 * SM2_MAX_FIELD_SIZE];
+    unsigned char inner[EVP_MAX_MD_SIZE];
+    unsigned char *self_xy, *peer_xy;
+    static const unsigned char tag_02 = 0x02, tag_03 = 0x03;
+    size_t field_size;
+    int md_size = EVP_MD_get_size(digest);
+    int w;
+
+    if (group == NULL || order == NULL || mont == NULL || d == NULL
+            || r == NULL || R == NULL || peer_P == NULL || peer_R == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+
+    field_size = (EC_GROUP_get_degree(group) + 7) / 8;
+    if (field_size == 0 || field_size > SM2_MAX_FIELD_SIZE) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_FIELD);
+        return 0;
+    }
+    if (md_size <= 0) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_DIGEST);
+        return 0;
+    }
+    w = (BN_num_bits(order) + 1) / 2 - 1;
+
+    ctx = BN_CTX_new_ex(libctx);
+    if (ctx == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    BN_CTX_start(ctx);
+    U = EC_POINT_new(group);
+    x = BN_CTX_get(ctx);
+    y = BN_CTX_get(ctx);
+    peer_x = BN_CTX_get(ctx);
+    peer_y = BN_CTX_get(ctx);
+    xbar = BN_CTX_get(ctx);
+    peer_xbar = BN_CTX_get(ctx);
+    t = BN_CTX_get(ctx);
+    xU = BN_CTX_get(ctx);
+    yU = BN_CTX_get(ctx);
+    if (U == NULL || yU == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        goto done;
+    }
+
+    if (EC_POINT_is_on_curve(group, peer_R, ctx) <= 0) {
+        ERR_raise(ERR_LIB_EC, EC_R_POINT_IS_NOT_ON_CURVE);
+        goto done;
+    }
+    if (!EC_POINT_get_affine_coordinates(group, R, x, y, ctx)
+            || !EC_POINT_get_affine_coordinates(group, peer_R, peer_x, peer_y,
+                                                ctx)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+        goto done;
+    }
+
+    /*
+     * t = (d + xbar * r) mod n. d and r are secret, so this is done with
+     * fixed-width Montgomery arithmetic rather than BN_mod_mul/BN_mod_add,
+     * which divide. With only xbar in the Montgomery domain the product comes
+     * out plain, and t keeps the width of n.
+     */
+    BN_set_flags(t, BN_FLG_CONSTTIME);
+    if (!sm2_reduced_x(xbar, x, w)
+            || !sm2_reduced_x(peer_xbar, peer_x, w)
+            || !bn_to_mont_fixed_top(t, xbar, mont, ctx)
+            || !bn_mul_mont_fixed_top(t, t, r, mont, ctx)
+            || !bn_mod_add_fixed_top(t, t, d, order)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+        goto done;
+    }
+
+    if (!sm2_shared_point(group, U, t, peer_xbar, peer_P, peer_R, ctx))
+        goto done;
+    if (EC_POINT_is_at_infinity(group, U)) {
+        ERR_raise(ERR_LIB_EC, EC_R_POINT_AT_INFINITY);
+        goto done;
+    }
+
+    if (!EC_POINT_get_affine_coordinates(group, U, xU, yU, ctx)
+            || BN_bn2binpad(xU, z, field_size) < 0
+            || BN_bn2binpad(yU, z + field_size, field_size) < 0) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        goto done;
+    }
+
+    /* ZA is always the initiator's and ZB the responder's */
+    if (!ossl_sm2_compute_z_digest(z + 2 * field_size
+                                   + (initiator ? 0 : md_size),
+                                   digest, id, id_len, key)
+            || !ossl_sm2_compute_z_digest(z + 2 * field_size
+                                          + (initiator ? md_size : 0),
+                                          digest, peer_id, peer_id_len,
+                                          peer_key))
+        goto done;
+
+    if (!ossl_sm2_kdf(out, outlen, z, 2 * field_size + 2 * md_size, digest,
+                      libctx, propq)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        goto done;
+    }
+
+    if (confirm == NULL && peer_confirm == NULL) {
+        rc = 1;
+        goto done;
+    }
+
+    self_xy = initiator ? xy : xy + 2 * field_size;
+    peer_xy = initiator ? xy + 2 * field_size : xy;
+    if (BN_bn2binpad(x, self_xy, field_size) < 0
+            || BN_bn2binpad(y, self_xy + field_size, field_size) < 0
+            || BN_bn2binpad(peer_x, peer_xy, field_size) < 0
+            || BN_bn2binpad(peer_y, peer_xy + field_size, field_size) < 0) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+        goto done;
+    }
+
+    hash = EVP_MD_CTX_new();
+    if (hash == NULL) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        goto done;
+    }
+
+    /*
+     * inner = H(xU || ZA || ZB || x1 || y1 || x2 || y2), then
+     * S1 = SB = H(0x02 || yU || inner) and SA = S2 = H(0x03 || yU || inner).
+     * The responder sends SB and the initiator answers with SA.
+     */
+    if (!EVP_DigestInit(hash, digest)
+            || !EVP_DigestUpdate(hash, z, field_size)
+            || !EVP_DigestUpdate(hash, z + 2 * field_size, 2 * md_size)
+            || !EVP_DigestUpdate(hash, xy, 4 * field_size)
+            || !EVP_DigestFinal(hash, inner, NULL)) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        goto done;
+    }
+    if (confirm != NULL
+            && (!EVP_DigestInit(hash, digest)
+                || !EVP_DigestUpdate(hash, initiator ? &tag_03 : &tag_02, 1)
+                || !EVP_DigestUpdate(hash, z + field_size, field_size)
+                || !EVP_DigestUpdate(hash, inner, md_size)
+                || !EVP_DigestFinal(hash, confirm, NULL))) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        goto done;
+    }
+    if (peer_confirm != NULL
+            && (!EVP_DigestInit(hash, digest)
+                || !EVP_DigestUpdate(hash, initiator ? &tag_02 : &tag_03, 1)
+                || !EVP_DigestUpdate(hash, z + field_size, field_size)
+                || !EVP_DigestUpdate(hash, inner, md_size)
+                || !EVP_DigestFinal(hash, peer_confirm, NULL))) {
+        ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
+        goto done;
+    }
+
+    rc = 1;
+
+ done:
+    OPENSSL_cleanse(z, sizeof(z));
+    OPENSSL_cleanse(inner, sizeof(inner));
+    EVP_MD_CTX_free(hash);
+    EC_POINT_clear_free(U);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    return rc;
+}
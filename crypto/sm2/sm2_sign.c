@@ -20,20 +20,16 @@
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include <openssl/bn.h>
+#include <openssl/rand.h>
 #include <string.h>
 
-#if 1
+#ifdef ECP_SM2Z256_ASM
 #define P256_LIMBS      (256/BN_BITS2)
 # define TOBN(hi,lo)    ((BN_ULONG)hi<<32|lo)
-void ecp_sm2z256_ord_sub_reduce(BN_ULONG res[4], BN_ULONG a[4]);
-void ecp_sm2z256_ord_add(BN_ULONG res[4], BN_ULONG a[4], BN_ULONG b[4]);
-void ecp_sm2z256_ord_mul_mont(BN_ULONG res[4], BN_ULONG a[4],
-                               BN_ULONG b[4]);
-void ecp_sm2z256_ord_negative(BN_ULONG res[4], BN_ULONG a[4]);
-void ecp_sm2z256_ord_sub(BN_ULONG res[4], BN_ULONG a[4], BN_ULONG b[4]);
 
 /* in1/in2 \in [0,2^256-1], this function compute in1+in2 mod n */
-static int BN_SM2_ord_add(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2){
+static int BN_SM2_ord_add(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2)
+{
     BN_ULONG x[P256_LIMBS];
     BN_ULONG y[P256_LIMBS];
 
@@ -53,7 +49,10 @@ static int BN_SM2_ord_add(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2){
 }
 
 /* r=in1*in2 mod ord(sm2) */
-static int BN_SM2_ord_mul_mont(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2, const BIGNUM *order, BN_CTX *ctx){
+static int BN_SM2_ord_mul_mont(BIGNUM *r, const BIGNUM *in1,
+                               const BIGNUM *in2, const BIGNUM *order,
+                               BN_CTX *ctx)
+{
     /* RR = 2^512 mod ord(sm2) */
     static BN_ULONG RR[P256_LIMBS]  = {
         TOBN(0x901192af,0x7c114f20), TOBN(0x3464504a,0xde6fa2fa),
@@ -86,7 +85,9 @@ static int BN_SM2_ord_mul_mont(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2,
 }
 
 /* r=in1-in2 mod ord(sm2) */
-static int BN_SM2_ord_sub(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2, const BIGNUM *order, BN_CTX *ctx){
+static int BN_SM2_ord_sub(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2,
+                          const BIGNUM *order, BN_CTX *ctx)
+{
     BN_ULONG x[P256_LIMBS];
     BN_ULONG y[P256_LIMBS];
 
@@ -112,11 +113,180 @@ static int BN_SM2_ord_sub(BIGNUM *r, const BIGNUM *in1, const BIGNUM *in2, const
     return 1;
 }
 
-    /* only effect in this file for computing add/mul mod ord(sm2) */
-    #define BN_mod_add(r, e, x1, order, ctx)    BN_SM2_ord_add(r, e, x1)
-    #define BN_mod_mul(r, a, b, order, ctx)     BN_SM2_ord_mul_mont(r, a, b, order, ctx)
-    #define BN_mod_sub(r, a, b, order, ctx)     BN_SM2_ord_sub(r, a, b, order, ctx)
+/* n = ord(sm2) */
+static int BN_SM2_is_ord(const BIGNUM *order)
+{
+    static const BN_ULONG ord[P256_LIMBS] = {
+        TOBN(0x53bbf409,0x39d54123), TOBN(0x7203df6b,0x21c6052b),
+        TOBN(0xffffffff,0xffffffff), TOBN(0xfffffffe,0xffffffff)
+    };
+
+    return bn_get_top(order) == P256_LIMBS
+        && memcmp(bn_get_words(order), ord, sizeof(ord)) == 0;
+}
+
+/*
+ * Sign engine for the built-in curve on the sm2z256 method. k, r, s, dA and
+ * (1+dA)^-1 stay in 4-limb form from the comb multiplication to the DER
+ * encoding, so a signature costs no BIGNUM conversion and no allocation.
+ */
+static BN_ULONG sm2z256_is_zero(const BN_ULONG a[P256_LIMBS])
+{
+    return (a[0] | a[1] | a[2] | a[3]) == 0;
+}
+
+/* big-endian |in| of at most 32 bytes to little-endian limbs */
+static void sm2z256_bin2limbs(BN_ULONG out[P256_LIMBS],
+                              const unsigned char *in, int len)
+{
+    int i;
+
+    memset(out, 0, sizeof(BN_ULONG) * P256_LIMBS);
+    for (i = 0; i < len; i++)
+        out[i / BN_BYTES] |= (BN_ULONG)in[len - 1 - i] << (8 * (i % BN_BYTES));
+}
+
+/*
+ * Returns 1 if the engine applies to |key|, 0 to leave it to the generic
+ * code, and -1 on error. On success |inv| holds the signing context of the
+ * key, (1+dA)^-1 mod n in Montgomery form, which the key caches.
+ */
+static int sm2z256_sign_setup(const EC_KEY *key, BN_ULONG inv[P256_LIMBS])
+{
+    if (EC_KEY_get0_private_key(key) == NULL
+            || !ecp_sm2z256_group_is_builtin(EC_KEY_get0_group(key)))
+        return 0;
+
+    if (!ossl_ec_key_sm2z256_sign_inverse(key, inv)) {
+        ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_PRIVATE_KEY);
+        return -1;
+    }
+    return 1;
+}
+
+/* s=(k+r)*(1+dA)^-1-r mod n with e in [0,2^256-1], inv from the key */
+static int sm2z256_sig_gen(OSSL_LIB_CTX *libctx, BN_ULONG r[P256_LIMBS],
+                           BN_ULONG s[P256_LIMBS],
+                           const BN_ULONG e_in[P256_LIMBS],
+                           BN_ULONG inv[P256_LIMBS])
+{
+    unsigned char buf[P256_LIMBS * BN_BYTES];
+    BN_ULONG e[P256_LIMBS], k[P256_LIMBS], x1[P256_LIMBS], t[P256_LIMBS];
+    int ret = 0;
+
+    memcpy(e, e_in, sizeof(e));
+    ecp_sm2z256_ord_sub_reduce(e, e);
+
+    for (;;) {
+        /* same draw as BN_priv_rand_range_ex() over [0, n) */
+        if (RAND_priv_bytes_ex(libctx, buf, sizeof(buf), 0) <= 0) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+            goto done;
+        }
+        sm2z256_bin2limbs(k, buf, sizeof(buf));
+        ecp_sm2z256_ord_sub_reduce(t, k);
+        if (memcmp(t, k, sizeof(k)) != 0 || sm2z256_is_zero(k))
+            continue;
+
+        ecp_sm2z256_mul_g_affine_x(x1, k);
+        ecp_sm2z256_ord_sub_reduce(x1, x1);
+        ecp_sm2z256_ord_add(r, e, x1);
+
+        /* try again if r == 0 or r+k == n */
+        if (sm2z256_is_zero(r))
+            continue;
+        ecp_sm2z256_ord_add(t, k, r);
+        if (sm2z256_is_zero(t))
+            continue;
+
+        ecp_sm2z256_ord_mul_mont(s, inv, t);
+        ecp_sm2z256_ord_sub(s, s, r);
+        if (!sm2z256_is_zero(s))
+            break;
+    }
+    ret = 1;
+
+ done:
+    OPENSSL_cleanse(buf, sizeof(buf));
+    OPENSSL_cleanse(k, sizeof(k));
+    OPENSSL_cleanse(t, sizeof(t));
+    return ret;
+}
+
+/* INTEGER a in minimal two's complement form, returns the end of the TLV */
+static unsigned char *sm2z256_encode_integer(unsigned char *p,
+                                             const BN_ULONG a[P256_LIMBS])
+{
+    unsigned char be[1 + P256_LIMBS * BN_BYTES];
+    int i, off, len;
+
+    be[0] = 0;
+    for (i = 0; i < P256_LIMBS * BN_BYTES; i++)
+        be[sizeof(be) - 1 - i] = (unsigned char)(a[i / BN_BYTES]
+                                                 >> (8 * (i % BN_BYTES)));
+    for (off = 0; off < (int)sizeof(be) - 1
+                  && be[off] == 0 && (be[off + 1] & 0x80) == 0; off++)
+        continue;
+    len = sizeof(be) - off;
+
+    *p++ = V_ASN1_INTEGER;
+    *p++ = (unsigned char)len;
+    memcpy(p, be + off, len);
+    return p + len;
+}
+
+/*
+ * DER SEQUENCE { INTEGER r, INTEGER s } written straight into |out|, which
+ * holds ECDSA_size() bytes like every caller of i2d_ECDSA_SIG() here.
+ */
+static int sm2z256_encode_sig(unsigned char *out,
+                              const BN_ULONG r[P256_LIMBS],
+                              const BN_ULONG s[P256_LIMBS])
+{
+    unsigned char *p = out + 2;
+
+    p = sm2z256_encode_integer(p, r);
+    p = sm2z256_encode_integer(p, s);
+    out[0] = V_ASN1_SEQUENCE | V_ASN1_CONSTRUCTED;
+    out[1] = (unsigned char)(p - out - 2);
+    return (int)(p - out);
+}
+#endif
+
+/*
+ * Modular add/mul/sub for the sign and verify equations. The group order of
+ * the built-in curve takes the fixed-modulus sm2z256 primitives, other groups
+ * (explicit parameters) keep the generic BIGNUM code.
+ */
+static ossl_inline int sm2_mod_add(BIGNUM *r, const BIGNUM *a, const BIGNUM *b,
+                                   const BIGNUM *order, BN_CTX *ctx)
+{
+#ifdef ECP_SM2Z256_ASM
+    if (BN_SM2_is_ord(order))
+        return BN_SM2_ord_add(r, a, b);
 #endif
+    return BN_mod_add(r, a, b, order, ctx);
+}
+
+static ossl_inline int sm2_mod_mul(BIGNUM *r, const BIGNUM *a, const BIGNUM *b,
+                                   const BIGNUM *order, BN_CTX *ctx)
+{
+#ifdef ECP_SM2Z256_ASM
+    if (BN_SM2_is_ord(order))
+        return BN_SM2_ord_mul_mont(r, a, b, order, ctx);
+#endif
+    return BN_mod_mul(r, a, b, order, ctx);
+}
+
+static ossl_inline int sm2_mod_sub(BIGNUM *r, const BIGNUM *a, const BIGNUM *b,
+                                   const BIGNUM *order, BN_CTX *ctx)
+{
+#ifdef ECP_SM2Z256_ASM
+    if (BN_SM2_is_ord(order))
+        return BN_SM2_ord_sub(r, a, b, order, ctx);
+#endif
+    return BN_mod_sub(r, a, b, order, ctx);
+}
 
 int ossl_sm2_compute_z_digest(uint8_t *out,
                               const EVP_MD *digest,
@@ -266,14 +436,13 @@ static BIGNUM *sm2_compute_msg_hash(const EVP_MD *digest,
         goto done;
     }
 
-    if (!ossl_sm2_compute_z_digest(z, fetched_digest, id, id_len, key)) {
+    if (!ossl_ec_key_sm2_z_digest_init(key, hash, fetched_digest, id,
+                                       id_len)) {
         /* SM2err already called */
         goto done;
     }
 
-    if (!EVP_DigestInit(hash, fetched_digest)
-            || !EVP_DigestUpdate(hash, z, md_size)
-            || !EVP_DigestUpdate(hash, msg, msg_len)
+    if (!EVP_DigestUpdate(hash, msg, msg_len)
                /* reuse z buffer to hold H(Z || M) */
             || !EVP_DigestFinal(hash, z, NULL)) {
         ERR_raise(ERR_LIB_SM2, ERR_R_EVP_LIB);
@@ -306,6 +475,39 @@ static ECDSA_SIG *sm2_sig_gen(const EC_KEY *key, const BIGNUM *e)
     BIGNUM *x1 = NULL;
     BIGNUM *tmp = NULL;
     OSSL_LIB_CTX *libctx = ossl_ec_key_get_libctx(key);
+#ifdef ECP_SM2Z256_ASM
+    BN_ULONG inv[P256_LIMBS], e_w[P256_LIMBS];
+    BN_ULONG r_w[P256_LIMBS], s_w[P256_LIMBS];
+    int fast = 0;
+
+    if (!BN_is_negative(e) && bn_copy_words(e_w, e, P256_LIMBS)
+            && (fast = sm2z256_sign_setup(key, inv)) < 0)
+        return NULL;
+    if (fast) {
+        int ok = sm2z256_sig_gen(libctx, r_w, s_w, e_w, inv);
+
+        OPENSSL_cleanse(inv, sizeof(inv));
+        if (!ok)
+            return NULL;
+
+        r = BN_new();
+        s = BN_new();
+        if (r == NULL || s == NULL
+                || (sig = ECDSA_SIG_new()) == NULL) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+            goto done;
+        }
+        if (!bn_set_words(r, r_w, P256_LIMBS)
+                || !bn_set_words(s, s_w, P256_LIMBS)) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+            ECDSA_SIG_free(sig);
+            sig = NULL;
+            goto done;
+        }
+        ECDSA_SIG_set0(sig, r, s);
+        return sig;
+    }
+#endif
 
     kG = EC_POINT_new(group);
     ctx = BN_CTX_new_ex(libctx);
@@ -344,7 +546,7 @@ static ECDSA_SIG *sm2_sig_gen(const EC_KEY *key, const BIGNUM *e)
         if (!EC_POINT_mul(group, kG, k, NULL, NULL, ctx)
                 || !EC_POINT_get_affine_coordinates(group, kG, x1, NULL,
                                                     ctx)
-                || !BN_mod_add(r, e, x1, order, ctx)) {
+                || !sm2_mod_add(r, e, x1, order, ctx)) {
             ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
             goto done;
         }
@@ -364,9 +566,9 @@ static ECDSA_SIG *sm2_sig_gen(const EC_KEY *key, const BIGNUM *e)
         /* s=(1+dA)^-1 * (k-r*dA) mod n */
         if (!BN_add(s, dA, BN_value_one())
                 || !ossl_ec_group_do_inverse_ord(group, s, s, ctx)
-                || !BN_mod_mul(tmp, dA, r, order, ctx)
+                || !sm2_mod_mul(tmp, dA, r, order, ctx)
                 || !BN_sub(tmp, k, tmp)
-                || !BN_mod_mul(s, s, tmp, order, ctx)) {
+                || !sm2_mod_mul(s, s, tmp, order, ctx)) {
             ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
             goto done;
         }
@@ -374,9 +576,9 @@ static ECDSA_SIG *sm2_sig_gen(const EC_KEY *key, const BIGNUM *e)
         /* (k+r)*(1+dA)^-1-r mod n, which can replace a mul with a add */
         if (!BN_add(s, dA, BN_value_one())
                 || !ossl_ec_group_do_inverse_ord(group, s, s, ctx)
-                || !BN_mod_add(tmp, k, r, order, ctx)
-                || !BN_mod_mul(s, s, tmp, order, ctx)
-                || !BN_mod_sub(s, s, r, order, ctx)) {
+                || !sm2_mod_add(tmp, k, r, order, ctx)
+                || !sm2_mod_mul(s, s, tmp, order, ctx)
+                || !sm2_mod_sub(s, s, r, order, ctx)) {
             ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
             goto done;
         }
@@ -416,6 +618,9 @@ static int sm2_sig_verify(const EC_KEY *key, const ECDSA_SIG *sig,
     const BIGNUM *r = NULL;
     const BIGNUM *s = NULL;
     OSSL_LIB_CTX *libctx = ossl_ec_key_get_libctx(key);
+#ifdef ECP_SM2Z256_ASM
+    const SM2Z256_POINT_TABLE *tbl = NULL;
+#endif
 
     ctx = BN_CTX_new_ex(libctx);
     pt = EC_POINT_new(group);
@@ -452,7 +657,7 @@ static int sm2_sig_verify(const EC_KEY *key, const ECDSA_SIG *sig,
         goto done;
     }
 
-    if (!BN_mod_add(t, r, s, order, ctx)) {
+    if (!sm2_mod_add(t, r, s, order, ctx)) {
         ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
         goto done;
     }
@@ -462,13 +667,30 @@ static int sm2_sig_verify(const EC_KEY *key, const ECDSA_SIG *sig,
         goto done;
     }
 
+#ifdef ECP_SM2Z256_ASM
+    /* A key verified often gets a comb table of its own for [t]PA */
+    if ((tbl = ossl_ec_key_sm2z256_pub_table(key)) != NULL) {
+        const EC_POINT *pub = EC_KEY_get0_public_key(key);
+        const BIGNUM *ts = t;
+        BN_ULONG xw[1][P256_LIMBS];
+        unsigned char inf;
+
+        if (!ecp_sm2z256_mul_batch_x(group, 1, &s, &pub, &ts, &tbl, xw, &inf,
+                                     ctx)
+                || inf
+                || !bn_set_words(x1, xw[0], P256_LIMBS)) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+            goto done;
+        }
+    } else
+#endif
     if (!EC_POINT_mul(group, pt, s, EC_KEY_get0_public_key(key), t, ctx)
             || !EC_POINT_get_affine_coordinates(group, pt, x1, NULL, ctx)) {
         ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
         goto done;
     }
 
-    if (!BN_mod_add(t, e, x1, order, ctx)) {
+    if (!sm2_mod_add(t, e, x1, order, ctx)) {
         ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
         goto done;
     }
@@ -535,6 +757,27 @@ int ossl_sm2_internal_sign(const unsigned char *dgst, int dgstlen,
     ECDSA_SIG *s = NULL;
     int sigleni;
     int ret = -1;
+#ifdef ECP_SM2Z256_ASM
+    BN_ULONG inv[P256_LIMBS], e_w[P256_LIMBS];
+    BN_ULONG r_w[P256_LIMBS], s_w[P256_LIMBS];
+    int fast = 0;
+
+    if (dgstlen >= 0 && dgstlen <= P256_LIMBS * BN_BYTES
+            && (fast = sm2z256_sign_setup(eckey, inv)) < 0)
+        return -1;
+    if (fast) {
+        sm2z256_bin2limbs(e_w, dgst, dgstlen);
+        ret = sm2z256_sig_gen(ossl_ec_key_get_libctx(eckey), r_w, s_w, e_w,
+                              inv);
+        OPENSSL_cleanse(inv, sizeof(inv));
+        if (!ret) {
+            ERR_raise(ERR_LIB_SM2, ERR_R_INTERNAL_ERROR);
+            return -1;
+        }
+        *siglen = (unsigned int)sm2z256_encode_sig(sig, r_w, s_w);
+        return 1;
+    }
+#endif
 
     e = BN_bin2bn(dgst, dgstlen, NULL);
     if (e == NULL) {
@@ -563,32 +806,49 @@ int ossl_sm2_internal_sign(const unsigned char *dgst, int dgstlen,
     return ret;
 }
 
-int ossl_sm2_internal_verify(const unsigned char *dgst, int dgstlen,
-                             const unsigned char *sig, int sig_len,
-                             EC_KEY *eckey)
+/* Decodes |sig|, which must be DER without trailing garbage */
+static ECDSA_SIG *sm2_sig_decode(const unsigned char *sig, int sig_len)
 {
     ECDSA_SIG *s = NULL;
-    BIGNUM *e = NULL;
     const unsigned char *p = sig;
     unsigned char *der = NULL;
     int derlen = -1;
-    int ret = -1;
 
     s = ECDSA_SIG_new();
     if (s == NULL) {
         ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
-        goto done;
+        return NULL;
     }
     if (d2i_ECDSA_SIG(&s, &p, sig_len) == NULL) {
         ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_ENCODING);
-        goto done;
+        goto err;
     }
     /* Ensure signature uses DER and doesn't have trailing garbage */
     derlen = i2d_ECDSA_SIG(s, &der);
     if (derlen != sig_len || memcmp(sig, der, derlen) != 0) {
         ERR_raise(ERR_LIB_SM2, SM2_R_INVALID_ENCODING);
-        goto done;
+        goto err;
     }
+    OPENSSL_free(der);
+    return s;
+
+ err:
+    OPENSSL_free(der);
+    ECDSA_SIG_free(s);
+    return NULL;
+}
+
+int ossl_sm2_internal_verify(const unsigned char *dgst, int dgstlen,
+                             const unsigned char *sig, int sig_len,
+                             EC_KEY *eckey)
+{
+    ECDSA_SIG *s = NULL;
+    BIGNUM *e = NULL;
+    int ret = -1;
+
+    s = sm2_sig_decode(sig, sig_len);
+    if (s == NULL)
+        goto done;
 
     e = BN_bin2bn(dgst, dgstlen, NULL);
     if (e == NULL) {
@@ -599,8 +859,195 @@ int ossl_sm2_internal_verify(const unsigned char *dgst, int dgstlen,
     ret = sm2_sig_verify(eckey, s, e);
 
  done:
-    OPENSSL_free(der);
     BN_free(e);
     ECDSA_SIG_free(s);
     return ret;
 }
+
+static int sm2_verify_one(EC_KEY *key, const unsigned char *sig,
+                          size_t siglen, const unsigned char *dgst,
+                          size_t dgstlen)
+{
+    if (siglen > INT_MAX || dgstlen > INT_MAX)
+        return 0;
+    return ossl_sm2_internal_verify(dgst, (int)dgstlen, sig, (int)siglen,
+                                    key) == 1;
+}
+
+#ifdef ECP_SM2Z256_ASM
+/*
+ * B1, B2 and B5 of sm2_sig_verify(): r and s in [1, n-1] and
+ * t = (r + s) mod n non-zero. Returns 0 if the signature fails them.
+ */
+static int sm2z256_sig_t(const BIGNUM *order, const BIGNUM *r,
+                         const BIGNUM *s, BN_ULONG t[P256_LIMBS])
+{
+    BN_ULONG rw[P256_LIMBS], sw[P256_LIMBS];
+
+    if (BN_cmp(r, BN_value_one()) < 0
+            || BN_cmp(s, BN_value_one()) < 0
+            || BN_cmp(order, r) <= 0
+            || BN_cmp(order, s) <= 0
+            || !bn_copy_words(rw, r, P256_LIMBS)
+            || !bn_copy_words(sw, s, P256_LIMBS))
+        return 0;
+    ecp_sm2z256_ord_add(t, rw, sw);
+    return !sm2z256_is_zero(t);
+}
+#endif
+
+/*
+ * Verifies |num| (key, DER signature, digest) tuples and sets bit i % 8 of
+ * results[i / 8] if and only if tuple i verifies. Tuples with a NULL key are
+ * skipped and left clear. On the built-in curve the joint multiplications
+ * of all tuples share one field inversion for their affine conversion.
+ * Returns 1 once every tuple is checked, 0 on a fatal error.
+ */
+int ossl_sm2_verify_batch(OSSL_LIB_CTX *libctx, size_t num,
+                          EC_KEY *const keys[],
+                          const unsigned char *const sigs[],
+                          const size_t siglens[],
+                          const unsigned char *const dgsts[],
+                          const size_t dgstlens[], unsigned char *results)
+{
+    size_t i;
+    int ret = 0;
+#ifdef ECP_SM2Z256_ASM
+    const EC_GROUP *group = NULL;
+    BN_CTX *ctx = NULL;
+    ECDSA_SIG **sig = NULL;
+    const BIGNUM **ss = NULL, **ts = NULL;
+    const EC_POINT **pts = NULL;
+    const SM2Z256_POINT_TABLE **tbls = NULL;
+    BN_ULONG (*e)[P256_LIMBS] = NULL, (*x)[P256_LIMBS] = NULL;
+    size_t *idx = NULL;
+    unsigned char *inf = NULL;
+    size_t j, n = 0;
+#endif
+
+    memset(results, 0, (num + 7) / 8);
+    /* rejected tuples are reported through |results| only */
+    ERR_set_mark();
+
+#ifdef ECP_SM2Z256_ASM
+    /* e[] and x[] have the largest elements of the per-item arrays */
+    if (num > OPENSSL_MALLOC_MAX_NELEMS(BN_ULONG[P256_LIMBS])) {
+        ERR_clear_last_mark();
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if ((ctx = BN_CTX_new_ex(libctx)) != NULL)
+        BN_CTX_start(ctx);
+    sig = OPENSSL_zalloc(num * sizeof(*sig));
+    ss = OPENSSL_malloc(num * sizeof(*ss));
+    ts = OPENSSL_malloc(num * sizeof(*ts));
+    pts = OPENSSL_malloc(num * sizeof(*pts));
+    tbls = OPENSSL_malloc(num * sizeof(*tbls));
+    e = OPENSSL_malloc(num * sizeof(*e));
+    x = OPENSSL_malloc(num * sizeof(*x));
+    idx = OPENSSL_malloc(num * sizeof(*idx));
+    inf = OPENSSL_malloc(num);
+    if (num > 0 && (ctx == NULL || sig == NULL || ss == NULL || ts == NULL
+                    || pts == NULL || tbls == NULL || e == NULL || x == NULL || idx == NULL
+                    || inf == NULL)) {
+        ERR_clear_last_mark();
+        ERR_raise(ERR_LIB_SM2, ERR_R_MALLOC_FAILURE);
+        goto done;
+    }
+
+    for (i = 0; i < num; i++) {
+        const EC_GROUP *g;
+        const BIGNUM *r, *s;
+        BN_ULONG tw[P256_LIMBS];
+        BIGNUM *t;
+
+        if (keys[i] == NULL)
+            continue;
+        g = EC_KEY_get0_group(keys[i]);
+        if (g == NULL || !ecp_sm2z256_group_is_builtin(g)
+                || EC_KEY_get0_public_key(keys[i]) == NULL
+                || dgstlens[i] > P256_LIMBS * BN_BYTES) {
+            if (sm2_verify_one(keys[i], sigs[i], siglens[i], dgsts[i],
+                               dgstlens[i]))
+                results[i / 8] |= 1 << (i % 8);
+            continue;
+        }
+        if (siglens[i] > INT_MAX
+                || (sig[n] = sm2_sig_decode(sigs[i], (int)siglens[i])) == NULL)
+            continue;
+
+        ECDSA_SIG_get0(sig[n], &r, &s);
+        if (!sm2z256_sig_t(EC_GROUP_get0_order(g), r, s, tw)) {
+            ECDSA_SIG_free(sig[n]);
+            sig[n] = NULL;
+            continue;
+        }
+        if ((t = BN_CTX_get(ctx)) == NULL
+                || !bn_set_words(t, tw, P256_LIMBS)) {
+            ECDSA_SIG_free(sig[n]);
+            ERR_clear_last_mark();
+            ERR_raise(ERR_LIB_SM2, ERR_R_BN_LIB);
+            goto done;
+        }
+
+        group = g;
+        ss[n] = s;
+        ts[n] = t;
+        pts[n] = EC_KEY_get0_public_key(keys[i]);
+        tbls[n] = ossl_ec_key_sm2z256_pub_table(keys[i]);
+        sm2z256_bin2limbs(e[n], dgsts[i], (int)dgstlens[i]);
+        idx[n++] = i;
+    }
+
+    /* B6 for all tuples at once */
+    if (n > 0 && !ecp_sm2z256_mul_batch_x(group, n, ss, pts, ts, tbls, x,
+                                          inf, ctx)) {
+        ERR_clear_last_mark();
+        ERR_raise(ERR_LIB_SM2, ERR_R_EC_LIB);
+        goto done;
+    }
+
+    /* B7: R = (e + x1) mod n must equal r */
+    for (j = 0; j < n; j++) {
+        const BIGNUM *r;
+        BN_ULONG rw[P256_LIMBS];
+
+        ECDSA_SIG_get0(sig[j], &r, NULL);
+        if (inf[j] || !bn_copy_words(rw, r, P256_LIMBS))
+            continue;
+        ecp_sm2z256_ord_sub_reduce(e[j], e[j]);
+        ecp_sm2z256_ord_sub_reduce(x[j], x[j]);
+        ecp_sm2z256_ord_add(x[j], e[j], x[j]);
+        if (memcmp(x[j], rw, sizeof(rw)) == 0)
+            results[idx[j] / 8] |= 1 << (idx[j] % 8);
+    }
+#else
+    for (i = 0; i < num; i++)
+        if (keys[i] != NULL
+                && sm2_verify_one(keys[i], sigs[i], siglens[i], dgsts[i],
+                                  dgstlens[i]))
+            results[i / 8] |= 1 << (i % 8);
+#endif
+
+    ERR_pop_to_mark();
+    ret = 1;
+
+#ifdef ECP_SM2Z256_ASM
+ done:
+    if (sig != NULL)
+        for (j = 0; j < n; j++)
+            ECDSA_SIG_free(sig[j]);
+    OPENSSL_free(sig);
+    OPENSSL_free(ss);
+    OPENSSL_free(ts);
+    OPENSSL_free(pts);
+    OPENSSL_free(tbls);
+    OPENSSL_free(e);
+    OPENSSL_free(x);
+    OPENSSL_free(idx);
+    OPENSSL_free(inf);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+#endif
+    return ret;
+}
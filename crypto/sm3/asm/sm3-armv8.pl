@@ -0,0 +1,543 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# SM3 for ARMv8.
+#
+# ossl_hwsm3_block_data_order uses the ARMv8.2 SM3 instructions: SM3PARTW1
+# and SM3PARTW2 expand four message words at a time, SM3SS1 and the
+# SM3TT1/SM3TT2 pairs perform one round each on the ABCD and EFGH halves
+# of the state kept in two vector registers.
+#
+# ossl_sm3_block_data_order_neon is meant for cores without the extension.
+# The rounds are done in integer registers, while the message expansion,
+# W[j] together with W'[j] = W[j] ^ W[j+4], runs on NEON four words ahead
+# and is interleaved with them. The expansion is only three words wide,
+# W[j+3] depends on W[j], so the fourth lane is fixed up separately, which
+# P1 being linear makes cheap.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}arm-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/arm-xlate.pl" and -f $xlate) or
+die "can't locate arm-xlate.pl";
+
+open OUT,"| \"$^X\" $xlate $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+($ctx,$inp,$num)=("x0","x1","x2");
+
+$code.=<<___;
+#include "arm_arch.h"
+
+.text
+___
+
+########################################################################
+# SM3 extension
+#
+# The state is kept as ABCD = {D,C,B,A} and EFGH = {H,G,F,E}, i.e. A and
+# E in the top lanes, which is where SM3SS1 and SM3TT* expect them.
+{
+my ($abcd,$efgh,$abcd_save,$efgh_save)=map("v$_",(16..19));
+my ($ss1,$wp,$t0,$t1,$tc)=map("v$_",(20..24));
+my @W=map("v$_",(0..4));
+my ($tmp0,$tmp1)=map("v$_",(5..6));
+
+sub hw_round {
+my ($ab,$i,$w,$t,$tn)=@_;
+$code.=<<___;
+	sm3ss1		$ss1.4s,$abcd.4s,$t.4s,$efgh.4s
+	shl		$tn.4s,$t.4s,#1
+	sri		$tn.4s,$t.4s,#31
+	sm3tt1$ab		$abcd.4s,$ss1.4s,$wp.s[$i]
+	sm3tt2$ab		$efgh.4s,$ss1.4s,$w.s[$i]
+___
+}
+
+# Four rounds on W[j..j+3] in @W[0], expanding W[j+16..j+19] into @W[4]
+# on the side unless $expand is false.
+sub hw_qround {
+my ($ab,$expand)=@_;
+$code.=<<___	if ($expand);
+	ext		@W[4].16b,@W[1].16b,@W[2].16b,#12
+	ext		$tmp0.16b,@W[0].16b,@W[1].16b,#12
+	ext		$tmp1.16b,@W[2].16b,@W[3].16b,#8
+	sm3partw1	@W[4].4s,@W[0].4s,@W[3].4s
+___
+$code.=<<___;
+	eor		$wp.16b,@W[0].16b,@W[1].16b
+___
+	&hw_round($ab,0,@W[0],$t0,$t1);
+	&hw_round($ab,1,@W[0],$t1,$t0);
+	&hw_round($ab,2,@W[0],$t0,$t1);
+	&hw_round($ab,3,@W[0],$t1,$t0);
+$code.=<<___	if ($expand);
+	sm3partw2	@W[4].4s,$tmp1.4s,$tmp0.4s
+___
+	push(@W,shift(@W));
+}
+
+$code.=<<___;
+.globl	ossl_hwsm3_block_data_order
+.type	ossl_hwsm3_block_data_order,%function
+.align	5
+ossl_hwsm3_block_data_order:
+	ld1		{$abcd.4s,$efgh.4s},[$ctx]
+	adr		x3,.Lsm3_tj
+	rev64		$abcd.4s,$abcd.4s
+	rev64		$efgh.4s,$efgh.4s
+	ld1		{$tc.2s},[x3]
+	ext		$abcd.16b,$abcd.16b,$abcd.16b,#8
+	ext		$efgh.16b,$efgh.16b,$efgh.16b,#8
+
+.Loop_hw:
+	ld1		{@W[0].16b-@W[3].16b},[$inp],#64
+	sub		$num,$num,#1
+	mov		$abcd_save.16b,$abcd.16b
+	mov		$efgh_save.16b,$efgh.16b
+	rev32		@W[0].16b,@W[0].16b
+	rev32		@W[1].16b,@W[1].16b
+	rev32		@W[2].16b,@W[2].16b
+	rev32		@W[3].16b,@W[3].16b
+	ext		$t0.16b,$tc.16b,$tc.16b,#4	// T0 to the top lane
+___
+for ($i=0;$i<4;$i++)	{ &hw_qround("a",1); }
+$code.=<<___;
+	dup		$t0.4s,$tc.s[1]			// rotl(T16,16)
+___
+for (;$i<13;$i++)	{ &hw_qround("b",1); }
+for (;$i<16;$i++)	{ &hw_qround("b",0); }
+$code.=<<___;
+	eor		$abcd.16b,$abcd.16b,$abcd_save.16b
+	eor		$efgh.16b,$efgh.16b,$efgh_save.16b
+	cbnz		$num,.Loop_hw
+
+	rev64		$abcd.4s,$abcd.4s
+	rev64		$efgh.4s,$efgh.4s
+	ext		$abcd.16b,$abcd.16b,$abcd.16b,#8
+	ext		$efgh.16b,$efgh.16b,$efgh.16b,#8
+	st1		{$abcd.4s,$efgh.4s},[$ctx]
+	ret
+.size	ossl_hwsm3_block_data_order,.-ossl_hwsm3_block_data_order
+
+.align	3
+.Lsm3_tj:
+	.long	0x79cc4519,0x9d8a7a87
+___
+}
+
+########################################################################
+# NEON message expansion, integer rounds
+#
+# The schedule is stored on the stack as 64 (W[j],W'[j]) pairs, so that
+# each round fetches its two words with one ldp. Vector k, W[4k..4k+3],
+# lives in @X[k%5]; vector k+5 is expanded and pair k+4 stored while the
+# rounds on pair k run.
+{
+my @V=($A,$B,$C,$D,$E,$F,$G,$H)=map("w$_",(4..11));
+my ($t0,$t1,$t2,$t3,$t4,$t5,$Tj)=map("w$_",(12..17,3));
+my ($Wp,$Sp)=("x19","x20");
+my @X=map("v$_",(0..4));
+my ($x0,$x1,$x2,$x3,$x4,$zero)=map("v$_",(16..20,31));
+
+# Vector $k from the four before it.
+sub neon_expand {
+my $k=shift;
+my ($s0,$s1,$s2,$s3,$d)=map(@X[($k+$_)%5],(1..5));
+
+	(
+	"ext	$x0.16b,$s1.16b,$s2.16b,#12",		# W[j-9..j-6]
+	"ext	$x1.16b,$s3.16b,$zero.16b,#4",		# W[j-3..j-1],0
+	"eor	$x0.16b,$x0.16b,$s0.16b",
+	"shl	$x2.4s,$x1.4s,#15",
+	"sri	$x2.4s,$x1.4s,#17",
+	"ext	$x3.16b,$s0.16b,$s1.16b,#12",		# W[j-13..j-10]
+	"eor	$x0.16b,$x0.16b,$x2.16b",
+	"ext	$x4.16b,$s2.16b,$s3.16b,#8",		# W[j-6..j-3]
+	"shl	$x1.4s,$x0.4s,#15",
+	"shl	$x2.4s,$x0.4s,#23",
+	"sri	$x1.4s,$x0.4s,#17",
+	"sri	$x2.4s,$x0.4s,#9",
+	"eor	$x0.16b,$x0.16b,$x1.16b",
+	"shl	$x1.4s,$x3.4s,#7",
+	"eor	$x0.16b,$x0.16b,$x2.16b",		# P1()
+	"sri	$x1.4s,$x3.4s,#25",
+	"eor	$x0.16b,$x0.16b,$x4.16b",
+	"eor	$d.16b,$x0.16b,$x1.16b",		# lane 3 lacks W[j]
+	"dup	$x0.4s,$d.s[0]",
+	"shl	$x1.4s,$x0.4s,#15",
+	"sri	$x1.4s,$x0.4s,#17",
+	"shl	$x2.4s,$x1.4s,#15",
+	"shl	$x3.4s,$x1.4s,#23",
+	"sri	$x2.4s,$x1.4s,#17",
+	"sri	$x3.4s,$x1.4s,#9",
+	"eor	$x1.16b,$x1.16b,$x2.16b",
+	"eor	$x1.16b,$x1.16b,$x3.16b",		# P1(rotl(W[j],15))
+	"ext	$x1.16b,$zero.16b,$x1.16b,#4",
+	"eor	$d.16b,$d.16b,$x1.16b",
+	);
+}
+
+# Pair $k, i.e. W[4k..4k+3] interleaved with W'[4k..4k+3].
+sub neon_store {
+my $k=shift;
+
+	(
+	"eor	$x4.16b,@X[$k%5].16b,@X[($k+1)%5].16b",
+	"mov	$x3.16b,@X[$k%5].16b",
+	"st2	{$x3.4s,$x4.4s},[$Sp],#32",
+	);
+}
+
+sub round {
+my ($i,$a,$b,$c,$d,$e,$f,$g,$h)=@_;
+my @insns;
+
+	push(@insns,
+	"ror	$t0,$a,#20",			# rotl(A,12)
+	"ldp	$t4,$t5,[$Wp],#8",		# W[i],W'[i]
+	"add	$t1,$t0,$e",
+	"add	$t1,$t1,$Tj");
+	push(@insns, $i==15 ?
+	("movz	$Tj,#0x7a87",
+	 "movk	$Tj,#0x9d8a,lsl#16")		# rotl(T16,16)
+	:
+	("ror	$Tj,$Tj,#31"));
+	push(@insns,
+	"ror	$t1,$t1,#25",			# SS1
+	"add	$h,$h,$t4",
+	"eor	$t0,$t1,$t0",			# SS2
+	"add	$d,$d,$t5",
+	"add	$h,$h,$t1",
+	"add	$d,$d,$t0");
+	push(@insns, $i<16 ?
+	("eor	$t2,$a,$b",
+	 "eor	$t3,$e,$f",
+	 "eor	$t2,$t2,$c",			# FF0(A,B,C)
+	 "eor	$t3,$t3,$g")			# GG0(E,F,G)
+	:
+	("orr	$t2,$a,$b",
+	 "and	$t3,$a,$b",
+	 "and	$t2,$t2,$c",
+	 "bic	$t4,$g,$e",
+	 "orr	$t2,$t2,$t3",			# FF1(A,B,C)
+	 "and	$t3,$e,$f",
+	 "orr	$t3,$t3,$t4"));			# GG1(E,F,G)
+	push(@insns,
+	"add	$d,$d,$t2",			# TT1
+	"add	$h,$h,$t3",			# TT2
+	"ror	$b,$b,#23",			# rotl(B,9)
+	"ror	$f,$f,#13",			# rotl(F,19)
+	"eor	$t0,$h,$h,ror#23",
+	"eor	$h,$t0,$h,ror#15");		# P0(TT2)
+	@insns;
+}
+
+$code.=<<___;
+
+.globl	ossl_sm3_block_data_order_neon
+.type	ossl_sm3_block_data_order_neon,%function
+.align	5
+ossl_sm3_block_data_order_neon:
+	stp		x29,x30,[sp,#-32]!
+	add		x29,sp,#0
+	stp		x19,x20,[sp,#16]
+	sub		sp,sp,#64*8
+
+	ldp		$A,$B,[$ctx]
+	ldp		$C,$D,[$ctx,#8]
+	ldp		$E,$F,[$ctx,#16]
+	ldp		$G,$H,[$ctx,#24]
+	movi		$zero.16b,#0
+
+.Loop_neon:
+	ld1		{@X[0].16b-@X[3].16b},[$inp],#64
+	sub		$num,$num,#1
+	mov		$Wp,sp
+	mov		$Sp,sp
+	movz		$Tj,#0x4519
+	movk		$Tj,#0x79cc,lsl#16
+	rev32		@X[0].16b,@X[0].16b
+	rev32		@X[1].16b,@X[1].16b
+	rev32		@X[2].16b,@X[2].16b
+	rev32		@X[3].16b,@X[3].16b
+___
+foreach (neon_expand(4),map(neon_store($_),(0..3))) {
+	$code.="\t$_\n";
+}
+for ($g=0;$g<16;$g++) {
+my @neon=$g<12 ? (neon_expand($g+5),neon_store($g+4)) : ();
+my @insns;
+
+	foreach (0..3) {
+		push(@insns,round(4*$g+$_,@V));
+		@V=(@V[3,0,1,2],@V[7,4,5,6]);
+	}
+	my ($ni,$nn)=(scalar(@insns),scalar(@neon));
+	for (my $i=0,my $n=0;$i<$ni;$i++) {
+		$code.="\t".$insns[$i]."\n";
+		for (;$n<$nn && $n*$ni<=$i*$nn;$n++) {
+			$code.="\t ".$neon[$n]."\n";
+		}
+	}
+}
+$code.=<<___;
+	ldp		$t0,$t1,[$ctx]
+	ldp		$t2,$t3,[$ctx,#8]
+	ldp		$t4,$t5,[$ctx,#16]
+	eor		$A,$A,$t0
+	eor		$B,$B,$t1
+	ldp		$t0,$t1,[$ctx,#24]
+	eor		$C,$C,$t2
+	eor		$D,$D,$t3
+	eor		$E,$E,$t4
+	eor		$F,$F,$t5
+	stp		$A,$B,[$ctx]
+	eor		$G,$G,$t0
+	eor		$H,$H,$t1
+	stp		$C,$D,[$ctx,#8]
+	stp		$E,$F,[$ctx,#16]
+	stp		$G,$H,[$ctx,#24]
+	cbnz		$num,.Loop_neon
+
+	add		sp,sp,#64*8
+	ldp		x19,x20,[sp,#16]
+	ldp		x29,x30,[sp],#32
+	ret
+.size	ossl_sm3_block_data_order_neon,.-ossl_sm3_block_data_order_neon
+___
+}
+
+########################################################################
+# Multi-buffer NEON
+#
+# ossl_sm3_multi_block hashes four independent streams in lockstep, one
+# per lane, and advances each of them by the same number of blocks; see
+# crypto/sm3/sm3_mb.c for the rest. The schedule is stored on the stack
+# as 68 vectors of W[j] for the four lanes. The rotated B and F are not
+# moved back, instead the register allocation follows them.
+{
+my @V=map("v$_",(0..7));
+my @P=map("v$_",(16..21));
+my ($x0,$x1,$x2,$x3,$x4)=map("v$_",(24..28));
+my @ptr=map("x$_",(4..7));
+my $Tp="x3";
+
+sub qreg { my $r=shift; $r=~s/^v/q/; $r; }
+
+# W[k] from the words before it
+sub mb_expand {
+my $k=shift;
+
+	(
+	"ldr	".qreg($x0).",[sp,#".(16*($k-16))."]",
+	"ldr	".qreg($x1).",[sp,#".(16*($k-9))."]",
+	"ldr	".qreg($x2).",[sp,#".(16*($k-3))."]",
+	"eor	$x0.16b,$x0.16b,$x1.16b",
+	"shl	$x1.4s,$x2.4s,#15",
+	"sri	$x1.4s,$x2.4s,#17",
+	"ldr	".qreg($x3).",[sp,#".(16*($k-13))."]",
+	"eor	$x0.16b,$x0.16b,$x1.16b",
+	"ldr	".qreg($x4).",[sp,#".(16*($k-6))."]",
+	"shl	$x1.4s,$x0.4s,#15",
+	"shl	$x2.4s,$x0.4s,#23",
+	"sri	$x1.4s,$x0.4s,#17",
+	"sri	$x2.4s,$x0.4s,#9",
+	"eor	$x0.16b,$x0.16b,$x1.16b",
+	"shl	$x1.4s,$x3.4s,#7",
+	"eor	$x0.16b,$x0.16b,$x2.16b",		# P1()
+	"sri	$x1.4s,$x3.4s,#25",
+	"eor	$x0.16b,$x0.16b,$x4.16b",
+	"eor	$x0.16b,$x0.16b,$x1.16b",
+	"str	".qreg($x0).",[sp,#".(16*$k)."]",
+	);
+}
+
+sub mb_round {
+my $i=shift;
+my ($a,$b,$c,$d,$e,$f,$g,$h)=@V;
+my ($t0,$t1,$t2,$t3,$tb,$tf)=@P;
+my @insns;
+
+	push(@insns,
+	"shl	$t0.4s,$a.4s,#12",
+	"ld1r	{$t2.4s},[$Tp],#4",
+	"sri	$t0.4s,$a.4s,#20",		# rotl(A,12)
+	"ldr	".qreg($t3).",[sp,#".(16*($i+4))."]",
+	"add	$t1.4s,$t0.4s,$e.4s",
+	"ldr	".qreg($tb).",[sp,#".(16*$i)."]",
+	"add	$t1.4s,$t1.4s,$t2.4s",
+	"eor	$t3.16b,$t3.16b,$tb.16b",
+	"add	$h.4s,$h.4s,$tb.4s",		# H+=W[i]
+	"shl	$t2.4s,$t1.4s,#7",
+	"add	$d.4s,$d.4s,$t3.4s",		# D+=W'[i]
+	"sri	$t2.4s,$t1.4s,#25",		# SS1
+	"eor	$t0.16b,$t0.16b,$t2.16b",	# SS2
+	"add	$h.4s,$h.4s,$t2.4s",
+	"add	$d.4s,$d.4s,$t0.4s");
+	push(@insns, $i<16 ?
+	("eor	$t0.16b,$a.16b,$b.16b",
+	 "eor	$t1.16b,$e.16b,$f.16b",
+	 "eor	$t0.16b,$t0.16b,$c.16b",	# FF0(A,B,C)
+	 "eor	$t1.16b,$t1.16b,$g.16b")	# GG0(E,F,G)
+	:
+	("eor	$t0.16b,$a.16b,$b.16b",
+	 "mov	$t1.16b,$e.16b",
+	 "bsl	$t0.16b,$c.16b,$a.16b",	# FF1(A,B,C)
+	 "bsl	$t1.16b,$f.16b,$g.16b"));	# GG1(E,F,G)
+	push(@insns,
+	"add	$d.4s,$d.4s,$t0.4s",		# TT1
+	"add	$h.4s,$h.4s,$t1.4s",		# TT2
+	"shl	$tb.4s,$b.4s,#9",
+	"shl	$tf.4s,$f.4s,#19",
+	"sri	$tb.4s,$b.4s,#23",		# rotl(B,9)
+	"sri	$tf.4s,$f.4s,#13",		# rotl(F,19)
+	"shl	$t0.4s,$h.4s,#9",
+	"shl	$t1.4s,$h.4s,#17",
+	"sri	$t0.4s,$h.4s,#23",
+	"sri	$t1.4s,$h.4s,#15",
+	"eor	$t0.16b,$t0.16b,$t1.16b",
+	"eor	$h.16b,$h.16b,$t0.16b");	# P0(TT2)
+
+	@P=($t0,$t1,$t2,$t3,$b,$f);
+	@V=($d,$a,$tb,$c,$h,$e,$tf,$g);
+	@insns;
+}
+
+$code.=<<___;
+
+.globl	ossl_sm3_multi_block
+.type	ossl_sm3_multi_block,%function
+.align	5
+ossl_sm3_multi_block:
+	cbz		$num,.Lmb_abort
+	stp		x29,x30,[sp,#-16]!
+	add		x29,sp,#0
+	sub		sp,sp,#68*16
+
+	ldp		@ptr[0],@ptr[1],[$inp]
+	ldp		@ptr[2],@ptr[3],[$inp,#16]
+	ld1		{@V[0].4s-@V[3].4s},[$ctx],#64
+	ld1		{@V[4].4s-@V[7].4s},[$ctx]
+	sub		$ctx,$ctx,#64
+
+.Loop_mb:
+___
+for (my $c=0;$c<4;$c++) {
+    for (my $l=0;$l<4;$l++) {
+	$code.="\tld1		{v".(16+4*$c+$l).".16b},[@ptr[$l]],#16\n";
+    }
+}
+for (my $i=16;$i<32;$i++) {
+	$code.="\trev32		v$i.16b,v$i.16b\n";
+}
+$code.=<<___;
+	mov		x8,sp
+	adr		$Tp,.Lsm3_tj_mb
+	st4		{v16.4s-v19.4s},[x8],#64
+	st4		{v20.4s-v23.4s},[x8],#64
+	st4		{v24.4s-v27.4s},[x8],#64
+	st4		{v28.4s-v31.4s},[x8]
+	sub		$num,$num,#1
+___
+for (my $i=0;$i<64;$i++) {
+	my @insns=mb_round($i);
+	my @vec=$i>=11 && $i<63 ? mb_expand($i+5) : ();
+
+	splice(@insns,int(@insns/3),0,@vec);
+	foreach (@insns) {
+		$code.="\t$_\n";
+	}
+}
+$code.=<<___;
+	ld1		{v24.4s-v27.4s},[$ctx],#64
+	ld1		{v28.4s-v31.4s},[$ctx]
+	sub		$ctx,$ctx,#64
+___
+for (my $i=0;$i<8;$i++) {
+	$code.="\teor		v".(24+$i).".16b,v".(24+$i).".16b,@V[$i].16b\n";
+}
+$code.=<<___;
+	st1		{v24.4s-v27.4s},[$ctx],#64
+	st1		{v28.4s-v31.4s},[$ctx]
+	sub		$ctx,$ctx,#64
+___
+for (my $i=0;$i<8;$i++) {
+	$code.="\tmov		v$i.16b,v".(24+$i).".16b\n";
+}
+$code.=<<___;
+	cbnz		$num,.Loop_mb
+
+	add		sp,sp,#68*16
+	ldp		x29,x30,[sp],#16
+.Lmb_abort:
+	ret
+.size	ossl_sm3_multi_block,.-ossl_sm3_multi_block
+
+.align	6
+.Lsm3_tj_mb:
+___
+for (my $i=0;$i<64;$i++) {
+	my $t=$i<16 ? 0x79cc4519 : 0x7a879d8a;
+	my $n=$i%32;
+	$t=(($t<<$n)|($t>>(32-$n)))&0xffffffff if ($n);
+	$code.=sprintf("\t.long	0x%08x\n",$t);
+}
+}
+
+{   my  %opcode = (
+	"sm3partw1"	=> 0xce60c000,	"sm3partw2"	=> 0xce60c400,
+	"sm3tt1a"	=> 0xce408000,	"sm3tt1b"	=> 0xce408400,
+	"sm3tt2a"	=> 0xce408800,	"sm3tt2b"	=> 0xce408c00	);
+
+    sub unsm3 {
+	my ($mnemonic,$arg)=@_;
+
+	$arg =~ m/v([0-9]+)[^,]*,\s*v([0-9]+)[^,]*,\s*v([0-9]+)(?:\.s\[([0-3])\])?/o
+	&&
+	sprintf ".inst\t0x%08x\t//%s %s",
+			$opcode{$mnemonic}|$1|($2<<5)|($3<<16)|($4<<12),
+			$mnemonic,$arg;
+    }
+
+    sub unsm3ss1 {
+	my ($mnemonic,$arg)=@_;
+
+	$arg =~ m/v([0-9]+)[^,]*,\s*v([0-9]+)[^,]*,\s*v([0-9]+)[^,]*,\s*v([0-9]+)/o
+	&&
+	sprintf ".inst\t0x%08x\t//%s %s",
+			0xce400000|$1|($2<<5)|($3<<16)|($4<<10),
+			$mnemonic,$arg;
+    }
+}
+
+open SELF,$0;
+while(<SELF>) {
+        next if (/^#!/);
+        last if (!s/^#/\/\// and !/^$/);
+        print;
+}
+close SELF;
+
+foreach(split("\n",$code)) {
+
+	s/\`([^\`]*)\`/eval($1)/ge;
+
+	s/\b(sm3ss1)\s+(v.*)/unsm3ss1($1,$2)/ge	or
+	s/\b(sm3\w+)\s+(v.*)/unsm3($1,$2)/ge;
+
+	print $_,"\n";
+}
+
+close STDOUT or die "error closing STDOUT: $!";
@@ -0,0 +1,503 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# Multi-buffer SM3 for x86_64.
+#
+# ossl_sm3_multi_block hashes eight independent streams in lockstep, one
+# per 32-bit lane of a ymm register, and advances each of them by the
+# same number of blocks. Ragged lengths and padding are dealt with by the
+# caller, see crypto/sm3/sm3_mb.c. On processors with AVX512VL the
+# rotations are done with vprold and the boolean functions with
+# vpternlogd, still on ymm registers.
+#
+# The caller is expected to check ossl_sm3_avx2_eligible(), from
+# sm3-x86_64.pl, first.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+push(@INC,"${dir}","${dir}../../perlasm");
+require "x86_64-support.pl";
+
+$ptr_size=&pointer_size($flavour);
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
+}
+
+if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)(?:\.([0-9]+))?/) {
+	$avx = ($1>=2.09) + ($1>=2.10) + ($1>=2.12);
+	$avx += 1 if ($1==2.11 && $2>=8);
+}
+
+if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
+	   `ml64 2>&1` =~ /Version ([0-9]+)\./) {
+	$avx = ($1>=10) + ($1>=11);
+}
+
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+$func="ossl_sm3_multi_block";
+($ctx,$inp,$num)=("%rdi","%rsi","%rdx");
+
+$code.=<<___;
+.text
+___
+
+if ($avx>1) {{{
+my @ptr=map("%r$_",(8..15));
+my @V=map("%ymm$_",(0..7));
+my @T=map("%ymm$_",(8..15));
+my $_rsp="2176(%rsp)";
+my $framesz=2192+$win64*16*10;
+my $avx512;
+
+sub W { 32*shift()."(%rsp)"; }
+
+# d = rotl(s,n), clobbers t
+sub rotl {
+my ($n,$s,$d,$t)=@_;
+
+    return ("vprold	\$$n,$s,$d") if ($avx512);
+    (
+	"vpsrld	\$".(32-$n).",$s,$t",
+	"vpslld	\$$n,$s,$d",
+	"vpor	$t,$d,$d",
+    );
+}
+
+# W[k] from the words before it
+sub expand {
+my $k=shift;
+my ($x0,$x1,$x2,$x3)=@T[4..7];
+
+    return (
+	"vprold	\$15,".W($k-3).",$x1",
+	"vmovdqa	".W($k-16).",$x0",
+	"vpternlogd	\$0x96,".W($k-9).",$x1,$x0",
+	"vprold	\$15,$x0,$x1",
+	"vprold	\$23,$x0,$x2",
+	"vpternlogd	\$0x96,$x2,$x1,$x0",		# P1()
+	"vprold	\$7,".W($k-13).",$x2",
+	"vpternlogd	\$0x96,".W($k-6).",$x2,$x0",
+	"vmovdqa	$x0,".W($k),
+    ) if ($avx512);
+
+    (
+	"vmovdqa	".W($k-3).",$x2",
+	"vmovdqa	".W($k-16).",$x0",
+	&rotl(15,$x2,$x1,$x3),
+	"vpxor	".W($k-9).",$x0,$x0",
+	"vpxor	$x1,$x0,$x0",
+	&rotl(15,$x0,$x1,$x3),
+	&rotl(23,$x0,$x2,$x3),
+	"vpxor	$x1,$x0,$x0",
+	"vmovdqa	".W($k-13).",$x1",
+	"vpxor	$x2,$x0,$x0",			# P1()
+	&rotl(7,$x1,$x2,$x3),
+	"vpxor	".W($k-6).",$x0,$x0",
+	"vpxor	$x2,$x0,$x0",
+	"vmovdqa	$x0,".W($k),
+    );
+}
+
+sub round {
+my ($i,$a,$b,$c,$d,$e,$f,$g,$h)=@_;
+my ($t0,$t1,$t2,$t3)=@T[0..3];
+my @insns;
+
+    push(@insns,
+	&rotl(12,$a,$t0,$t1),			# rotl(A,12)
+	"vpbroadcastd	".(4*$i)."(%rax),$t2",
+	"vpaddd	$e,$t0,$t1",
+	"vpaddd	$t2,$t1,$t1",
+	"vmovdqa	".W($i).",$t2",
+	"vpaddd	$t2,$h,$h",			# H+=W[i]
+	"vpxor	".W($i+4).",$t2,$t2",
+	"vpaddd	$t2,$d,$d",			# D+=W'[i]
+	&rotl(7,$t1,$t1,$t2),			# SS1
+	"vpxor	$t1,$t0,$t0",			# SS2
+	"vpaddd	$t1,$h,$h",
+	"vpaddd	$t0,$d,$d");
+    if ($avx512) {
+	push(@insns,
+	"vmovdqa	$a,$t2",
+	"vmovdqa	$e,$t3",
+	$i<16 ? "vpternlogd	\$0x96,$c,$b,$t2"	# FF0(A,B,C)
+	      : "vpternlogd	\$0xe8,$c,$b,$t2",	# FF1(A,B,C)
+	$i<16 ? "vpternlogd	\$0x96,$g,$f,$t3"	# GG0(E,F,G)
+	      : "vpternlogd	\$0xca,$g,$f,$t3");	# GG1(E,F,G)
+    } elsif ($i<16) {
+	push(@insns,
+	"vpxor	$b,$a,$t2",
+	"vpxor	$f,$e,$t3",
+	"vpxor	$c,$t2,$t2",			# FF0(A,B,C)
+	"vpxor	$g,$t3,$t3");			# GG0(E,F,G)
+    } else {
+	push(@insns,
+	"vpor	$b,$a,$t2",
+	"vpand	$b,$a,$t0",
+	"vpand	$c,$t2,$t2",
+	"vpxor	$g,$f,$t3",
+	"vpor	$t0,$t2,$t2",			# FF1(A,B,C)
+	"vpand	$e,$t3,$t3",
+	"vpxor	$g,$t3,$t3");			# GG1(E,F,G)
+    }
+    push(@insns,
+	"vpaddd	$t2,$d,$d",
+	"vpaddd	$t3,$h,$h",
+	&rotl(9,$b,$b,$t0),
+	&rotl(19,$f,$f,$t1),
+	&rotl(9,$h,$t2,$t0),
+	&rotl(17,$h,$t3,$t1));
+    push(@insns, $avx512 ?
+	"vpternlogd	\$0x96,$t3,$t2,$h" : (	# P0(TT2)
+	"vpxor	$t2,$h,$h",
+	"vpxor	$t3,$h,$h"));
+    @insns;
+}
+
+sub body {
+my ($suffix)=@_;
+my @R=@V;
+
+    $code.=".Loop_$suffix:\n";
+    for (my $c=0;$c<4;$c++) {
+	my @t=@T[0..3];
+	my @u=@T[4..7];
+
+	for (my $i=0;$i<4;$i++) {
+	    my $x=$t[$i]; $x=~s/%y/%x/;
+	    $code.=<<___;
+	vmovdqu	`16*$c`(@ptr[$i]),$x
+	vinserti128	\$1,`16*$c`(@ptr[$i+4]),$t[$i],$t[$i]
+___
+	}
+	$code.=<<___;
+	vpunpckldq	$t[1],$t[0],$u[0]
+	vpunpckhdq	$t[1],$t[0],$u[1]
+	vpunpckldq	$t[3],$t[2],$u[2]
+	vpunpckhdq	$t[3],$t[2],$u[3]
+	vpunpcklqdq	$u[2],$u[0],$t[0]
+	vpunpckhqdq	$u[2],$u[0],$t[1]
+	vpunpcklqdq	$u[3],$u[1],$t[2]
+	vpunpckhqdq	$u[3],$u[1],$t[3]
+___
+	for (my $i=0;$i<4;$i++) {
+	    $code.=<<___;
+	vpshufb	.Lbswap(%rip),$t[$i],$t[$i]
+	vmovdqa	$t[$i],`32*(4*$c+$i)`(%rsp)
+___
+	}
+    }
+    foreach (@ptr) {
+	$code.="\tlea	64($_),$_\n";
+    }
+
+    for (my $i=0;$i<64;$i++) {
+	my @insns=round($i,@R);
+	my @vec=$i>=11 && $i<63 ? expand($i+5) : ();
+
+	@R=(@R[3,0,1,2],@R[7,4,5,6]);
+	splice(@insns,int(@insns/3),0,@vec);
+	foreach (@insns) {
+	    $code.="\t$_\n";
+	}
+    }
+
+    for (my $i=0;$i<8;$i++) {
+	$code.=<<___;
+	vpxor	`32*$i`($ctx),@V[$i],@V[$i]
+	vmovdqu	@V[$i],`32*$i`($ctx)
+___
+    }
+    $code.=<<___;
+	dec	$num
+	jnz	.Loop_$suffix
+	jmp	.Ldone_mb
+___
+}
+
+$code.=<<___;
+.extern	OPENSSL_ia32cap_P
+.globl	$func
+.type	$func,\@function,3
+.align	64
+$func:
+.cfi_startproc
+	mov	%rsp,%rax		# copy %rsp
+.cfi_def_cfa_register	%rax
+	push	%rbx
+.cfi_push	%rbx
+	push	%rbp
+.cfi_push	%rbp
+	push	%r12
+.cfi_push	%r12
+	push	%r13
+.cfi_push	%r13
+	push	%r14
+.cfi_push	%r14
+	push	%r15
+.cfi_push	%r15
+	sub	\$$framesz,%rsp
+	and	\$-64,%rsp		# align stack frame
+	mov	%rax,$_rsp		# save copy of %rsp
+.cfi_cfa_expression	$_rsp,deref,+8
+___
+$code.=<<___ if ($win64);
+	movaps	%xmm6,2192(%rsp)
+	movaps	%xmm7,2208(%rsp)
+	movaps	%xmm8,2224(%rsp)
+	movaps	%xmm9,2240(%rsp)
+	movaps	%xmm10,2256(%rsp)
+	movaps	%xmm11,2272(%rsp)
+	movaps	%xmm12,2288(%rsp)
+	movaps	%xmm13,2304(%rsp)
+	movaps	%xmm14,2320(%rsp)
+	movaps	%xmm15,2336(%rsp)
+___
+$code.=<<___;
+.Lprologue_mb:
+
+	test	$num,$num
+	jz	.Ldone_mb
+___
+for (my $i=0;$i<8;$i++) {
+    my $ptr_reg=&pointer_register($flavour,@ptr[$i]);
+    $code.="\tmov	`$ptr_size*$i`($inp),$ptr_reg\n";
+}
+for (my $i=0;$i<8;$i++) {
+    $code.="\tvmovdqu	`32*$i`($ctx),@V[$i]\n";
+}
+$code.=<<___;
+	mov	OPENSSL_ia32cap_P+8(%rip),%ebx
+	lea	.Lsm3_tj(%rip),%rax
+___
+if ($avx>2) {
+$code.=<<___;
+	and	\$`1<<31|1<<16`,%ebx	# check for AVX512VL+AVX512F
+	cmp	\$`1<<31|1<<16`,%ebx
+	je	.Loop_avx512
+___
+}
+$code.=<<___;
+	jmp	.Loop_avx2
+.align	32
+___
+	$avx512=0; &body("avx2");
+if ($avx>2) {
+$code.=".align	32\n";
+	$avx512=1; &body("avx512");
+}
+$code.=<<___;
+.Ldone_mb:
+	mov	$_rsp,%rsi
+.cfi_def_cfa	%rsi,8
+	vzeroupper
+___
+$code.=<<___ if ($win64);
+	movaps	2192(%rsp),%xmm6
+	movaps	2208(%rsp),%xmm7
+	movaps	2224(%rsp),%xmm8
+	movaps	2240(%rsp),%xmm9
+	movaps	2256(%rsp),%xmm10
+	movaps	2272(%rsp),%xmm11
+	movaps	2288(%rsp),%xmm12
+	movaps	2304(%rsp),%xmm13
+	movaps	2320(%rsp),%xmm14
+	movaps	2336(%rsp),%xmm15
+___
+$code.=<<___;
+	mov	-48(%rsi),%r15
+.cfi_restore	%r15
+	mov	-40(%rsi),%r14
+.cfi_restore	%r14
+	mov	-32(%rsi),%r13
+.cfi_restore	%r13
+	mov	-24(%rsi),%r12
+.cfi_restore	%r12
+	mov	-16(%rsi),%rbp
+.cfi_restore	%rbp
+	mov	-8(%rsi),%rbx
+.cfi_restore	%rbx
+	lea	(%rsi),%rsp
+.cfi_def_cfa_register	%rsp
+.Lepilogue_mb:
+	ret
+.cfi_endproc
+.size	$func,.-$func
+
+.align	64
+.Lsm3_tj:
+___
+for (my $i=0;$i<64;$i++) {
+    my $t=$i<16 ? 0x79cc4519 : 0x7a879d8a;
+    my $n=$i%32;
+    $t=(($t<<$n)|($t>>(32-$n)))&0xffffffff if ($n);
+    $code.=sprintf("\t.long	0x%08x\n",$t);
+}
+$code.=<<___;
+.Lbswap:
+	.byte	3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12
+	.byte	3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12
+.asciz	"Multi-buffer SM3 for x86_64, CRYPTOGAMS by <appro\@openssl.org>"
+___
+
+# EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
+#		CONTEXT *context,DISPATCHER_CONTEXT *disp)
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	se_handler,\@abi-omnipotent
+.align	16
+se_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HanderlData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lin_prologue
+
+	mov	152($context),%rax	# pull context->Rsp
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lin_prologue
+
+	mov	%rax,%rsi		# put aside Rsp
+	mov	2176(%rax),%rax		# pull $_rsp
+
+	mov	-8(%rax),%rbx
+	mov	-16(%rax),%rbp
+	mov	-24(%rax),%r12
+	mov	-32(%rax),%r13
+	mov	-40(%rax),%r14
+	mov	-48(%rax),%r15
+	mov	%rbx,144($context)	# restore context->Rbx
+	mov	%rbp,160($context)	# restore context->Rbp
+	mov	%r12,216($context)	# restore context->R12
+	mov	%r13,224($context)	# restore context->R13
+	mov	%r14,232($context)	# restore context->R14
+	mov	%r15,240($context)	# restore context->R15
+
+	lea	2192(%rsi),%rsi		# Xmm6- save area
+	lea	512($context),%rdi	# &context.Xmm6
+	mov	\$20,%ecx
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lin_prologue:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	se_handler,.-se_handler
+
+.section	.pdata
+.align	4
+	.rva	.LSEH_begin_$func
+	.rva	.LSEH_end_$func
+	.rva	.LSEH_info_$func
+
+.section	.xdata
+.align	8
+.LSEH_info_$func:
+	.byte	9,0,0,0
+	.rva	se_handler
+	.rva	.Lprologue_mb,.Lepilogue_mb		# HandlerData[]
+___
+}
+}}} else {{{
+$code.=<<___;
+.globl	$func
+.type	$func,\@abi-omnipotent
+$func:
+	.byte	0x0f,0x0b	# ud2
+	ret
+.size	$func,.-$func
+___
+}}}
+
+foreach (split("\n",$code)) {
+	s/\`([^\`]*)\`/eval($1)/geo;
+
+	print $_,"\n";
+}
+
+close STDOUT or die "error closing STDOUT: $!";
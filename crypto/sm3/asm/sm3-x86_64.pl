@@ -0,0 +1,524 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# SM3 for x86_64.
+#
+# ossl_sm3_block_data_order_avx2 does the rounds in integer registers with
+# BMI1/BMI2 rorx and andn. The message expansion, W[j] together with
+# W'[j] = W[j] ^ W[j+4], runs in xmm registers four words ahead of the
+# rounds and is interleaved with them. It is only three words wide, W[j+3]
+# depends on W[j], so the fourth lane is fixed up separately, which P1
+# being linear makes cheap. On processors with AVX512VL the rotations in
+# the expansion are done with vprold and the three-way XORs with
+# vpternlogd.
+#
+# The caller checks OPENSSL_ia32cap_P for BMI1, AVX2 and BMI2 first, see
+# AVX2SM3_CAPABLE. If the assembler is too old for the code, the function
+# hands over to the C ossl_sm3_block_data_order instead and
+# ossl_sm3_avx2_eligible(), which also covers the multi-block code,
+# returns 0.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
+}
+
+if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)(?:\.([0-9]+))?/) {
+	$avx = ($1>=2.09) + ($1>=2.10) + ($1>=2.12);
+	$avx += 1 if ($1==2.11 && $2>=8);
+}
+
+if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
+	   `ml64 2>&1` =~ /Version ([0-9]+)\./) {
+	$avx = ($1>=10) + ($1>=11);
+}
+
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+$func="ossl_sm3_block_data_order_avx2";
+($ctx,$inp,$end)=("%rdi","%rsi","%rdx");
+
+$code.=<<___;
+.text
+___
+
+if ($avx>1) {{{
+my @V=map("%e$_",qw(ax bx cx)); push(@V,map("%r${_}d",(8..12)));
+my ($t0,$t1,$t2,$t3)=("%r13d","%r14d","%ebp","%r15d");
+my @X=map("%xmm$_",(0..4));
+my ($x0,$x1,$x2,$x3,$x4,$bswap)=map("%xmm$_",(5..10));
+my $_rsp="512(%rsp)";
+my $framesz=528+$win64*16*5;
+my $avx512;
+
+sub r64 { my $r=shift; $r=~s/^%e/%r/; $r=~s/(%r\d+)d$/$1/; $r; }
+
+# Vector $k, i.e. W[4k..4k+3], from the four before it.
+sub expand {
+my $k=shift;
+my ($s0,$s1,$s2,$s3,$d)=map(@X[($k+$_)%5],(1..5));
+
+    return (
+	"vpalignr	\$12,$s1,$s2,$x0",		# W[j-9..j-6]
+	"vpsrldq	\$4,$s3,$x1",			# W[j-3..j-1],0
+	"vpxor	$s0,$x0,$x0",
+	"vprold	\$15,$x1,$x2",
+	"vpalignr	\$12,$s0,$s1,$x3",		# W[j-13..j-10]
+	"vpxor	$x2,$x0,$x0",
+	"vprold	\$7,$x3,$x3",
+	"vprold	\$15,$x0,$x1",
+	"vprold	\$23,$x0,$x2",
+	"vpalignr	\$8,$s2,$s3,$x4",		# W[j-6..j-3]
+	"vpternlogd	\$0x96,$x2,$x1,$x0",	# P1()
+	"vpternlogd	\$0x96,$x4,$x3,$x0",	# lane 3 lacks W[j]
+	"vpslldq	\$12,$x0,$x1",
+	"vprold	\$15,$x1,$x1",
+	"vprold	\$15,$x1,$x2",
+	"vprold	\$23,$x1,$x3",
+	"vpternlogd	\$0x96,$x3,$x2,$x1",	# P1(rotl(W[j],15))
+	"vpxor	$x1,$x0,$d",
+    ) if ($avx512);
+
+    return (
+	"vpalignr	\$12,$s1,$s2,$x0",		# W[j-9..j-6]
+	"vpsrldq	\$4,$s3,$x1",			# W[j-3..j-1],0
+	"vpxor	$s0,$x0,$x0",
+	"vpslld	\$15,$x1,$x2",
+	"vpsrld	\$17,$x1,$x1",
+	"vpalignr	\$12,$s0,$s1,$x3",		# W[j-13..j-10]
+	"vpxor	$x2,$x0,$x0",
+	"vpxor	$x1,$x0,$x0",
+	"vpalignr	\$8,$s2,$s3,$x4",		# W[j-6..j-3]
+	"vpslld	\$15,$x0,$x1",
+	"vpsrld	\$17,$x0,$x2",
+	"vpxor	$x0,$x1,$x1",
+	"vpxor	$x2,$x1,$x1",
+	"vpslld	\$23,$x0,$x2",
+	"vpsrld	\$9,$x0,$x0",
+	"vpxor	$x2,$x1,$x1",
+	"vpxor	$x1,$x0,$x0",			# P1()
+	"vpslld	\$7,$x3,$x1",
+	"vpsrld	\$25,$x3,$x3",
+	"vpxor	$x4,$x0,$x0",
+	"vpxor	$x1,$x0,$x0",
+	"vpxor	$x3,$x0,$x0",			# lane 3 lacks W[j]
+	"vpslldq	\$12,$x0,$x1",
+	"vpslld	\$15,$x1,$x2",
+	"vpsrld	\$17,$x1,$x1",
+	"vpxor	$x2,$x1,$x1",			# rotl(W[j],15)
+	"vpslld	\$15,$x1,$x2",
+	"vpsrld	\$17,$x1,$x3",
+	"vpxor	$x2,$x0,$x0",
+	"vpslld	\$23,$x1,$x4",
+	"vpxor	$x3,$x0,$x0",
+	"vpsrld	\$9,$x1,$x2",
+	"vpxor	$x4,$x0,$x0",
+	"vpxor	$x2,$x0,$x0",
+	"vpxor	$x1,$x0,$d",			# with P1(rotl(W[j],15))
+    );
+}
+
+# W[4k..4k+3] and W'[4k..4k+3] to the stack.
+sub store {
+my $k=shift;
+
+    (
+	"vmovdqa	@X[$k%5],".(16*$k)."(%rsp)",
+	"vpxor	@X[$k%5],@X[($k+1)%5],$x4",
+	"vmovdqa	$x4,".(256+16*$k)."(%rsp)",
+    );
+}
+
+sub round {
+my ($i,$a,$b,$c,$d,$e,$f,$g,$h)=@_;
+my $T=(($i<16?0x79cc4519:0x7a879d8a)<<($i%32)|($i<16?0x79cc4519:0x7a879d8a)>>(32-$i%32))&0xffffffff;
+   $T-=1<<32 if ($T>=1<<31);
+my @insns;
+
+    push(@insns, $i<16 ? (
+	"add	".(256+4*$i)."(%rsp),$d",	# D+=W'[i]
+	"mov	$a,$t2",
+	"add	".(4*$i)."(%rsp),$h",		# H+=W[i]
+	"mov	$e,$t3",
+	"rorx	\$20,$a,$t0",			# rotl(A,12)
+	"xor	$b,$t2",
+	"xor	$f,$t3",
+	"lea	$T(".r64($t0).",".r64($e)."),$t1",
+	"xor	$c,$t2",			# FF0(A,B,C)
+	"xor	$g,$t3",			# GG0(E,F,G)
+	"rorx	\$25,$t1,$t1",			# SS1
+	"add	$t2,$d",
+	"add	$t3,$h") : (
+	"add	".(256+4*$i)."(%rsp),$d",	# D+=W'[i]
+	"mov	$a,$t2",
+	"add	".(4*$i)."(%rsp),$h",		# H+=W[i]
+	"mov	$a,$t3",
+	"rorx	\$20,$a,$t0",			# rotl(A,12)
+	"and	$b,$t2",			# A&B
+	"xor	$b,$t3",
+	"lea	$T(".r64($t0).",".r64($e)."),$t1",
+	"and	$c,$t3",			# (A^B)&C
+	"add	$t2,$d",
+	"rorx	\$25,$t1,$t1",			# SS1
+	"andn	$g,$e,$t2",			# ~E&G
+	"add	$t3,$d",			# FF1(A,B,C)
+	"mov	$e,$t3",
+	"and	$f,$t3",			# E&F
+	"add	$t2,$h",
+	"add	$t3,$h"));			# GG1(E,F,G)
+    push(@insns,
+	"xor	$t1,$t0",			# SS2
+	"add	$t1,$h",
+	"add	$t0,$d");
+    push(@insns,
+	"rol	\$9,$b",
+	"rorx	\$23,$h,$t0",
+	"rol	\$19,$f",
+	"rorx	\$15,$h,$t1",
+	"xor	$t0,$h",
+	"xor	$t1,$h");			# P0(TT2)
+    @insns;
+}
+
+sub body {
+my ($suffix)=@_;
+my @R=@V;
+
+    $code.=<<___;
+.Loop_$suffix:
+	vmovdqu	0x00($inp),@X[0]
+	vmovdqu	0x10($inp),@X[1]
+	vmovdqu	0x20($inp),@X[2]
+	vmovdqu	0x30($inp),@X[3]
+	lea	0x40($inp),$inp
+	vpshufb	$bswap,@X[0],@X[0]
+	vpshufb	$bswap,@X[1],@X[1]
+	vpshufb	$bswap,@X[2],@X[2]
+	vpshufb	$bswap,@X[3],@X[3]
+___
+    foreach (expand(4),map(store($_),(0..3))) {
+	$code.="\t$_\n";
+    }
+    for (my $g=0;$g<16;$g++) {
+	my @vec=$g<12 ? (expand($g+5),store($g+4)) : ();
+	my @insns;
+
+	foreach (0..3) {
+	    push(@insns,round(4*$g+$_,@R));
+	    @R=(@R[3,0,1,2],@R[7,4,5,6]);
+	}
+	my ($ni,$nv)=(scalar(@insns),scalar(@vec));
+	for (my $i=0,my $n=0;$i<$ni;$i++) {
+	    $code.="\t".$insns[$i]."\n";
+	    for (;$n<$nv && $n*$ni<=$i*$nv;$n++) {
+		$code.="\t ".$vec[$n]."\n";
+	    }
+	}
+    }
+    $code.=<<___;
+	xor	0($ctx),@V[0]
+	xor	4($ctx),@V[1]
+	xor	8($ctx),@V[2]
+	xor	12($ctx),@V[3]
+	xor	16($ctx),@V[4]
+	xor	20($ctx),@V[5]
+	xor	24($ctx),@V[6]
+	xor	28($ctx),@V[7]
+	mov	@V[0],0($ctx)
+	mov	@V[1],4($ctx)
+	mov	@V[2],8($ctx)
+	mov	@V[3],12($ctx)
+	mov	@V[4],16($ctx)
+	mov	@V[5],20($ctx)
+	mov	@V[6],24($ctx)
+	mov	@V[7],28($ctx)
+	cmp	$end,$inp
+	jne	.Loop_$suffix
+	jmp	.Ldone_avx2
+___
+}
+
+$code.=<<___;
+.extern	OPENSSL_ia32cap_P
+.globl	ossl_sm3_avx2_eligible
+.type	ossl_sm3_avx2_eligible,\@abi-omnipotent
+.align	32
+ossl_sm3_avx2_eligible:
+	mov	OPENSSL_ia32cap_P+8(%rip),%ecx
+	xor	%eax,%eax
+	and	\$`1<<8|1<<5|1<<3`,%ecx		# check for BMI2+AVX2+BMI1
+	cmp	\$`1<<8|1<<5|1<<3`,%ecx
+	sete	%al
+	ret
+.size	ossl_sm3_avx2_eligible,.-ossl_sm3_avx2_eligible
+
+.globl	$func
+.type	$func,\@function,3
+.align	64
+$func:
+.cfi_startproc
+	mov	%rsp,%rax		# copy %rsp
+.cfi_def_cfa_register	%rax
+	push	%rbx
+.cfi_push	%rbx
+	push	%rbp
+.cfi_push	%rbp
+	push	%r12
+.cfi_push	%r12
+	push	%r13
+.cfi_push	%r13
+	push	%r14
+.cfi_push	%r14
+	push	%r15
+.cfi_push	%r15
+	sub	\$$framesz,%rsp
+	shl	\$6,$end		# num*64
+	and	\$-64,%rsp		# align stack frame
+	add	$inp,$end		# end of input
+	mov	%rax,$_rsp		# save copy of %rsp
+.cfi_cfa_expression	$_rsp,deref,+8
+___
+$code.=<<___ if ($win64);
+	movaps	%xmm6,528(%rsp)
+	movaps	%xmm7,544(%rsp)
+	movaps	%xmm8,560(%rsp)
+	movaps	%xmm9,576(%rsp)
+	movaps	%xmm10,592(%rsp)
+___
+$code.=<<___;
+.Lprologue_avx2:
+
+	vzeroupper
+	mov	OPENSSL_ia32cap_P+8(%rip),%r15d
+	vmovdqa	.Lbswap(%rip),$bswap
+	mov	0($ctx),@V[0]
+	mov	4($ctx),@V[1]
+	mov	8($ctx),@V[2]
+	mov	12($ctx),@V[3]
+	mov	16($ctx),@V[4]
+	mov	20($ctx),@V[5]
+	mov	24($ctx),@V[6]
+	mov	28($ctx),@V[7]
+___
+if ($avx>2) {
+$code.=<<___;
+	and	\$`1<<31|1<<16`,%r15d	# check for AVX512VL+AVX512F
+	cmp	\$`1<<31|1<<16`,%r15d
+	je	.Loop_avx512
+___
+}
+$code.=<<___;
+	jmp	.Loop_avx2
+.align	32
+___
+	$avx512=0; &body("avx2");
+if ($avx>2) {
+$code.=".align	32\n";
+	$avx512=1; &body("avx512");
+}
+$code.=<<___;
+.Ldone_avx2:
+	mov	$_rsp,%rsi
+.cfi_def_cfa	%rsi,8
+	vzeroupper
+___
+$code.=<<___ if ($win64);
+	movaps	528(%rsp),%xmm6
+	movaps	544(%rsp),%xmm7
+	movaps	560(%rsp),%xmm8
+	movaps	576(%rsp),%xmm9
+	movaps	592(%rsp),%xmm10
+___
+$code.=<<___;
+	mov	-48(%rsi),%r15
+.cfi_restore	%r15
+	mov	-40(%rsi),%r14
+.cfi_restore	%r14
+	mov	-32(%rsi),%r13
+.cfi_restore	%r13
+	mov	-24(%rsi),%r12
+.cfi_restore	%r12
+	mov	-16(%rsi),%rbp
+.cfi_restore	%rbp
+	mov	-8(%rsi),%rbx
+.cfi_restore	%rbx
+	lea	(%rsi),%rsp
+.cfi_def_cfa_register	%rsp
+.Lepilogue_avx2:
+	ret
+.cfi_endproc
+.size	$func,.-$func
+
+.align	16
+.Lbswap:
+	.byte	3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12
+.asciz	"SM3 block transform for x86_64, CRYPTOGAMS by <appro\@openssl.org>"
+___
+
+# EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
+#		CONTEXT *context,DISPATCHER_CONTEXT *disp)
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	se_handler,\@abi-omnipotent
+.align	16
+se_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HanderlData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lin_prologue
+
+	mov	152($context),%rax	# pull context->Rsp
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lin_prologue
+
+	mov	%rax,%rsi		# put aside Rsp
+	mov	512(%rax),%rax		# pull $_rsp
+
+	mov	-8(%rax),%rbx
+	mov	-16(%rax),%rbp
+	mov	-24(%rax),%r12
+	mov	-32(%rax),%r13
+	mov	-40(%rax),%r14
+	mov	-48(%rax),%r15
+	mov	%rbx,144($context)	# restore context->Rbx
+	mov	%rbp,160($context)	# restore context->Rbp
+	mov	%r12,216($context)	# restore context->R12
+	mov	%r13,224($context)	# restore context->R13
+	mov	%r14,232($context)	# restore context->R14
+	mov	%r15,240($context)	# restore context->R15
+
+	lea	528(%rsi),%rsi		# Xmm6- save area
+	lea	512($context),%rdi	# &context.Xmm6
+	mov	\$10,%ecx
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lin_prologue:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	se_handler,.-se_handler
+
+.section	.pdata
+.align	4
+	.rva	.LSEH_begin_$func
+	.rva	.LSEH_end_$func
+	.rva	.LSEH_info_$func
+
+.section	.xdata
+.align	8
+.LSEH_info_$func:
+	.byte	9,0,0,0
+	.rva	se_handler
+	.rva	.Lprologue_avx2,.Lepilogue_avx2		# HandlerData[]
+___
+}
+}}} else {{{
+$code.=<<___;
+.globl	ossl_sm3_avx2_eligible
+.type	ossl_sm3_avx2_eligible,\@abi-omnipotent
+ossl_sm3_avx2_eligible:
+	xor	%eax,%eax
+	ret
+.size	ossl_sm3_avx2_eligible,.-ossl_sm3_avx2_eligible
+
+.extern	ossl_sm3_block_data_order
+.globl	$func
+.type	$func,\@abi-omnipotent
+$func:
+	jmp	ossl_sm3_block_data_order\@PLT
+.size	$func,.-$func
+___
+}}}
+
+foreach (split("\n",$code)) {
+	s/\`([^\`]*)\`/eval($1)/geo;
+
+	print $_,"\n";
+}
+
+close STDOUT or die "error closing STDOUT: $!";
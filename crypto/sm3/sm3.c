@@ -193,3 +193,184 @@ void ossl_sm3_block_data_order(SM3_CTX *ctx, const void *p, size_t num)
         ctx->H ^= H;
     }
 }
+
+#ifdef SM3_MB_LANES
+/*
+ * A lane runs through the whole blocks of its message straight from the
+ * input and then through the one or two padded blocks kept in |tail|.
+ */
+typedef struct {
+    const unsigned char *p;
+    size_t blocks;
+    size_t tail_blocks;
+    size_t msg;
+    unsigned char tail[2 * SM3_CBLOCK];
+} SM3_MB_LANE;
+
+static void sm3_mb_lane_init(SM3_MB_CTX *ctx, SM3_MB_LANE *lane, int l,
+                             size_t msg, const unsigned char *in, size_t len)
+{
+    size_t rem = len % SM3_CBLOCK;
+    size_t tlen = rem < SM3_CBLOCK - 8 ? SM3_CBLOCK : 2 * SM3_CBLOCK;
+    uint64_t bits = (uint64_t)len << 3;
+    int i;
+
+    ctx->A[l] = SM3_A;
+    ctx->B[l] = SM3_B;
+    ctx->C[l] = SM3_C;
+    ctx->D[l] = SM3_D;
+    ctx->E[l] = SM3_E;
+    ctx->F[l] = SM3_F;
+    ctx->G[l] = SM3_G;
+    ctx->H[l] = SM3_H;
+
+    if (rem != 0)
+        memcpy(lane->tail, in + len - rem, rem);
+    lane->tail[rem] = 0x80;
+    memset(lane->tail + rem + 1, 0, tlen - rem - 9);
+    for (i = 1; i <= 8; i++, bits >>= 8)
+        lane->tail[tlen - i] = (unsigned char)bits;
+
+    lane->msg = msg;
+    lane->tail_blocks = tlen / SM3_CBLOCK;
+    lane->blocks = len / SM3_CBLOCK;
+    lane->p = in;
+    if (lane->blocks == 0) {
+        lane->p = lane->tail;
+        lane->blocks = lane->tail_blocks;
+        lane->tail_blocks = 0;
+    }
+}
+
+static void sm3_mb_lane_final(const SM3_MB_CTX *ctx, int l,
+                              unsigned char *md)
+{
+    unsigned long ll;
+
+    ll = ctx->A[l]; (void)HOST_l2c(ll, md);
+    ll = ctx->B[l]; (void)HOST_l2c(ll, md);
+    ll = ctx->C[l]; (void)HOST_l2c(ll, md);
+    ll = ctx->D[l]; (void)HOST_l2c(ll, md);
+    ll = ctx->E[l]; (void)HOST_l2c(ll, md);
+    ll = ctx->F[l]; (void)HOST_l2c(ll, md);
+    ll = ctx->G[l]; (void)HOST_l2c(ll, md);
+    ll = ctx->H[l]; (void)HOST_l2c(ll, md);
+}
+
+/*
+ * ossl_sm3_multi_block() advances all lanes by the same number of blocks,
+ * so each call goes as far as the shortest run, after which the lanes
+ * that are done move on to their tail or to the next message. Once the
+ * messages run out, idle lanes repeat another lane's input and are
+ * ignored, and the last lane left is finished on its own.
+ */
+static void sm3_digest_mb(size_t num, const unsigned char *const in[],
+                          const size_t inlen[], unsigned char *const out[])
+{
+    SM3_MB_CTX ctx;
+    SM3_MB_LANE lane[SM3_MB_LANES];
+    const unsigned char *ptr[SM3_MB_LANES];
+    size_t next, n;
+    int l, live, active;
+
+    for (l = 0, next = 0; l < SM3_MB_LANES; l++) {
+        if (next < num) {
+            sm3_mb_lane_init(&ctx, &lane[l], l, next, in[next], inlen[next]);
+            next++;
+        } else {
+            lane[l].msg = num;
+        }
+    }
+
+    for (;;) {
+        n = (size_t)-1;
+        live = 0;
+        for (l = 0, active = 0; l < SM3_MB_LANES; l++) {
+            if (lane[l].msg == num)
+                continue;
+            active++;
+            live = l;
+            if (lane[l].blocks < n)
+                n = lane[l].blocks;
+        }
+        if (active <= 1)
+            break;
+
+        for (l = 0; l < SM3_MB_LANES; l++)
+            ptr[l] = lane[lane[l].msg == num ? live : l].p;
+        ossl_sm3_multi_block(&ctx, ptr, n);
+
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            if (lane[l].msg == num)
+                continue;
+            lane[l].p += n * SM3_CBLOCK;
+            if ((lane[l].blocks -= n) != 0)
+                continue;
+            if (lane[l].tail_blocks != 0) {
+                lane[l].p = lane[l].tail;
+                lane[l].blocks = lane[l].tail_blocks;
+                lane[l].tail_blocks = 0;
+                continue;
+            }
+            sm3_mb_lane_final(&ctx, l, out[lane[l].msg]);
+            if (next < num) {
+                sm3_mb_lane_init(&ctx, &lane[l], l, next, in[next],
+                                 inlen[next]);
+                next++;
+            } else {
+                lane[l].msg = num;
+            }
+        }
+    }
+
+    if (active == 1) {
+        SM3_CTX c;
+        SM3_MB_LANE *ln = &lane[live];
+
+        c.A = ctx.A[live];
+        c.B = ctx.B[live];
+        c.C = ctx.C[live];
+        c.D = ctx.D[live];
+        c.E = ctx.E[live];
+        c.F = ctx.F[live];
+        c.G = ctx.G[live];
+        c.H = ctx.H[live];
+        HASH_BLOCK_DATA_ORDER(&c, ln->p, ln->blocks);
+        if (ln->tail_blocks != 0)
+            HASH_BLOCK_DATA_ORDER(&c, ln->tail, ln->tail_blocks);
+        ctx.A[live] = c.A;
+        ctx.B[live] = c.B;
+        ctx.C[live] = c.C;
+        ctx.D[live] = c.D;
+        ctx.E[live] = c.E;
+        ctx.F[live] = c.F;
+        ctx.G[live] = c.G;
+        ctx.H[live] = c.H;
+        sm3_mb_lane_final(&ctx, live, out[ln->msg]);
+        OPENSSL_cleanse(&c, sizeof(c));
+    }
+
+    OPENSSL_cleanse(&ctx, sizeof(ctx));
+    OPENSSL_cleanse(lane, sizeof(lane));
+}
+#endif
+
+void ossl_sm3_digest_batch(size_t num, const unsigned char *const in[],
+                           const size_t inlen[], unsigned char *const out[])
+{
+    SM3_CTX c;
+    size_t i;
+
+#ifdef SM3_MB_LANES
+    if (num > 1 && SM3_MB_CAPABLE) {
+        sm3_digest_mb(num, in, inlen, out);
+        return;
+    }
+#endif
+    for (i = 0; i < num; i++) {
+        ossl_sm3_init(&c);
+        ossl_sm3_update(&c, in[i], inlen[i]);
+        ossl_sm3_final(out[i], &c);
+    }
+    OPENSSL_cleanse(&c, sizeof(c));
+}
@@ -32,9 +32,58 @@
         ll=(c)->G; (void)HOST_l2c(ll, (s)); \
         ll=(c)->H; (void)HOST_l2c(ll, (s)); \
       } while (0)
-#define HASH_BLOCK_DATA_ORDER   ossl_sm3_block_data_order
 
 void ossl_sm3_block_data_order(SM3_CTX *c, const void *p, size_t num);
+
+#if defined(SM3_ASM) && (defined(__aarch64__) || defined(_M_ARM64))
+# include "arm_arch.h"
+# define HWSM3_CAPABLE          (OPENSSL_armcap_P & ARMV8_SM3)
+# define NEONSM3_CAPABLE        (OPENSSL_armcap_P & ARMV7_NEON)
+void ossl_hwsm3_block_data_order(SM3_CTX *c, const void *p, size_t num);
+void ossl_sm3_block_data_order_neon(SM3_CTX *c, const void *p, size_t num);
+# define SM3_MB_LANES           4
+# define SM3_MB_CAPABLE         (!HWSM3_CAPABLE && NEONSM3_CAPABLE)
+#elif defined(SM3_ASM) && (defined(__x86_64) || defined(_M_AMD64) \
+                           || defined(_M_X64))
+extern unsigned int OPENSSL_ia32cap_P[];
+/* BMI1, AVX2 and BMI2 */
+# define AVX2SM3_CAPABLE                                            \
+    ((OPENSSL_ia32cap_P[2] & ((1 << 3) | (1 << 5) | (1 << 8)))      \
+     == ((1 << 3) | (1 << 5) | (1 << 8)))
+void ossl_sm3_block_data_order_avx2(SM3_CTX *c, const void *p, size_t num);
+/* Checked once per batch, it is also 0 if the assembler was too old */
+int ossl_sm3_avx2_eligible(void);
+# define SM3_MB_LANES           8
+# define SM3_MB_CAPABLE         ossl_sm3_avx2_eligible()
+#endif
+
+#ifdef SM3_MB_LANES
+/* One stream per lane, see ossl_sm3_digest_batch() */
+typedef struct {
+    SM3_WORD A[SM3_MB_LANES], B[SM3_MB_LANES];
+    SM3_WORD C[SM3_MB_LANES], D[SM3_MB_LANES];
+    SM3_WORD E[SM3_MB_LANES], F[SM3_MB_LANES];
+    SM3_WORD G[SM3_MB_LANES], H[SM3_MB_LANES];
+} SM3_MB_CTX;
+
+void ossl_sm3_multi_block(SM3_MB_CTX *ctx,
+                          const unsigned char *const inp[SM3_MB_LANES],
+                          size_t num);
+#endif
+
+#if defined(HWSM3_CAPABLE)
+# define HASH_BLOCK_DATA_ORDER(c, p, num)                           \
+    (HWSM3_CAPABLE ? ossl_hwsm3_block_data_order(c, p, num)         \
+     : NEONSM3_CAPABLE ? ossl_sm3_block_data_order_neon(c, p, num)  \
+     : ossl_sm3_block_data_order(c, p, num))
+#elif defined(AVX2SM3_CAPABLE)
+# define HASH_BLOCK_DATA_ORDER(c, p, num)                           \
+    (AVX2SM3_CAPABLE ? ossl_sm3_block_data_order_avx2(c, p, num)    \
+     : ossl_sm3_block_data_order(c, p, num))
+#else
+# define HASH_BLOCK_DATA_ORDER  ossl_sm3_block_data_order
+#endif
+
 void ossl_sm3_transform(SM3_CTX *c, const unsigned char *data);
 
 #include "crypto/md32_common.h"
@@ -0,0 +1,426 @@
+#! /usr/bin/env perl
+# Copyright 2022 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# SM4 for ARMv8 with the ARMv8.2 SM4 extension.
+#
+# SM4EKEY makes four round keys and SM4E performs four rounds at a time,
+# so a block is eight SM4E on the same register with all 32 round keys
+# resident in v16-v23. SM4E is latency bound, which is why ECB, CTR and
+# CBC decryption process eight independent blocks at once. CBC encryption
+# is inherently serial.
+#
+# A decryption key schedule is the encryption one in reverse order, so
+# decryption is the same code as encryption.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}arm-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/arm-xlate.pl" and -f $xlate) or
+die "can't locate arm-xlate.pl";
+
+open OUT,"| \"$^X\" $xlate $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+my @rks=map("v$_",(16..23));
+
+# Blocks are loaded as bytes, so the byte order is fixed up the same way
+# on either endianness. On the way out the words are also put back in
+# reverse order, which together is a byte reversal of the whole register.
+sub rev_in {
+	join("",map("\trev32	$_.16b,$_.16b\n",@_));
+}
+
+sub rev_out {
+	join("",map("\trev64	$_.16b,$_.16b\n\text	$_.16b,$_.16b,$_.16b,#8\n",@_));
+}
+
+sub crypt_blks {
+my $code="";
+	foreach my $rk (@rks) {
+		$code.=join("",map("\tsm4e	$_.4s,$rk.4s\n",@_));
+	}
+	$code;
+}
+
+sub load_key {
+my ($key)=@_;
+	"\tld1	{@rks[0].4s-@rks[3].4s},[$key],#64\n".
+	"\tld1	{@rks[4].4s-@rks[7].4s},[$key]\n";
+}
+
+$code.=<<___;
+#include "arm_arch.h"
+
+.text
+
+.type	_hwsm4_consts,%object
+.align	6
+_hwsm4_consts:
+.Lck:
+	.long	0x00070E15,0x1C232A31,0x383F464D,0x545B6269
+	.long	0x70777E85,0x8C939AA1,0xA8AFB6BD,0xC4CBD2D9
+	.long	0xE0E7EEF5,0xFC030A11,0x181F262D,0x343B4249
+	.long	0x50575E65,0x6C737A81,0x888F969D,0xA4ABB2B9
+	.long	0xC0C7CED5,0xDCE3EAF1,0xF8FF060D,0x141B2229
+	.long	0x30373E45,0x4C535A61,0x686F767D,0x848B9299
+	.long	0xA0A7AEB5,0xBCC3CAD1,0xD8DFE6ED,0xF4FB0209
+	.long	0x10171E25,0x2C333A41,0x484F565D,0x646B7279
+.Lfk:
+	.long	0xA3B1BAC6,0x56AA3350,0x677D9197,0xB27022DC
+.size	_hwsm4_consts,.-_hwsm4_consts
+___
+
+########################################################################
+# int ossl_hwsm4_set_encrypt_key(const unsigned char *userKey, SM4_KEY *key);
+# int ossl_hwsm4_set_decrypt_key(const unsigned char *userKey, SM4_KEY *key);
+{
+my ($inp,$key)=("x0","x1");
+my @K=map("v$_",(0..7));
+my @R=map("v$_",(24..31));
+
+$code.=<<___;
+.type	_hwsm4_expand_key,%function
+.align	4
+_hwsm4_expand_key:
+	ld1	{v0.16b},[$inp]
+	adr	x9,.Lck
+	ld1	{@rks[0].4s-@rks[3].4s},[x9],#64
+	ld1	{@rks[4].4s-@rks[7].4s},[x9],#64
+	ld1	{v24.4s},[x9]
+	rev32	v0.16b,v0.16b
+	eor	v0.16b,v0.16b,v24.16b
+	sm4ekey	@K[0].4s,v0.4s,@rks[0].4s
+___
+for (my $i=1; $i<8; $i++) {
+	$code.="\tsm4ekey	@K[$i].4s,@K[$i-1].4s,@rks[$i].4s\n";
+}
+$code.=<<___;
+	ret
+.size	_hwsm4_expand_key,.-_hwsm4_expand_key
+
+.globl	ossl_hwsm4_set_encrypt_key
+.type	ossl_hwsm4_set_encrypt_key,%function
+.align	5
+ossl_hwsm4_set_encrypt_key:
+	stp	x29,x30,[sp,#-16]!
+	add	x29,sp,#0
+	bl	_hwsm4_expand_key
+	st1	{@K[0].4s-@K[3].4s},[$key],#64
+	st1	{@K[4].4s-@K[7].4s},[$key]
+	mov	w0,#1
+	ldp	x29,x30,[sp],#16
+	ret
+.size	ossl_hwsm4_set_encrypt_key,.-ossl_hwsm4_set_encrypt_key
+
+.globl	ossl_hwsm4_set_decrypt_key
+.type	ossl_hwsm4_set_decrypt_key,%function
+.align	5
+ossl_hwsm4_set_decrypt_key:
+	stp	x29,x30,[sp,#-16]!
+	add	x29,sp,#0
+	bl	_hwsm4_expand_key
+___
+for (my $i=0; $i<8; $i++) {
+	$code.=<<___;
+	rev64	@R[7-$i].4s,@K[$i].4s
+	ext	@R[7-$i].16b,@R[7-$i].16b,@R[7-$i].16b,#8
+___
+}
+$code.=<<___;
+	st1	{@R[0].4s-@R[3].4s},[$key],#64
+	st1	{@R[4].4s-@R[7].4s},[$key]
+	mov	w0,#1
+	ldp	x29,x30,[sp],#16
+	ret
+.size	ossl_hwsm4_set_decrypt_key,.-ossl_hwsm4_set_decrypt_key
+___
+}
+
+########################################################################
+# void ossl_hwsm4_encrypt(const unsigned char *in, unsigned char *out,
+#                         const SM4_KEY *key);
+# void ossl_hwsm4_decrypt(const unsigned char *in, unsigned char *out,
+#                         const SM4_KEY *key);
+{
+my ($inp,$out,$key)=map("x$_",(0..2));
+
+$code.=<<___;
+.globl	ossl_hwsm4_encrypt
+.type	ossl_hwsm4_encrypt,%function
+.globl	ossl_hwsm4_decrypt
+.type	ossl_hwsm4_decrypt,%function
+.align	5
+ossl_hwsm4_encrypt:
+ossl_hwsm4_decrypt:
+	ld1	{v0.16b},[$inp]
+___
+$code.=load_key($key);
+$code.=rev_in("v0");
+$code.=crypt_blks("v0");
+$code.=rev_out("v0");
+$code.=<<___;
+	st1	{v0.16b},[$out]
+	ret
+.size	ossl_hwsm4_encrypt,.-ossl_hwsm4_encrypt
+.size	ossl_hwsm4_decrypt,.-ossl_hwsm4_decrypt
+___
+}
+
+########################################################################
+# void ossl_hwsm4_ecb_encrypt(const unsigned char *in, unsigned char *out,
+#                             size_t len, const SM4_KEY *key,
+#                             const int enc);
+#
+# The direction is in the key schedule, enc is not used.
+{
+my ($inp,$out,$len,$key)=map("x$_",(0..3));
+my @B=map("v$_",(0..7));
+
+$code.=<<___;
+.globl	ossl_hwsm4_ecb_encrypt
+.type	ossl_hwsm4_ecb_encrypt,%function
+.align	5
+ossl_hwsm4_ecb_encrypt:
+___
+$code.=load_key($key);
+$code.=<<___;
+	lsr	$len,$len,#4
+	subs	$len,$len,#8
+	b.lo	.Lecb_tail
+.Loop_ecb8:
+	ld1	{@B[0].16b-@B[3].16b},[$inp],#64
+	ld1	{@B[4].16b-@B[7].16b},[$inp],#64
+___
+$code.=rev_in(@B);
+$code.=crypt_blks(@B);
+$code.=rev_out(@B);
+$code.=<<___;
+	st1	{@B[0].16b-@B[3].16b},[$out],#64
+	st1	{@B[4].16b-@B[7].16b},[$out],#64
+	subs	$len,$len,#8
+	b.hs	.Loop_ecb8
+
+.Lecb_tail:
+	adds	$len,$len,#8
+	b.eq	.Lecb_done
+.Loop_ecb1:
+	ld1	{@B[0].16b},[$inp],#16
+___
+$code.=rev_in(@B[0]);
+$code.=crypt_blks(@B[0]);
+$code.=rev_out(@B[0]);
+$code.=<<___;
+	st1	{@B[0].16b},[$out],#16
+	subs	$len,$len,#1
+	b.ne	.Loop_ecb1
+.Lecb_done:
+	ret
+.size	ossl_hwsm4_ecb_encrypt,.-ossl_hwsm4_ecb_encrypt
+___
+}
+
+########################################################################
+# void ossl_hwsm4_cbc_encrypt(const unsigned char *in, unsigned char *out,
+#                             size_t len, const SM4_KEY *key,
+#                             unsigned char ivec[16], const int enc);
+#
+# Decryption needs a decryption key schedule, of course.
+{
+my ($inp,$out,$len,$key,$ivp)=map("x$_",(0..4));
+my @B=map("v$_",(0..7));
+my @C=map("v$_",(24..31));
+my $iv="v8";
+
+$code.=<<___;
+.globl	ossl_hwsm4_cbc_encrypt
+.type	ossl_hwsm4_cbc_encrypt,%function
+.align	5
+ossl_hwsm4_cbc_encrypt:
+	stp	d8,d9,[sp,#-16]!
+	ld1	{$iv.16b},[$ivp]
+___
+$code.=load_key($key);
+$code.=<<___;
+	lsr	$len,$len,#4
+	cbz	$len,.Lcbc_done
+	cbz	w5,.Lcbc_dec
+
+.Loop_cbc_enc:
+	ld1	{@B[0].16b},[$inp],#16
+	eor	@B[0].16b,@B[0].16b,$iv.16b
+___
+$code.=rev_in(@B[0]);
+$code.=crypt_blks(@B[0]);
+$code.=rev_out(@B[0]);
+$code.=<<___;
+	mov	$iv.16b,@B[0].16b
+	st1	{@B[0].16b},[$out],#16
+	subs	$len,$len,#1
+	b.ne	.Loop_cbc_enc
+	b	.Lcbc_done
+
+.Lcbc_dec:
+	subs	$len,$len,#8
+	b.lo	.Lcbc_dec_tail
+.Loop_cbc_dec8:
+	ld1	{@C[0].16b-@C[3].16b},[$inp],#64
+	ld1	{@C[4].16b-@C[7].16b},[$inp],#64
+___
+$code.=join("",map("\trev32	@B[$_].16b,@C[$_].16b\n",(0..7)));
+$code.=crypt_blks(@B);
+$code.=rev_out(@B);
+$code.=<<___;
+	eor	@B[0].16b,@B[0].16b,$iv.16b
+___
+$code.=join("",map("\teor	@B[$_].16b,@B[$_].16b,@C[$_-1].16b\n",(1..7)));
+$code.=<<___;
+	mov	$iv.16b,@C[7].16b
+	st1	{@B[0].16b-@B[3].16b},[$out],#64
+	st1	{@B[4].16b-@B[7].16b},[$out],#64
+	subs	$len,$len,#8
+	b.hs	.Loop_cbc_dec8
+
+.Lcbc_dec_tail:
+	adds	$len,$len,#8
+	b.eq	.Lcbc_done
+.Loop_cbc_dec1:
+	ld1	{@C[0].16b},[$inp],#16
+	rev32	@B[0].16b,@C[0].16b
+___
+$code.=crypt_blks(@B[0]);
+$code.=rev_out(@B[0]);
+$code.=<<___;
+	eor	@B[0].16b,@B[0].16b,$iv.16b
+	mov	$iv.16b,@C[0].16b
+	st1	{@B[0].16b},[$out],#16
+	subs	$len,$len,#1
+	b.ne	.Loop_cbc_dec1
+
+.Lcbc_done:
+	st1	{$iv.16b},[$ivp]
+	ldp	d8,d9,[sp],#16
+	ret
+.size	ossl_hwsm4_cbc_encrypt,.-ossl_hwsm4_cbc_encrypt
+___
+}
+
+########################################################################
+# void ossl_hwsm4_ctr32_encrypt_blocks(const unsigned char *in,
+#                                      unsigned char *out, size_t blocks,
+#                                      const SM4_KEY *key,
+#                                      const unsigned char ivec[16]);
+#
+# The counter block is kept with its words in native order, so counter
+# blocks are made by inserting the last word and need no byte swapping.
+{
+my ($inp,$out,$len,$key,$ivp)=map("x$_",(0..4));
+my ($ctr,$tmp)=("w5","w6");
+my @B=map("v$_",(0..7));
+my $iv="v24";
+my @D=map("v$_",(25..28));
+
+$code.=<<___;
+.globl	ossl_hwsm4_ctr32_encrypt_blocks
+.type	ossl_hwsm4_ctr32_encrypt_blocks,%function
+.align	5
+ossl_hwsm4_ctr32_encrypt_blocks:
+	cbz	$len,.Lctr_done
+	ld1	{$iv.16b},[$ivp]
+___
+$code.=load_key($key);
+$code.=<<___;
+	rev32	$iv.16b,$iv.16b
+	mov	$ctr,$iv.s[3]
+	subs	$len,$len,#8
+	b.lo	.Lctr_tail
+.Loop_ctr8:
+___
+for (my $i=0; $i<8; $i++) {
+	$code.="\tadd	$tmp,$ctr,#$i\n" if ($i);
+	$code.="\tmov	@B[$i].16b,$iv.16b\n";
+	$code.="\tmov	@B[$i].s[3],$tmp\n" if ($i);
+}
+$code.=<<___;
+	add	$ctr,$ctr,#8
+___
+$code.=crypt_blks(@B);
+$code.=rev_out(@B);
+$code.=<<___;
+	ld1	{@D[0].16b-@D[3].16b},[$inp],#64
+___
+$code.=join("",map("\teor	@B[$_].16b,@B[$_].16b,@D[$_].16b\n",(0..3)));
+$code.=<<___;
+	ld1	{@D[0].16b-@D[3].16b},[$inp],#64
+___
+$code.=join("",map("\teor	@B[$_+4].16b,@B[$_+4].16b,@D[$_].16b\n",(0..3)));
+$code.=<<___;
+	st1	{@B[0].16b-@B[3].16b},[$out],#64
+	st1	{@B[4].16b-@B[7].16b},[$out],#64
+	mov	$iv.s[3],$ctr
+	subs	$len,$len,#8
+	b.hs	.Loop_ctr8
+
+.Lctr_tail:
+	adds	$len,$len,#8
+	b.eq	.Lctr_done
+.Loop_ctr1:
+	mov	@B[0].16b,$iv.16b
+	add	$ctr,$ctr,#1
+___
+$code.=crypt_blks(@B[0]);
+$code.=rev_out(@B[0]);
+$code.=<<___;
+	ld1	{@D[0].16b},[$inp],#16
+	mov	$iv.s[3],$ctr
+	eor	@B[0].16b,@B[0].16b,@D[0].16b
+	st1	{@B[0].16b},[$out],#16
+	subs	$len,$len,#1
+	b.ne	.Loop_ctr1
+.Lctr_done:
+	ret
+.size	ossl_hwsm4_ctr32_encrypt_blocks,.-ossl_hwsm4_ctr32_encrypt_blocks
+___
+}
+
+{
+my %opcode = ( "sm4e" => 0xcec08400, "sm4ekey" => 0xce60c800 );
+
+    sub unsm4 {
+	my ($mnemonic,$arg)=@_;
+
+	$arg =~ m/v([0-9]+)[^,]*,\s*v([0-9]+)[^,]*(?:,\s*v([0-9]+))?/o
+	&&
+	sprintf ".inst\t0x%08x\t//%s %s",
+			$opcode{$mnemonic}|$1|($2<<5)|($3<<16),
+			$mnemonic,$arg;
+    }
+}
+
+open SELF,$0;
+while(<SELF>) {
+        next if (/^#!/);
+        last if (!s/^#/\/\// and !/^$/);
+        print;
+}
+close SELF;
+
+foreach(split("\n",$code)) {
+	s/\`([^\`]*)\`/eval($1)/ge;
+
+	s/\b(sm4e(?:key)?)\s+(v.*)/unsm4($1,$2)/ge;
+
+	print $_,"\n";
+}
+
+close STDOUT or die "error closing STDOUT: $!";
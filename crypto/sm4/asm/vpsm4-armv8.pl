@@ -0,0 +1,466 @@
+#! /usr/bin/env perl
+# Copyright 2022 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# SM4 for ARMv8 NEON, four or eight blocks at a time.
+#
+# As in the x86_64 version the state words of four blocks are kept
+# transposed, one word per 32-bit lane. The whole 256-byte S-box fits in
+# v16-v31, so the substitution is one TBL and three TBX lookups of 64
+# bytes each, with the index rebased between them. The lookups don't touch
+# memory, so timing doesn't depend on the data either.
+#
+# Two sets of four blocks are interleaved in the main loop to hide the
+# latency of the lookups, shorter input goes through a single set.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}arm-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/arm-xlate.pl" and -f $xlate) or
+die "can't locate arm-xlate.pl";
+
+open OUT,"| \"$^X\" $xlate $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+my ($inp,$out,$len,$key,$arg4)=map("x$_",(0..4));
+my ($rks,$rkp,$rounds)=("x10","x11","w12");
+my @A=map("v$_",(0..3));
+my @B=map("v$_",(4..7));
+my @TA=map("v$_",(8..10));
+my @TB=map("v$_",(11..13));
+my ($c64,$rk)=("v14","v15");
+
+# One round on the transposed words @$b of four blocks, $i picks the
+# round key lane. Returns the instructions as a list so that two sets
+# can be interleaved.
+sub round {
+my ($i,$b,$t)=@_;
+my ($x,$y,$s)=@$t;
+	(
+	"dup	$y.4s,$rk.s[$i]",
+	"eor	$x.16b,@$b[1].16b,@$b[2].16b",
+	"eor	$x.16b,$x.16b,@$b[3].16b",
+	"eor	$x.16b,$x.16b,$y.16b",
+	"tbl	$y.16b,{v16.16b-v19.16b},$x.16b",
+	"sub	$x.16b,$x.16b,$c64.16b",
+	"tbx	$y.16b,{v20.16b-v23.16b},$x.16b",
+	"sub	$x.16b,$x.16b,$c64.16b",
+	"tbx	$y.16b,{v24.16b-v27.16b},$x.16b",
+	"sub	$x.16b,$x.16b,$c64.16b",
+	"tbx	$y.16b,{v28.16b-v31.16b},$x.16b",
+	# L(y) = y ^ (y <<< 24) ^ ((y ^ (y <<< 8) ^ (y <<< 16)) <<< 2)
+	"shl	$s.4s,$y.4s,#8",
+	"rev32	$x.8h,$y.8h",
+	"sri	$s.4s,$y.4s,#24",
+	"eor	$s.16b,$s.16b,$x.16b",
+	"eor	@$b[0].16b,@$b[0].16b,$y.16b",
+	"eor	$s.16b,$s.16b,$y.16b",
+	"shl	$x.4s,$y.4s,#24",
+	"sri	$x.4s,$y.4s,#8",
+	"shl	$y.4s,$s.4s,#2",
+	"eor	@$b[0].16b,@$b[0].16b,$x.16b",
+	"sri	$y.4s,$s.4s,#30",
+	"eor	@$b[0].16b,@$b[0].16b,$y.16b",
+	);
+}
+
+sub rounds {
+my @sets=@_;
+my $code="";
+	for (my $i=0; $i<4; $i++) {
+		my @ins=map { [round($i,$_->[0],$_->[1])] } @sets;
+		while (grep { @$_ } @ins) {
+			foreach (@ins) { $code.="\t".(shift @$_)."\n" if (@$_); }
+		}
+		foreach (@sets) { push @{$_->[0]},shift @{$_->[0]}; }
+	}
+	$code;
+}
+
+$code.=<<___;
+#include "arm_arch.h"
+
+.text
+
+.type	_vpsm4_consts,%object
+.align	6
+_vpsm4_consts:
+.Lsbox:
+	.byte	0xd6,0x90,0xe9,0xfe,0xcc,0xe1,0x3d,0xb7,0x16,0xb6,0x14,0xc2,0x28,0xfb,0x2c,0x05
+	.byte	0x2b,0x67,0x9a,0x76,0x2a,0xbe,0x04,0xc3,0xaa,0x44,0x13,0x26,0x49,0x86,0x06,0x99
+	.byte	0x9c,0x42,0x50,0xf4,0x91,0xef,0x98,0x7a,0x33,0x54,0x0b,0x43,0xed,0xcf,0xac,0x62
+	.byte	0xe4,0xb3,0x1c,0xa9,0xc9,0x08,0xe8,0x95,0x80,0xdf,0x94,0xfa,0x75,0x8f,0x3f,0xa6
+	.byte	0x47,0x07,0xa7,0xfc,0xf3,0x73,0x17,0xba,0x83,0x59,0x3c,0x19,0xe6,0x85,0x4f,0xa8
+	.byte	0x68,0x6b,0x81,0xb2,0x71,0x64,0xda,0x8b,0xf8,0xeb,0x0f,0x4b,0x70,0x56,0x9d,0x35
+	.byte	0x1e,0x24,0x0e,0x5e,0x63,0x58,0xd1,0xa2,0x25,0x22,0x7c,0x3b,0x01,0x21,0x78,0x87
+	.byte	0xd4,0x00,0x46,0x57,0x9f,0xd3,0x27,0x52,0x4c,0x36,0x02,0xe7,0xa0,0xc4,0xc8,0x9e
+	.byte	0xea,0xbf,0x8a,0xd2,0x40,0xc7,0x38,0xb5,0xa3,0xf7,0xf2,0xce,0xf9,0x61,0x15,0xa1
+	.byte	0xe0,0xae,0x5d,0xa4,0x9b,0x34,0x1a,0x55,0xad,0x93,0x32,0x30,0xf5,0x8c,0xb1,0xe3
+	.byte	0x1d,0xf6,0xe2,0x2e,0x82,0x66,0xca,0x60,0xc0,0x29,0x23,0xab,0x0d,0x53,0x4e,0x6f
+	.byte	0xd5,0xdb,0x37,0x45,0xde,0xfd,0x8e,0x2f,0x03,0xff,0x6a,0x72,0x6d,0x6c,0x5b,0x51
+	.byte	0x8d,0x1b,0xaf,0x92,0xbb,0xdd,0xbc,0x7f,0x11,0xd9,0x5c,0x41,0x1f,0x10,0x5a,0xd8
+	.byte	0x0a,0xc1,0x31,0x88,0xa5,0xcd,0x7b,0xbd,0x2d,0x74,0xd0,0x12,0xb8,0xe5,0xb4,0xb0
+	.byte	0x89,0x69,0x97,0x4a,0x0c,0x96,0x77,0x7e,0x65,0xb9,0xf1,0x09,0xc5,0x6e,0xc6,0x84
+	.byte	0x18,0xf0,0x7d,0xec,0x3a,0xdc,0x4d,0x20,0x79,0xee,0x5f,0x3e,0xd7,0xcb,0x39,0x48
+.Lctr_inc:
+	.long	0,1,2,3
+.size	_vpsm4_consts,.-_vpsm4_consts
+
+// Loads the S-box into v16-v31 and the rebasing constant into v14.
+.type	_vpsm4_preheat,%function
+.align	4
+_vpsm4_preheat:
+	adr	x9,.Lsbox
+	ld1	{v16.16b-v19.16b},[x9],#64
+	ld1	{v20.16b-v23.16b},[x9],#64
+	ld1	{v24.16b-v27.16b},[x9],#64
+	ld1	{v28.16b-v31.16b},[x9]
+	movi	$c64.16b,#64
+	ret
+.size	_vpsm4_preheat,.-_vpsm4_preheat
+
+// 32 rounds on four blocks in v0-v3, with the round keys at $rks.
+// The output is left in v0-v3, i.e. still in reverse word order.
+.type	_vpsm4_crypt4,%function
+.align	4
+_vpsm4_crypt4:
+	mov	$rkp,$rks
+	mov	$rounds,#8
+.Loop_crypt4:
+	ld1	{$rk.4s},[$rkp],#16
+___
+$code.=rounds([[@A],[@TA]]);
+$code.=<<___;
+	subs	$rounds,$rounds,#1
+	b.ne	.Loop_crypt4
+	ret
+.size	_vpsm4_crypt4,.-_vpsm4_crypt4
+
+// Same for eight blocks in v0-v7.
+.type	_vpsm4_crypt8,%function
+.align	4
+_vpsm4_crypt8:
+	mov	$rkp,$rks
+	mov	$rounds,#8
+.Loop_crypt8:
+	ld1	{$rk.4s},[$rkp],#16
+___
+$code.=rounds([[@A],[@TA]],[[@B],[@TB]]);
+$code.=<<___;
+	subs	$rounds,$rounds,#1
+	b.ne	.Loop_crypt8
+	ret
+.size	_vpsm4_crypt8,.-_vpsm4_crypt8
+___
+
+# The frame is the saved x29/x30 and d8-d15, then 128 bytes for short
+# input and 128 bytes for the reversed key schedule.
+sub prologue {
+$code.=<<___;
+	stp	x29,x30,[sp,#-80]!
+	add	x29,sp,#0
+	stp	d8,d9,[sp,#16]
+	stp	d10,d11,[sp,#32]
+	stp	d12,d13,[sp,#48]
+	stp	d14,d15,[sp,#64]
+	sub	sp,sp,#256
+	bl	_vpsm4_preheat
+___
+}
+
+sub epilogue {
+$code.=<<___;
+	movi	v0.16b,#0
+	movi	v1.16b,#0
+	movi	v2.16b,#0
+	movi	v3.16b,#0
+	mov	x9,sp
+	st1	{v0.16b-v3.16b},[x9],#64
+	st1	{v0.16b-v3.16b},[x9],#64
+	st1	{v0.16b-v3.16b},[x9],#64
+	st1	{v0.16b-v3.16b},[x9]
+	add	sp,sp,#256
+	ldp	d8,d9,[sp,#16]
+	ldp	d10,d11,[sp,#32]
+	ldp	d12,d13,[sp,#48]
+	ldp	d14,d15,[sp,#64]
+	ldp	x29,x30,[sp],#80
+	ret
+___
+}
+
+# Words are loaded with LD4, which leaves them in memory byte order only on
+# little-endian.
+sub byteswap {
+	"#ifndef __AARCH64EB__\n".
+	join("",map("\trev32	$_.16b,$_.16b\n",@_)).
+	"#endif\n";
+}
+
+# Stores four blocks from the state words @$s, last word first.
+sub store4 {
+my ($s,$dst)=@_;
+$code.=<<___;
+#ifndef __AARCH64EB__
+	rev32	v8.16b,@$s[3].16b
+	rev32	v9.16b,@$s[2].16b
+	rev32	v10.16b,@$s[1].16b
+	rev32	v11.16b,@$s[0].16b
+#else
+	mov	v8.16b,@$s[3].16b
+	mov	v9.16b,@$s[2].16b
+	mov	v10.16b,@$s[1].16b
+	mov	v11.16b,@$s[0].16b
+#endif
+	st4	{v8.4s-v11.4s},[$dst],#64
+___
+}
+
+# Same, xor-ed with four blocks of input first.
+sub xor_store4 {
+my ($s)=@_;
+$code.=<<___;
+#ifndef __AARCH64EB__
+	rev32	v8.16b,@$s[3].16b
+	rev32	v9.16b,@$s[2].16b
+	rev32	v10.16b,@$s[1].16b
+	rev32	v11.16b,@$s[0].16b
+#else
+	mov	v8.16b,@$s[3].16b
+	mov	v9.16b,@$s[2].16b
+	mov	v10.16b,@$s[1].16b
+	mov	v11.16b,@$s[0].16b
+#endif
+	ld4	{v12.4s-v15.4s},[$inp],#64
+	eor	v8.16b,v8.16b,v12.16b
+	eor	v9.16b,v9.16b,v13.16b
+	eor	v10.16b,v10.16b,v14.16b
+	eor	v11.16b,v11.16b,v15.16b
+	st4	{v8.4s-v11.4s},[$out],#64
+___
+}
+
+########################################################################
+# void ossl_vpsm4_ecb_encrypt(const unsigned char *in, unsigned char *out,
+#                             size_t len, const SM4_KEY *key, const int enc);
+$code.=<<___;
+.globl	ossl_vpsm4_ecb_encrypt
+.type	ossl_vpsm4_ecb_encrypt,%function
+.align	5
+ossl_vpsm4_ecb_encrypt:
+___
+prologue();
+$code.=<<___;
+	mov	$rks,$key
+	cbnz	w4,.Lecb_blocks
+
+	// decryption uses the round keys in reverse order
+	add	$rks,sp,#128
+	add	x9,sp,#256
+	mov	$rounds,#8
+.Lecb_rev_key:
+	ld1	{v0.4s},[$key],#16
+	rev64	v0.4s,v0.4s
+	ext	v0.16b,v0.16b,v0.16b,#8
+	str	q0,[x9,#-16]!
+	subs	$rounds,$rounds,#1
+	b.ne	.Lecb_rev_key
+
+.Lecb_blocks:
+	lsr	$len,$len,#4
+	subs	$len,$len,#8
+	b.lo	.Lecb_tail
+.Loop_ecb8:
+	ld4	{v0.4s-v3.4s},[$inp],#64
+	ld4	{v4.4s-v7.4s},[$inp],#64
+___
+$code.=byteswap("v0","v1","v2","v3","v4","v5","v6","v7");
+$code.=<<___;
+	bl	_vpsm4_crypt8
+___
+store4(\@A,$out);
+store4(\@B,$out);
+$code.=<<___;
+	subs	$len,$len,#8
+	b.hs	.Loop_ecb8
+
+.Lecb_tail:
+	adds	$len,$len,#8
+	b.eq	.Lecb_done
+	cmp	$len,#4
+	b.lo	.Lecb_short
+	ld4	{v0.4s-v3.4s},[$inp],#64
+___
+$code.=byteswap("v0","v1","v2","v3");
+$code.=<<___;
+	bl	_vpsm4_crypt4
+___
+store4(\@A,$out);
+$code.=<<___;
+	subs	$len,$len,#4
+	b.eq	.Lecb_done
+
+.Lecb_short:
+	// 1-3 blocks go through the stack
+	mov	x9,sp
+	mov	x5,$len
+.Lecb_copy_in:
+	ldr	q0,[$inp],#16
+	str	q0,[x9],#16
+	subs	x5,x5,#1
+	b.ne	.Lecb_copy_in
+	mov	x9,sp
+	ld4	{v0.4s-v3.4s},[x9]
+___
+$code.=byteswap("v0","v1","v2","v3");
+$code.=<<___;
+	bl	_vpsm4_crypt4
+___
+store4(\@A,"x9");
+$code.=<<___;
+	mov	x9,sp
+.Lecb_copy_out:
+	ldr	q0,[x9],#16
+	str	q0,[$out],#16
+	subs	$len,$len,#1
+	b.ne	.Lecb_copy_out
+
+.Lecb_done:
+___
+epilogue();
+$code.=<<___;
+.size	ossl_vpsm4_ecb_encrypt,.-ossl_vpsm4_ecb_encrypt
+___
+
+########################################################################
+# void ossl_vpsm4_ctr32_encrypt_blocks(const unsigned char *in,
+#                                      unsigned char *out, size_t blocks,
+#                                      const SM4_KEY *key,
+#                                      const unsigned char ivec[16]);
+#
+# Counter blocks are made directly in the transposed form, only the last
+# word differs between them.
+my ($ctr0,$ctr1,$ctr2,$ctr3)=map("w$_",(5..8));
+
+sub counters {
+my ($n)=@_;
+$code.=<<___;
+	ld1	{v8.4s},[x9]
+	dup	v0.4s,$ctr0
+	dup	v1.4s,$ctr1
+	dup	v2.4s,$ctr2
+	dup	v3.4s,$ctr3
+	add	v3.4s,v3.4s,v8.4s
+___
+$code.=<<___ if ($n==8);
+	movi	v9.4s,#4
+	mov	v4.16b,v0.16b
+	mov	v5.16b,v1.16b
+	mov	v6.16b,v2.16b
+	add	v7.4s,v3.4s,v9.4s
+___
+}
+
+$code.=<<___;
+.globl	ossl_vpsm4_ctr32_encrypt_blocks
+.type	ossl_vpsm4_ctr32_encrypt_blocks,%function
+.align	5
+ossl_vpsm4_ctr32_encrypt_blocks:
+___
+prologue();
+$code.=<<___;
+	cbz	$len,.Lctr_done
+	mov	$rks,$key
+	ldp	$ctr0,$ctr1,[$arg4]
+	ldp	$ctr2,$ctr3,[$arg4,#8]
+#ifndef	__AARCH64EB__
+	rev	$ctr0,$ctr0
+	rev	$ctr1,$ctr1
+	rev	$ctr2,$ctr2
+	rev	$ctr3,$ctr3
+#endif
+	adr	x9,.Lctr_inc
+	subs	$len,$len,#8
+	b.lo	.Lctr_tail
+.Loop_ctr8:
+___
+counters(8);
+$code.=<<___;
+	add	$ctr3,$ctr3,#8
+	bl	_vpsm4_crypt8
+___
+xor_store4(\@A);
+xor_store4(\@B);
+$code.=<<___;
+	movi	$c64.16b,#64
+	subs	$len,$len,#8
+	b.hs	.Loop_ctr8
+
+.Lctr_tail:
+	adds	$len,$len,#8
+	b.eq	.Lctr_done
+	cmp	$len,#4
+	b.lo	.Lctr_short
+___
+counters(4);
+$code.=<<___;
+	add	$ctr3,$ctr3,#4
+	bl	_vpsm4_crypt4
+___
+xor_store4(\@A);
+$code.=<<___;
+	movi	$c64.16b,#64
+	subs	$len,$len,#4
+	b.eq	.Lctr_done
+
+.Lctr_short:
+	// the key stream for the last 1-3 blocks goes through the stack
+___
+counters(4);
+$code.=<<___;
+	bl	_vpsm4_crypt4
+	mov	x9,sp
+___
+store4(\@A,"x9");
+$code.=<<___;
+	mov	x9,sp
+.Lctr_xor:
+	ldr	q0,[$inp],#16
+	ldr	q1,[x9],#16
+	eor	v0.16b,v0.16b,v1.16b
+	str	q0,[$out],#16
+	subs	$len,$len,#1
+	b.ne	.Lctr_xor
+
+.Lctr_done:
+___
+epilogue();
+$code.=<<___;
+.size	ossl_vpsm4_ctr32_encrypt_blocks,.-ossl_vpsm4_ctr32_encrypt_blocks
+___
+
+open SELF,$0;
+while(<SELF>) {
+        next if (/^#!/);
+        last if (!s/^#/\/\// and !/^$/);
+        print;
+}
+close SELF;
+
+foreach(split("\n",$code)) {
+	s/\`([^\`]*)\`/eval($1)/ge;
+
+	print $_,"\n";
+}
+
+close STDOUT or die "error closing STDOUT: $!";
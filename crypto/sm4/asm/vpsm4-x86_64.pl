@@ -0,0 +1,750 @@
+#! /usr/bin/env perl
+# Copyright 2022 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# SM4 for x86_64 with AVX2, eight blocks at a time.
+#
+# The four state words of eight blocks are kept transposed, one word per
+# 32-bit lane of a ymm register, so a round is the same sequence of
+# vector instructions for all blocks. The S-box is evaluated in one of
+# two ways:
+#
+# - SM4 and AES S-boxes are both inversions in GF(2^8) wrapped in affine
+#   maps, and the two fields are isomorphic. The input is moved to the
+#   AES field with a vpshufb nibble lookup, run through vaesenclast with
+#   ShiftRows undone afterwards, and moved back with another lookup.
+# - With GFNI the same thing is vgf2p8affineqb followed by
+#   vgf2p8affineinvqb, on full ymm registers.
+#
+# Neither needs secret-dependent memory accesses.
+#
+# The caller is expected to check ossl_vpsm4_eligible() first, it is false
+# without AES-NI and AVX2, or if the assembler is too old for either.
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22);
+	$gfni = ($1>=2.30);
+}
+
+if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)(?:\.([0-9]+))?/) {
+	$avx = ($1>=2.09) + ($1>=2.10);
+	$gfni = ($1>=2.14);
+}
+
+if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
+	   `ml64 2>&1` =~ /Version ([0-9]+)\./) {
+	$avx = ($1>=10) + ($1>=11);
+}
+
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0);
+	$gfni = ($2>=6.0);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+$code.=<<___;
+.text
+___
+
+if ($avx>1) {{{
+my ($inp,$out,$len,$key,$ivp)=("%rdi","%rsi","%rdx","%rcx","%r8");
+my @B=map("%ymm$_",(0..3));
+my @C=map("%ymm$_",(10..13));		# second batch, GFNI only
+my @T=map("%ymm$_",(4..7));
+my ($mask,$pre_lo,$pre_hi,$post_lo,$post_hi)=map("%ymm$_",(8..12));
+my ($gf_pre,$gf_post)=map("%ymm$_",(8..9));
+my @isr_rol=map("%ymm$_",(13..15));	# InvShiftRows, then <<< 8, 16, 24
+my $_rsp="256(%rsp)";
+my $framesz=272+$win64*16*10;
+
+sub xmm { my $r=shift; $r=~s/%y/%x/; $r; }
+
+# "off(%reg)" plus n
+sub at { my ($m,$n)=@_; $m=~/^(-?\d*)(\(.*\))$/; ($1+$n).$2; }
+
+# B0 ^= L(S(B1 ^ B2 ^ B3 ^ rk)), rk at %rax
+sub round {
+my ($gf,$b0,$b1,$b2,$b3,$x,$t,$u,$v)=@_;
+my @insns=(
+	"vpbroadcastd	(%rax),$x",
+	"vpxor	$b2,$b1,$t",
+	"vpxor	$b3,$x,$x",
+	"vpxor	$t,$x,$x");
+
+    if ($gf) {
+	push(@insns,
+	"vgf2p8affineqb	\$0x3e,$gf_pre,$x,$x",
+	"vgf2p8affineinvqb	\$0xd3,$gf_post,$x,$x",
+	"vpshufb	.Lrol8(%rip),$x,$t",
+	"vpshufb	.Lrol16(%rip),$x,$u",
+	"vpxor	$x,$b0,$b0",
+	"vpxor	$x,$t,$t",
+	"vpshufb	.Lrol24(%rip),$x,$x");
+    } else {
+	# ShiftRows of vaesenclast is undone by the rotation shuffles,
+	# and its round key, the 0x0f mask, is cancelled by post-affine
+	push(@insns,
+	"vpsrld	\$4,$x,$t",
+	"vpand	$mask,$x,$x",
+	"vpand	$mask,$t,$t",
+	"vpshufb	$x,$pre_lo,$x",
+	"vpshufb	$t,$pre_hi,$t",
+	"vpxor	$t,$x,$x",
+	"vextracti128	\$1,$x,".xmm($t),
+	"vaesenclast	".xmm($mask).",".xmm($x).",".xmm($x),
+	"vaesenclast	".xmm($mask).",".xmm($t).",".xmm($t),
+	"vinserti128	\$1,".xmm($t).",$x,$x",
+	"vpsrld	\$4,$x,$t",
+	"vpand	$mask,$x,$x",
+	"vpand	$mask,$t,$t",
+	"vpshufb	$x,$post_lo,$x",
+	"vpshufb	$t,$post_hi,$t",
+	"vpxor	$t,$x,$v",
+	"vpshufb	.Lisr(%rip),$v,$x",
+	"vpshufb	$isr_rol[0],$v,$t",
+	"vpshufb	$isr_rol[1],$v,$u",
+	"vpxor	$x,$b0,$b0",
+	"vpxor	$x,$t,$t",
+	"vpshufb	$isr_rol[2],$v,$x");
+    }
+    push(@insns,
+	"vpxor	$u,$t,$t",		# t ^ t<<<8 ^ t<<<16
+	"vpxor	$x,$b0,$b0",
+	"vpslld	\$2,$t,$u",
+	"vpsrld	\$30,$t,$t",
+	"vpxor	$u,$b0,$b0",
+	"vpxor	$t,$b0,$b0");
+    @insns;
+}
+
+# 32 rounds on @B, and on @C for $n==16, with the round keys at %r10 in
+# steps of %r11. The two batches are independent and interleaved.
+sub crypt {
+my ($gf,$n)=@_;
+my $sfx=($gf?"gfni":"aesni").$n;
+
+    $code.=<<___;
+.type	_vpsm4_crypt$sfx,\@abi-omnipotent
+.align	32
+_vpsm4_crypt$sfx:
+	mov	%r10,%rax
+	mov	\$8,%r9d
+.Loop_crypt$sfx:
+___
+    for (my $i=0;$i<4;$i++) {
+	my @r=($i,($i+1)%4,($i+2)%4,($i+3)%4);
+	my @a=&round($gf,@B[@r],@T);
+	my @c=$n==16 ? &round($gf,@C[@r],$T[3],"%ymm14","%ymm15") : ();
+
+	while (@a || @c) {
+	    $code.="\t".shift(@a)."\n" if (@a);
+	    $code.="\t".shift(@c)."\n" if (@c);
+	}
+	$code.="\tadd	%r11,%rax\n";
+    }
+    $code.=<<___;
+	dec	%r9d
+	jnz	.Loop_crypt$sfx
+	ret
+.size	_vpsm4_crypt$sfx,.-_vpsm4_crypt$sfx
+___
+}
+
+# eight blocks at $ptr, block i and i+4 in the same register
+sub load8 {
+my ($ptr,@r)=@_;
+
+    for (my $i=0;$i<4;$i++) {
+	$code.=<<___;
+	vmovdqu	@{[at($ptr,16*$i)]},@{[xmm($r[$i])]}
+	vinserti128	\$1,@{[at($ptr,16*($i+4))]},$r[$i],$r[$i]
+___
+    }
+    &transpose(@r);
+    for (my $i=0;$i<4;$i++) {
+	$code.="\tvpshufb	.Lbswap(%rip),$r[$i],$r[$i]\n";
+    }
+}
+
+# output block is B3 || B2 || B1 || B0, rows end up in @r[3,2,1,0]
+sub unload8 {
+my @r=@_;
+
+    for (my $i=0;$i<4;$i++) {
+	$code.="\tvpshufb	.Lbswap(%rip),$r[$i],$r[$i]\n";
+    }
+    &transpose(@r[3,2,1,0]);
+}
+
+sub transpose {
+my @r=@_;
+my @t=@T;
+
+    $code.=<<___;
+	vpunpckldq	$r[1],$r[0],$t[0]
+	vpunpckhdq	$r[1],$r[0],$t[1]
+	vpunpckldq	$r[3],$r[2],$t[2]
+	vpunpckhdq	$r[3],$r[2],$t[3]
+	vpunpcklqdq	$t[2],$t[0],$r[0]
+	vpunpckhqdq	$t[2],$t[0],$r[1]
+	vpunpcklqdq	$t[3],$t[1],$r[2]
+	vpunpckhqdq	$t[3],$t[1],$r[3]
+___
+}
+
+# rows of unload8 to $ptr, xor-ed with $xor first if given
+sub store8 {
+my ($ptr,$xor,@r)=@_;
+
+    @r=@r[3,2,1,0];
+    for (my $i=0;$i<4;$i++) {
+	$code.=<<___ if ($xor);
+	vmovdqu	@{[at($xor,16*$i)]},@{[xmm($T[0])]}
+	vinserti128	\$1,@{[at($xor,16*($i+4))]},$T[0],$T[0]
+	vpxor	$T[0],$r[$i],$r[$i]
+___
+	$code.=<<___;
+	vmovdqu	@{[xmm($r[$i])]},@{[at($ptr,16*$i)]}
+	vextracti128	\$1,$r[$i],@{[at($ptr,16*($i+4))]}
+___
+    }
+}
+
+sub setup {
+my $gf=shift;
+
+    if ($gf) {
+	$code.=<<___;
+	vpbroadcastq	.Lgfni_pre(%rip),$gf_pre
+	vpbroadcastq	.Lgfni_post(%rip),$gf_post
+___
+    } else {
+	$code.=<<___;
+	vpbroadcastb	.Lnibble(%rip),$mask
+	vbroadcasti128	.Lpre_lo(%rip),$pre_lo
+	vbroadcasti128	.Lpre_hi(%rip),$pre_hi
+	vbroadcasti128	.Lpost_lo(%rip),$post_lo
+	vbroadcasti128	.Lpost_hi(%rip),$post_hi
+	vbroadcasti128	.Lisr_rol8(%rip),$isr_rol[0]
+	vbroadcasti128	.Lisr_rol16(%rip),$isr_rol[1]
+	vbroadcasti128	.Lisr_rol24(%rip),$isr_rol[2]
+___
+    }
+}
+
+sub prologue {
+my ($func,$n)=@_;
+
+    $code.=<<___;
+.globl	$func
+.type	$func,\@function,$n
+.align	32
+$func:
+.cfi_startproc
+	endbranch
+	mov	%rsp,%rax		# copy %rsp
+.cfi_def_cfa_register	%rax
+	sub	\$$framesz,%rsp
+	and	\$-32,%rsp		# align stack frame
+	mov	%rax,$_rsp		# save copy of %rsp
+.cfi_cfa_expression	$_rsp,deref,+8
+___
+    $code.=<<___ if ($win64);
+	movaps	%xmm6,272(%rsp)
+	movaps	%xmm7,288(%rsp)
+	movaps	%xmm8,304(%rsp)
+	movaps	%xmm9,320(%rsp)
+	movaps	%xmm10,336(%rsp)
+	movaps	%xmm11,352(%rsp)
+	movaps	%xmm12,368(%rsp)
+	movaps	%xmm13,384(%rsp)
+	movaps	%xmm14,400(%rsp)
+	movaps	%xmm15,416(%rsp)
+___
+    $code.=".Lprologue_$func:\n";
+}
+
+sub epilogue {
+my $func=shift;
+
+    $code.=<<___;
+	vpxor	$B[0],$B[0],$B[0]	# wipe key stream and state
+	vmovdqa	$B[0],0(%rsp)
+	vmovdqa	$B[0],32(%rsp)
+	vmovdqa	$B[0],64(%rsp)
+	vmovdqa	$B[0],96(%rsp)
+	vmovdqa	$B[0],128(%rsp)
+	vmovdqa	$B[0],160(%rsp)
+	vmovdqa	$B[0],192(%rsp)
+	vmovdqa	$B[0],224(%rsp)
+	mov	$_rsp,%rax
+.cfi_def_cfa	%rax,8
+	vzeroall
+___
+    $code.=<<___ if ($win64);
+	movaps	272(%rsp),%xmm6
+	movaps	288(%rsp),%xmm7
+	movaps	304(%rsp),%xmm8
+	movaps	320(%rsp),%xmm9
+	movaps	336(%rsp),%xmm10
+	movaps	352(%rsp),%xmm11
+	movaps	368(%rsp),%xmm12
+	movaps	384(%rsp),%xmm13
+	movaps	400(%rsp),%xmm14
+	movaps	416(%rsp),%xmm15
+___
+    $code.=<<___;
+	lea	(%rax),%rsp
+.cfi_def_cfa_register	%rsp
+.Lepilogue_$func:
+	ret
+.cfi_endproc
+.size	$func,.-$func
+___
+}
+
+$code.=<<___;
+.extern	OPENSSL_ia32cap_P
+
+# int ossl_vpsm4_eligible(void);
+.globl	ossl_vpsm4_eligible
+.type	ossl_vpsm4_eligible,\@abi-omnipotent
+.align	32
+ossl_vpsm4_eligible:
+	mov	OPENSSL_ia32cap_P+4(%rip),%ecx
+	mov	OPENSSL_ia32cap_P+8(%rip),%eax
+	shr	\$`57-32`,%ecx			# AES-NI
+	shr	\$5,%eax			# AVX2
+	and	%ecx,%eax
+	and	\$1,%eax
+	ret
+.size	ossl_vpsm4_eligible,.-ossl_vpsm4_eligible
+___
+&crypt(0,8);
+&crypt(1,8) if ($gfni);
+&crypt(1,16) if ($gfni);
+
+######################################################################
+# void ossl_vpsm4_ecb_encrypt(const unsigned char *in,
+#                             unsigned char *out, size_t len,
+#                             const SM4_KEY *key, const int enc);
+#
+# The key schedule is walked backwards for decryption.
+{
+my $func="ossl_vpsm4_ecb_encrypt";
+
+&prologue($func,5);
+$code.=<<___;
+	shr	\$4,$len
+	jz	.Lecb_done
+	mov	$key,%r10
+	mov	\$4,%r11
+	test	${ivp}d,${ivp}d
+	jnz	.Lecb_enc
+	lea	124($key),%r10
+	neg	%r11
+.Lecb_enc:
+___
+$code.=<<___ if ($gfni);
+	testl	\$`1<<8`,OPENSSL_ia32cap_P+12(%rip)	# GFNI?
+	jnz	.Lecb_gfni
+___
+for my $gf (0..$gfni) {
+my $sfx=$gf?"gfni":"aesni";
+
+    $code.=".Lecb_$sfx:\n";
+    &setup($gf);
+    if ($gf) {
+	$code.=<<___;
+	sub	\$16,$len
+	jb	.Lecb16_done_$sfx
+.Loop_ecb16_$sfx:
+___
+	&load8("($inp)",@B);
+	&load8("128($inp)",@C);
+	$code.="\tcall	_vpsm4_crypt${sfx}16\n";
+	&unload8(@B);
+	&store8("($out)","",@B);
+	&unload8(@C);
+	&store8("128($out)","",@C);
+	$code.=<<___;
+	lea	256($inp),$inp
+	lea	256($out),$out
+	sub	\$16,$len
+	jae	.Loop_ecb16_$sfx
+.Lecb16_done_$sfx:
+	add	\$16,$len
+	jz	.Lecb_done
+___
+    }
+    $code.=<<___;
+	sub	\$8,$len
+	jb	.Lecb_tail_$sfx
+.Loop_ecb_$sfx:
+___
+    &load8("($inp)",@B);
+    $code.="\tcall	_vpsm4_crypt${sfx}8\n";
+    &unload8(@B);
+    &store8("($out)","",@B);
+    $code.=<<___;
+	lea	128($inp),$inp
+	lea	128($out),$out
+	sub	\$8,$len
+	jae	.Loop_ecb_$sfx
+.Lecb_tail_$sfx:
+	add	\$8,$len
+	jz	.Lecb_done
+	xor	%eax,%eax
+	mov	$len,%r9
+.Lecb_copy_in_$sfx:
+	vmovdqu	($inp,%rax),%xmm0
+	vmovdqa	%xmm0,(%rsp,%rax)
+	add	\$16,%rax
+	dec	%r9
+	jnz	.Lecb_copy_in_$sfx
+___
+    &load8("(%rsp)",@B);
+    $code.="\tcall	_vpsm4_crypt${sfx}8\n";
+    &unload8(@B);
+    &store8("(%rsp)","",@B);
+    $code.=<<___;
+	xor	%eax,%eax
+.Lecb_copy_out_$sfx:
+	vmovdqa	(%rsp,%rax),%xmm0
+	vmovdqu	%xmm0,($out,%rax)
+	add	\$16,%rax
+	dec	$len
+	jnz	.Lecb_copy_out_$sfx
+	jmp	.Lecb_done
+___
+}
+$code.=".Lecb_done:\n";
+&epilogue($func);
+}
+
+######################################################################
+# void ossl_vpsm4_ctr32_encrypt_blocks(const unsigned char *in,
+#                                      unsigned char *out, size_t blocks,
+#                                      const SM4_KEY *key,
+#                                      const unsigned char ivec[16]);
+#
+# Counter blocks are built directly in transposed form: words 0-2 are
+# the same in all blocks and only word 3 varies. The frame holds them
+# at 128(%rsp), the tail key stream goes to 0(%rsp).
+{
+my $func="ossl_vpsm4_ctr32_encrypt_blocks";
+
+&prologue($func,5);
+$code.=<<___;
+	test	$len,$len
+	jz	.Lctr_done
+	mov	$key,%r10
+	mov	\$4,%r11
+	vmovdqu	($ivp),%xmm0
+	vpshufb	.Lbswap(%rip),%xmm0,%xmm0
+	vpshufd	\$0x55,%xmm0,%xmm1
+	vpshufd	\$0xaa,%xmm0,%xmm2
+	vpshufd	\$0xff,%xmm0,%xmm3
+	vpbroadcastd	%xmm0,$B[0]
+	vpbroadcastd	%xmm1,$B[1]
+	vpbroadcastd	%xmm2,$B[2]
+	vpbroadcastd	%xmm3,$B[3]
+	vpaddd	.Lctr_inc(%rip),$B[3],$B[3]
+	vmovdqa	$B[0],128(%rsp)
+	vmovdqa	$B[1],160(%rsp)
+	vmovdqa	$B[2],192(%rsp)
+	vmovdqa	$B[3],224(%rsp)
+___
+$code.=<<___ if ($gfni);
+	testl	\$`1<<8`,OPENSSL_ia32cap_P+12(%rip)	# GFNI?
+	jnz	.Lctr_gfni
+___
+for my $gf (0..$gfni) {
+my $sfx=$gf?"gfni":"aesni";
+
+    $code.=".Lctr_$sfx:\n";
+    &setup($gf);
+    if ($gf) {
+	$code.=<<___;
+	sub	\$16,$len
+	jb	.Lctr16_done_$sfx
+.Loop_ctr16_$sfx:
+	vmovdqa	128(%rsp),$B[0]
+	vmovdqa	160(%rsp),$B[1]
+	vmovdqa	192(%rsp),$B[2]
+	vmovdqa	224(%rsp),$B[3]
+	vmovdqa	$B[0],$C[0]
+	vmovdqa	$B[1],$C[1]
+	vmovdqa	$B[2],$C[2]
+	vpaddd	.Lctr_step(%rip),$B[3],$C[3]
+	vpaddd	.Lctr_step(%rip),$C[3],$T[0]
+	vmovdqa	$T[0],224(%rsp)
+	call	_vpsm4_crypt${sfx}16
+___
+	&unload8(@B);
+	&store8("($out)","($inp)",@B);
+	&unload8(@C);
+	&store8("128($out)","128($inp)",@C);
+	$code.=<<___;
+	lea	256($inp),$inp
+	lea	256($out),$out
+	sub	\$16,$len
+	jae	.Loop_ctr16_$sfx
+.Lctr16_done_$sfx:
+	add	\$16,$len
+	jz	.Lctr_done
+___
+    }
+    $code.=<<___;
+	jmp	.Lctr_entry_$sfx
+.align	16
+.Loop_ctr_$sfx:
+	lea	128($inp),$inp
+	lea	128($out),$out
+.Lctr_entry_$sfx:
+	vmovdqa	128(%rsp),$B[0]
+	vmovdqa	160(%rsp),$B[1]
+	vmovdqa	192(%rsp),$B[2]
+	vmovdqa	224(%rsp),$B[3]
+	vpaddd	.Lctr_step(%rip),$B[3],$T[0]
+	vmovdqa	$T[0],224(%rsp)
+	call	_vpsm4_crypt${sfx}8
+___
+    &unload8(@B);
+    $code.=<<___;
+	sub	\$8,$len
+	jb	.Lctr_tail_$sfx
+___
+    &store8("($out)","($inp)",@B);
+    $code.=<<___;
+	jnz	.Loop_ctr_$sfx
+	jmp	.Lctr_done
+.Lctr_tail_$sfx:
+___
+    &store8("(%rsp)","",@B);
+    $code.=<<___;
+	add	\$8,$len
+	xor	%eax,%eax
+.Lctr_xor_$sfx:
+	vmovdqu	($inp,%rax),%xmm0
+	vpxor	(%rsp,%rax),%xmm0,%xmm0
+	vmovdqu	%xmm0,($out,%rax)
+	add	\$16,%rax
+	dec	$len
+	jnz	.Lctr_xor_$sfx
+	jmp	.Lctr_done
+___
+}
+$code.=".Lctr_done:\n";
+&epilogue($func);
+}
+
+sub bytes { join(",",map(sprintf("0x%02x",$_),@_)); }
+
+$code.=<<___;
+.align	64
+.Lbswap:
+	.byte	3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12
+	.byte	3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12
+.Lrol8:
+	.byte	3,0,1,2,7,4,5,6,11,8,9,10,15,12,13,14
+	.byte	3,0,1,2,7,4,5,6,11,8,9,10,15,12,13,14
+.Lrol16:
+	.byte	2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13
+	.byte	2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13
+.Lrol24:
+	.byte	1,2,3,0,5,6,7,4,9,10,11,8,13,14,15,12
+	.byte	1,2,3,0,5,6,7,4,9,10,11,8,13,14,15,12
+.Lisr:				# InvShiftRows
+	.byte	0,13,10,7,4,1,14,11,8,5,2,15,12,9,6,3
+	.byte	0,13,10,7,4,1,14,11,8,5,2,15,12,9,6,3
+.Lisr_rol8:
+	.byte	7,0,13,10,11,4,1,14,15,8,5,2,3,12,9,6
+.Lisr_rol16:
+	.byte	10,7,0,13,14,11,4,1,2,15,8,5,6,3,12,9
+.Lisr_rol24:
+	.byte	13,10,7,0,1,14,11,4,5,2,15,8,9,6,3,12
+.Lpre_lo:			# SM4 affine, then to AES field
+	.byte	@{[bytes(0x3e,0xb2,0x0e,0x82,0xbb,0x37,0x8b,0x07,
+		         0xa1,0x2d,0x91,0x1d,0x24,0xa8,0x14,0x98)]}
+.Lpre_hi:
+	.byte	@{[bytes(0x00,0xdc,0x2e,0xf2,0xc5,0x19,0xeb,0x37,
+		         0x08,0xd4,0x26,0xfa,0xcd,0x11,0xe3,0x3f)]}
+.Lpost_lo:			# undo AES affine, to SM4 field, SM4 affine
+	.byte	@{[bytes(0x47,0xff,0x8d,0x35,0x79,0xc1,0xb3,0x0b,
+		         0x20,0x98,0xea,0x52,0x1e,0xa6,0xd4,0x6c)]}
+.Lpost_hi:
+	.byte	@{[bytes(0x00,0xe0,0x50,0xb0,0x9d,0x7d,0xcd,0x2d,
+		         0xc0,0x20,0x90,0x70,0x5d,0xbd,0x0d,0xed)]}
+.Lctr_inc:
+	.long	0,1,2,3,4,5,6,7
+.Lctr_step:
+	.long	8,8,8,8,8,8,8,8
+.Lgfni_pre:
+	.quad	0x4c287db91a22505d
+.Lgfni_post:
+	.quad	0xf3ab34a974a6b589
+.Lnibble:
+	.byte	0x0f
+.asciz	"SM4 for x86_64/AVX2, CRYPTOGAMS by <appro\@openssl.org>"
+___
+
+# EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
+#		CONTEXT *context,DISPATCHER_CONTEXT *disp)
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	se_handler,\@abi-omnipotent
+.align	16
+se_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HanderlData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lin_prologue
+
+	mov	152($context),%rax	# pull context->Rsp
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lin_prologue
+
+	lea	272(%rax),%rsi		# Xmm6- save area
+	mov	256(%rax),%rax		# pull $_rsp
+	lea	512($context),%rdi	# &context.Xmm6
+	mov	\$20,%ecx
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lin_prologue:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	se_handler,.-se_handler
+
+.section	.pdata
+.align	4
+	.rva	.LSEH_begin_ossl_vpsm4_ecb_encrypt
+	.rva	.LSEH_end_ossl_vpsm4_ecb_encrypt
+	.rva	.LSEH_info_ossl_vpsm4_ecb_encrypt
+	.rva	.LSEH_begin_ossl_vpsm4_ctr32_encrypt_blocks
+	.rva	.LSEH_end_ossl_vpsm4_ctr32_encrypt_blocks
+	.rva	.LSEH_info_ossl_vpsm4_ctr32_encrypt_blocks
+
+.section	.xdata
+.align	8
+.LSEH_info_ossl_vpsm4_ecb_encrypt:
+	.byte	9,0,0,0
+	.rva	se_handler
+	.rva	.Lprologue_ossl_vpsm4_ecb_encrypt,.Lepilogue_ossl_vpsm4_ecb_encrypt	# HandlerData[]
+.LSEH_info_ossl_vpsm4_ctr32_encrypt_blocks:
+	.byte	9,0,0,0
+	.rva	se_handler
+	.rva	.Lprologue_ossl_vpsm4_ctr32_encrypt_blocks,.Lepilogue_ossl_vpsm4_ctr32_encrypt_blocks	# HandlerData[]
+___
+}
+}}} else {{{
+$code.=<<___;
+.globl	ossl_vpsm4_eligible
+.type	ossl_vpsm4_eligible,\@abi-omnipotent
+ossl_vpsm4_eligible:
+	xor	%eax,%eax
+	ret
+.size	ossl_vpsm4_eligible,.-ossl_vpsm4_eligible
+
+.globl	ossl_vpsm4_ecb_encrypt
+.type	ossl_vpsm4_ecb_encrypt,\@abi-omnipotent
+ossl_vpsm4_ecb_encrypt:
+.globl	ossl_vpsm4_ctr32_encrypt_blocks
+.type	ossl_vpsm4_ctr32_encrypt_blocks,\@abi-omnipotent
+ossl_vpsm4_ctr32_encrypt_blocks:
+	.byte	0x0f,0x0b	# ud2
+	ret
+.size	ossl_vpsm4_ecb_encrypt,.-ossl_vpsm4_ecb_encrypt
+___
+}}}
+
+foreach (split("\n",$code)) {
+	s/\`([^\`]*)\`/eval($1)/geo;
+
+	print $_,"\n";
+}
+
+close STDOUT or die "error closing STDOUT: $!";
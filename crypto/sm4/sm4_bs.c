@@ -0,0 +1,345 @@
+/*
+ * Copyright 2022 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Bitsliced SM4 for ECB and CTR bulk processing.
+ *
+ * 16 blocks are processed at once.  Each of the four 32-bit state words is
+ * held as eight 64-bit bit planes: plane b carries bit b of every byte of
+ * that word in all 16 blocks, with byte p (counting from the least
+ * significant byte) of block i in bit 16 * p + i.  With this layout the
+ * S-box is evaluated for all 64 bytes of a round by one boolean circuit,
+ * and rotating a word left by 8 bits is a rotation of each plane by 16.
+ *
+ * No table lookups depend on secret data, so unlike ossl_sm4_encrypt()
+ * the code runs in constant time.
+ */
+
+#include <string.h>
+#include <openssl/crypto.h>
+#include "crypto/sm4.h"
+
+#define SM4_BS_BLOCKS   16
+
+typedef uint64_t sm4_bs_plane[8];
+
+/*
+ * The state and the key schedule are wrapped in structures so that they can
+ * be passed around as const pointers; C has no implicit conversion between
+ * pointers to arrays with different qualifiers.
+ */
+typedef struct {
+    sm4_bs_plane b[4];
+} SM4_BS_STATE;
+
+typedef struct {
+    sm4_bs_plane rk[SM4_KEY_SCHEDULE];
+} SM4_BS_KEY;
+
+static ossl_inline uint64_t rotl64(uint64_t a, int n)
+{
+    return (a << n) | (a >> (64 - n));
+}
+
+/*
+ * GF(2^2) = GF(2)[W] / (W^2 + W + 1), element x[0] + x[1] * W.
+ */
+static ossl_inline void gf4_mul(uint64_t z[2], const uint64_t x[2],
+                                const uint64_t y[2])
+{
+    uint64_t lo = x[0] & y[0];
+    uint64_t hi = x[1] & y[1];
+    uint64_t mid = (x[0] ^ x[1]) & (y[0] ^ y[1]);
+
+    z[0] = lo ^ hi;
+    z[1] = mid ^ lo;
+}
+
+/*
+ * GF(2^4) = GF(2^2)[Z] / (Z^2 + Z + W), element x[0..1] + x[2..3] * Z.
+ */
+static ossl_inline void gf16_mul(uint64_t z[4], const uint64_t x[4],
+                                 const uint64_t y[4])
+{
+    uint64_t lo[2], hi[2], mid[2], xs[2], ys[2];
+
+    xs[0] = x[0] ^ x[2];
+    xs[1] = x[1] ^ x[3];
+    ys[0] = y[0] ^ y[2];
+    ys[1] = y[1] ^ y[3];
+    gf4_mul(lo, x, y);
+    gf4_mul(hi, x + 2, y + 2);
+    gf4_mul(mid, xs, ys);
+    /* lo + W * hi */
+    z[0] = lo[0] ^ hi[1];
+    z[1] = lo[1] ^ hi[0] ^ hi[1];
+    z[2] = mid[0] ^ lo[0];
+    z[3] = mid[1] ^ lo[1];
+}
+
+/*
+ * For a = a0 + a1 * Z the inverse is (a0 + a1, a1) / d with the norm
+ * d = W * a1^2 + a1 * a0 + a0^2 in GF(2^2), and d^-1 = d^2 there.
+ * Zero maps to zero.
+ */
+static ossl_inline void gf16_inv(uint64_t z[4], const uint64_t a[4])
+{
+    uint64_t d[2], di[2], as[2];
+
+    gf4_mul(d, a, a + 2);
+    d[0] ^= a[0] ^ a[1] ^ a[3];
+    d[1] ^= a[1] ^ a[2];
+    di[0] = d[0] ^ d[1];
+    di[1] = d[1];
+    as[0] = a[0] ^ a[2];
+    as[1] = a[1] ^ a[3];
+    gf4_mul(z, as, di);
+    gf4_mul(z + 2, a + 2, di);
+}
+
+/*
+ * The SM4 S-box is S(x) = A * (A * x + c)^-1 + c, with the inversion done
+ * in GF(2^8) mod x^8 + x^7 + x^6 + x^5 + x^4 + x^2 + 1, A the circulant
+ * matrix of 0xa7 and c = 0xd3.  The inversion is moved to the tower field
+ * GF(2^4)[Y] / (Y^2 + Y + 9); the change of basis is folded into the two
+ * affine maps, and the norm becomes 9 * a1^2 + a1 * a0 + a0^2.
+ */
+static ossl_inline void sm4_bs_sbox(uint64_t x[8])
+{
+    uint64_t u[8], d[4], di[4], us[4], z[8];
+
+    u[0] = x[0] ^ x[4] ^ x[5] ^ x[6];
+    u[1] = x[1] ^ x[4] ^ x[5];
+    u[2] = ~x[5];
+    u[3] = x[0] ^ x[1] ^ x[2] ^ x[5] ^ x[6];
+    u[4] = x[0] ^ x[1] ^ x[2] ^ x[4] ^ x[6];
+    u[5] = ~x[6];
+    u[6] = ~(x[2] ^ x[7]);
+    u[7] = ~(u[4] ^ x[3] ^ x[5]);
+
+    gf16_mul(d, u, u + 4);
+    d[0] ^= u[0] ^ u[1] ^ u[3] ^ u[4] ^ u[5] ^ u[6] ^ u[7];
+    d[1] ^= u[1] ^ u[2] ^ u[5] ^ u[7];
+    d[2] ^= u[2] ^ u[3] ^ u[5];
+    d[3] ^= u[3] ^ u[4];
+    gf16_inv(di, d);
+    us[0] = u[0] ^ u[4];
+    us[1] = u[1] ^ u[5];
+    us[2] = u[2] ^ u[6];
+    us[3] = u[3] ^ u[7];
+    gf16_mul(z, us, di);
+    gf16_mul(z + 4, u + 4, di);
+
+    x[0] = ~(z[0] ^ z[2]);
+    x[1] = ~(z[0] ^ z[4] ^ z[6]);
+    x[2] = z[1] ^ z[2] ^ z[4];
+    x[3] = z[0] ^ z[6] ^ z[7];
+    x[4] = ~(z[1] ^ z[3] ^ z[5]);
+    x[5] = z[1] ^ z[3] ^ z[7];
+    x[6] = ~(z[0] ^ z[1] ^ z[4] ^ z[5]);
+    x[7] = ~(x[3] ^ z[1] ^ z[2] ^ z[3] ^ z[4]);
+}
+
+/*
+ * B0 ^= L(S(B1 ^ B2 ^ B3 ^ rk)), with
+ * L(t) = t ^ (t <<< 2) ^ (t <<< 10) ^ (t <<< 18) ^ (t <<< 24).
+ */
+static ossl_inline void sm4_bs_round(sm4_bs_plane b0, const sm4_bs_plane b1,
+                                     const sm4_bs_plane b2,
+                                     const sm4_bs_plane b3,
+                                     const sm4_bs_plane rk)
+{
+    uint64_t t[8], r;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        t[i] = b1[i] ^ b2[i] ^ b3[i] ^ rk[i];
+
+    sm4_bs_sbox(t);
+
+    for (i = 0; i < 8; i++) {
+        /* bit i of t <<< 2 */
+        r = i >= 2 ? t[i - 2] : rotl64(t[i + 6], 16);
+        b0[i] ^= t[i] ^ rotl64(t[i], 48)
+                 ^ r ^ rotl64(r, 16) ^ rotl64(r, 32);
+    }
+}
+
+/*
+ * Transpose the 8x8 bit matrix held in |x| (row i in byte i).
+ */
+static ossl_inline uint64_t transpose8x8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+static void sm4_bs_load(SM4_BS_STATE *st, const uint8_t *in)
+{
+    uint64_t lo, hi;
+    int w, p, i, b;
+
+    memset(st, 0, sizeof(*st));
+    for (w = 0; w < 4; w++) {
+        for (p = 0; p < 4; p++) {
+            const uint8_t *q = in + 4 * w + 3 - p;
+
+            lo = hi = 0;
+            for (i = 0; i < 8; i++) {
+                lo |= (uint64_t)q[16 * i] << (8 * i);
+                hi |= (uint64_t)q[16 * (i + 8)] << (8 * i);
+            }
+            lo = transpose8x8(lo);
+            hi = transpose8x8(hi);
+            for (b = 0; b < 8; b++)
+                st->b[w][b] |= (((lo >> (8 * b)) & 0xff)
+                             | (((hi >> (8 * b)) & 0xff) << 8)) << (16 * p);
+        }
+    }
+}
+
+/*
+ * The output block is B3 || B2 || B1 || B0.
+ */
+static void sm4_bs_store(uint8_t *out, const SM4_BS_STATE *st)
+{
+    uint64_t lo, hi;
+    int w, p, i, b;
+
+    for (w = 0; w < 4; w++) {
+        for (p = 0; p < 4; p++) {
+            uint8_t *q = out + 4 * w + 3 - p;
+
+            lo = hi = 0;
+            for (b = 0; b < 8; b++) {
+                lo |= ((st->b[3 - w][b] >> (16 * p)) & 0xff) << (8 * b);
+                hi |= ((st->b[3 - w][b] >> (16 * p + 8)) & 0xff) << (8 * b);
+            }
+            lo = transpose8x8(lo);
+            hi = transpose8x8(hi);
+            for (i = 0; i < 8; i++) {
+                q[16 * i] = (uint8_t)(lo >> (8 * i));
+                q[16 * (i + 8)] = (uint8_t)(hi >> (8 * i));
+            }
+        }
+    }
+}
+
+/*
+ * Spread each round key over the planes, in decryption order if !enc.
+ */
+static void sm4_bs_key(SM4_BS_KEY *rk, const SM4_KEY *ks, int enc)
+{
+    int r, p, b;
+
+    for (r = 0; r < SM4_KEY_SCHEDULE; r++) {
+        uint32_t k = ks->rk[enc ? r : SM4_KEY_SCHEDULE - 1 - r];
+
+        for (b = 0; b < 8; b++) {
+            uint64_t m = 0;
+
+            for (p = 0; p < 4; p++)
+                m |= (0 - (uint64_t)((k >> (8 * p + b)) & 1))
+                     & (0xffffULL << (16 * p));
+            rk->rk[r][b] = m;
+        }
+    }
+}
+
+static void sm4_bs_crypt(const uint8_t *in, uint8_t *out,
+                         const SM4_BS_KEY *rk)
+{
+    SM4_BS_STATE st;
+    int r;
+
+    sm4_bs_load(&st, in);
+    for (r = 0; r < SM4_KEY_SCHEDULE; r += 4) {
+        sm4_bs_round(st.b[0], st.b[1], st.b[2], st.b[3], rk->rk[r]);
+        sm4_bs_round(st.b[1], st.b[2], st.b[3], st.b[0], rk->rk[r + 1]);
+        sm4_bs_round(st.b[2], st.b[3], st.b[0], st.b[1], rk->rk[r + 2]);
+        sm4_bs_round(st.b[3], st.b[0], st.b[1], st.b[2], rk->rk[r + 3]);
+    }
+    sm4_bs_store(out, &st);
+    OPENSSL_cleanse(&st, sizeof(st));
+}
+
+void ossl_sm4_bs_ecb_encrypt(const unsigned char *in, unsigned char *out,
+                             size_t len, const SM4_KEY *ks, const int enc)
+{
+    SM4_BS_KEY rk;
+    uint8_t buf[SM4_BS_BLOCKS * SM4_BLOCK_SIZE];
+    size_t blocks = len / SM4_BLOCK_SIZE;
+
+    if (blocks == 0)
+        return;
+
+    sm4_bs_key(&rk, ks, enc);
+    for (; blocks >= SM4_BS_BLOCKS; blocks -= SM4_BS_BLOCKS) {
+        sm4_bs_crypt(in, out, &rk);
+        in += sizeof(buf);
+        out += sizeof(buf);
+    }
+    if (blocks > 0) {
+        memset(buf, 0, sizeof(buf));
+        memcpy(buf, in, blocks * SM4_BLOCK_SIZE);
+        sm4_bs_crypt(buf, buf, &rk);
+        memcpy(out, buf, blocks * SM4_BLOCK_SIZE);
+        OPENSSL_cleanse(buf, sizeof(buf));
+    }
+    OPENSSL_cleanse(&rk, sizeof(rk));
+}
+
+/*
+ * Only the low 32 bits of the counter are incremented, as the ctr128_f
+ * contract requires.
+ */
+void ossl_sm4_bs_ctr32_encrypt_blocks(const unsigned char *in,
+                                      unsigned char *out, size_t blocks,
+                                      const SM4_KEY *ks,
+                                      const unsigned char ivec[16])
+{
+    SM4_BS_KEY rk;
+    uint8_t buf[SM4_BS_BLOCKS * SM4_BLOCK_SIZE];
+    uint32_t ctr;
+    size_t i, n;
+
+    if (blocks == 0)
+        return;
+
+    sm4_bs_key(&rk, ks, 1);
+    ctr = ((uint32_t)ivec[12] << 24) | ((uint32_t)ivec[13] << 16)
+          | ((uint32_t)ivec[14] << 8) | ivec[15];
+    while (blocks > 0) {
+        n = blocks < SM4_BS_BLOCKS ? blocks : SM4_BS_BLOCKS;
+        for (i = 0; i < SM4_BS_BLOCKS; i++, ctr++) {
+            uint8_t *b = buf + i * SM4_BLOCK_SIZE;
+
+            memcpy(b, ivec, 12);
+            b[12] = (uint8_t)(ctr >> 24);
+            b[13] = (uint8_t)(ctr >> 16);
+            b[14] = (uint8_t)(ctr >> 8);
+            b[15] = (uint8_t)ctr;
+        }
+        sm4_bs_crypt(buf, buf, &rk);
+        for (i = 0; i < n * SM4_BLOCK_SIZE; i++)
+            out[i] = in[i] ^ buf[i];
+        in += n * SM4_BLOCK_SIZE;
+        out += n * SM4_BLOCK_SIZE;
+        blocks -= n;
+    }
+    OPENSSL_cleanse(buf, sizeof(buf));
+    OPENSSL_cleanse(&rk, sizeof(rk));
+}
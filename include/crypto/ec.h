@@ -66,6 +66,44 @@ int ossl_ec_key_pairwise_check(const EC_KEY *eckey, BN_CTX *ctx);
 OSSL_LIB_CTX *ossl_ec_key_get_libctx(const EC_KEY *eckey);
 const char *ossl_ec_key_get0_propq(const EC_KEY *eckey);
 void ossl_ec_key_set0_libctx(EC_KEY *key, OSSL_LIB_CTX *libctx);
+# ifdef ECP_SM2Z256_ASM
+typedef struct sm2z256_point_table_st SM2Z256_POINT_TABLE;
+
+int ossl_ec_key_sm2z256_sign_inverse(const EC_KEY *key, BN_ULONG inv[4]);
+const SM2Z256_POINT_TABLE *ossl_ec_key_sm2z256_pub_table(const EC_KEY *key);
+
+/*
+ * Entry points of the sm2z256 method for the SM2 code, see ecp_sm2z256.c.
+ * The ecp_sm2z256_ord_* functions work modulo the order of the built-in
+ * group and come from the assembly module or from ecp_sm2z256_c64.c.
+ */
+int ecp_sm2z256_group_is_builtin(const EC_GROUP *group);
+void ecp_sm2z256_mul_g_affine_x(BN_ULONG x[4], const BN_ULONG k[4]);
+int ecp_sm2z256_mul_batch_x(const EC_GROUP *group, size_t num,
+                            const BIGNUM *g_scalars[],
+                            const EC_POINT *points[],
+                            const BIGNUM *p_scalars[],
+                            const SM2Z256_POINT_TABLE *const tables[],
+                            BN_ULONG (*x)[4], unsigned char *infinity,
+                            BN_CTX *ctx);
+int ecp_sm2z256_encrypt_points(const EC_GROUP *group, unsigned char c1[64],
+                               unsigned char kp[64], const BIGNUM *k,
+                               const EC_POINT *point,
+                               const SM2Z256_POINT_TABLE *tbl, BN_CTX *ctx);
+void ecp_sm2z256_ord_mul_mont(BN_ULONG res[4], const BN_ULONG a[4],
+                              const BN_ULONG b[4]);
+void ecp_sm2z256_ord_sub_reduce(BN_ULONG res[4], const BN_ULONG a[4]);
+void ecp_sm2z256_ord_add(BN_ULONG res[4], const BN_ULONG a[4],
+                         const BN_ULONG b[4]);
+void ecp_sm2z256_ord_sub(BN_ULONG res[4], const BN_ULONG a[4],
+                         const BN_ULONG b[4]);
+void ecp_sm2z256_ord_negative(BN_ULONG res[4], const BN_ULONG a[4]);
+# endif
+# if !defined(OPENSSL_NO_SM2) && !defined(FIPS_MODULE)
+int ossl_ec_key_sm2_z_digest_init(const EC_KEY *key, EVP_MD_CTX *mdctx,
+                                  const EVP_MD *md, const uint8_t *id,
+                                  size_t id_len);
+# endif
 
 /* Backend support */
 int ossl_ec_group_todata(const EC_GROUP *group, OSSL_PARAM_BLD *tmpl,
@@ -899,6 +899,12 @@ int evp_pkey_ctx_get1_id_prov(EVP_PKEY_CTX *ctx, void *id);
 int evp_pkey_ctx_get1_id_len_prov(EVP_PKEY_CTX *ctx, size_t *id_len);
 
 int evp_pkey_ctx_use_cached_data(EVP_PKEY_CTX *ctx);
+
+/*
+ * Returns 1 if |md| is the SM3 of the built-in default provider, i.e. the
+ * code that ossl_sm3_digest_batch() may stand in for.
+ */
+int evp_md_is_default_sm3(const EVP_MD *md);
 # endif /* !defined(FIPS_MODULE) */
 
 int evp_method_store_flush(OSSL_LIB_CTX *libctx);
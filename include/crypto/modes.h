@@ -148,6 +148,16 @@ struct xts128_context {
     block128_f block1, block2;
 };
 
+/* Tweak update rules understood by ossl_crypto_xts128_encrypt_blocks() */
+#define XTS128_STANDARD_IEEE    0   /* IEEE Std 1619-2007 */
+#define XTS128_STANDARD_GB      1   /* GB/T 17964-2021 */
+
+int ossl_crypto_xts128_encrypt_blocks(const XTS128_CONTEXT *ctx,
+                                      const unsigned char iv[16],
+                                      const unsigned char *inp,
+                                      unsigned char *out, size_t len,
+                                      int enc, int standard, ecb128_f ecb);
+
 struct ccm128_context {
     union {
         u64 u[2];
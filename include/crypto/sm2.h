@@ -61,6 +61,16 @@ int ossl_sm2_internal_verify(const unsigned char *dgst, int dgstlen,
                              const unsigned char *sig, int siglen,
                              EC_KEY *eckey);
 
+/*
+ * SM2 verification of a batch of signatures, with a per-item result bitmap.
+ */
+int ossl_sm2_verify_batch(OSSL_LIB_CTX *libctx, size_t num,
+                          EC_KEY *const keys[],
+                          const unsigned char *const sigs[],
+                          const size_t siglens[],
+                          const unsigned char *const dgsts[],
+                          const size_t dgstlens[], unsigned char *results);
+
 /*
  * SM2 encryption
  */
@@ -80,6 +90,48 @@ int ossl_sm2_decrypt(const EC_KEY *key,
                      const uint8_t *ciphertext, size_t ciphertext_len,
                      uint8_t *ptext_buf, size_t *ptext_len);
 
+/*
+ * Streaming SM2 encryption in the raw C1 || C3 || C2 layout. C1 and C3 go
+ * in and out through the init and final calls, C2 through the updates.
+ * SM2_STREAM_MAX_C1 is the largest C1, a point on a 521 bit curve.
+ */
+#  define SM2_STREAM_MAX_C1 (1 + 2 * 66)
+
+typedef struct sm2_stream_st SM2_STREAM;
+
+SM2_STREAM *ossl_sm2_stream_new(void);
+void ossl_sm2_stream_free(SM2_STREAM *ctx);
+int ossl_sm2_stream_active(const SM2_STREAM *ctx);
+int ossl_sm2_stream_encrypt_init(SM2_STREAM *ctx, const EC_KEY *key,
+                                 const EVP_MD *md,
+                                 unsigned char *c1, size_t *c1len);
+int ossl_sm2_stream_decrypt_init(SM2_STREAM *ctx, const EC_KEY *key,
+                                 const EVP_MD *md,
+                                 const unsigned char *c1, size_t c1len,
+                                 const unsigned char *c3, size_t c3len);
+int ossl_sm2_stream_update(SM2_STREAM *ctx, unsigned char *out,
+                           const unsigned char *in, size_t inlen);
+int ossl_sm2_stream_encrypt_final(SM2_STREAM *ctx,
+                                  unsigned char *c3, size_t *c3len);
+int ossl_sm2_stream_decrypt_final(SM2_STREAM *ctx);
+
+int ossl_sm2_kdf(unsigned char *out, size_t outlen,
+                 const unsigned char *z, size_t zlen, const EVP_MD *digest,
+                 OSSL_LIB_CTX *libctx, const char *propq);
+
+/*
+ * SM2 key exchange. Derives |outlen| bytes of shared key from the static and
+ * ephemeral keys of both sides, and optionally the confirmation hash to send
+ * to the peer and the one expected back from it.
+ */
+int ossl_sm2_compute_key(unsigned char *out, size_t outlen, int initiator,
+                         const uint8_t *id, size_t id_len,
+                         const uint8_t *peer_id, size_t peer_id_len,
+                         const EC_KEY *key, const EC_KEY *eph,
+                         const EC_KEY *peer_key, const EC_KEY *peer_eph,
+                         const EVP_MD *digest, unsigned char *confirm,
+                         unsigned char *peer_confirm);
+
 const unsigned char *ossl_sm2_algorithmidentifier_encoding(int md_nid,
                                                            size_t *len);
 # endif /* OPENSSL_NO_SM2 */
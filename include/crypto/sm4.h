@@ -14,6 +14,7 @@
 
 # include <openssl/opensslconf.h>
 # include <openssl/e_os2.h>
+# include <stddef.h>
 
 # ifdef OPENSSL_NO_SM4
 #  error SM4 is disabled.
@@ -35,4 +36,11 @@ void ossl_sm4_encrypt(const uint8_t *in, uint8_t *out, const SM4_KEY *ks);
 
 void ossl_sm4_decrypt(const uint8_t *in, uint8_t *out, const SM4_KEY *ks);
 
+void ossl_sm4_bs_ecb_encrypt(const unsigned char *in, unsigned char *out,
+                             size_t len, const SM4_KEY *ks, const int enc);
+void ossl_sm4_bs_ctr32_encrypt_blocks(const unsigned char *in,
+                                      unsigned char *out, size_t blocks,
+                                      const SM4_KEY *ks,
+                                      const unsigned char ivec[16]);
+
 #endif
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2022 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_SM4_PLATFORM_H
+# define OSSL_SM4_PLATFORM_H
+# pragma once
+
+# include "crypto/sm4.h"
+
+# ifdef VPSM4_ASM
+void ossl_vpsm4_ecb_encrypt(const unsigned char *in, unsigned char *out,
+                            size_t len, const SM4_KEY *key, const int enc);
+void ossl_vpsm4_ctr32_encrypt_blocks(const unsigned char *in,
+                                     unsigned char *out, size_t blocks,
+                                     const SM4_KEY *key,
+                                     const unsigned char ivec[16]);
+# endif /* VPSM4_ASM */
+
+# ifdef HWSM4_ASM
+int ossl_hwsm4_set_encrypt_key(const unsigned char *userKey, SM4_KEY *key);
+int ossl_hwsm4_set_decrypt_key(const unsigned char *userKey, SM4_KEY *key);
+void ossl_hwsm4_encrypt(const unsigned char *in, unsigned char *out,
+                        const SM4_KEY *key);
+void ossl_hwsm4_decrypt(const unsigned char *in, unsigned char *out,
+                        const SM4_KEY *key);
+void ossl_hwsm4_cbc_encrypt(const unsigned char *in, unsigned char *out,
+                            size_t len, const SM4_KEY *key,
+                            unsigned char ivec[16], const int enc);
+void ossl_hwsm4_ecb_encrypt(const unsigned char *in, unsigned char *out,
+                            size_t len, const SM4_KEY *key, const int enc);
+void ossl_hwsm4_ctr32_encrypt_blocks(const unsigned char *in,
+                                     unsigned char *out, size_t blocks,
+                                     const SM4_KEY *key,
+                                     const unsigned char ivec[16]);
+# endif /* HWSM4_ASM */
+
+# if defined(OPENSSL_CPUID_OBJ)
+#  if defined(__aarch64__)
+#   include "arm_arch.h"
+#   ifdef VPSM4_ASM
+#    define VPSM4_CAPABLE (OPENSSL_armcap_P & ARMV7_NEON)
+#   endif
+#   ifdef HWSM4_ASM
+#    define HWSM4_CAPABLE (OPENSSL_armcap_P & ARMV8_SM4)
+#    define HWSM4_set_encrypt_key ossl_hwsm4_set_encrypt_key
+#    define HWSM4_set_decrypt_key ossl_hwsm4_set_decrypt_key
+#    define HWSM4_encrypt ossl_hwsm4_encrypt
+#    define HWSM4_decrypt ossl_hwsm4_decrypt
+#    define HWSM4_cbc_encrypt ossl_hwsm4_cbc_encrypt
+#    define HWSM4_ecb_encrypt ossl_hwsm4_ecb_encrypt
+#    define HWSM4_ctr32_encrypt_blocks ossl_hwsm4_ctr32_encrypt_blocks
+#   endif
+#  elif defined(__x86_64) || defined(__x86_64__) \
+        || defined(_M_AMD64) || defined(_M_X64)
+#   ifdef VPSM4_ASM
+int ossl_vpsm4_eligible(void);
+#    define VPSM4_CAPABLE ossl_vpsm4_eligible()
+#   endif
+#  endif
+# endif /* OPENSSL_CPUID_OBJ */
+
+#endif /* OSSL_SM4_PLATFORM_H */
@@ -36,4 +36,7 @@ int ossl_sm3_init(SM3_CTX *c);
 int ossl_sm3_update(SM3_CTX *c, const void *data, size_t len);
 int ossl_sm3_final(unsigned char *md, SM3_CTX *c);
 
+void ossl_sm3_digest_batch(size_t num, const unsigned char *const in[],
+                           const size_t inlen[], unsigned char *const out[]);
+
 #endif /* OSSL_INTERNAL_SM3_H */
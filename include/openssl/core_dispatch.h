@@ -701,6 +701,7 @@ OSSL_CORE_MAKE_FUNC(const OSSL_PARAM *, keyexch_gettable_ctx_params,
 # define OSSL_FUNC_SIGNATURE_GETTABLE_CTX_MD_PARAMS 23
 # define OSSL_FUNC_SIGNATURE_SET_CTX_MD_PARAMS      24
 # define OSSL_FUNC_SIGNATURE_SETTABLE_CTX_MD_PARAMS 25
+# define OSSL_FUNC_SIGNATURE_VERIFY_BATCH           26
 
 OSSL_CORE_MAKE_FUNC(void *, signature_newctx, (void *provctx,
                                                   const char *propq))
@@ -761,6 +762,11 @@ OSSL_CORE_MAKE_FUNC(int, signature_set_ctx_md_params,
                     (void *ctx, const OSSL_PARAM params[]))
 OSSL_CORE_MAKE_FUNC(const OSSL_PARAM *, signature_settable_ctx_md_params,
                     (void *ctx))
+OSSL_CORE_MAKE_FUNC(int, signature_verify_batch,
+                    (void *ctx, size_t num, void *const provkeys[],
+                     const unsigned char *const sigs[], const size_t siglens[],
+                     const unsigned char *const tbs[], const size_t tbslens[],
+                     unsigned char *results))
 
 
 /* Asymmetric Ciphers */
@@ -776,6 +782,8 @@ OSSL_CORE_MAKE_FUNC(const OSSL_PARAM *, signature_settable_ctx_md_params,
 # define OSSL_FUNC_ASYM_CIPHER_GETTABLE_CTX_PARAMS     9
 # define OSSL_FUNC_ASYM_CIPHER_SET_CTX_PARAMS         10
 # define OSSL_FUNC_ASYM_CIPHER_SETTABLE_CTX_PARAMS    11
+# define OSSL_FUNC_ASYM_CIPHER_STREAM_UPDATE          12
+# define OSSL_FUNC_ASYM_CIPHER_STREAM_FINAL           13
 
 OSSL_CORE_MAKE_FUNC(void *, asym_cipher_newctx, (void *provctx))
 OSSL_CORE_MAKE_FUNC(int, asym_cipher_encrypt_init, (void *ctx, void *provkey,
@@ -802,6 +810,12 @@ OSSL_CORE_MAKE_FUNC(int, asym_cipher_set_ctx_params,
                     (void *ctx, const OSSL_PARAM params[]))
 OSSL_CORE_MAKE_FUNC(const OSSL_PARAM *, asym_cipher_settable_ctx_params,
                     (void *ctx, void *provctx))
+OSSL_CORE_MAKE_FUNC(int, asym_cipher_stream_update,
+                    (void *ctx, unsigned char *out, const unsigned char *in,
+                     size_t inlen))
+OSSL_CORE_MAKE_FUNC(int, asym_cipher_stream_final,
+                    (void *ctx, unsigned char *out, size_t *outlen,
+                     size_t outsize))
 
 /* Asymmetric Key encapsulation */
 # define OSSL_FUNC_KEM_NEWCTX                  1
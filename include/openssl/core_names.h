@@ -95,6 +95,7 @@ extern "C" {
 #define OSSL_CIPHER_PARAM_RC2_KEYBITS          "keybits"      /* size_t */
 #define OSSL_CIPHER_PARAM_SPEED                "speed"        /* uint */
 #define OSSL_CIPHER_PARAM_CTS_MODE             "cts_mode"     /* utf8_string */
+#define OSSL_CIPHER_PARAM_XTS_STANDARD         "xts_standard" /* utf8_string */
 /* For passing the AlgorithmIdentifier parameter in DER form */
 #define OSSL_CIPHER_PARAM_ALGORITHM_ID_PARAMS  "alg_id_param" /* octet_string */
 
@@ -120,6 +121,10 @@ extern "C" {
 #define OSSL_CIPHER_CTS_MODE_CS2 "CS2"
 #define OSSL_CIPHER_CTS_MODE_CS3 "CS3"
 
+/* OSSL_CIPHER_PARAM_XTS_STANDARD Values */
+#define OSSL_CIPHER_XTS_STANDARD_GB "GB"
+#define OSSL_CIPHER_XTS_STANDARD_IEEE "IEEE"
+
 /* digest parameters */
 #define OSSL_DIGEST_PARAM_XOFLEN       "xoflen"        /* size_t */
 #define OSSL_DIGEST_PARAM_SSL3_MS      "ssl3-ms"       /* octet string */
@@ -436,6 +441,14 @@ extern "C" {
 #define OSSL_EXCHANGE_PARAM_KDF_OUTLEN            "kdf-outlen" /* size_t */
 /* The following parameter is an octet_string on set and an octet_ptr on get */
 #define OSSL_EXCHANGE_PARAM_KDF_UKM               "kdf-ukm"
+#define OSSL_EXCHANGE_PARAM_SM2_INITIATOR         "sm2-initiator" /* int */
+#define OSSL_EXCHANGE_PARAM_SM2_DIST_ID           OSSL_PKEY_PARAM_DIST_ID
+#define OSSL_EXCHANGE_PARAM_SM2_PEER_DIST_ID      "peer-distid" /* octet_string */
+#define OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PRIV    "sm2-ephemeral-priv" /* BN */
+#define OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PUB     "sm2-ephemeral-pub" /* octet_string */
+#define OSSL_EXCHANGE_PARAM_SM2_PEER_EPHEMERAL_PUB "sm2-peer-ephemeral-pub" /* octet_string */
+#define OSSL_EXCHANGE_PARAM_SM2_CONFIRM           "sm2-confirm" /* octet_string */
+#define OSSL_EXCHANGE_PARAM_SM2_PEER_CONFIRM      "sm2-peer-confirm" /* octet_string */
 
 /* Signature parameters */
 #define OSSL_SIGNATURE_PARAM_ALGORITHM_ID       "algorithm-id"
@@ -463,6 +476,8 @@ extern "C" {
 #define OSSL_ASYM_CIPHER_PARAM_OAEP_LABEL               "oaep-label"
 #define OSSL_ASYM_CIPHER_PARAM_TLS_CLIENT_VERSION       "tls-client-version"
 #define OSSL_ASYM_CIPHER_PARAM_TLS_NEGOTIATED_VERSION   "tls-negotiated-version"
+#define OSSL_ASYM_CIPHER_PARAM_SM2_C1                   "sm2-c1" /* octet_string */
+#define OSSL_ASYM_CIPHER_PARAM_SM2_C3                   "sm2-c3" /* octet_string */
 
 /*
  * Encoder / decoder parameters
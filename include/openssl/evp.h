@@ -714,6 +714,9 @@ __owur int EVP_DigestFinal_ex(EVP_MD_CTX *ctx, unsigned char *md,
 __owur int EVP_Digest(const void *data, size_t count,
                           unsigned char *md, unsigned int *size,
                           const EVP_MD *type, ENGINE *impl);
+__owur int EVP_Digest_batch(size_t num, const void *const data[],
+                            const size_t counts[], unsigned char *const mds[],
+                            const EVP_MD *type);
 __owur int EVP_Q_digest(OSSL_LIB_CTX *libctx, const char *name,
                         const char *propq, const void *data, size_t datalen,
                         unsigned char *md, size_t *mdlen);
@@ -1896,6 +1899,11 @@ int EVP_PKEY_verify_init_ex(EVP_PKEY_CTX *ctx, const OSSL_PARAM params[]);
 int EVP_PKEY_verify(EVP_PKEY_CTX *ctx,
                     const unsigned char *sig, size_t siglen,
                     const unsigned char *tbs, size_t tbslen);
+int EVP_PKEY_verify_batch(size_t num, EVP_PKEY *const pkeys[],
+                          const unsigned char *const sigs[],
+                          const size_t siglens[],
+                          const unsigned char *const tbs[],
+                          const size_t tbslens[], unsigned char *results);
 int EVP_PKEY_verify_recover_init(EVP_PKEY_CTX *ctx);
 int EVP_PKEY_verify_recover_init_ex(EVP_PKEY_CTX *ctx,
                                     const OSSL_PARAM params[]);
@@ -1913,6 +1921,25 @@ int EVP_PKEY_decrypt(EVP_PKEY_CTX *ctx,
                      unsigned char *out, size_t *outlen,
                      const unsigned char *in, size_t inlen);
 
+# ifndef OPENSSL_NO_SM2
+EVP_SM2_STREAM_CTX *EVP_SM2_STREAM_CTX_new(void);
+void EVP_SM2_STREAM_CTX_free(EVP_SM2_STREAM_CTX *ctx);
+int EVP_SM2_STREAM_encrypt_init(EVP_SM2_STREAM_CTX *ctx, OSSL_LIB_CTX *libctx,
+                                EVP_PKEY *pkey, const char *propq,
+                                const EVP_MD *md,
+                                unsigned char *c1, size_t *c1len);
+int EVP_SM2_STREAM_decrypt_init(EVP_SM2_STREAM_CTX *ctx, OSSL_LIB_CTX *libctx,
+                                EVP_PKEY *pkey, const char *propq,
+                                const EVP_MD *md,
+                                const unsigned char *c1, size_t c1len,
+                                const unsigned char *c3, size_t c3len);
+int EVP_SM2_STREAM_update(EVP_SM2_STREAM_CTX *ctx, unsigned char *out,
+                          const unsigned char *in, size_t inlen);
+int EVP_SM2_STREAM_encrypt_final(EVP_SM2_STREAM_CTX *ctx,
+                                 unsigned char *c3, size_t *c3len);
+int EVP_SM2_STREAM_decrypt_final(EVP_SM2_STREAM_CTX *ctx);
+# endif
+
 int EVP_PKEY_derive_init(EVP_PKEY_CTX *ctx);
 int EVP_PKEY_derive_init_ex(EVP_PKEY_CTX *ctx, const OSSL_PARAM params[]);
 int EVP_PKEY_derive_set_peer_ex(EVP_PKEY_CTX *ctx, EVP_PKEY *peer,
@@ -129,6 +129,8 @@ typedef struct evp_kem_st EVP_KEM;
 
 typedef struct evp_Encode_Ctx_st EVP_ENCODE_CTX;
 
+typedef struct evp_sm2_stream_ctx_st EVP_SM2_STREAM_CTX;
+
 typedef struct hmac_ctx_st HMAC_CTX;
 
 typedef struct dh_st DH;
@@ -22,10 +22,12 @@
 #include "prov/provider_util.h"
 
 static OSSL_FUNC_asym_cipher_newctx_fn sm2_newctx;
-static OSSL_FUNC_asym_cipher_encrypt_init_fn sm2_init;
+static OSSL_FUNC_asym_cipher_encrypt_init_fn sm2_encrypt_init;
 static OSSL_FUNC_asym_cipher_encrypt_fn sm2_asym_encrypt;
-static OSSL_FUNC_asym_cipher_decrypt_init_fn sm2_init;
+static OSSL_FUNC_asym_cipher_decrypt_init_fn sm2_decrypt_init;
 static OSSL_FUNC_asym_cipher_decrypt_fn sm2_asym_decrypt;
+static OSSL_FUNC_asym_cipher_stream_update_fn sm2_stream_update;
+static OSSL_FUNC_asym_cipher_stream_final_fn sm2_stream_final;
 static OSSL_FUNC_asym_cipher_freectx_fn sm2_freectx;
 static OSSL_FUNC_asym_cipher_dupctx_fn sm2_dupctx;
 static OSSL_FUNC_asym_cipher_get_ctx_params_fn sm2_get_ctx_params;
@@ -43,6 +45,17 @@ typedef struct {
     OSSL_LIB_CTX *libctx;
     EC_KEY *key;
     PROV_DIGEST md;
+    int enc;
+
+    /*
+     * Streaming state. C1 is produced when an encryption starts, or set
+     * together with C3 by the caller before a decryption starts.
+     */
+    SM2_STREAM *stream;
+    unsigned char c1[SM2_STREAM_MAX_C1];
+    size_t c1len;
+    unsigned char c3[EVP_MAX_MD_SIZE];
+    size_t c3len;
 } PROV_SM2_CTX;
 
 static void *sm2_newctx(void *provctx)
@@ -56,7 +69,8 @@ static void *sm2_newctx(void *provctx)
     return psm2ctx;
 }
 
-static int sm2_init(void *vpsm2ctx, void *vkey, const OSSL_PARAM params[])
+static int sm2_init(void *vpsm2ctx, void *vkey, const OSSL_PARAM params[],
+                    int enc)
 {
     PROV_SM2_CTX *psm2ctx = (PROV_SM2_CTX *)vpsm2ctx;
 
@@ -64,10 +78,26 @@ static int sm2_init(void *vpsm2ctx, void *vkey, const OSSL_PARAM params[])
         return 0;
     EC_KEY_free(psm2ctx->key);
     psm2ctx->key = vkey;
+    psm2ctx->enc = enc;
+    ossl_sm2_stream_free(psm2ctx->stream);
+    psm2ctx->stream = NULL;
+    psm2ctx->c1len = psm2ctx->c3len = 0;
 
     return sm2_set_ctx_params(psm2ctx, params);
 }
 
+static int sm2_encrypt_init(void *vpsm2ctx, void *vkey,
+                            const OSSL_PARAM params[])
+{
+    return sm2_init(vpsm2ctx, vkey, params, 1);
+}
+
+static int sm2_decrypt_init(void *vpsm2ctx, void *vkey,
+                            const OSSL_PARAM params[])
+{
+    return sm2_init(vpsm2ctx, vkey, params, 0);
+}
+
 static const EVP_MD *sm2_get_md(PROV_SM2_CTX *psm2ctx)
 {
     const EVP_MD *md = ossl_prov_digest_md(&psm2ctx->md);
@@ -118,12 +148,92 @@ static int sm2_asym_decrypt(void *vpsm2ctx, unsigned char *out, size_t *outlen,
     return ossl_sm2_decrypt(psm2ctx->key, md, in, inlen, out, outlen);
 }
 
+static int sm2_stream_alloc(PROV_SM2_CTX *psm2ctx)
+{
+    if (psm2ctx->stream == NULL
+            && (psm2ctx->stream = ossl_sm2_stream_new()) == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Starts a streaming operation. An encryption generates C1, which the caller
+ * gets before any update, a decryption needs C1 and C3 to have been set.
+ */
+static int sm2_stream_start(PROV_SM2_CTX *psm2ctx)
+{
+    const EVP_MD *md = sm2_get_md(psm2ctx);
+
+    if (md == NULL || psm2ctx->key == NULL || !sm2_stream_alloc(psm2ctx))
+        return 0;
+
+    if (psm2ctx->enc) {
+        psm2ctx->c1len = sizeof(psm2ctx->c1);
+        return ossl_sm2_stream_encrypt_init(psm2ctx->stream, psm2ctx->key, md,
+                                            psm2ctx->c1, &psm2ctx->c1len);
+    }
+
+    if (psm2ctx->c1len == 0 || psm2ctx->c3len == 0) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_SET);
+        return 0;
+    }
+    return ossl_sm2_stream_decrypt_init(psm2ctx->stream, psm2ctx->key, md,
+                                        psm2ctx->c1, psm2ctx->c1len,
+                                        psm2ctx->c3, psm2ctx->c3len);
+}
+
+static int sm2_stream_running(PROV_SM2_CTX *psm2ctx)
+{
+    if (psm2ctx->stream == NULL || !ossl_sm2_stream_active(psm2ctx->stream)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_SET);
+        return 0;
+    }
+    return 1;
+}
+
+static int sm2_stream_update(void *vpsm2ctx, unsigned char *out,
+                             const unsigned char *in, size_t inlen)
+{
+    PROV_SM2_CTX *psm2ctx = (PROV_SM2_CTX *)vpsm2ctx;
+
+    if (!sm2_stream_running(psm2ctx))
+        return 0;
+
+    return ossl_sm2_stream_update(psm2ctx->stream, out, in, inlen);
+}
+
+/*
+ * Finishes a streaming operation. An encryption outputs C3, a decryption
+ * outputs nothing and fails if the C3 it was given does not match.
+ */
+static int sm2_stream_final(void *vpsm2ctx, unsigned char *out,
+                            size_t *outlen, size_t outsize)
+{
+    PROV_SM2_CTX *psm2ctx = (PROV_SM2_CTX *)vpsm2ctx;
+
+    if (!sm2_stream_running(psm2ctx))
+        return 0;
+
+    if (!psm2ctx->enc) {
+        *outlen = 0;
+        return ossl_sm2_stream_decrypt_final(psm2ctx->stream);
+    }
+
+    if (out == NULL)
+        return ossl_sm2_stream_encrypt_final(psm2ctx->stream, NULL, outlen);
+    *outlen = outsize;
+    return ossl_sm2_stream_encrypt_final(psm2ctx->stream, out, outlen);
+}
+
 static void sm2_freectx(void *vpsm2ctx)
 {
     PROV_SM2_CTX *psm2ctx = (PROV_SM2_CTX *)vpsm2ctx;
 
     EC_KEY_free(psm2ctx->key);
     ossl_prov_digest_reset(&psm2ctx->md);
+    ossl_sm2_stream_free(psm2ctx->stream);
 
     OPENSSL_free(psm2ctx);
 }
@@ -133,11 +243,18 @@ static void *sm2_dupctx(void *vpsm2ctx)
     PROV_SM2_CTX *srcctx = (PROV_SM2_CTX *)vpsm2ctx;
     PROV_SM2_CTX *dstctx;
 
+    /* The state of a running stream is not duplicated */
+    if (srcctx->stream != NULL && ossl_sm2_stream_active(srcctx->stream)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NOT_SUPPORTED);
+        return NULL;
+    }
+
     dstctx = OPENSSL_zalloc(sizeof(*srcctx));
     if (dstctx == NULL)
         return NULL;
 
     *dstctx = *srcctx;
+    dstctx->stream = NULL;
     if (dstctx->key != NULL && !EC_KEY_up_ref(dstctx->key)) {
         OPENSSL_free(dstctx);
         return NULL;
@@ -168,11 +285,45 @@ static int sm2_get_ctx_params(void *vpsm2ctx, OSSL_PARAM *params)
             return 0;
     }
 
+    /*
+     * Getting C1 starts a streaming encryption, unless only its size is
+     * asked for.
+     */
+    p = OSSL_PARAM_locate(params, OSSL_ASYM_CIPHER_PARAM_SM2_C1);
+    if (p != NULL) {
+        if (!psm2ctx->enc) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_NOT_SUPPORTED);
+            return 0;
+        }
+        if (psm2ctx->stream == NULL
+                || !ossl_sm2_stream_active(psm2ctx->stream)) {
+            if (p->data != NULL) {
+                if (!sm2_stream_start(psm2ctx))
+                    return 0;
+            } else {
+                const EVP_MD *md = sm2_get_md(psm2ctx);
+
+                if (md == NULL || psm2ctx->key == NULL
+                        || !sm2_stream_alloc(psm2ctx)
+                        || !ossl_sm2_stream_encrypt_init(psm2ctx->stream,
+                                                         psm2ctx->key, md,
+                                                         NULL,
+                                                         &psm2ctx->c1len))
+                    return 0;
+            }
+        }
+        if (!OSSL_PARAM_set_octet_string(p, psm2ctx->c1, psm2ctx->c1len)) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_OUTPUT_BUFFER_TOO_SMALL);
+            return 0;
+        }
+    }
+
     return 1;
 }
 
 static const OSSL_PARAM known_gettable_ctx_params[] = {
     OSSL_PARAM_utf8_string(OSSL_ASYM_CIPHER_PARAM_DIGEST, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_ASYM_CIPHER_PARAM_SM2_C1, NULL, 0),
     OSSL_PARAM_END
 };
 
@@ -185,6 +336,8 @@ static const OSSL_PARAM *sm2_gettable_ctx_params(ossl_unused void *vpsm2ctx,
 static int sm2_set_ctx_params(void *vpsm2ctx, const OSSL_PARAM params[])
 {
     PROV_SM2_CTX *psm2ctx = (PROV_SM2_CTX *)vpsm2ctx;
+    const OSSL_PARAM *p1, *p3;
+    void *vp;
 
     if (psm2ctx == NULL)
         return 0;
@@ -195,6 +348,35 @@ static int sm2_set_ctx_params(void *vpsm2ctx, const OSSL_PARAM params[])
                                            psm2ctx->libctx))
         return 0;
 
+    /* C1 and C3 are inputs to a streaming decryption only */
+    p1 = OSSL_PARAM_locate_const(params, OSSL_ASYM_CIPHER_PARAM_SM2_C1);
+    p3 = OSSL_PARAM_locate_const(params, OSSL_ASYM_CIPHER_PARAM_SM2_C3);
+    if (p1 == NULL && p3 == NULL)
+        return 1;
+    if (psm2ctx->enc) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NOT_SUPPORTED);
+        return 0;
+    }
+    if (p1 != NULL) {
+        vp = psm2ctx->c1;
+        if (!OSSL_PARAM_get_octet_string(p1, &vp, sizeof(psm2ctx->c1),
+                                         &psm2ctx->c1len)) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_DATA);
+            return 0;
+        }
+    }
+    if (p3 != NULL) {
+        vp = psm2ctx->c3;
+        if (!OSSL_PARAM_get_octet_string(p3, &vp, sizeof(psm2ctx->c3),
+                                         &psm2ctx->c3len)) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+            return 0;
+        }
+    }
+
+    /* Start as soon as both are known so that bad values fail early */
+    if (psm2ctx->c1len != 0 && psm2ctx->c3len != 0)
+        return sm2_stream_start(psm2ctx);
     return 1;
 }
 
@@ -202,6 +384,8 @@ static const OSSL_PARAM known_settable_ctx_params[] = {
     OSSL_PARAM_utf8_string(OSSL_ASYM_CIPHER_PARAM_DIGEST, NULL, 0),
     OSSL_PARAM_utf8_string(OSSL_ASYM_CIPHER_PARAM_PROPERTIES, NULL, 0),
     OSSL_PARAM_utf8_string(OSSL_ASYM_CIPHER_PARAM_ENGINE, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_ASYM_CIPHER_PARAM_SM2_C1, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_ASYM_CIPHER_PARAM_SM2_C3, NULL, 0),
     OSSL_PARAM_END
 };
 
@@ -213,10 +397,12 @@ static const OSSL_PARAM *sm2_settable_ctx_params(ossl_unused void *vpsm2ctx,
 
 const OSSL_DISPATCH ossl_sm2_asym_cipher_functions[] = {
     { OSSL_FUNC_ASYM_CIPHER_NEWCTX, (void (*)(void))sm2_newctx },
-    { OSSL_FUNC_ASYM_CIPHER_ENCRYPT_INIT, (void (*)(void))sm2_init },
+    { OSSL_FUNC_ASYM_CIPHER_ENCRYPT_INIT, (void (*)(void))sm2_encrypt_init },
     { OSSL_FUNC_ASYM_CIPHER_ENCRYPT, (void (*)(void))sm2_asym_encrypt },
-    { OSSL_FUNC_ASYM_CIPHER_DECRYPT_INIT, (void (*)(void))sm2_init },
+    { OSSL_FUNC_ASYM_CIPHER_DECRYPT_INIT, (void (*)(void))sm2_decrypt_init },
     { OSSL_FUNC_ASYM_CIPHER_DECRYPT, (void (*)(void))sm2_asym_decrypt },
+    { OSSL_FUNC_ASYM_CIPHER_STREAM_UPDATE, (void (*)(void))sm2_stream_update },
+    { OSSL_FUNC_ASYM_CIPHER_STREAM_FINAL, (void (*)(void))sm2_stream_final },
     { OSSL_FUNC_ASYM_CIPHER_FREECTX, (void (*)(void))sm2_freectx },
     { OSSL_FUNC_ASYM_CIPHER_DUPCTX, (void (*)(void))sm2_dupctx },
     { OSSL_FUNC_ASYM_CIPHER_GET_CTX_PARAMS,
@@ -8,6 +8,7 @@
  */
 
 #include "cipher_sm4.h"
+#include "crypto/sm4_platform.h"
 
 static int cipher_hw_sm4_initkey(PROV_CIPHER_CTX *ctx,
                                  const unsigned char *key, size_t keylen)
@@ -15,14 +16,55 @@ static int cipher_hw_sm4_initkey(PROV_CIPHER_CTX *ctx,
     PROV_SM4_CTX *sctx =  (PROV_SM4_CTX *)ctx;
     SM4_KEY *ks = &sctx->ks.ks;
 
-    ossl_sm4_set_key(key, ks);
     ctx->ks = ks;
+    ctx->stream.cbc = NULL;
+#ifdef HWSM4_CAPABLE
+    if (HWSM4_CAPABLE) {
+        if (ctx->enc
+                || (ctx->mode != EVP_CIPH_ECB_MODE
+                    && ctx->mode != EVP_CIPH_CBC_MODE)) {
+            HWSM4_set_encrypt_key(key, ks);
+            ctx->block = (block128_f)HWSM4_encrypt;
+        } else {
+            HWSM4_set_decrypt_key(key, ks);
+            ctx->block = (block128_f)HWSM4_decrypt;
+        }
+        if (ctx->mode == EVP_CIPH_CBC_MODE)
+            ctx->stream.cbc = (cbc128_f)HWSM4_cbc_encrypt;
+        else if (ctx->mode == EVP_CIPH_ECB_MODE)
+            ctx->stream.ecb = (ecb128_f)HWSM4_ecb_encrypt;
+        else if (ctx->mode == EVP_CIPH_CTR_MODE)
+            ctx->stream.ctr = (ctr128_f)HWSM4_ctr32_encrypt_blocks;
+        return 1;
+    }
+#endif
+
+    ossl_sm4_set_key(key, ks);
     if (ctx->enc
             || (ctx->mode != EVP_CIPH_ECB_MODE
                 && ctx->mode != EVP_CIPH_CBC_MODE))
         ctx->block = (block128_f)ossl_sm4_encrypt;
     else
         ctx->block = (block128_f)ossl_sm4_decrypt;
+
+    /*
+     * ECB and CTR can work on many blocks at once, which the SIMD code
+     * and, failing that, the bitsliced one are much faster at.
+     */
+#ifdef VPSM4_CAPABLE
+    if (VPSM4_CAPABLE) {
+        if (ctx->mode == EVP_CIPH_ECB_MODE)
+            ctx->stream.ecb = (ecb128_f)ossl_vpsm4_ecb_encrypt;
+        else if (ctx->mode == EVP_CIPH_CTR_MODE)
+            ctx->stream.ctr = (ctr128_f)ossl_vpsm4_ctr32_encrypt_blocks;
+    } else
+#endif
+    {
+        if (ctx->mode == EVP_CIPH_ECB_MODE)
+            ctx->stream.ecb = (ecb128_f)ossl_sm4_bs_ecb_encrypt;
+        else if (ctx->mode == EVP_CIPH_CTR_MODE)
+            ctx->stream.ctr = (ctr128_f)ossl_sm4_bs_ctr32_encrypt_blocks;
+    }
     return 1;
 }
 
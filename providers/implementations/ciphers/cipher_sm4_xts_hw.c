@@ -0,0 +1,75 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "cipher_sm4_xts.h"
+#include "crypto/sm4_platform.h"
+
+/*
+ * Whole blocks go through ctx->stream.ecb in batches, see
+ * ossl_crypto_xts128_encrypt_blocks(); the single block functions are only
+ * used for the tweak and for ciphertext stealing.
+ */
+static int cipher_hw_sm4_xts_initkey(PROV_CIPHER_CTX *ctx,
+                                     const unsigned char *key, size_t keylen)
+{
+    PROV_SM4_XTS_CTX *xctx = (PROV_SM4_XTS_CTX *)ctx;
+    size_t bytes = keylen / 2;
+
+    xctx->xts.key1 = &xctx->ks1.ks;
+    xctx->xts.key2 = &xctx->ks2.ks;
+#ifdef HWSM4_CAPABLE
+    if (HWSM4_CAPABLE) {
+        if (ctx->enc) {
+            HWSM4_set_encrypt_key(key, &xctx->ks1.ks);
+            xctx->xts.block1 = (block128_f)HWSM4_encrypt;
+        } else {
+            HWSM4_set_decrypt_key(key, &xctx->ks1.ks);
+            xctx->xts.block1 = (block128_f)HWSM4_decrypt;
+        }
+        HWSM4_set_encrypt_key(key + bytes, &xctx->ks2.ks);
+        xctx->xts.block2 = (block128_f)HWSM4_encrypt;
+        ctx->stream.ecb = (ecb128_f)HWSM4_ecb_encrypt;
+        return 1;
+    }
+#endif
+
+    ossl_sm4_set_key(key, &xctx->ks1.ks);
+    xctx->xts.block1 = ctx->enc ? (block128_f)ossl_sm4_encrypt
+                                : (block128_f)ossl_sm4_decrypt;
+    ossl_sm4_set_key(key + bytes, &xctx->ks2.ks);
+    xctx->xts.block2 = (block128_f)ossl_sm4_encrypt;
+#ifdef VPSM4_CAPABLE
+    if (VPSM4_CAPABLE)
+        ctx->stream.ecb = (ecb128_f)ossl_vpsm4_ecb_encrypt;
+    else
+#endif
+        ctx->stream.ecb = (ecb128_f)ossl_sm4_bs_ecb_encrypt;
+    return 1;
+}
+
+static void cipher_hw_sm4_xts_copyctx(PROV_CIPHER_CTX *dst,
+                                      const PROV_CIPHER_CTX *src)
+{
+    PROV_SM4_XTS_CTX *sctx = (PROV_SM4_XTS_CTX *)src;
+    PROV_SM4_XTS_CTX *dctx = (PROV_SM4_XTS_CTX *)dst;
+
+    *dctx = *sctx;
+    dctx->xts.key1 = &dctx->ks1.ks;
+    dctx->xts.key2 = &dctx->ks2.ks;
+}
+
+static const PROV_CIPHER_HW sm4_generic_xts = {
+    cipher_hw_sm4_xts_initkey,
+    NULL,
+    cipher_hw_sm4_xts_copyctx
+};
+const PROV_CIPHER_HW *ossl_prov_cipher_hw_sm4_xts(size_t keybits)
+{
+    return &sm4_generic_xts;
+}
@@ -0,0 +1,599 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * EC_KEY low level APIs are deprecated for public use, but still ok for
+ * internal use.
+ */
+#include "internal/deprecated.h"
+
+#include <string.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/ec.h>
+#include <openssl/params.h>
+#include <openssl/err.h>
+#include <openssl/proverr.h>
+#include "prov/provider_ctx.h"
+#include "prov/providercommon.h"
+#include "prov/implementations.h"
+#include "crypto/ec.h"
+#include "crypto/sm2.h"
+
+static OSSL_FUNC_keyexch_newctx_fn sm2_exch_newctx;
+static OSSL_FUNC_keyexch_init_fn sm2_exch_init;
+static OSSL_FUNC_keyexch_set_peer_fn sm2_exch_set_peer;
+static OSSL_FUNC_keyexch_derive_fn sm2_exch_derive;
+static OSSL_FUNC_keyexch_freectx_fn sm2_exch_freectx;
+static OSSL_FUNC_keyexch_dupctx_fn sm2_exch_dupctx;
+static OSSL_FUNC_keyexch_set_ctx_params_fn sm2_exch_set_ctx_params;
+static OSSL_FUNC_keyexch_settable_ctx_params_fn sm2_exch_settable_ctx_params;
+static OSSL_FUNC_keyexch_get_ctx_params_fn sm2_exch_get_ctx_params;
+static OSSL_FUNC_keyexch_gettable_ctx_params_fn sm2_exch_gettable_ctx_params;
+
+/* klen when the caller doesn't ask for anything else: one SM4 key */
+#define SM2_EXCH_DEFAULT_OUTLEN 16
+
+/*
+ * What's passed as an actual key is defined by the KEYMGMT interface.
+ * We happen to know that our KEYMGMT simply passes EC_KEY structures, so
+ * we use that here too.
+ */
+
+typedef struct {
+    OSSL_LIB_CTX *libctx;
+
+    /* Our own and the peer's static keys */
+    EC_KEY *k;
+    EC_KEY *peerk;
+    /* Our own ephemeral key pair and the peer's ephemeral public key */
+    EC_KEY *eph;
+    EC_KEY *peereph;
+
+    /* 1 for the initiator (user A), 0 for the responder (user B) */
+    int initiator;
+    /* The distinguishing IDs that go into ZA and ZB */
+    unsigned char *id;
+    size_t id_len;
+    unsigned char *peer_id;
+    size_t peer_id_len;
+
+    /* The hash for Z, the KDF and the confirmation values, SM3 by default */
+    EVP_MD *md;
+    /* klen, the length of the derived key */
+    size_t outlen;
+
+    /* Filled in by derive: the value to send and the one the peer sends */
+    unsigned char confirm[EVP_MAX_MD_SIZE];
+    unsigned char peer_confirm[EVP_MAX_MD_SIZE];
+    size_t confirm_len;
+} PROV_SM2_EXCH_CTX;
+
+static void *sm2_exch_newctx(void *provctx)
+{
+    PROV_SM2_EXCH_CTX *psm2ctx;
+
+    if (!ossl_prov_is_running())
+        return NULL;
+
+    psm2ctx = OPENSSL_zalloc(sizeof(*psm2ctx));
+    if (psm2ctx == NULL)
+        return NULL;
+
+    psm2ctx->libctx = PROV_LIBCTX_OF(provctx);
+    psm2ctx->initiator = 1;
+    psm2ctx->outlen = SM2_EXCH_DEFAULT_OUTLEN;
+
+    return psm2ctx;
+}
+
+static int sm2_exch_init(void *vpsm2ctx, void *vkey, const OSSL_PARAM params[])
+{
+    PROV_SM2_EXCH_CTX *psm2ctx = (PROV_SM2_EXCH_CTX *)vpsm2ctx;
+
+    if (!ossl_prov_is_running()
+            || psm2ctx == NULL
+            || vkey == NULL
+            || !EC_KEY_up_ref(vkey))
+        return 0;
+    EC_KEY_free(psm2ctx->k);
+    psm2ctx->k = vkey;
+
+    /* A new exchange needs new ephemeral keys on both sides */
+    EC_KEY_free(psm2ctx->eph);
+    psm2ctx->eph = NULL;
+    EC_KEY_free(psm2ctx->peereph);
+    psm2ctx->peereph = NULL;
+    OPENSSL_cleanse(psm2ctx->confirm, sizeof(psm2ctx->confirm));
+    OPENSSL_cleanse(psm2ctx->peer_confirm, sizeof(psm2ctx->peer_confirm));
+    psm2ctx->confirm_len = 0;
+
+    if (psm2ctx->md == NULL) {
+        psm2ctx->md = EVP_MD_fetch(psm2ctx->libctx, "SM3", NULL);
+        if (psm2ctx->md == NULL) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_DIGEST);
+            return 0;
+        }
+    }
+
+    return sm2_exch_set_ctx_params(psm2ctx, params);
+}
+
+static int sm2_exch_match_params(const EC_KEY *priv, const EC_KEY *peer)
+{
+    int ret;
+    BN_CTX *ctx = NULL;
+    const EC_GROUP *group_priv = EC_KEY_get0_group(priv);
+    const EC_GROUP *group_peer = EC_KEY_get0_group(peer);
+
+    ctx = BN_CTX_new_ex(ossl_ec_key_get_libctx(priv));
+    if (ctx == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    ret = group_priv != NULL
+          && group_peer != NULL
+          && EC_GROUP_cmp(group_priv, group_peer, ctx) == 0;
+    if (!ret)
+        ERR_raise(ERR_LIB_PROV, PROV_R_MISMATCHING_DOMAIN_PARAMETERS);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
+static int sm2_exch_set_peer(void *vpsm2ctx, void *vkey)
+{
+    PROV_SM2_EXCH_CTX *psm2ctx = (PROV_SM2_EXCH_CTX *)vpsm2ctx;
+
+    if (!ossl_prov_is_running()
+            || psm2ctx == NULL
+            || vkey == NULL
+            || !sm2_exch_match_params(psm2ctx->k, vkey)
+            || !EC_KEY_up_ref(vkey))
+        return 0;
+
+    EC_KEY_free(psm2ctx->peerk);
+    psm2ctx->peerk = vkey;
+    return 1;
+}
+
+static void sm2_exch_freectx(void *vpsm2ctx)
+{
+    PROV_SM2_EXCH_CTX *psm2ctx = (PROV_SM2_EXCH_CTX *)vpsm2ctx;
+
+    EC_KEY_free(psm2ctx->k);
+    EC_KEY_free(psm2ctx->peerk);
+    EC_KEY_free(psm2ctx->eph);
+    EC_KEY_free(psm2ctx->peereph);
+    OPENSSL_free(psm2ctx->id);
+    OPENSSL_free(psm2ctx->peer_id);
+    EVP_MD_free(psm2ctx->md);
+
+    OPENSSL_clear_free(psm2ctx, sizeof(*psm2ctx));
+}
+
+static void *sm2_exch_dupctx(void *vpsm2ctx)
+{
+    PROV_SM2_EXCH_CTX *srcctx = (PROV_SM2_EXCH_CTX *)vpsm2ctx;
+    PROV_SM2_EXCH_CTX *dstctx;
+
+    if (!ossl_prov_is_running())
+        return NULL;
+
+    dstctx = OPENSSL_zalloc(sizeof(*srcctx));
+    if (dstctx == NULL)
+        return NULL;
+
+    *dstctx = *srcctx;
+
+    /* clear all pointers */
+
+    dstctx->k = NULL;
+    dstctx->peerk = NULL;
+    dstctx->eph = NULL;
+    dstctx->peereph = NULL;
+    dstctx->id = NULL;
+    dstctx->peer_id = NULL;
+    dstctx->md = NULL;
+
+    /* up-ref all ref-counted objects referenced in dstctx */
+
+    if (srcctx->k != NULL && !EC_KEY_up_ref(srcctx->k))
+        goto err;
+    dstctx->k = srcctx->k;
+
+    if (srcctx->peerk != NULL && !EC_KEY_up_ref(srcctx->peerk))
+        goto err;
+    dstctx->peerk = srcctx->peerk;
+
+    if (srcctx->eph != NULL && !EC_KEY_up_ref(srcctx->eph))
+        goto err;
+    dstctx->eph = srcctx->eph;
+
+    if (srcctx->peereph != NULL && !EC_KEY_up_ref(srcctx->peereph))
+        goto err;
+    dstctx->peereph = srcctx->peereph;
+
+    if (srcctx->md != NULL && !EVP_MD_up_ref(srcctx->md))
+        goto err;
+    dstctx->md = srcctx->md;
+
+    if (srcctx->id != NULL) {
+        dstctx->id = OPENSSL_memdup(srcctx->id, srcctx->id_len);
+        if (dstctx->id == NULL)
+            goto err;
+    }
+    if (srcctx->peer_id != NULL) {
+        dstctx->peer_id = OPENSSL_memdup(srcctx->peer_id,
+                                         srcctx->peer_id_len);
+        if (dstctx->peer_id == NULL)
+            goto err;
+    }
+
+    return dstctx;
+
+ err:
+    sm2_exch_freectx(dstctx);
+    return NULL;
+}
+
+/* An empty EC_KEY on the curve of our own static key */
+static EC_KEY *sm2_exch_new_key(PROV_SM2_EXCH_CTX *psm2ctx)
+{
+    EC_KEY *key;
+
+    if (psm2ctx->k == NULL) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_MISSING_KEY);
+        return NULL;
+    }
+    key = EC_KEY_new_ex(psm2ctx->libctx, ossl_ec_key_get0_propq(psm2ctx->k));
+    if (key == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if (!EC_KEY_set_group(key, EC_KEY_get0_group(psm2ctx->k))) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_EC_LIB);
+        EC_KEY_free(key);
+        return NULL;
+    }
+    return key;
+}
+
+#if !defined(OPENSSL_NO_ACVP_TESTS)
+/* Sets our ephemeral key pair from a given r, for known answer tests */
+static int sm2_exch_set_ephemeral(PROV_SM2_EXCH_CTX *psm2ctx,
+                                  const BIGNUM *r)
+{
+    EC_KEY *eph;
+    EC_POINT *R = NULL;
+    const EC_GROUP *group;
+    int ret = 0;
+
+    if ((eph = sm2_exch_new_key(psm2ctx)) == NULL)
+        return 0;
+    group = EC_KEY_get0_group(eph);
+    if ((R = EC_POINT_new(group)) == NULL
+            || !EC_KEY_set_private_key(eph, r)
+            || !EC_POINT_mul(group, R, r, NULL, NULL, NULL)
+            || !EC_KEY_set_public_key(eph, R)
+            || !EC_KEY_check_key(eph)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_KEY);
+        goto err;
+    }
+
+    EC_KEY_free(psm2ctx->eph);
+    psm2ctx->eph = eph;
+    eph = NULL;
+    ret = 1;
+
+ err:
+    EC_POINT_free(R);
+    EC_KEY_free(eph);
+    return ret;
+}
+#endif
+
+/* Generates our ephemeral key pair unless there is one already */
+static int sm2_exch_get_ephemeral(PROV_SM2_EXCH_CTX *psm2ctx)
+{
+    EC_KEY *eph;
+
+    if (psm2ctx->eph != NULL)
+        return 1;
+    if ((eph = sm2_exch_new_key(psm2ctx)) == NULL)
+        return 0;
+    if (!EC_KEY_generate_key(eph)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GENERATE_KEY);
+        EC_KEY_free(eph);
+        return 0;
+    }
+    psm2ctx->eph = eph;
+    return 1;
+}
+
+static int sm2_exch_set_peer_ephemeral(PROV_SM2_EXCH_CTX *psm2ctx,
+                                       const unsigned char *buf, size_t len)
+{
+    EC_KEY *peereph;
+
+    if ((peereph = sm2_exch_new_key(psm2ctx)) == NULL)
+        return 0;
+    if (!EC_KEY_oct2key(peereph, buf, len, NULL)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_KEY);
+        EC_KEY_free(peereph);
+        return 0;
+    }
+    EC_KEY_free(psm2ctx->peereph);
+    psm2ctx->peereph = peereph;
+    return 1;
+}
+
+static int sm2_exch_set_ctx_params(void *vpsm2ctx, const OSSL_PARAM params[])
+{
+    char name[80] = { '\0' }; /* should be big enough */
+    char *str = NULL;
+    PROV_SM2_EXCH_CTX *psm2ctx = (PROV_SM2_EXCH_CTX *)vpsm2ctx;
+    const OSSL_PARAM *p;
+
+    if (psm2ctx == NULL)
+        return 0;
+    if (params == NULL)
+        return 1;
+
+    p = OSSL_PARAM_locate_const(params, OSSL_EXCHANGE_PARAM_SM2_INITIATOR);
+    if (p != NULL && !OSSL_PARAM_get_int(p, &psm2ctx->initiator))
+        return 0;
+
+    p = OSSL_PARAM_locate_const(params, OSSL_EXCHANGE_PARAM_SM2_DIST_ID);
+    if (p != NULL) {
+        void *tmp_id = NULL;
+        size_t tmp_idlen;
+
+        if (!OSSL_PARAM_get_octet_string(p, &tmp_id, 0, &tmp_idlen))
+            return 0;
+        OPENSSL_free(psm2ctx->id);
+        psm2ctx->id = tmp_id;
+        psm2ctx->id_len = tmp_idlen;
+    }
+
+    p = OSSL_PARAM_locate_const(params, OSSL_EXCHANGE_PARAM_SM2_PEER_DIST_ID);
+    if (p != NULL) {
+        void *tmp_id = NULL;
+        size_t tmp_idlen;
+
+        if (!OSSL_PARAM_get_octet_string(p, &tmp_id, 0, &tmp_idlen))
+            return 0;
+        OPENSSL_free(psm2ctx->peer_id);
+        psm2ctx->peer_id = tmp_id;
+        psm2ctx->peer_id_len = tmp_idlen;
+    }
+
+#if !defined(OPENSSL_NO_ACVP_TESTS)
+    p = OSSL_PARAM_locate_const(params, OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PRIV);
+    if (p != NULL) {
+        BIGNUM *r = NULL;
+        int ok;
+
+        if (!OSSL_PARAM_get_BN(p, &r))
+            return 0;
+        ok = sm2_exch_set_ephemeral(psm2ctx, r);
+        BN_clear_free(r);
+        if (!ok)
+            return 0;
+    }
+#endif
+
+    p = OSSL_PARAM_locate_const(params,
+                                OSSL_EXCHANGE_PARAM_SM2_PEER_EPHEMERAL_PUB);
+    if (p != NULL) {
+        const void *buf;
+        size_t len;
+
+        if (!OSSL_PARAM_get_octet_string_ptr(p, &buf, &len)
+                || !sm2_exch_set_peer_ephemeral(psm2ctx, buf, len))
+            return 0;
+    }
+
+    p = OSSL_PARAM_locate_const(params, OSSL_EXCHANGE_PARAM_KDF_DIGEST);
+    if (p != NULL) {
+        char mdprops[80] = { '\0' }; /* should be big enough */
+
+        str = name;
+        if (!OSSL_PARAM_get_utf8_string(p, &str, sizeof(name)))
+            return 0;
+
+        str = mdprops;
+        p = OSSL_PARAM_locate_const(params,
+                                    OSSL_EXCHANGE_PARAM_KDF_DIGEST_PROPS);
+
+        if (p != NULL) {
+            if (!OSSL_PARAM_get_utf8_string(p, &str, sizeof(mdprops)))
+                return 0;
+        }
+
+        EVP_MD_free(psm2ctx->md);
+        psm2ctx->md = EVP_MD_fetch(psm2ctx->libctx, name, mdprops);
+        if (psm2ctx->md == NULL) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_DIGEST);
+            return 0;
+        }
+    }
+
+    p = OSSL_PARAM_locate_const(params, OSSL_EXCHANGE_PARAM_KDF_OUTLEN);
+    if (p != NULL) {
+        size_t outlen;
+
+        if (!OSSL_PARAM_get_size_t(p, &outlen))
+            return 0;
+        psm2ctx->outlen = outlen;
+    }
+
+    return 1;
+}
+
+static const OSSL_PARAM known_settable_ctx_params[] = {
+    OSSL_PARAM_int(OSSL_EXCHANGE_PARAM_SM2_INITIATOR, NULL),
+    OSSL_PARAM_octet_string(OSSL_EXCHANGE_PARAM_SM2_DIST_ID, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_EXCHANGE_PARAM_SM2_PEER_DIST_ID, NULL, 0),
+#if !defined(OPENSSL_NO_ACVP_TESTS)
+    OSSL_PARAM_BN(OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PRIV, NULL, 0),
+#endif
+    OSSL_PARAM_octet_string(OSSL_EXCHANGE_PARAM_SM2_PEER_EPHEMERAL_PUB,
+                            NULL, 0),
+    OSSL_PARAM_utf8_string(OSSL_EXCHANGE_PARAM_KDF_DIGEST, NULL, 0),
+    OSSL_PARAM_utf8_string(OSSL_EXCHANGE_PARAM_KDF_DIGEST_PROPS, NULL, 0),
+    OSSL_PARAM_size_t(OSSL_EXCHANGE_PARAM_KDF_OUTLEN, NULL),
+    OSSL_PARAM_END
+};
+
+static const OSSL_PARAM *sm2_exch_settable_ctx_params(ossl_unused void *vpsm2ctx,
+                                                      ossl_unused void *provctx)
+{
+    return known_settable_ctx_params;
+}
+
+static int sm2_exch_get_ctx_params(void *vpsm2ctx, OSSL_PARAM params[])
+{
+    PROV_SM2_EXCH_CTX *psm2ctx = (PROV_SM2_EXCH_CTX *)vpsm2ctx;
+    OSSL_PARAM *p;
+
+    if (psm2ctx == NULL)
+        return 0;
+
+    p = OSSL_PARAM_locate(params, OSSL_EXCHANGE_PARAM_SM2_INITIATOR);
+    if (p != NULL && !OSSL_PARAM_set_int(p, psm2ctx->initiator))
+        return 0;
+
+    p = OSSL_PARAM_locate(params, OSSL_EXCHANGE_PARAM_KDF_DIGEST);
+    if (p != NULL
+            && !OSSL_PARAM_set_utf8_string(p, psm2ctx->md == NULL
+                                           ? ""
+                                           : EVP_MD_get0_name(psm2ctx->md)))
+        return 0;
+
+    p = OSSL_PARAM_locate(params, OSSL_EXCHANGE_PARAM_KDF_OUTLEN);
+    if (p != NULL && !OSSL_PARAM_set_size_t(p, psm2ctx->outlen))
+        return 0;
+
+    /* R, the value to send to the peer, which is made on first use */
+    p = OSSL_PARAM_locate(params, OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PUB);
+    if (p != NULL) {
+        unsigned char *buf = NULL;
+        size_t len;
+        int ok;
+
+        if (!sm2_exch_get_ephemeral(psm2ctx))
+            return 0;
+        len = EC_KEY_key2buf(psm2ctx->eph, POINT_CONVERSION_UNCOMPRESSED,
+                             &buf, NULL);
+        ok = len != 0 && OSSL_PARAM_set_octet_string(p, buf, len);
+        OPENSSL_free(buf);
+        if (!ok)
+            return 0;
+    }
+
+    p = OSSL_PARAM_locate(params, OSSL_EXCHANGE_PARAM_SM2_CONFIRM);
+    if (p != NULL) {
+        if (psm2ctx->confirm_len == 0) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_STATE);
+            return 0;
+        }
+        if (!OSSL_PARAM_set_octet_string(p, psm2ctx->confirm,
+                                         psm2ctx->confirm_len))
+            return 0;
+    }
+
+    p = OSSL_PARAM_locate(params, OSSL_EXCHANGE_PARAM_SM2_PEER_CONFIRM);
+    if (p != NULL) {
+        if (psm2ctx->confirm_len == 0) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_STATE);
+            return 0;
+        }
+        if (!OSSL_PARAM_set_octet_string(p, psm2ctx->peer_confirm,
+                                         psm2ctx->confirm_len))
+            return 0;
+    }
+
+    return 1;
+}
+
+static const OSSL_PARAM known_gettable_ctx_params[] = {
+    OSSL_PARAM_int(OSSL_EXCHANGE_PARAM_SM2_INITIATOR, NULL),
+    OSSL_PARAM_utf8_string(OSSL_EXCHANGE_PARAM_KDF_DIGEST, NULL, 0),
+    OSSL_PARAM_size_t(OSSL_EXCHANGE_PARAM_KDF_OUTLEN, NULL),
+    OSSL_PARAM_octet_string(OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PUB, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_EXCHANGE_PARAM_SM2_CONFIRM, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_EXCHANGE_PARAM_SM2_PEER_CONFIRM, NULL, 0),
+    OSSL_PARAM_END
+};
+
+static const OSSL_PARAM *sm2_exch_gettable_ctx_params(ossl_unused void *vpsm2ctx,
+                                                      ossl_unused void *provctx)
+{
+    return known_gettable_ctx_params;
+}
+
+static int sm2_exch_derive(void *vpsm2ctx, unsigned char *secret,
+                           size_t *psecretlen, size_t outlen)
+{
+    PROV_SM2_EXCH_CTX *psm2ctx = (PROV_SM2_EXCH_CTX *)vpsm2ctx;
+
+    if (!ossl_prov_is_running())
+        return 0;
+
+    if (secret == NULL) {
+        *psecretlen = psm2ctx->outlen;
+        return 1;
+    }
+
+    if (psm2ctx->k == NULL || psm2ctx->peerk == NULL
+            || psm2ctx->peereph == NULL) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_MISSING_KEY);
+        return 0;
+    }
+    if (psm2ctx->outlen > outlen) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_OUTPUT_BUFFER_TOO_SMALL);
+        return 0;
+    }
+    if (!sm2_exch_get_ephemeral(psm2ctx))
+        return 0;
+
+    psm2ctx->confirm_len = 0;
+    if (!ossl_sm2_compute_key(secret, psm2ctx->outlen, psm2ctx->initiator,
+                              psm2ctx->id, psm2ctx->id_len,
+                              psm2ctx->peer_id, psm2ctx->peer_id_len,
+                              psm2ctx->k, psm2ctx->eph,
+                              psm2ctx->peerk, psm2ctx->peereph,
+                              psm2ctx->md, psm2ctx->confirm,
+                              psm2ctx->peer_confirm))
+        return 0;
+    psm2ctx->confirm_len = EVP_MD_get_size(psm2ctx->md);
+
+    *psecretlen = psm2ctx->outlen;
+    return 1;
+}
+
+const OSSL_DISPATCH ossl_sm2_keyexch_functions[] = {
+    { OSSL_FUNC_KEYEXCH_NEWCTX, (void (*)(void))sm2_exch_newctx },
+    { OSSL_FUNC_KEYEXCH_INIT, (void (*)(void))sm2_exch_init },
+    { OSSL_FUNC_KEYEXCH_DERIVE, (void (*)(void))sm2_exch_derive },
+    { OSSL_FUNC_KEYEXCH_SET_PEER, (void (*)(void))sm2_exch_set_peer },
+    { OSSL_FUNC_KEYEXCH_FREECTX, (void (*)(void))sm2_exch_freectx },
+    { OSSL_FUNC_KEYEXCH_DUPCTX, (void (*)(void))sm2_exch_dupctx },
+    { OSSL_FUNC_KEYEXCH_SET_CTX_PARAMS,
+      (void (*)(void))sm2_exch_set_ctx_params },
+    { OSSL_FUNC_KEYEXCH_SETTABLE_CTX_PARAMS,
+      (void (*)(void))sm2_exch_settable_ctx_params },
+    { OSSL_FUNC_KEYEXCH_GET_CTX_PARAMS,
+      (void (*)(void))sm2_exch_get_ctx_params },
+    { OSSL_FUNC_KEYEXCH_GETTABLE_CTX_PARAMS,
+      (void (*)(void))sm2_exch_gettable_ctx_params },
+    { 0, NULL }
+};
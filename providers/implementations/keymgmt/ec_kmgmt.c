@@ -94,6 +94,7 @@ const char *sm2_query_operation_name(int operation_id)
 {
     switch (operation_id) {
     case OSSL_OP_SIGNATURE:
+    case OSSL_OP_KEYEXCH:
         return "SM2";
     }
     return NULL;
@@ -37,6 +37,7 @@ static OSSL_FUNC_signature_sign_init_fn sm2sig_signature_init;
 static OSSL_FUNC_signature_verify_init_fn sm2sig_signature_init;
 static OSSL_FUNC_signature_sign_fn sm2sig_sign;
 static OSSL_FUNC_signature_verify_fn sm2sig_verify;
+static OSSL_FUNC_signature_verify_batch_fn sm2sig_verify_batch;
 static OSSL_FUNC_signature_digest_sign_init_fn sm2sig_digest_signverify_init;
 static OSSL_FUNC_signature_digest_sign_update_fn sm2sig_digest_signverify_update;
 static OSSL_FUNC_signature_digest_sign_final_fn sm2sig_digest_sign_final;
@@ -154,6 +155,11 @@ static int sm2sig_sign(void *vpsm2ctx, unsigned char *sig, size_t *siglen,
     if (ctx->mdsize != 0 && tbslen != ctx->mdsize)
         return 0;
 
+    /*
+     * ctx->ec is the key object itself (up-ref'd, also by dupctx), so the
+     * SM2 signing context cached in it is reused by every EVP_DigestSign
+     * with this key.
+     */
     ret = ossl_sm2_internal_sign(tbs, tbslen, sig, &sltmp, ctx->ec);
     if (ret <= 0)
         return 0;
@@ -173,6 +179,36 @@ static int sm2sig_verify(void *vpsm2ctx, const unsigned char *sig, size_t siglen
     return ossl_sm2_internal_verify(tbs, tbslen, sig, siglen, ctx->ec);
 }
 
+static int sm2sig_verify_batch(void *vpsm2ctx, size_t num,
+                               void *const provkeys[],
+                               const unsigned char *const sigs[],
+                               const size_t siglens[],
+                               const unsigned char *const tbs[],
+                               const size_t tbslens[], unsigned char *results)
+{
+    PROV_SM2_CTX *ctx = (PROV_SM2_CTX *)vpsm2ctx;
+    EC_KEY **ec;
+    size_t i;
+    int ret;
+
+    if (num > OPENSSL_MALLOC_MAX_NELEMS(EC_KEY *)) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if ((ec = OPENSSL_malloc(num * sizeof(*ec))) == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    /* Items are held to the same digest size as sm2sig_verify() */
+    for (i = 0; i < num; i++)
+        ec[i] = ctx->mdsize != 0 && tbslens[i] != ctx->mdsize
+                ? NULL : provkeys[i];
+    ret = ossl_sm2_verify_batch(ctx->libctx, num, ec, sigs, siglens, tbs,
+                                tbslens, results);
+    OPENSSL_free(ec);
+    return ret;
+}
+
 static void free_md(PROV_SM2_CTX *ctx)
 {
     EVP_MD_CTX_free(ctx->mdctx);
@@ -231,20 +267,19 @@ static int sm2sig_digest_signverify_init(void *vpsm2ctx, const char *mdname,
 
 static int sm2sig_compute_z_digest(PROV_SM2_CTX *ctx)
 {
-    uint8_t *z = NULL;
     int ret = 1;
 
     if (ctx->flag_compute_z_digest) {
         /* Only do this once */
         ctx->flag_compute_z_digest = 0;
 
-        if ((z = OPENSSL_zalloc(ctx->mdsize)) == NULL
-            /* get hashed prefix 'z' of tbs message */
-            || !ossl_sm2_compute_z_digest(z, ctx->md, ctx->id, ctx->id_len,
-                                          ctx->ec)
-            || !EVP_DigestUpdate(ctx->mdctx, z, ctx->mdsize))
+        /*
+         * restart from the digest state with the hashed prefix 'z' of tbs
+         * message already absorbed, which the key keeps per ID and digest
+         */
+        if (!ossl_ec_key_sm2_z_digest_init(ctx->ec, ctx->mdctx, ctx->md,
+                                           ctx->id, ctx->id_len))
             ret = 0;
-        OPENSSL_free(z);
     }
 
     return ret;
@@ -512,6 +547,7 @@ const OSSL_DISPATCH ossl_sm2_signature_functions[] = {
     { OSSL_FUNC_SIGNATURE_SIGN, (void (*)(void))sm2sig_sign },
     { OSSL_FUNC_SIGNATURE_VERIFY_INIT, (void (*)(void))sm2sig_signature_init },
     { OSSL_FUNC_SIGNATURE_VERIFY, (void (*)(void))sm2sig_verify },
+    { OSSL_FUNC_SIGNATURE_VERIFY_BATCH, (void (*)(void))sm2sig_verify_batch },
     { OSSL_FUNC_SIGNATURE_DIGEST_SIGN_INIT,
       (void (*)(void))sm2sig_digest_signverify_init },
     { OSSL_FUNC_SIGNATURE_DIGEST_SIGN_UPDATE,
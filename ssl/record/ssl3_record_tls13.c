@@ -87,7 +87,7 @@ int tls13_enc(SSL *s, SSL3_RECORD *recs, size_t n_recs, int sending,
         alg_enc = s->s3.tmp.new_cipher->algorithm_enc;
     }
 
-    if (alg_enc & SSL_AESCCM) {
+    if (alg_enc & (SSL_AESCCM | SSL_SM4CCM)) {
         if (alg_enc & (SSL_AES128CCM8 | SSL_AES256CCM8))
             taglen = EVP_CCM8_TLS_TAG_LEN;
          else
@@ -97,7 +97,7 @@ int tls13_enc(SSL *s, SSL3_RECORD *recs, size_t n_recs, int sending,
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
             return 0;
         }
-    } else if (alg_enc & SSL_AESGCM) {
+    } else if (alg_enc & (SSL_AESGCM | SSL_SM4GCM)) {
         taglen = EVP_GCM_TLS_TAG_LEN;
     } else if (alg_enc & SSL_CHACHA20) {
         taglen = EVP_CHACHAPOLY_TLS_TAG_LEN;
@@ -163,7 +163,7 @@ int tls13_enc(SSL *s, SSL3_RECORD *recs, size_t n_recs, int sending,
      * For CCM we must explicitly set the total plaintext length before we add
      * any AAD.
      */
-    if (((alg_enc & SSL_AESCCM) != 0
+    if (((alg_enc & (SSL_AESCCM | SSL_SM4CCM)) != 0
                  && EVP_CipherUpdate(ctx, NULL, &lenu, NULL,
                                      (unsigned int)rec->length) <= 0)
             || EVP_CipherUpdate(ctx, NULL, &lenu, recheader,
@@ -55,6 +55,8 @@ static const ssl_cipher_table ssl_cipher_table_cipher[SSL_ENC_NUM_IDX] = {
     {SSL_ARIA256GCM, NID_aria_256_gcm}, /* SSL_ENC_ARIA256GCM_IDX 21 */
     {SSL_MAGMA, NID_magma_ctr_acpkm}, /* SSL_ENC_MAGMA_IDX */
     {SSL_KUZNYECHIK, NID_kuznyechik_ctr_acpkm}, /* SSL_ENC_KUZNYECHIK_IDX */
+    {SSL_SM4GCM, NID_sm4_gcm},  /* SSL_ENC_SM4GCM_IDX 24 */
+    {SSL_SM4CCM, NID_sm4_ccm},  /* SSL_ENC_SM4CCM_IDX 25 */
 };
 
 #define SSL_COMP_NULL_IDX       0
@@ -82,7 +84,8 @@ static const ssl_cipher_table ssl_cipher_table_mac[SSL_MD_NUM_IDX] = {
     {0, NID_sha224},            /* SSL_MD_SHA224_IDX 10 */
     {0, NID_sha512},            /* SSL_MD_SHA512_IDX 11 */
     {SSL_MAGMAOMAC, NID_magma_mac}, /* sSL_MD_MAGMAOMAC_IDX */
-    {SSL_KUZNYECHIKOMAC, NID_kuznyechik_mac} /* SSL_MD_KUZNYECHIKOMAC_IDX */
+    {SSL_KUZNYECHIKOMAC, NID_kuznyechik_mac}, /* SSL_MD_KUZNYECHIKOMAC_IDX */
+    {SSL_SM3, NID_sm3}          /* SSL_MD_SM3_IDX 14 */
 };
 
 /* *INDENT-OFF* */
@@ -141,7 +144,9 @@ static const int default_mac_pkey_id[SSL_MD_NUM_IDX] = {
     /* GOST2012_512 */
     EVP_PKEY_HMAC,
     /* MD5/SHA1, SHA224, SHA512, MAGMAOMAC, KUZNYECHIKOMAC */
-    NID_undef, NID_undef, NID_undef, NID_undef, NID_undef
+    NID_undef, NID_undef, NID_undef, NID_undef, NID_undef,
+    /* SM3 */
+    EVP_PKEY_HMAC
 };
 
 #define CIPHER_ADD      1
@@ -1826,6 +1831,12 @@ char *SSL_CIPHER_description(const SSL_CIPHER *cipher, char *buf, int len)
     case SSL_ARIA256GCM:
         enc = "ARIAGCM(256)";
         break;
+    case SSL_SM4GCM:
+        enc = "SM4GCM(128)";
+        break;
+    case SSL_SM4CCM:
+        enc = "SM4CCM(128)";
+        break;
     case SSL_SEED:
         enc = "SEED(128)";
         break;
@@ -2153,9 +2164,10 @@ int ssl_cipher_get_overhead(const SSL_CIPHER *c, size_t *mac_overhead,
 
     /* Some hard-coded numbers for the CCM/Poly1305 MAC overhead
      * because there are no handy #defines for those. */
-    if (c->algorithm_enc & (SSL_AESGCM | SSL_ARIAGCM)) {
+    if (c->algorithm_enc & (SSL_AESGCM | SSL_ARIAGCM | SSL_SM4GCM)) {
         out = EVP_GCM_TLS_EXPLICIT_IV_LEN + EVP_GCM_TLS_TAG_LEN;
-    } else if (c->algorithm_enc & (SSL_AES128CCM | SSL_AES256CCM)) {
+    } else if (c->algorithm_enc & (SSL_AES128CCM | SSL_AES256CCM
+                                   | SSL_SM4CCM)) {
         out = EVP_CCM_TLS_EXPLICIT_IV_LEN + 16;
     } else if (c->algorithm_enc & (SSL_AES128CCM8 | SSL_AES256CCM8)) {
         out = EVP_CCM_TLS_EXPLICIT_IV_LEN + 8;
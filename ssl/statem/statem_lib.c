@@ -208,6 +208,10 @@ int tls_setup_handshake(SSL *s)
 #define TLS13_TBS_START_SIZE            64
 #define TLS13_TBS_PREAMBLE_SIZE         (TLS13_TBS_START_SIZE + 33 + 1)
 
+/* Distinguishing identifier for sm2sig_sm3 in TLS 1.3, see RFC 8998 3.2.1 */
+#define TLS13_SM2_ID                    "TLSv1.3"
+#define TLS13_SM2_ID_LEN                (sizeof(TLS13_SM2_ID) - 1)
+
 static int get_cert_verify_tbs_data(SSL *s, unsigned char *tls13tbs,
                                     void **hdata, size_t *hdatalen)
 {
@@ -324,6 +328,11 @@ int tls_construct_cert_verify(SSL *s, WPACKET *pkt)
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_EVP_LIB);
             goto err;
         }
+    } else if (lu->sig == EVP_PKEY_SM2) {
+        if (EVP_PKEY_CTX_set1_id(pctx, TLS13_SM2_ID, TLS13_SM2_ID_LEN) <= 0) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_EVP_LIB);
+            goto err;
+        }
     }
     if (s->version == SSL3_VERSION) {
         /*
@@ -517,6 +526,11 @@ MSG_PROCESS_RETURN tls_process_cert_verify(SSL *s, PACKET *pkt)
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_EVP_LIB);
             goto err;
         }
+    } else if (s->s3.tmp.peer_sigalg->sig == EVP_PKEY_SM2) {
+        if (EVP_PKEY_CTX_set1_id(pctx, TLS13_SM2_ID, TLS13_SM2_ID_LEN) <= 0) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_EVP_LIB);
+            goto err;
+        }
     }
     if (s->version == SSL3_VERSION) {
         if (EVP_DigestVerifyUpdate(mctx, hdata, hdatalen) <= 0
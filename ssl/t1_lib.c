@@ -182,7 +182,8 @@ static struct {
     {NID_ffdhe3072, OSSL_TLS_GROUP_ID_ffdhe3072},
     {NID_ffdhe4096, OSSL_TLS_GROUP_ID_ffdhe4096},
     {NID_ffdhe6144, OSSL_TLS_GROUP_ID_ffdhe6144},
-    {NID_ffdhe8192, OSSL_TLS_GROUP_ID_ffdhe8192}
+    {NID_ffdhe8192, OSSL_TLS_GROUP_ID_ffdhe8192},
+    {NID_sm2, OSSL_TLS_GROUP_ID_curveSM2}
 };
 
 static const unsigned char ecformats_default[] = {
@@ -980,6 +981,9 @@ static const uint16_t tls12_sigalgs[] = {
     TLSEXT_SIGALG_ecdsa_secp521r1_sha512,
     TLSEXT_SIGALG_ed25519,
     TLSEXT_SIGALG_ed448,
+#ifndef OPENSSL_NO_SM2
+    TLSEXT_SIGALG_sm2sig_sm3,
+#endif
 
     TLSEXT_SIGALG_rsa_pss_pss_sha256,
     TLSEXT_SIGALG_rsa_pss_pss_sha384,
@@ -1036,6 +1040,11 @@ static const SIGALG_LOOKUP sigalg_lookup_tbl[] = {
     {"ed448", TLSEXT_SIGALG_ed448,
      NID_undef, -1, EVP_PKEY_ED448, SSL_PKEY_ED448,
      NID_undef, NID_undef, 1},
+#ifndef OPENSSL_NO_SM2
+    {"sm2sig_sm3", TLSEXT_SIGALG_sm2sig_sm3,
+     NID_sm3, SSL_MD_SM3_IDX, EVP_PKEY_SM2, SSL_PKEY_SM2,
+     NID_SM2_with_SM3, NID_sm2, 1},
+#endif
     {NULL, TLSEXT_SIGALG_ecdsa_sha224,
      NID_sha224, SSL_MD_SHA224_IDX, EVP_PKEY_EC, SSL_PKEY_ECC,
      NID_ecdsa_with_SHA224, NID_undef, 1},
@@ -1135,6 +1144,7 @@ static const uint16_t tls_default_sigalg[] = {
     TLSEXT_SIGALG_gostr34102012_512_intrinsic, /* SSL_PKEY_GOST12_512 */
     0, /* SSL_PKEY_ED25519 */
     0, /* SSL_PKEY_ED448 */
+    0, /* SSL_PKEY_SM2 */
 };
 
 int ssl_setup_sig_algs(SSL_CTX *ctx)
@@ -1459,14 +1469,22 @@ int tls12_check_peer_sigalg(SSL *s, uint16_t sig, EVP_PKEY *pkey)
     const EVP_MD *md = NULL;
     char sigalgstr[2];
     size_t sent_sigslen, i, cidx;
-    int pkeyid = -1;
+    int pkeyid = -1, keytype;
     const SIGALG_LOOKUP *lu;
     int secbits = 0;
 
     pkeyid = EVP_PKEY_get_id(pkey);
+    /* Provider only key types such as SM2 have no legacy id */
+    if (pkeyid == EVP_PKEY_KEYMGMT) {
+        const SSL_CERT_LOOKUP *clu = ssl_cert_lookup_by_pkey(pkey, NULL);
+
+        if (clu != NULL)
+            pkeyid = clu->nid;
+    }
     /* Should never happen */
     if (pkeyid == -1)
         return -1;
+    keytype = pkeyid;
     if (SSL_IS_TLS13(s)) {
         /* Disallow DSA for TLS 1.3 */
         if (pkeyid == EVP_PKEY_DSA) {
@@ -1484,13 +1502,14 @@ int tls12_check_peer_sigalg(SSL *s, uint16_t sig, EVP_PKEY *pkey)
      */
     if (lu == NULL
         || (SSL_IS_TLS13(s) && (lu->hash == NID_sha1 || lu->hash == NID_sha224))
+        || (!SSL_IS_TLS13(s) && lu->sig == EVP_PKEY_SM2)
         || (pkeyid != lu->sig
         && (lu->sig != EVP_PKEY_RSA_PSS || pkeyid != EVP_PKEY_RSA))) {
         SSLfatal(s, SSL_AD_ILLEGAL_PARAMETER, SSL_R_WRONG_SIGNATURE_TYPE);
         return 0;
     }
     /* Check the sigalg is consistent with the key OID */
-    if (!ssl_cert_lookup_by_nid(EVP_PKEY_get_id(pkey), &cidx)
+    if (!ssl_cert_lookup_by_nid(keytype, &cidx)
             || lu->sig_idx != (int)cidx) {
         SSLfatal(s, SSL_AD_ILLEGAL_PARAMETER, SSL_R_WRONG_SIGNATURE_TYPE);
         return 0;
@@ -2057,6 +2076,19 @@ static int tls12_sigalg_allowed(const SSL *s, int op, const SIGALG_LOOKUP *lu)
     if (ssl_cert_is_disabled(s->ctx, lu->sig_idx))
         return 0;
 
+    /*
+     * sm2sig_sm3 is only defined for TLS 1.3 (RFC 8998). A client that has
+     * not negotiated a version yet may offer it if it could do TLSv1.3.
+     */
+    if (lu->sig == EVP_PKEY_SM2) {
+        if (s->method->version == TLS_ANY_VERSION) {
+            if (s->s3.tmp.max_ver < TLS1_3_VERSION)
+                return 0;
+        } else if (!SSL_IS_TLS13(s)) {
+            return 0;
+        }
+    }
+
     if (lu->sig == NID_id_GostR3410_2012_256
             || lu->sig == NID_id_GostR3410_2012_512
             || lu->sig == NID_id_GostR3410_2001) {
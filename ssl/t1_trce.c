@@ -250,6 +250,8 @@ static const ssl_trace_tbl ssl_ciphers_tbl[] = {
     {0x00C3, "TLS_DHE_DSS_WITH_CAMELLIA_256_CBC_SHA256"},
     {0x00C4, "TLS_DHE_RSA_WITH_CAMELLIA_256_CBC_SHA256"},
     {0x00C5, "TLS_DH_anon_WITH_CAMELLIA_256_CBC_SHA256"},
+    {0x00C6, "TLS_SM4_GCM_SM3"},
+    {0x00C7, "TLS_SM4_CCM_SM3"},
     {0x00FF, "TLS_EMPTY_RENEGOTIATION_INFO_SCSV"},
     {0x5600, "TLS_FALLBACK_SCSV"},
     {0xC001, "TLS_ECDH_ECDSA_WITH_NULL_SHA"},
@@ -532,6 +534,7 @@ static const ssl_trace_tbl ssl_groups_tbl[] = {
     {38, "GC512A"},
     {39, "GC512B"},
     {40, "GC512C"},
+    {41, "curveSM2"},
     {256, "ffdhe2048"},
     {257, "ffdhe3072"},
     {258, "ffdhe4096"},
@@ -562,6 +565,7 @@ static const ssl_trace_tbl ssl_sigalg_tbl[] = {
     {TLSEXT_SIGALG_ecdsa_sha224, "ecdsa_sha224"},
     {TLSEXT_SIGALG_ed25519, "ed25519"},
     {TLSEXT_SIGALG_ed448, "ed448"},
+    {TLSEXT_SIGALG_sm2sig_sm3, "sm2sig_sm3"},
     {TLSEXT_SIGALG_ecdsa_sha1, "ecdsa_sha1"},
     {TLSEXT_SIGALG_rsa_pss_rsae_sha256, "rsa_pss_rsae_sha256"},
     {TLSEXT_SIGALG_rsa_pss_rsae_sha384, "rsa_pss_rsae_sha384"},
@@ -1164,6 +1164,55 @@ static int test_EVP_Digest(void)
     return ret;
 }
 
+static const char *batch_digests[] = {
+    "SHA256",
+#ifndef OPENSSL_NO_SM3
+    "SM3",
+#endif
+};
+
+/*
+ * EVP_Digest_batch() must give the same results as separate EVP_Digest()
+ * calls, whether or not the digest has a multi-buffer implementation.
+ */
+static int test_EVP_Digest_batch(int idx)
+{
+    int ret = 0;
+    EVP_MD *md = NULL;
+    const void *data[11];
+    size_t counts[11], i;
+    unsigned char out[11][EVP_MAX_MD_SIZE], *mds[11];
+    unsigned char expected[EVP_MAX_MD_SIZE];
+    unsigned char msg[300];
+    unsigned int mdlen;
+
+    if (!TEST_ptr(md = EVP_MD_fetch(testctx, batch_digests[idx], testpropq)))
+        goto out;
+
+    for (i = 0; i < sizeof(msg); i++)
+        msg[i] = (unsigned char)i;
+    for (i = 0; i < OSSL_NELEM(data); i++) {
+        data[i] = msg + i;
+        counts[i] = sizeof(msg) - 27 * i;
+        mds[i] = out[i];
+    }
+
+    if (!TEST_true(EVP_Digest_batch(OSSL_NELEM(data), data, counts, mds, md)))
+        goto out;
+
+    for (i = 0; i < OSSL_NELEM(data); i++) {
+        if (!TEST_true(EVP_Digest(data[i], counts[i], expected, &mdlen, md,
+                                  NULL))
+                || !TEST_mem_eq(out[i], EVP_MD_get_size(md), expected, mdlen))
+            goto out;
+    }
+    ret = 1;
+
+ out:
+    EVP_MD_free(md);
+    return ret;
+}
+
 static int test_d2i_AutoPrivateKey(int i)
 {
     int ret = 0;
@@ -3412,6 +3461,7 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_EVP_DigestSignInit, 9);
     ADD_TEST(test_EVP_DigestVerifyInit);
     ADD_TEST(test_EVP_Digest);
+    ADD_ALL_TESTS(test_EVP_Digest_batch, OSSL_NELEM(batch_digests));
     ADD_ALL_TESTS(test_EVP_Enveloped, 2);
     ADD_ALL_TESTS(test_d2i_AutoPrivateKey, OSSL_NELEM(keydata));
     ADD_TEST(test_privatekey_to_pkcs8);
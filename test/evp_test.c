@@ -540,6 +540,7 @@ typedef struct cipher_data_st {
     int tls_version;
     unsigned char *tag;
     const char *cts_mode;
+    const char *xts_standard;
     size_t tag_len;
     int tag_late;
     unsigned char *mac_key;
@@ -683,6 +684,10 @@ static int cipher_test_parse(EVP_TEST *t, const char *keyword,
         cdat->cts_mode = value;
         return 1;
     }
+    if (strcmp(keyword, "XTSStandard") == 0) {
+        cdat->xts_standard = value;
+        return 1;
+    }
     return 0;
 }
 
@@ -752,6 +757,19 @@ static int cipher_test_enc(EVP_TEST *t, int enc,
             goto err;
         }
     }
+    if (expected->xts_standard != NULL) {
+        OSSL_PARAM params[2];
+
+        params[0] =
+            OSSL_PARAM_construct_utf8_string(OSSL_CIPHER_PARAM_XTS_STANDARD,
+                                             (char *)expected->xts_standard,
+                                             0);
+        params[1] = OSSL_PARAM_construct_end();
+        if (!EVP_CIPHER_CTX_set_params(ctx_base, params)) {
+            t->err = "INVALID_XTS_STANDARD";
+            goto err;
+        }
+    }
     if (expected->iv) {
         if (expected->aead) {
             if (!EVP_CIPHER_CTX_ctrl(ctx_base, EVP_CTRL_AEAD_SET_IVLEN,
@@ -27,6 +27,8 @@
 #include <openssl/err.h>
 #include <openssl/ec.h>
 #include <openssl/rand.h>
+#include <openssl/core_names.h>
+#include <openssl/provider.h>
 #include "testutil.h"
 #include "../crypto/ec/ec_local.h"
 #include "../crypto/bn/bn_local.h"
@@ -37,17 +39,14 @@
 
 int bn_mul_mont(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp,
                 const BN_ULONG *np, const BN_ULONG *n0p, int num);
+EC_GROUP *EC_GROUP_new_curve_sm2_GFp(const BIGNUM *p, const BIGNUM *a,
+                                     const BIGNUM *b, BN_CTX *ctx);
+# ifdef ECP_SM2Z256_ASM
 /* Montgomery mul: res = a*b*2^-256 mod P */
 void ecp_sm2z256_mul_mont(BN_ULONG res[4],
                            const BN_ULONG a[4],
                            const BN_ULONG b[4]);
-
-void ecp_sm2z256_ord_mul_mont(BN_ULONG res[4],
-                           const BN_ULONG a[4],
-                           const BN_ULONG b[4]);
-
-void ecp_sm2z256_mod_inverse_sqr(BN_ULONG r[4],
-                                       const BN_ULONG in[4]);
+# endif
 static fake_random_generate_cb get_faked_bytes;
 
 static OSSL_PROVIDER *fake_rand = NULL;
@@ -75,14 +74,14 @@ static double Time_F(int s);
 # define TM_START        0
 # define TM_STOP         1
 
-double app_tminterval(int stop, int usertime)
+static double app_tminterval(int stop, int usertim)
 {
     double ret = 0;
     struct tms rus;
     clock_t now = times(&rus);
     static clock_t tmstart;
 
-    if (usertime)
+    if (usertim)
         now = rus.tms_utime;
 
     if (stop == TM_START) {
@@ -101,9 +100,18 @@ static void alarmed(int sig)
     run = 0;
 }
 
+/* each timed loop runs for at most SECONDS */
+#define SECONDS 1
+
 static double Time_F(int s)
 {
-    double ret = app_tminterval(s, usertime);
+    double ret;
+
+    if (s == START) {
+        run = 1;
+        alarm(SECONDS);
+    }
+    ret = app_tminterval(s, usertime);
     if (s == STOP)
         alarm(0);
     return ret;
@@ -263,6 +271,58 @@ done:
     return group;
 }
 
+/* The SM2 recommended curve: p, a, b, the generator, its order, cofactor */
+static const char *const sm2_curve_params[] = {
+    "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF00000000FFFFFFFFFFFFFFFF",
+    "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF00000000FFFFFFFFFFFFFFFC",
+    "28E9FA9E9D9F5E344D5A9E4BCF6509A7F39789F515AB8F92DDBCBD414D940E93",
+    "32C4AE2C1F1981195F9904466A39C9948FE30BBFF2660BE1715A4589334C74C7",
+    "BC3736A2F4F6779C59BDCEE36B692153D0A9877CC62A474002DF32E52139F0A0",
+    "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54123",
+    "1"
+};
+
+/*
+ * Builds the SM2 curve twice, groups[0] on the sm2z256 method and groups[1]
+ * on the generic one, for tests that compare the two. The caller frees both
+ * groups, also on failure.
+ */
+static int make_sm2_group_pair(EC_GROUP *groups[2])
+{
+    const char *const *p = sm2_curve_params;
+
+    groups[0] = create_EC_group(p[0], p[1], p[2], p[3], p[4], p[5], p[6]);
+    groups[1] = create_EC_group_slow(p[0], p[1], p[2], p[3], p[4], p[5],
+                                     p[6]);
+    return TEST_ptr(groups[0]) && TEST_ptr(groups[1]);
+}
+
+/*
+ * Sets p[j] on groups[j] to [m]G, for m > 0. The point is computed on the
+ * generic group and carried over to the sm2z256 one by its affine
+ * coordinates, so the method under test plays no part in making it.
+ */
+static int make_sm2_point_pair(EC_GROUP *groups[2], EC_POINT *p[2],
+                               unsigned long m, BN_CTX *ctx)
+{
+    BIGNUM *k, *x, *y;
+    int ok;
+
+    BN_CTX_start(ctx);
+    k = BN_CTX_get(ctx);
+    x = BN_CTX_get(ctx);
+    y = BN_CTX_get(ctx);
+    ok = TEST_ptr(y)
+         && TEST_true(BN_set_word(k, m))
+         && TEST_true(EC_POINT_mul(groups[1], p[1], k, NULL, NULL, ctx))
+         && TEST_true(EC_POINT_get_affine_coordinates(groups[1], p[1], x, y,
+                                                      ctx))
+         && TEST_true(EC_POINT_set_affine_coordinates(groups[0], p[0], x, y,
+                                                      ctx));
+    BN_CTX_end(ctx);
+    return ok;
+}
+
 static int test_sm2_crypt(const EC_GROUP *group,
                           const EVP_MD *digest,
                           const char *privkey_hex,
@@ -311,7 +371,7 @@ static int test_sm2_crypt(const EC_GROUP *group,
         goto done;
     }
     // BIO_printf(bio_err, "%s\n", ctext);
-    for (i=0; i<ctext_len; i++){
+    for (i = 0; i < (int)ctext_len; i++) {
         BIO_printf(bio_err, "%02x", ctext[i]);
     }
     BIO_printf(bio_err, "\n");
@@ -396,6 +456,306 @@ static int sm2_crypt_test(void)
     return testresult;
 }
 
+/*
+ * With the same k, the sm2z256 encryption path has to produce exactly the
+ * ciphertext of the generic one, and each has to decrypt the other's. The
+ * second pass runs once the key has its own comb table.
+ */
+static int sm2_crypt_fast_path_test(void)
+{
+    static const char *const ks[] = {
+        "4C62EEFD6ECFC2B95B92FD6C3D9575148AFA17425546D49018E5388D49DD7B4F",
+        "0000000000000000000000000000000000000000000000000000000000000003"
+    };
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_KEY *keys[2] = { NULL, NULL };
+    BIGNUM *priv = NULL;
+    EC_POINT *pt = NULL;
+    unsigned char msg[300], ctext[2][512], ptext[sizeof(msg)];
+    size_t ctext_len[2], ptext_len, msg_len;
+    int i, j, pass, testresult = 0;
+
+    if (!make_sm2_group_pair(groups)
+            || !TEST_true(BN_hex2bn(&priv, "1649AB77A00637BD5E2EFE283FBF3535"
+                                    "34AA7F7CB89463F208DDBC2920BB0DA0")))
+        goto done;
+
+    for (i = 0; i < 2; i++) {
+        EC_POINT_free(pt);
+        pt = NULL;
+        if (!TEST_ptr(keys[i] = EC_KEY_new())
+                || !TEST_true(EC_KEY_set_group(keys[i], groups[i]))
+                || !TEST_true(EC_KEY_set_private_key(keys[i], priv))
+                || !TEST_ptr(pt = EC_POINT_new(groups[i]))
+                || !TEST_true(EC_POINT_mul(groups[i], pt, priv, NULL, NULL,
+                                           NULL))
+                || !TEST_true(EC_KEY_set_public_key(keys[i], pt)))
+            goto done;
+    }
+
+    for (i = 0; i < (int)sizeof(msg); i++)
+        msg[i] = (unsigned char)(i * 7 + 1);
+
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; pass == 1 && i < 16; i++) {
+            ctext_len[0] = sizeof(ctext[0]);
+            if (!TEST_true(ossl_sm2_encrypt(keys[0], EVP_sm3(), msg, 32,
+                                            ctext[0], &ctext_len[0])))
+                goto done;
+        }
+
+        for (msg_len = 1; msg_len <= sizeof(msg); msg_len += 149) {
+            for (j = 0; j < (int)OSSL_NELEM(ks); j++) {
+                for (i = 0; i < 2; i++) {
+                    ctext_len[i] = sizeof(ctext[i]);
+                    if (!TEST_true(start_fake_rand(ks[j])))
+                        goto done;
+                    if (!TEST_true(ossl_sm2_encrypt(keys[i], EVP_sm3(), msg,
+                                                    msg_len, ctext[i],
+                                                    &ctext_len[i]))) {
+                        restore_rand();
+                        goto done;
+                    }
+                    restore_rand();
+                }
+                if (!TEST_mem_eq(ctext[0], ctext_len[0],
+                                 ctext[1], ctext_len[1]))
+                    goto done;
+
+                for (i = 0; i < 2; i++) {
+                    ptext_len = sizeof(ptext);
+                    if (!TEST_true(ossl_sm2_decrypt(keys[i], EVP_sm3(),
+                                                    ctext[1 - i],
+                                                    ctext_len[1 - i],
+                                                    ptext, &ptext_len))
+                            || !TEST_mem_eq(ptext, ptext_len, msg, msg_len))
+                        goto done;
+                }
+            }
+        }
+    }
+
+    testresult = 1;
+ done:
+    for (i = 0; i < 2; i++) {
+        EC_KEY_free(keys[i]);
+        EC_GROUP_free(groups[i]);
+    }
+    EC_POINT_free(pt);
+    BN_free(priv);
+    return testresult;
+}
+
+/*
+ * The SM2 key on the built-in group goes through the public EVP_SM2_STREAM
+ * API and so the provider, the EC key on a generic group straight through
+ * the SM2_STREAM functions underneath.
+ */
+static int stream_encrypt_init(EVP_SM2_STREAM_CTX *sctx, SM2_STREAM *st,
+                               EVP_PKEY *pkey, unsigned char *c1,
+                               size_t *c1len)
+{
+    if (st == NULL)
+        return EVP_SM2_STREAM_encrypt_init(sctx, NULL, pkey, NULL, NULL,
+                                           c1, c1len);
+    return ossl_sm2_stream_encrypt_init(st, EVP_PKEY_get0_EC_KEY(pkey),
+                                        EVP_sm3(), c1, c1len);
+}
+
+static int stream_decrypt_init(EVP_SM2_STREAM_CTX *sctx, SM2_STREAM *st,
+                               EVP_PKEY *pkey, const unsigned char *c1,
+                               size_t c1len, const unsigned char *c3,
+                               size_t c3len)
+{
+    if (st == NULL)
+        return EVP_SM2_STREAM_decrypt_init(sctx, NULL, pkey, NULL, NULL,
+                                           c1, c1len, c3, c3len);
+    return ossl_sm2_stream_decrypt_init(st, EVP_PKEY_get0_EC_KEY(pkey),
+                                        EVP_sm3(), c1, c1len, c3, c3len);
+}
+
+static int stream_update(EVP_SM2_STREAM_CTX *sctx, SM2_STREAM *st,
+                         unsigned char *out, const unsigned char *in,
+                         size_t inlen)
+{
+    if (st == NULL)
+        return EVP_SM2_STREAM_update(sctx, out, in, inlen);
+    return ossl_sm2_stream_update(st, out, in, inlen);
+}
+
+static int stream_encrypt_final(EVP_SM2_STREAM_CTX *sctx, SM2_STREAM *st,
+                                unsigned char *c3, size_t *c3len)
+{
+    if (st == NULL)
+        return EVP_SM2_STREAM_encrypt_final(sctx, c3, c3len);
+    return ossl_sm2_stream_encrypt_final(st, c3, c3len);
+}
+
+static int stream_decrypt_final(EVP_SM2_STREAM_CTX *sctx, SM2_STREAM *st)
+{
+    if (st == NULL)
+        return EVP_SM2_STREAM_decrypt_final(sctx);
+    return ossl_sm2_stream_decrypt_final(st);
+}
+
+/*
+ * Streams a message in odd-sized pieces, on the built-in group and on a
+ * generic one, and checks C3 and C2 against the DER output of
+ * ossl_sm2_encrypt() for the same k.
+ */
+static int sm2_stream_test(void)
+{
+    static const char k_hex[] =
+        "4C62EEFD6ECFC2B95B92FD6C3D9575148AFA17425546D49018E5388D49DD7B4F";
+    static const size_t chunks[] = { 1, 31, 32, 33, 500, 7 };
+    enum { MSG_LEN = 1000 };
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_KEY *key = NULL;
+    EVP_PKEY *pkey = NULL;
+    EVP_SM2_STREAM_CTX *sctx = NULL;
+    SM2_STREAM *st = NULL;
+    OSSL_LIB_CTX *libctx = NULL;
+    OSSL_PROVIDER *prov = NULL;
+    EVP_PKEY_CTX *kctx = NULL;
+    unsigned char msg[MSG_LEN], c2[MSG_LEN], ptext[MSG_LEN];
+    unsigned char der[MSG_LEN + 200], c1[65], c3[32];
+    size_t derlen, c1len, c3len, off, n;
+    int i, j, testresult = 0;
+
+    if (!make_sm2_group_pair(groups)
+            || !TEST_ptr(sctx = EVP_SM2_STREAM_CTX_new()))
+        goto done;
+
+    /* Only SM2 keys are accepted by the public API */
+    if (!TEST_ptr(key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1))
+            || !TEST_true(EC_KEY_generate_key(key))
+            || !TEST_ptr(pkey = EVP_PKEY_new())
+            || !TEST_true(EVP_PKEY_set1_EC_KEY(pkey, key)))
+        goto done;
+    c1len = sizeof(c1);
+    if (!TEST_false(EVP_SM2_STREAM_encrypt_init(sctx, NULL, pkey, NULL, NULL,
+                                                c1, &c1len))
+            || !TEST_false(EVP_SM2_STREAM_update(sctx, c2, msg, 1)))
+        goto done;
+
+    for (i = 0; i < MSG_LEN; i++)
+        msg[i] = (unsigned char)(i * 13 + 5);
+
+    /* The cipher is fetched from the library context and properties given */
+    EVP_PKEY_free(pkey);
+    pkey = NULL;
+    if (!TEST_ptr(libctx = OSSL_LIB_CTX_new())
+            || !TEST_ptr(prov = OSSL_PROVIDER_load(libctx, "default"))
+            || !TEST_ptr(kctx = EVP_PKEY_CTX_new_from_name(libctx, "SM2",
+                                                           NULL))
+            || !TEST_int_gt(EVP_PKEY_keygen_init(kctx), 0)
+            || !TEST_int_gt(EVP_PKEY_keygen(kctx, &pkey), 0))
+        goto done;
+    c1len = sizeof(c1);
+    c3len = sizeof(c3);
+    if (!TEST_false(EVP_SM2_STREAM_encrypt_init(sctx, libctx, pkey,
+                                                "provider=fips", NULL,
+                                                c1, &c1len))
+            || !TEST_true(EVP_SM2_STREAM_encrypt_init(sctx, libctx, pkey,
+                                                      "provider=default", NULL,
+                                                      c1, &c1len))
+            || !TEST_true(EVP_SM2_STREAM_update(sctx, c2, msg, 16))
+            || !TEST_true(EVP_SM2_STREAM_encrypt_final(sctx, c3, &c3len))
+            || !TEST_true(EVP_SM2_STREAM_decrypt_init(sctx, libctx, pkey,
+                                                      NULL, NULL, c1, c1len,
+                                                      c3, c3len))
+            || !TEST_true(EVP_SM2_STREAM_update(sctx, ptext, c2, 16))
+            || !TEST_true(EVP_SM2_STREAM_decrypt_final(sctx))
+            || !TEST_mem_eq(ptext, 16, msg, 16))
+        goto done;
+
+    for (i = 0; i < 2; i++) {
+        EC_KEY_free(key);
+        EVP_PKEY_free(pkey);
+        key = NULL;
+        pkey = NULL;
+        if (!TEST_ptr(key = (i == 0 ? EC_KEY_new_by_curve_name(NID_sm2)
+                                    : EC_KEY_new()))
+                || (i == 1 && !TEST_true(EC_KEY_set_group(key, groups[1])))
+                || !TEST_true(EC_KEY_generate_key(key))
+                || !TEST_ptr(pkey = EVP_PKEY_new())
+                || !TEST_true(EVP_PKEY_set1_EC_KEY(pkey, key)))
+            goto done;
+        if (i == 1 && !TEST_ptr(st = ossl_sm2_stream_new()))
+            goto done;
+
+        derlen = sizeof(der);
+        if (!TEST_true(start_fake_rand(k_hex)))
+            goto done;
+        if (!TEST_true(ossl_sm2_encrypt(key, EVP_sm3(), msg, MSG_LEN, der,
+                                        &derlen))) {
+            restore_rand();
+            goto done;
+        }
+
+        c1len = sizeof(c1);
+        if (!TEST_true(start_fake_rand(k_hex))
+                || !TEST_true(stream_encrypt_init(sctx, st, pkey, c1,
+                                                  &c1len))) {
+            restore_rand();
+            goto done;
+        }
+        restore_rand();
+        for (off = 0, j = 0; off < MSG_LEN; off += n, j++) {
+            n = j < (int)OSSL_NELEM(chunks) ? chunks[j] : MSG_LEN - off;
+            if (n > MSG_LEN - off)
+                n = MSG_LEN - off;
+            if (!TEST_true(stream_update(sctx, st, c2 + off, msg + off, n)))
+                goto done;
+        }
+        c3len = sizeof(c3);
+        if (!TEST_true(stream_encrypt_final(sctx, st, c3, &c3len))
+                || !TEST_size_t_eq(c1len, sizeof(c1))
+                || !TEST_size_t_eq(c3len, sizeof(c3))
+                /* DER tail: C3, then a four byte OCTET STRING header, C2 */
+                || !TEST_mem_eq(c2, MSG_LEN, der + derlen - MSG_LEN, MSG_LEN)
+                || !TEST_mem_eq(c3, c3len,
+                                der + derlen - MSG_LEN - 4 - c3len, c3len))
+            goto done;
+
+        /* Decrypt in place, seven bytes at a time */
+        memcpy(ptext, c2, MSG_LEN);
+        if (!TEST_true(stream_decrypt_init(sctx, st, pkey, c1, c1len,
+                                           c3, c3len)))
+            goto done;
+        for (off = 0; off < MSG_LEN; off += n) {
+            n = MSG_LEN - off < 7 ? MSG_LEN - off : 7;
+            if (!TEST_true(stream_update(sctx, st, ptext + off, ptext + off,
+                                         n)))
+                goto done;
+        }
+        if (!TEST_true(stream_decrypt_final(sctx, st))
+                || !TEST_mem_eq(ptext, MSG_LEN, msg, MSG_LEN))
+            goto done;
+
+        /* A flipped bit in C2 has to be caught by C3 */
+        c2[500] ^= 1;
+        if (!TEST_true(stream_decrypt_init(sctx, st, pkey, c1, c1len,
+                                           c3, c3len))
+                || !TEST_true(stream_update(sctx, st, ptext, c2, MSG_LEN))
+                || !TEST_false(stream_decrypt_final(sctx, st)))
+            goto done;
+    }
+
+    testresult = 1;
+ done:
+    EVP_SM2_STREAM_CTX_free(sctx);
+    ossl_sm2_stream_free(st);
+    EVP_PKEY_free(pkey);
+    EC_KEY_free(key);
+    EC_GROUP_free(groups[0]);
+    EC_GROUP_free(groups[1]);
+    EVP_PKEY_CTX_free(kctx);
+    OSSL_PROVIDER_unload(prov);
+    OSSL_LIB_CTX_free(libctx);
+    return testresult;
+}
+
 static int test_sm2_sign(const EC_GROUP *group,
                          const char *userid,
                          const char *privkey_hex,
@@ -492,7 +852,6 @@ static int speed_sm2_sign(const EC_GROUP *group,
     // BIGNUM *r = NULL;
     // BIGNUM *s = NULL;
     BN_CTX *ctx = NULL;
-    int ret;
 
 
 #if SIGALRM > 0
@@ -552,6 +911,7 @@ static int speed_sm2_sign(const EC_GROUP *group,
         BIO_printf(bio_err, "%ld bn_mul_mont in %.2fs \n", count, d);
         BIO_printf(bio_err, "%8.1f bn_mul_mont/s\n", (double)count / d);
 
+#ifdef ECP_SM2Z256_ASM
         d = 0.0;
         Time_F(START);
         for(count = 0; run && (count < FUNCTION_TESTS); count++){
@@ -569,6 +929,7 @@ static int speed_sm2_sign(const EC_GROUP *group,
         d = Time_F(STOP);
         BIO_printf(bio_err, "%ld ecp_sm2z256_ord_mul_mont in %.2fs \n", count, d);
         BIO_printf(bio_err, "%8.1f ecp_sm2z256_ord_mul_mont/s\n", (double)count / d);
+#endif
 
         /*
         * for mod p inverse 
@@ -596,6 +957,7 @@ static int speed_sm2_sign(const EC_GROUP *group,
         BIO_printf(bio_err, "%ld mod p default inv in %.2fs \n", count, d);
         BIO_printf(bio_err, "%8.1f mod p default inv/s\n", (double)count / d);
 
+#ifdef ECP_SM2Z256_ASM
         d = 0.0;
         Time_F(START);
         for(count = 0; run && (count < FUNCTION_TESTS); count++){
@@ -604,6 +966,7 @@ static int speed_sm2_sign(const EC_GROUP *group,
         d = Time_F(STOP);
         BIO_printf(bio_err, "%ld mod p fast inv in %.2fs \n", count, d);
         BIO_printf(bio_err, "%8.1f mod p fast inv/s\n", (double)count / d);
+#endif
 
         test_functions = 0;
     }
@@ -624,7 +987,8 @@ static int speed_sm2_sign(const EC_GROUP *group,
     d = 0.0;
     Time_F(START);
     for(count = 0; run && (count < TESTS); count++){
-        ossl_ec_group_do_inverse_ord(group, big_r, big_a, ctx);
+        if (!ossl_ec_group_do_inverse_ord(group, big_r, big_a, ctx))
+            break;
     }
     d = Time_F(STOP);
     BIO_printf(bio_err, "%ld mod n inv in %.2fs \n", count, d);
@@ -674,6 +1038,17 @@ static int speed_sm2_sign(const EC_GROUP *group,
     BIO_printf(bio_err, "%8.1f unfixed-point mul/s\n", (double)count / d);
 #endif
 
+#ifdef ECP_SM2Z256_ASM
+    /* Fixed-base and sign throughput depend on the configured comb */
+    if (ecp_sm2z256_group_is_builtin(group)) {
+        size_t table_size;
+        const char *comb = ecp_sm2z256_comb_geometry(&table_size);
+
+        BIO_printf(bio_err, "generator comb %s, %lu bytes of table\n",
+                   comb, (unsigned long)table_size);
+    }
+#endif
+
     d = 0.0;
     Time_F(START);
     for(count = 0; run && (count < TESTS); count++){
@@ -799,6 +1174,1000 @@ static int sm2_sig_test(void)
     return testresult;
 }
 
+/*
+ * The signing context cached in the key must follow a private key change,
+ * otherwise signatures made after the change no longer verify.
+ */
+static int sm2_sign_key_change_test(void)
+{
+    static const unsigned char dgst[32] = { 0x5a };
+    unsigned char sig[72];
+    unsigned int siglen;
+    EC_KEY *key = NULL, *other = NULL;
+    int i, testresult = 0;
+
+    if (!TEST_ptr(key = EC_KEY_new_by_curve_name(NID_sm2))
+            || !TEST_ptr(other = EC_KEY_new_by_curve_name(NID_sm2))
+            || !TEST_true(EC_KEY_generate_key(key)))
+        goto done;
+
+    for (i = 0; i < 3; i++) {
+        siglen = sizeof(sig);
+        if (!TEST_int_eq(ossl_sm2_internal_sign(dgst, sizeof(dgst), sig,
+                                                &siglen, key), 1)
+                || !TEST_int_eq(ossl_sm2_internal_verify(dgst, sizeof(dgst),
+                                                         sig, siglen, key), 1))
+            goto done;
+
+        if (!TEST_true(EC_KEY_generate_key(other))
+                || !TEST_true(EC_KEY_set_private_key(key,
+                                  EC_KEY_get0_private_key(other)))
+                || !TEST_true(EC_KEY_set_public_key(key,
+                                  EC_KEY_get0_public_key(other))))
+            goto done;
+    }
+
+    testresult = 1;
+ done:
+    EC_KEY_free(key);
+    EC_KEY_free(other);
+    return testresult;
+}
+
+/*
+ * With the same k, the allocation-free sm2z256 sign path has to produce
+ * exactly the DER signature of the generic ossl_sm2_internal_sign() code on
+ * an sm2 group that does not use the sm2z256 method, and each has to verify
+ * the other's. The k streams include a k = 1, an n - 1 and a draw at or
+ * above n that both paths have to reject before taking the next one.
+ */
+static int sm2_sign_fast_path_test(void)
+{
+    static const char *const privs[] = {
+        "1",
+        "128B2FA8BD433C6C068C8D803DFF79792A519A55171B1B650C23661D15897263",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54121"
+    };
+    static const char *const ks[] = {
+        "0000000000000000000000000000000000000000000000000000000000000001",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54122",
+        "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF"
+        "6CB28D99385C175C94F94E934817663FC176D925DD72B727260DBAAE1FB2F96F"
+    };
+    unsigned char dgsts[3][32];
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_KEY *keys[2] = { NULL, NULL };
+    BIGNUM *priv = NULL;
+    EC_POINT *pt = NULL;
+    unsigned char sig[2][80];
+    unsigned int siglen[2];
+    int i, j, d, p, testresult = 0;
+
+    memset(dgsts[0], 0, sizeof(dgsts[0]));
+    memset(dgsts[1], 0xff, sizeof(dgsts[1]));
+    for (i = 0; i < (int)sizeof(dgsts[2]); i++)
+        dgsts[2][i] = (unsigned char)(i * 29 + 3);
+
+    if (!make_sm2_group_pair(groups))
+        goto done;
+
+    for (p = 0; p < (int)OSSL_NELEM(privs); p++) {
+        if (!TEST_true(BN_hex2bn(&priv, privs[p])))
+            goto done;
+        for (i = 0; i < 2; i++) {
+            EC_KEY_free(keys[i]);
+            EC_POINT_free(pt);
+            pt = NULL;
+            if (!TEST_ptr(keys[i] = EC_KEY_new())
+                    || !TEST_true(EC_KEY_set_group(keys[i], groups[i]))
+                    || !TEST_true(EC_KEY_set_private_key(keys[i], priv))
+                    || !TEST_ptr(pt = EC_POINT_new(groups[i]))
+                    || !TEST_true(EC_POINT_mul(groups[i], pt, priv, NULL,
+                                               NULL, NULL))
+                    || !TEST_true(EC_KEY_set_public_key(keys[i], pt)))
+                goto done;
+        }
+
+        for (d = 0; d < (int)OSSL_NELEM(dgsts); d++) {
+            for (j = 0; j < (int)OSSL_NELEM(ks); j++) {
+                for (i = 0; i < 2; i++) {
+                    siglen[i] = sizeof(sig[i]);
+                    if (!TEST_true(start_fake_rand(ks[j])))
+                        goto done;
+                    if (!TEST_int_eq(ossl_sm2_internal_sign(dgsts[d],
+                                                            sizeof(dgsts[d]),
+                                                            sig[i], &siglen[i],
+                                                            keys[i]), 1)) {
+                        restore_rand();
+                        goto done;
+                    }
+                    restore_rand();
+                }
+                if (!TEST_mem_eq(sig[0], siglen[0], sig[1], siglen[1]))
+                    goto done;
+
+                for (i = 0; i < 2; i++)
+                    if (!TEST_int_eq(ossl_sm2_internal_verify(dgsts[d],
+                                                              sizeof(dgsts[d]),
+                                                              sig[1 - i],
+                                                              siglen[1 - i],
+                                                              keys[i]), 1))
+                        goto done;
+            }
+        }
+    }
+
+    testresult = 1;
+ done:
+    for (i = 0; i < 2; i++) {
+        EC_KEY_free(keys[i]);
+        EC_GROUP_free(groups[i]);
+    }
+    EC_POINT_free(pt);
+    BN_free(priv);
+    return testresult;
+}
+
+/*
+ * Alternates user IDs and digests on one key, then changes the key, and
+ * checks each digest state handed out by the key against a fresh H(ZA || M).
+ */
+static int sm2_z_digest_cache_test(void)
+{
+    static const char *ids[] = { "1234567812345678", "ALICE123@YAHOO.COM", "" };
+    static const unsigned char msg[] = "message digest";
+    unsigned char got[EVP_MAX_MD_SIZE], want[EVP_MAX_MD_SIZE];
+    uint8_t z[EVP_MAX_MD_SIZE];
+    const EVP_MD *mds[2];
+    EVP_MD_CTX *mdctx = NULL;
+    EC_KEY *key = NULL, *other = NULL;
+    int i, j, testresult = 0;
+
+    mds[0] = EVP_sm3();
+    mds[1] = EVP_sha256();
+    if (!TEST_ptr(mdctx = EVP_MD_CTX_new())
+            || !TEST_ptr(key = EC_KEY_new_by_curve_name(NID_sm2))
+            || !TEST_ptr(other = EC_KEY_new_by_curve_name(NID_sm2))
+            || !TEST_true(EC_KEY_generate_key(key)))
+        goto done;
+
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < 12; j++) {
+            const uint8_t *id = (const uint8_t *)ids[(j / 2) % 3];
+            size_t id_len = strlen(ids[(j / 2) % 3]);
+            const EVP_MD *md = mds[j / 6];
+            int md_size = EVP_MD_get_size(md);
+
+            if (!TEST_true(ossl_sm2_compute_z_digest(z, md, id, id_len, key))
+                    || !TEST_true(EVP_DigestInit_ex(mdctx, md, NULL))
+                    || !TEST_true(EVP_DigestUpdate(mdctx, z, md_size))
+                    || !TEST_true(EVP_DigestUpdate(mdctx, msg, sizeof(msg)))
+                    || !TEST_true(EVP_DigestFinal_ex(mdctx, want, NULL))
+                    || !TEST_true(ossl_ec_key_sm2_z_digest_init(key, mdctx, md,
+                                                                id, id_len))
+                    || !TEST_true(EVP_DigestUpdate(mdctx, msg, sizeof(msg)))
+                    || !TEST_true(EVP_DigestFinal_ex(mdctx, got, NULL))
+                    || !TEST_mem_eq(got, md_size, want, md_size))
+                goto done;
+        }
+
+        if (!TEST_true(EC_KEY_generate_key(other))
+                || !TEST_true(EC_KEY_set_private_key(key,
+                                  EC_KEY_get0_private_key(other)))
+                || !TEST_true(EC_KEY_set_public_key(key,
+                                  EC_KEY_get0_public_key(other))))
+            goto done;
+    }
+
+    testresult = 1;
+ done:
+    EVP_MD_CTX_free(mdctx);
+    EC_KEY_free(key);
+    EC_KEY_free(other);
+    return testresult;
+}
+
+/*
+ * Verifies often enough with one key for it to get a comb table of its own,
+ * then replaces the public key and does it again.
+ */
+static int sm2_verify_table_test(void)
+{
+    unsigned char dgst[32] = { 0xa5 };
+    unsigned char sig[72], oldsig[72];
+    unsigned int siglen, oldsiglen = 0;
+    EC_KEY *key = NULL, *other = NULL;
+    int i, j, testresult = 0;
+
+    if (!TEST_ptr(key = EC_KEY_new_by_curve_name(NID_sm2))
+            || !TEST_ptr(other = EC_KEY_new_by_curve_name(NID_sm2))
+            || !TEST_true(EC_KEY_generate_key(key)))
+        goto done;
+
+    for (i = 0; i < 2; i++) {
+        siglen = sizeof(sig);
+        if (!TEST_int_eq(ossl_sm2_internal_sign(dgst, sizeof(dgst), sig,
+                                                &siglen, key), 1))
+            goto done;
+
+        for (j = 0; j < 24; j++) {
+            dgst[1] ^= 1;
+            if (!TEST_int_le(ossl_sm2_internal_verify(dgst, sizeof(dgst),
+                                                      sig, siglen, key), 0))
+                goto done;
+            dgst[1] ^= 1;
+            if (!TEST_int_eq(ossl_sm2_internal_verify(dgst, sizeof(dgst),
+                                                      sig, siglen, key), 1))
+                goto done;
+        }
+        if (oldsiglen != 0
+                && !TEST_int_le(ossl_sm2_internal_verify(dgst, sizeof(dgst),
+                                                         oldsig, oldsiglen,
+                                                         key), 0))
+            goto done;
+        memcpy(oldsig, sig, siglen);
+        oldsiglen = siglen;
+
+        if (!TEST_true(EC_KEY_generate_key(other))
+                || !TEST_true(EC_KEY_set_private_key(key,
+                                  EC_KEY_get0_private_key(other)))
+                || !TEST_true(EC_KEY_set_public_key(key,
+                                  EC_KEY_get0_public_key(other))))
+            goto done;
+    }
+
+    testresult = 1;
+ done:
+    EC_KEY_free(key);
+    EC_KEY_free(other);
+    return testresult;
+}
+
+/*
+ * Moves the generator of the built-in curve to [7]G, which is not the one
+ * the static table was made for, precomputes a comb table for it and checks
+ * fixed base multiplications against the generic method.
+ */
+static int sm2_custom_generator_test(void)
+{
+    static const char *const ks[] = {
+        "1",
+        "2",
+        "4C62EEFD6ECFC2B95B92FD6C3D9575148AFA17425546D49018E5388D49DD7B4F",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54122"
+    };
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_POINT *g[2] = { NULL, NULL }, *r[2] = { NULL, NULL };
+    BIGNUM *k = NULL;
+    BN_CTX *ctx = NULL;
+    unsigned char buf[2][65];
+    size_t i;
+    int j, testresult = 0;
+
+    if (!make_sm2_group_pair(groups)
+            || !TEST_ptr(ctx = BN_CTX_new())
+            || !TEST_ptr(g[0] = EC_POINT_new(groups[0]))
+            || !TEST_ptr(g[1] = EC_POINT_new(groups[1]))
+            || !make_sm2_point_pair(groups, g, 7, ctx))
+        goto done;
+
+    for (j = 0; j < 2; j++) {
+        if (!TEST_true(EC_GROUP_set_generator(groups[j], g[j],
+                                              EC_GROUP_get0_order(groups[1]),
+                                              BN_value_one()))
+                || !TEST_ptr(r[j] = EC_POINT_new(groups[j])))
+            goto done;
+    }
+    if (!TEST_true(EC_GROUP_precompute_mult(groups[0], ctx))
+            || !TEST_true(EC_GROUP_have_precompute_mult(groups[0])))
+        goto done;
+
+    for (i = 0; i < OSSL_NELEM(ks); i++) {
+        if (!TEST_true(BN_hex2bn(&k, ks[i])))
+            goto done;
+        for (j = 0; j < 2; j++)
+            if (!TEST_true(EC_POINT_mul(groups[j], r[j], k, NULL, NULL, ctx))
+                    || !TEST_size_t_eq(EC_POINT_point2oct(groups[j], r[j],
+                                           POINT_CONVERSION_UNCOMPRESSED,
+                                           buf[j], sizeof(buf[j]), ctx),
+                                       sizeof(buf[j])))
+                goto done;
+        if (!TEST_mem_eq(buf[0], sizeof(buf[0]), buf[1], sizeof(buf[1])))
+            goto done;
+    }
+
+    testresult = 1;
+ done:
+    for (j = 0; j < 2; j++) {
+        EC_POINT_free(g[j]);
+        EC_POINT_free(r[j]);
+        EC_GROUP_free(groups[j]);
+    }
+    BN_free(k);
+    BN_CTX_free(ctx);
+    return testresult;
+}
+
+/*
+ * Single-point multiplications with a secret scalar, as in decryption and
+ * ECDH, compared against the generic method. The scalars cover the window
+ * edges, multiples of the order and inputs that need reducing.
+ */
+static int sm2_point_mul_test(void)
+{
+    static const char *const ks[] = {
+        "0",
+        "1",
+        "2",
+        "10",
+        "1F",
+        "20",
+        "4C62EEFD6ECFC2B95B92FD6C3D9575148AFA17425546D49018E5388D49DD7B4F",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54122",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54123",
+        "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+        "1000000000000000000000000000000000000000000000000000000000000000005",
+        "-3"
+    };
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_POINT *p[2] = { NULL, NULL }, *r[2] = { NULL, NULL };
+    BIGNUM *k = NULL;
+    BN_CTX *ctx = NULL;
+    unsigned char buf[2][65];
+    size_t i, len[2];
+    int j, testresult = 0;
+
+    if (!make_sm2_group_pair(groups)
+            || !TEST_ptr(ctx = BN_CTX_new())
+            || !TEST_ptr(p[0] = EC_POINT_new(groups[0]))
+            || !TEST_ptr(p[1] = EC_POINT_new(groups[1]))
+            || !make_sm2_point_pair(groups, p, 7, ctx)
+            || !TEST_ptr(r[0] = EC_POINT_new(groups[0]))
+            || !TEST_ptr(r[1] = EC_POINT_new(groups[1])))
+        goto done;
+
+    for (i = 0; i < OSSL_NELEM(ks); i++) {
+        if (!TEST_true(BN_hex2bn(&k, ks[i])))
+            goto done;
+        for (j = 0; j < 2; j++)
+            if (!TEST_true(EC_POINT_mul(groups[j], r[j], NULL, p[j], k, ctx))
+                    || !TEST_size_t_gt(len[j] =
+                                       EC_POINT_point2oct(groups[j], r[j],
+                                           POINT_CONVERSION_UNCOMPRESSED,
+                                           buf[j], sizeof(buf[j]), ctx),
+                                       0))
+                goto done;
+        if (!TEST_mem_eq(buf[0], len[0], buf[1], len[1])) {
+            TEST_info("k = %s", ks[i]);
+            goto done;
+        }
+    }
+
+    /* The point at infinity stays there */
+    if (!TEST_true(EC_POINT_set_to_infinity(groups[0], p[0]))
+            || !TEST_true(EC_POINT_mul(groups[0], r[0], NULL, p[0], k, ctx))
+            || !TEST_true(EC_POINT_is_at_infinity(groups[0], r[0])))
+        goto done;
+
+    testresult = 1;
+ done:
+    for (j = 0; j < 2; j++) {
+        EC_POINT_free(p[j]);
+        EC_POINT_free(r[j]);
+        EC_GROUP_free(groups[j]);
+    }
+    BN_free(k);
+    BN_CTX_free(ctx);
+    return testresult;
+}
+
+/*
+ * scalar*G + k*P with one point, which the sm2z256 method computes with the
+ * variable-time interleaved kernel, compared against the generic method.
+ * Both scalars run over zero, small and negative values, the edges of the
+ * order and values beyond it, and P over a multiple of G, G itself, so that
+ * the affine additions meet equal points, and the point at infinity.
+ */
+static int sm2_points_mul_test(void)
+{
+    static const char *const scalars[] = {
+        "0",
+        "1",
+        "7",
+        "-1",
+        "-7",
+        "4C62EEFD6ECFC2B95B92FD6C3D9575148AFA17425546D49018E5388D49DD7B4F",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54122",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54123",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54128",
+        "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+        "1000000000000000000000000000000000000000000000000000000000000000005",
+        "-FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54124"
+    };
+    static const unsigned long multiples[] = { 7, 1, 0 };
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_POINT *p[2] = { NULL, NULL }, *r[2] = { NULL, NULL };
+    BIGNUM *m = NULL, *k = NULL;
+    BN_CTX *ctx = NULL;
+    unsigned char buf[2][65];
+    size_t a, b, c, len[2];
+    int j, testresult = 0;
+
+    if (!make_sm2_group_pair(groups)
+            || !TEST_ptr(ctx = BN_CTX_new())
+            || !TEST_ptr(m = BN_new())
+            || !TEST_ptr(k = BN_new())
+            || !TEST_ptr(p[0] = EC_POINT_new(groups[0]))
+            || !TEST_ptr(p[1] = EC_POINT_new(groups[1]))
+            || !TEST_ptr(r[0] = EC_POINT_new(groups[0]))
+            || !TEST_ptr(r[1] = EC_POINT_new(groups[1])))
+        goto done;
+
+    for (c = 0; c < OSSL_NELEM(multiples); c++) {
+        if (multiples[c] == 0) {
+            if (!TEST_true(EC_POINT_set_to_infinity(groups[0], p[0]))
+                    || !TEST_true(EC_POINT_set_to_infinity(groups[1], p[1])))
+                goto done;
+        } else if (!make_sm2_point_pair(groups, p, multiples[c], ctx)) {
+            goto done;
+        }
+
+        for (a = 0; a < OSSL_NELEM(scalars); a++) {
+            for (b = 0; b < OSSL_NELEM(scalars); b++) {
+                if (!TEST_true(BN_hex2bn(&m, scalars[a]))
+                        || !TEST_true(BN_hex2bn(&k, scalars[b])))
+                    goto done;
+                for (j = 0; j < 2; j++)
+                    if (!TEST_true(EC_POINT_mul(groups[j], r[j], m, p[j], k,
+                                                ctx))
+                            || !TEST_size_t_gt(len[j] =
+                                               EC_POINT_point2oct(groups[j],
+                                                   r[j],
+                                                   POINT_CONVERSION_UNCOMPRESSED,
+                                                   buf[j], sizeof(buf[j]),
+                                                   ctx),
+                                               0))
+                        goto done;
+                if (!TEST_mem_eq(buf[0], len[0], buf[1], len[1])) {
+                    TEST_info("P = %luG, m = %s, k = %s", multiples[c],
+                              scalars[a], scalars[b]);
+                    goto done;
+                }
+            }
+        }
+    }
+
+    testresult = 1;
+ done:
+    for (j = 0; j < 2; j++) {
+        EC_POINT_free(p[j]);
+        EC_POINT_free(r[j]);
+        EC_GROUP_free(groups[j]);
+    }
+    BN_free(m);
+    BN_free(k);
+    BN_CTX_free(ctx);
+    return testresult;
+}
+
+/*
+ * Point encodings on the sm2z256 method against the generic one: all three
+ * forms of a few points, in both directions, and encodings that have to be
+ * rejected.
+ */
+static int sm2_point_oct_test(void)
+{
+    static const char *const ks[] = {
+        "1",
+        "2",
+        "4C62EEFD6ECFC2B95B92FD6C3D9575148AFA17425546D49018E5388D49DD7B4F",
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFF7203DF6B21C6052B53BBF40939D54122"
+    };
+    static const point_conversion_form_t forms[] = {
+        POINT_CONVERSION_COMPRESSED,
+        POINT_CONVERSION_UNCOMPRESSED,
+        POINT_CONVERSION_HYBRID
+    };
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_POINT *p[2] = { NULL, NULL }, *q[2] = { NULL, NULL };
+    BIGNUM *k = NULL;
+    BN_CTX *ctx = NULL;
+    unsigned char buf[2][65];
+    size_t i, f, len[2];
+    int j, testresult = 0;
+
+    if (!make_sm2_group_pair(groups)
+            || !TEST_ptr(ctx = BN_CTX_new())
+            || !TEST_ptr(k = BN_new()))
+        goto done;
+    for (j = 0; j < 2; j++)
+        if (!TEST_ptr(p[j] = EC_POINT_new(groups[j]))
+                || !TEST_ptr(q[j] = EC_POINT_new(groups[j])))
+            goto done;
+
+    for (i = 0; i < OSSL_NELEM(ks); i++) {
+        if (!TEST_true(BN_hex2bn(&k, ks[i])))
+            goto done;
+        for (j = 0; j < 2; j++)
+            if (!TEST_true(EC_POINT_mul(groups[j], p[j], k, NULL, NULL, ctx))
+                    || !TEST_int_eq(EC_POINT_is_on_curve(groups[j], p[j],
+                                                         ctx), 1))
+                goto done;
+
+        for (f = 0; f < OSSL_NELEM(forms); f++) {
+            for (j = 0; j < 2; j++)
+                if (!TEST_size_t_gt(len[j] =
+                                    EC_POINT_point2oct(groups[j], p[j],
+                                                       forms[f], buf[j],
+                                                       sizeof(buf[j]), ctx),
+                                    0))
+                    goto done;
+            if (!TEST_mem_eq(buf[0], len[0], buf[1], len[1])
+                    || !TEST_true(EC_POINT_oct2point(groups[0], q[0], buf[0],
+                                                     len[0], ctx))
+                    || !TEST_int_eq(EC_POINT_cmp(groups[0], p[0], q[0], ctx),
+                                    0))
+                goto done;
+
+            /* Off the curve, or the wrong root */
+            buf[0][len[0] - 1] ^= 1;
+            for (j = 0; j < 2; j++)
+                if (!TEST_false(EC_POINT_oct2point(groups[j], q[j], buf[0],
+                                                   len[0], ctx)))
+                    goto done;
+        }
+    }
+
+    /*
+     * x = p is out of range. For x = 1..8 both methods have to agree on
+     * whether x^3 - 3x + b is a square, and on the root.
+     */
+    for (i = 0; i <= 8; i++) {
+        unsigned char enc[33] = { POINT_CONVERSION_COMPRESSED };
+        int ok[2];
+
+        if (i == 0)
+            BN_bn2binpad(EC_GROUP_get0_field(groups[1]), enc + 1, 32);
+        else
+            enc[32] = (unsigned char)i;
+        for (j = 0; j < 2; j++)
+            ok[j] = EC_POINT_oct2point(groups[j], q[j], enc, sizeof(enc), ctx);
+        ERR_clear_error();
+        if (!TEST_int_eq(ok[0], ok[1])
+                || (i == 0 && !TEST_false(ok[0])))
+            goto done;
+        if (!ok[0])
+            continue;
+        for (j = 0; j < 2; j++)
+            if (!TEST_size_t_eq(EC_POINT_point2oct(groups[j], q[j],
+                                    POINT_CONVERSION_UNCOMPRESSED,
+                                    buf[j], sizeof(buf[j]), ctx),
+                                sizeof(buf[j])))
+                goto done;
+        if (!TEST_mem_eq(buf[0], sizeof(buf[0]), buf[1], sizeof(buf[1])))
+            goto done;
+    }
+
+    testresult = 1;
+ done:
+    for (j = 0; j < 2; j++) {
+        EC_POINT_free(p[j]);
+        EC_POINT_free(q[j]);
+        EC_GROUP_free(groups[j]);
+    }
+    BN_free(k);
+    BN_CTX_free(ctx);
+    return testresult;
+}
+
+/*
+ * EC_KEY_check_key on the sm2z256 method against the generic one: a valid
+ * key pair, the public key alone, a wrong private key, a public key off the
+ * curve and one at infinity. Both have to agree, down to the error reason.
+ */
+static int sm2_check_key_test(void)
+{
+    EC_GROUP *groups[2] = { NULL, NULL };
+    EC_KEY *keys[2] = { NULL, NULL };
+    EC_POINT *q[2] = { NULL, NULL };
+    BIGNUM *d = NULL, *d1 = NULL;
+    unsigned long err[2];
+    int i, j, res[2], testresult = 0;
+
+    if (!make_sm2_group_pair(groups)
+            || !TEST_ptr(d = BN_new())
+            || !TEST_ptr(d1 = BN_new())
+            || !TEST_true(BN_rand_range(d, EC_GROUP_get0_order(groups[0])))
+            || !TEST_true(BN_add_word(d, 1))
+            || !TEST_true(BN_add(d1, d, BN_value_one())))
+        goto done;
+
+    for (j = 0; j < 2; j++) {
+        if (!TEST_ptr(keys[j] = EC_KEY_new())
+                || !TEST_true(EC_KEY_set_group(keys[j], groups[j]))
+                || !TEST_ptr(q[j] = EC_POINT_new(groups[j])))
+            goto done;
+    }
+
+    /*
+     * 0: the key pair, 1: public key only, 2: wrong private key,
+     * 3: public key off the curve, 4: public key at infinity
+     */
+    for (i = 0; i < 5; i++) {
+        for (j = 0; j < 2; j++) {
+            if (!TEST_true(EC_POINT_mul(groups[j], q[j], d, NULL, NULL, NULL)))
+                goto done;
+            if (i == 3 && !TEST_true(BN_add_word(q[j]->Y, 1)))
+                goto done;
+            if (i == 4 && !TEST_true(EC_POINT_set_to_infinity(groups[j], q[j])))
+                goto done;
+            if (!TEST_true(EC_KEY_set_public_key(keys[j], q[j])))
+                goto done;
+            if (i == 1) {
+                EC_KEY_set_private_key(keys[j], NULL);
+            } else if (!TEST_true(EC_KEY_set_private_key(keys[j],
+                                                         i == 2 ? d1 : d))) {
+                goto done;
+            }
+
+            ERR_clear_error();
+            res[j] = EC_KEY_check_key(keys[j]);
+            err[j] = ERR_GET_REASON(ERR_peek_last_error());
+        }
+        if (!TEST_int_eq(res[0], i < 2)
+                || !TEST_int_eq(res[0], res[1])
+                || !TEST_ulong_eq(err[0], err[1])) {
+            TEST_info("case %d", i);
+            goto done;
+        }
+    }
+
+    testresult = 1;
+ done:
+    ERR_clear_error();
+    for (j = 0; j < 2; j++) {
+        EC_POINT_free(q[j]);
+        EC_KEY_free(keys[j]);
+        EC_GROUP_free(groups[j]);
+    }
+    BN_free(d);
+    BN_free(d1);
+    return testresult;
+}
+
+static int sign_digest(EVP_PKEY *pkey, const unsigned char *dgst,
+                       unsigned char *sig, size_t *siglen)
+{
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_pkey(NULL, pkey, NULL);
+    int ok = TEST_ptr(ctx)
+        && TEST_int_gt(EVP_PKEY_sign_init(ctx), 0)
+        && TEST_int_gt(EVP_PKEY_sign(ctx, sig, siglen, dgst, 32), 0);
+
+    EVP_PKEY_CTX_free(ctx);
+    return ok;
+}
+
+/*
+ * Mixes good and bad SM2 signatures from several keys with an ECDSA item,
+ * which takes the per-item path, and checks the result bitmap.
+ */
+static int sm2_verify_batch_test(void)
+{
+    enum { NUM = 11 };
+    EVP_PKEY *keys[3] = { NULL, NULL, NULL };
+    EVP_PKEY *pkeys[NUM];
+    unsigned char sigbuf[NUM][80], dgstbuf[NUM][32];
+    const unsigned char *sigs[NUM], *tbs[NUM];
+    size_t siglens[NUM], tbslens[NUM];
+    unsigned char results[(NUM + 7) / 8];
+    unsigned int expected = 0, got = 0;
+    EVP_PKEY_CTX *kctx = NULL;
+    int i, testresult = 0;
+
+    for (i = 0; i < 2; i++) {
+        EVP_PKEY_CTX_free(kctx);
+        if (!TEST_ptr(kctx = EVP_PKEY_CTX_new_from_name(NULL, "SM2", NULL))
+                || !TEST_int_gt(EVP_PKEY_keygen_init(kctx), 0)
+                || !TEST_int_gt(EVP_PKEY_keygen(kctx, &keys[i]), 0))
+            goto done;
+    }
+    if (!TEST_ptr(keys[2] = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256")))
+        goto done;
+
+    for (i = 0; i < NUM; i++) {
+        pkeys[i] = keys[i == NUM - 1 ? 2 : i % 2];
+        memset(dgstbuf[i], i + 1, sizeof(dgstbuf[i]));
+        siglens[i] = sizeof(sigbuf[i]);
+        if (!sign_digest(pkeys[i], dgstbuf[i], sigbuf[i], &siglens[i]))
+            goto done;
+        sigs[i] = sigbuf[i];
+        tbs[i] = dgstbuf[i];
+        tbslens[i] = sizeof(dgstbuf[i]);
+        expected |= 1U << i;
+    }
+
+    /*
+     * no key, wrong digest, wrong key, corrupt r, trailing garbage, and a
+     * digest that is not SM3 sized
+     */
+    pkeys[0] = NULL;
+    dgstbuf[1][0] ^= 1;
+    pkeys[2] = keys[1];
+    sigbuf[5][5] ^= 0x40;
+    siglens[6]++;
+    tbslens[8] = 20;
+    expected &= ~((1U << 0) | (1U << 1) | (1U << 2) | (1U << 5) | (1U << 6)
+                  | (1U << 8));
+
+    if (!TEST_true(EVP_PKEY_verify_batch(NUM, pkeys, sigs, siglens, tbs,
+                                         tbslens, results)))
+        goto done;
+    for (i = 0; i < NUM; i++)
+        got |= (unsigned int)((results[i / 8] >> (i % 8)) & 1) << i;
+    if (!TEST_uint_eq(got, expected))
+        goto done;
+
+    testresult = 1;
+ done:
+    EVP_PKEY_CTX_free(kctx);
+    for (i = 0; i < 3; i++)
+        EVP_PKEY_free(keys[i]);
+    return testresult;
+}
+
+static EC_KEY *sm2_keyexch_key(const EC_GROUP *group, const char *priv_hex)
+{
+    EC_KEY *key = EC_KEY_new();
+    EC_POINT *pub = EC_POINT_new(group);
+    BIGNUM *priv = NULL;
+    int ok = TEST_ptr(key)
+        && TEST_ptr(pub)
+        && TEST_true(BN_hex2bn(&priv, priv_hex))
+        && TEST_true(EC_KEY_set_group(key, group))
+        && TEST_true(EC_KEY_set_private_key(key, priv))
+        && TEST_true(EC_POINT_mul(group, pub, priv, NULL, NULL, NULL))
+        && TEST_true(EC_KEY_set_public_key(key, pub));
+
+    BN_free(priv);
+    EC_POINT_free(pub);
+    if (!ok) {
+        EC_KEY_free(key);
+        key = NULL;
+    }
+    return key;
+}
+
+static int test_sm2_keyexch(const EC_GROUP *group,
+                            const char *idA, const char *dA, const char *rA,
+                            const char *idB, const char *dB, const char *rB,
+                            const char *k_hex, const char *sb_hex,
+                            const char *sa_hex)
+{
+    EC_KEY *keyA = sm2_keyexch_key(group, dA);
+    EC_KEY *ephA = sm2_keyexch_key(group, rA);
+    EC_KEY *keyB = sm2_keyexch_key(group, dB);
+    EC_KEY *ephB = sm2_keyexch_key(group, rB);
+    unsigned char *expected_k = NULL, *expected_sb = NULL, *expected_sa = NULL;
+    long k_len = 0, sb_len = 0, sa_len = 0;
+    unsigned char kA[64], kB[64];
+    unsigned char sa[EVP_MAX_MD_SIZE], sb_expected_by_a[EVP_MAX_MD_SIZE];
+    unsigned char sb[EVP_MAX_MD_SIZE], sa_expected_by_b[EVP_MAX_MD_SIZE];
+    int testresult = 0;
+
+    if (!TEST_ptr(keyA) || !TEST_ptr(ephA) || !TEST_ptr(keyB)
+            || !TEST_ptr(ephB)
+            || !TEST_ptr(expected_k = OPENSSL_hexstr2buf(k_hex, &k_len))
+            || !TEST_ptr(expected_sb = OPENSSL_hexstr2buf(sb_hex, &sb_len))
+            || !TEST_ptr(expected_sa = OPENSSL_hexstr2buf(sa_hex, &sa_len))
+            || !TEST_long_le(k_len, sizeof(kA)))
+        goto done;
+
+    if (!TEST_true(ossl_sm2_compute_key(kA, k_len, 1,
+                                        (const uint8_t *)idA, strlen(idA),
+                                        (const uint8_t *)idB, strlen(idB),
+                                        keyA, ephA, keyB, ephB, EVP_sm3(),
+                                        sa, sb_expected_by_a))
+            || !TEST_true(ossl_sm2_compute_key(kB, k_len, 0,
+                                               (const uint8_t *)idB,
+                                               strlen(idB),
+                                               (const uint8_t *)idA,
+                                               strlen(idA),
+                                               keyB, ephB, keyA, ephA,
+                                               EVP_sm3(), sb,
+                                               sa_expected_by_b)))
+        goto done;
+
+    if (!TEST_mem_eq(kA, k_len, expected_k, k_len)
+            || !TEST_mem_eq(kB, k_len, expected_k, k_len)
+            || !TEST_mem_eq(sb, sb_len, expected_sb, sb_len)
+            || !TEST_mem_eq(sb_expected_by_a, sb_len, expected_sb, sb_len)
+            || !TEST_mem_eq(sa, sa_len, expected_sa, sa_len)
+            || !TEST_mem_eq(sa_expected_by_b, sa_len, expected_sa, sa_len))
+        goto done;
+
+    testresult = 1;
+ done:
+    OPENSSL_free(expected_k);
+    OPENSSL_free(expected_sb);
+    OPENSSL_free(expected_sa);
+    EC_KEY_free(keyA);
+    EC_KEY_free(ephA);
+    EC_KEY_free(keyB);
+    EC_KEY_free(ephB);
+    return testresult;
+}
+
+/*
+ * The key exchange examples of GB/T 32918.3 on its 256-bit test curve, and
+ * of GM/T 0003.5 on the recommended curve.  The latter is run on both the
+ * sm2z256 method, which makes the joint multiplication, and on the generic
+ * one.
+ */
+static int sm2_keyexch_test(void)
+{
+    int testresult = 0;
+    EC_GROUP *test_group =
+        create_EC_group_slow
+        ("8542D69E4C044F18E8B92435BF6FF7DE457283915C45517D722EDB8B08F1DFC3",
+         "787968B4FA32C3FD2417842E73BBFEFF2F3C848B6831D7E0EC65228B3937E498",
+         "63E4C6D3B23B0C849CF84241484BFE48F61D59A5B16BA06E6E12D1DA27C5249A",
+         "421DEBD61B62EAB6746434EBC3CC315E32220B3BADD50BDC4C4E6C147FEDD43D",
+         "0680512BCBB42C07D47349D2153B70C4E5D7FDFCBFA36EA1A85841B9E46E09A2",
+         "8542D69E4C044F18E8B92435BF6FF7DD297720630485628D5AE74EE7C32E79B7",
+         "1");
+    EC_GROUP *groups[2] = { NULL, NULL };
+    int i;
+
+    if (!TEST_ptr(test_group) || !make_sm2_group_pair(groups))
+        goto done;
+
+    if (!TEST_true(test_sm2_keyexch(
+                        test_group,
+                        "ALICE123@YAHOO.COM",
+                        "6FCBA2EF9AE0AB902BC3BDE3FF915D44BA4CC78F88E2F8E7F8996D3B8CCEEDEE",
+                        "83A2C9C8B96E5AF70BD480B472409A9A327257F1EBB73F5B073354B248668563",
+                        "BILL456@YAHOO.COM",
+                        "5E35D7D3F3C54DBAC72E61819E730B019A84208CA3A35E4C2E353DFCCB2A3B53",
+                        "33FE21940342161C55619C4A0C060293D543C80AF19748CE176D83477DE71C80",
+                        "55B0AC62A6B927BA23703832C853DED4",
+                        "284C8F198F141B502E81250F1581C7E9EEB4CA6990F9E02DF388B45471F5BC5C",
+                        "23444DAF8ED7534366CB901C84B3BDBB63504F4065C1116C91A4C00697E6CF7A")))
+        goto done;
+
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(test_sm2_keyexch(
+                            groups[i],
+                            "1234567812345678",
+                            "81EB26E941BB5AF16DF116495F90695272AE2CD63D6C4AE1678418BE48230029",
+                            "D4DE15474DB74D06491C440D305E012400990F3E390C7E87153C12DB2EA60BB3",
+                            "1234567812345678",
+                            "785129917D45A9EA5437A59356B82338EAADDA6CEB199088F14AE10DEFA229B5",
+                            "7E07124814B309489125EAED101113164EBF0F3458C5BD88335C1F9D596243D6",
+                            "6C89347354DE2484C60B4AB1FDE4C6E5",
+                            "D3A0FE15DEE185CEAE907A6B595CC32A266ED7B3367E9983A896DC32FA20F8EB",
+                            "18C7894B3816DF16CF07B05C5EC0BEF5D655D58F779CC1B400A4F3884644DB88")))
+            goto done;
+    }
+
+    testresult = 1;
+ done:
+    EC_GROUP_free(test_group);
+    EC_GROUP_free(groups[0]);
+    EC_GROUP_free(groups[1]);
+    return testresult;
+}
+
+static EVP_PKEY *sm2_keyexch_keygen(void)
+{
+    EVP_PKEY_CTX *kctx = EVP_PKEY_CTX_new_from_name(NULL, "SM2", NULL);
+    EVP_PKEY *key = NULL;
+
+    if (!TEST_ptr(kctx)
+            || !TEST_int_gt(EVP_PKEY_keygen_init(kctx), 0)
+            || !TEST_int_gt(EVP_PKEY_keygen(kctx, &key), 0))
+        key = NULL;
+    EVP_PKEY_CTX_free(kctx);
+    return key;
+}
+
+static EVP_PKEY_CTX *sm2_keyexch_init(EVP_PKEY *key, EVP_PKEY *peer,
+                                      int initiator)
+{
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_pkey(NULL, key, NULL);
+    OSSL_PARAM params[2];
+
+    params[0] = OSSL_PARAM_construct_int(OSSL_EXCHANGE_PARAM_SM2_INITIATOR,
+                                         &initiator);
+    params[1] = OSSL_PARAM_construct_end();
+    if (!TEST_ptr(ctx)
+            || !TEST_int_gt(EVP_PKEY_derive_init_ex(ctx, params), 0)
+            || !TEST_int_gt(EVP_PKEY_derive_set_peer(ctx, peer), 0)) {
+        EVP_PKEY_CTX_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/*
+ * Runs both sides of the exchange through the provider, passing the
+ * ephemeral public keys across, and checks the keys and confirmations agree
+ */
+static int sm2_keyexch_provider_test(void)
+{
+    EVP_PKEY *keyA = NULL, *keyB = NULL;
+    EVP_PKEY_CTX *ctxA = NULL, *ctxB = NULL;
+    unsigned char RA[65], RB[65];
+    unsigned char kA[48], kB[48];
+    unsigned char sa[32], sb[32], sa_expected[32], sb_expected[32];
+    size_t kA_len = sizeof(kA), kB_len = sizeof(kB), outlen = sizeof(kA);
+    OSSL_PARAM params[4];
+    int testresult = 0;
+
+    if (!TEST_ptr(keyA = sm2_keyexch_keygen())
+            || !TEST_ptr(keyB = sm2_keyexch_keygen())
+            || !TEST_ptr(ctxA = sm2_keyexch_init(keyA, keyB, 1))
+            || !TEST_ptr(ctxB = sm2_keyexch_init(keyB, keyA, 0)))
+        goto done;
+
+    /* A sends RA; B answers with RB */
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PUB, RA, sizeof(RA));
+    params[1] = OSSL_PARAM_construct_end();
+    if (!TEST_true(EVP_PKEY_CTX_get_params(ctxA, params))
+            || !TEST_size_t_eq(params[0].return_size, sizeof(RA)))
+        goto done;
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_EPHEMERAL_PUB, RB, sizeof(RB));
+    if (!TEST_true(EVP_PKEY_CTX_get_params(ctxB, params))
+            || !TEST_size_t_eq(params[0].return_size, sizeof(RB)))
+        goto done;
+
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_PEER_EPHEMERAL_PUB, RA, sizeof(RA));
+    params[1] = OSSL_PARAM_construct_size_t(OSSL_EXCHANGE_PARAM_KDF_OUTLEN,
+                                            &outlen);
+    params[2] = OSSL_PARAM_construct_end();
+    if (!TEST_true(EVP_PKEY_CTX_set_params(ctxB, params)))
+        goto done;
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_PEER_EPHEMERAL_PUB, RB, sizeof(RB));
+    if (!TEST_true(EVP_PKEY_CTX_set_params(ctxA, params)))
+        goto done;
+
+    if (!TEST_int_gt(EVP_PKEY_derive(ctxA, kA, &kA_len), 0)
+            || !TEST_int_gt(EVP_PKEY_derive(ctxB, kB, &kB_len), 0)
+            || !TEST_mem_eq(kA, kA_len, kB, kB_len)
+            || !TEST_size_t_eq(kA_len, outlen))
+        goto done;
+
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_CONFIRM, sa, sizeof(sa));
+    params[1] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_PEER_CONFIRM, sb_expected,
+                    sizeof(sb_expected));
+    params[2] = OSSL_PARAM_construct_end();
+    if (!TEST_true(EVP_PKEY_CTX_get_params(ctxA, params)))
+        goto done;
+    params[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_CONFIRM, sb, sizeof(sb));
+    params[1] = OSSL_PARAM_construct_octet_string(
+                    OSSL_EXCHANGE_PARAM_SM2_PEER_CONFIRM, sa_expected,
+                    sizeof(sa_expected));
+    if (!TEST_true(EVP_PKEY_CTX_get_params(ctxB, params))
+            || !TEST_mem_eq(sa, sizeof(sa), sa_expected, sizeof(sa_expected))
+            || !TEST_mem_eq(sb, sizeof(sb), sb_expected, sizeof(sb_expected))
+            || !TEST_mem_ne(sa, sizeof(sa), sb, sizeof(sb)))
+        goto done;
+
+    testresult = 1;
+ done:
+    EVP_PKEY_CTX_free(ctxA);
+    EVP_PKEY_CTX_free(ctxB);
+    EVP_PKEY_free(keyA);
+    EVP_PKEY_free(keyB);
+    return testresult;
+}
+
 #endif
 
 int setup_tests(void)
@@ -811,7 +2180,21 @@ int setup_tests(void)
         return 0;
 
     ADD_TEST(sm2_crypt_test);
+    ADD_TEST(sm2_crypt_fast_path_test);
+    ADD_TEST(sm2_stream_test);
     ADD_TEST(sm2_sig_test);
+    ADD_TEST(sm2_sign_key_change_test);
+    ADD_TEST(sm2_sign_fast_path_test);
+    ADD_TEST(sm2_z_digest_cache_test);
+    ADD_TEST(sm2_verify_table_test);
+    ADD_TEST(sm2_custom_generator_test);
+    ADD_TEST(sm2_point_mul_test);
+    ADD_TEST(sm2_points_mul_test);
+    ADD_TEST(sm2_point_oct_test);
+    ADD_TEST(sm2_check_key_test);
+    ADD_TEST(sm2_verify_batch_test);
+    ADD_TEST(sm2_keyexch_test);
+    ADD_TEST(sm2_keyexch_provider_test);
 #endif
     return 1;
 }
@@ -73,12 +73,66 @@ static int test_sm3(void)
 
     return 1;
 }
+
+/*
+ * Ragged lengths around the padding boundaries, a few long messages so
+ * that lanes run out at different times, and batch sizes on either side
+ * of the lane count.
+ */
+static int test_sm3_digest_batch(int idx)
+{
+    static const size_t nums[] = { 1, 2, 3, 9, 17, 200 };
+    size_t num = nums[idx], i;
+    unsigned char *buf = NULL, *md = NULL, **out = NULL;
+    const unsigned char **in = NULL;
+    size_t *inlen = NULL;
+    unsigned char expected[SM3_DIGEST_LENGTH];
+    SM3_CTX ctx;
+    int ret = 0;
+
+    if (!TEST_ptr(buf = OPENSSL_malloc(4096))
+            || !TEST_ptr(md = OPENSSL_malloc(num * SM3_DIGEST_LENGTH))
+            || !TEST_ptr(out = OPENSSL_malloc(num * sizeof(*out)))
+            || !TEST_ptr(in = OPENSSL_malloc(num * sizeof(*in)))
+            || !TEST_ptr(inlen = OPENSSL_malloc(num * sizeof(*inlen))))
+        goto err;
+
+    for (i = 0; i < 4096; i++)
+        buf[i] = (unsigned char)(i * 7 + (i >> 8));
+    for (i = 0; i < num; i++) {
+        inlen[i] = i % 13 == 5 ? 1000 + 3 * i : (i * 37) % 200;
+        in[i] = buf + (i * 11) % 2048;
+        out[i] = md + i * SM3_DIGEST_LENGTH;
+    }
+
+    ossl_sm3_digest_batch(num, in, inlen, out);
+
+    for (i = 0; i < num; i++) {
+        if (!TEST_true(ossl_sm3_init(&ctx))
+                || !TEST_true(ossl_sm3_update(&ctx, in[i], inlen[i]))
+                || !TEST_true(ossl_sm3_final(expected, &ctx))
+                || !TEST_mem_eq(out[i], SM3_DIGEST_LENGTH,
+                                expected, SM3_DIGEST_LENGTH)) {
+            TEST_info("message %zu of %zu, length %zu", i, num, inlen[i]);
+            goto err;
+        }
+    }
+    ret = 1;
+ err:
+    OPENSSL_free(buf);
+    OPENSSL_free(md);
+    OPENSSL_free(out);
+    OPENSSL_free(in);
+    OPENSSL_free(inlen);
+    return ret;
+}
 #endif
 
 int setup_tests(void)
 {
 #ifndef OPENSSL_NO_SM3
     ADD_TEST(test_sm3);
+    ADD_ALL_TESTS(test_sm3_digest_batch, 6);
 #endif
     return 1;
 }
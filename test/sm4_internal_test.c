@@ -14,6 +14,7 @@
 
 #include <string.h>
 #include <openssl/opensslconf.h>
+#include "internal/nelem.h"
 #include "testutil.h"
 
 #ifndef OPENSSL_NO_SM4
@@ -75,12 +76,61 @@ static int test_sm4_ecb(void)
 
     return 1;
 }
+
+/*
+ * Block counts around the 16 blocks handled per pass by the bitsliced code.
+ */
+static const size_t bs_blocks[] = { 1, 3, 15, 16, 17, 32, 37 };
+
+static int test_sm4_bs(int idx)
+{
+    static const uint8_t k[SM4_BLOCK_SIZE] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+    /* The 32-bit counter wraps after five blocks */
+    static const uint8_t iv[SM4_BLOCK_SIZE] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0xff, 0xff, 0xff, 0xfb
+    };
+    const size_t blocks = bs_blocks[idx];
+    const size_t len = blocks * SM4_BLOCK_SIZE;
+    uint8_t in[37 * SM4_BLOCK_SIZE], out[37 * SM4_BLOCK_SIZE];
+    uint8_t expected[37 * SM4_BLOCK_SIZE], ctr[SM4_BLOCK_SIZE];
+    SM4_KEY key;
+    size_t i, j;
+
+    for (i = 0; i < len; i++)
+        in[i] = (uint8_t)(i * 7 + 1);
+    ossl_sm4_set_key(k, &key);
+
+    for (i = 0; i < len; i += SM4_BLOCK_SIZE)
+        ossl_sm4_encrypt(in + i, expected + i, &key);
+    ossl_sm4_bs_ecb_encrypt(in, out, len, &key, SM4_ENCRYPT);
+    if (!TEST_mem_eq(out, len, expected, len))
+        return 0;
+    ossl_sm4_bs_ecb_encrypt(expected, out, len, &key, SM4_DECRYPT);
+    if (!TEST_mem_eq(out, len, in, len))
+        return 0;
+
+    memcpy(ctr, iv, sizeof(ctr));
+    for (i = 0; i < len; i += SM4_BLOCK_SIZE) {
+        ossl_sm4_encrypt(ctr, expected + i, &key);
+        for (j = 0; j < SM4_BLOCK_SIZE; j++)
+            expected[i + j] ^= in[i + j];
+        for (j = SM4_BLOCK_SIZE; j-- > 12 && ++ctr[j] == 0; )
+            continue;
+    }
+    ossl_sm4_bs_ctr32_encrypt_blocks(in, out, blocks, &key, iv);
+    return TEST_mem_eq(out, len, expected, len);
+}
 #endif
 
 int setup_tests(void)
 {
 #ifndef OPENSSL_NO_SM4
     ADD_TEST(test_sm4_ecb);
+    ADD_ALL_TESTS(test_sm4_bs, OSSL_NELEM(bs_blocks));
 #endif
     return 1;
 }
@@ -4936,6 +4936,10 @@ static int test_tls13_ciphersuite(int idx)
         { TLS1_3_RFC_CHACHA20_POLY1305_SHA256, 0 },
         { TLS1_3_RFC_AES_256_GCM_SHA384
           ":" TLS1_3_RFC_CHACHA20_POLY1305_SHA256, 0 },
+# endif
+# if !defined(OPENSSL_NO_SM3) && !defined(OPENSSL_NO_SM4)
+        { TLS1_3_RFC_SM4_GCM_SM3, 0 },
+        { TLS1_3_RFC_SM4_CCM_SM3, 0 },
 # endif
         { TLS1_3_RFC_AES_128_CCM_8_SHA256 ":" TLS1_3_RFC_AES_128_CCM_SHA256, 1 }
     };
@@ -7920,6 +7924,84 @@ static int test_client_cert_cb(int tst)
     return testresult;
 }
 
+#if !defined(OSSL_NO_USABLE_TLS1_3) && !defined(OPENSSL_NO_SM2) \
+    && !defined(OPENSSL_NO_SM3) && !defined(OPENSSL_NO_SM4)
+/*
+ * Test a ShangMi TLSv1.3 handshake as per RFC 8998: curveSM2 key exchange and
+ * sm2sig_sm3 signatures from both the server and the client.
+ * Test 0: TLS_SM4_GCM_SM3
+ * Test 1: TLS_SM4_CCM_SM3
+ */
+static int test_tls13_shangmi(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    const char *ciphersuite = tst == 0 ? TLS1_3_RFC_SM4_GCM_SM3
+                                       : TLS1_3_RFC_SM4_CCM_SM3;
+    char *sm2cert = test_mk_file_path(certsdir, "sm2.pem");
+    char *sm2key = test_mk_file_path(certsdir, "sm2.key");
+    int nid, testresult = 0;
+
+    if (is_fips) {
+        testresult = TEST_skip("ShangMi algorithms are not FIPS approved");
+        goto end;
+    }
+
+    if (!TEST_ptr(sm2cert)
+            || !TEST_ptr(sm2key)
+            || !TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                              TLS_client_method(),
+                                              TLS1_3_VERSION, 0,
+                                              &sctx, &cctx, sm2cert, sm2key))
+            || !TEST_true(SSL_CTX_set_ciphersuites(sctx, ciphersuite))
+            || !TEST_true(SSL_CTX_set_ciphersuites(cctx, ciphersuite))
+            || !TEST_true(SSL_CTX_set1_groups_list(sctx, "curveSM2"))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx, "curveSM2"))
+            || !TEST_true(SSL_CTX_set1_sigalgs_list(sctx, "sm2sig_sm3"))
+            || !TEST_true(SSL_CTX_set1_sigalgs_list(cctx, "sm2sig_sm3"))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(cctx, sm2cert,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(cctx, sm2key,
+                                                        SSL_FILETYPE_PEM), 1))
+        goto end;
+
+    /* The test certificates are not checked here, only the signatures */
+    SSL_CTX_set_verify(sctx,
+                       SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+                       verify_cb);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    if (!TEST_str_eq(SSL_CIPHER_get_name(SSL_get_current_cipher(clientssl)),
+                     ciphersuite)
+            || !TEST_int_eq(SSL_get_negotiated_group(clientssl), NID_sm2)
+            || !TEST_int_eq(SSL_get_negotiated_group(serverssl), NID_sm2)
+            || !TEST_true(SSL_get_peer_signature_type_nid(clientssl, &nid))
+            || !TEST_int_eq(nid, EVP_PKEY_SM2)
+            || !TEST_true(SSL_get_peer_signature_type_nid(serverssl, &nid))
+            || !TEST_int_eq(nid, EVP_PKEY_SM2)
+            || !TEST_true(SSL_get_peer_signature_nid(clientssl, &nid))
+            || !TEST_int_eq(nid, NID_sm3))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(sm2cert);
+    OPENSSL_free(sm2key);
+
+    return testresult;
+}
+#endif
+
 #if !defined(OPENSSL_NO_TLS1_2) || !defined(OSSL_NO_USABLE_TLS1_3)
 /*
  * Test setting certificate authorities on both client and server.
@@ -9417,6 +9499,10 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_incorrect_shutdown, 2);
     ADD_ALL_TESTS(test_cert_cb, 6);
     ADD_ALL_TESTS(test_client_cert_cb, 2);
+#if !defined(OSSL_NO_USABLE_TLS1_3) && !defined(OPENSSL_NO_SM2) \
+    && !defined(OPENSSL_NO_SM3) && !defined(OPENSSL_NO_SM4)
+    ADD_ALL_TESTS(test_tls13_shangmi, 2);
+#endif
     ADD_ALL_TESTS(test_ca_names, 3);
 #ifndef OPENSSL_NO_TLS1_2
     ADD_ALL_TESTS(test_multiblock_write, OSSL_NELEM(multiblock_cipherlist_data));